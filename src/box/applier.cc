@@ -31,6 +31,7 @@
 #include "applier.h"
 
 #include <msgpuck.h>
+#include <unistd.h>
 
 #include "xlog.h"
 #include "fiber.h"
@@ -50,6 +51,11 @@
 #include "schema.h"
 #include "txn.h"
 #include "box.h"
+#include "engine.h"
+#include "memtx_engine.h"
+#include "xstream.h"
+#include "fio.h"
+#include "scoped_guard.h"
 
 STRS(applier_state, applier_STATE);
 
@@ -139,6 +145,26 @@ applier_writer_f(va_list ap)
 		if (applier->state != APPLIER_SYNC &&
 		    applier->state != APPLIER_FOLLOW)
 			continue;
+		/*
+		 * Let the reader apply more transactions so that
+		 * they are all confirmed by a single ACK, which
+		 * saves a message to the master and a status
+		 * update in the master's relay and tx threads
+		 * per transaction. Don't delay the ACK for longer
+		 * than replication_timeout though, or the master
+		 * may think the replica is dead.
+		 */
+		double deadline = applier->last_ack_time +
+				  MIN(replication_ack_interval,
+				      replication_timeout);
+		while (!applier->is_heartbeat_pending &&
+		       ev_monotonic_now(loop()) < deadline &&
+		       fiber_cond_wait_deadline(&applier->writer_cond,
+						deadline) == 0);
+		if (fiber_is_cancelled())
+			break;
+		applier->is_heartbeat_pending = false;
+		applier->last_ack_time = ev_monotonic_now(loop());
 		try {
 			struct xrow_header xrow;
 			xrow_encode_vclock(&xrow, &replicaset.vclock);
@@ -179,6 +205,92 @@ apply_initial_join_row(struct xrow_header *row)
 	return space_apply_initial_join_row(space, &request);
 }
 
+/** Size of reads of a file received on initial join. */
+enum { APPLIER_FILE_BUF_SIZE = 1024 * 1024 };
+
+/**
+ * Receive a checkpoint file sent by the master as is on initial
+ * join and store it next to the local snapshots. The contents
+ * follow the header row, part of them may have been read ahead
+ * into the input buffer already. Return the file signature.
+ */
+static int64_t
+applier_join_file(struct applier *applier, struct xrow_header *row)
+{
+	struct ev_io *coio = &applier->io;
+	struct ibuf *ibuf = &applier->ibuf;
+	const char *name;
+	uint32_t name_len;
+	uint64_t size;
+	xrow_decode_file_xc(row, &name, &name_len, &size);
+	say_info("receiving file `%.*s' (%llu bytes)", (int) name_len,
+		 name, (unsigned long long) size);
+
+	struct memtx_engine *memtx =
+		(struct memtx_engine *) engine_by_name("memtx");
+	int64_t signature;
+	int fd = memtx_engine_create_join_file(memtx, name, name_len,
+					       &signature);
+	if (fd < 0)
+		diag_raise();
+	auto fd_guard = make_scoped_guard([=] { close(fd); });
+	while (size > 0) {
+		if (ibuf_used(ibuf) == 0) {
+			ibuf_reset(ibuf);
+			ibuf_reserve_xc(ibuf, MIN(size, APPLIER_FILE_BUF_SIZE));
+			coio_breadn(coio, ibuf, 1);
+		}
+		size_t len = MIN(ibuf_used(ibuf), size);
+		if (fio_writen(fd, ibuf->rpos, len) != 0)
+			tnt_raise(SystemError, "failed to write file");
+		ibuf->rpos += len;
+		size -= len;
+		applier->last_row_time = ev_monotonic_now(loop());
+	}
+	return signature;
+}
+
+/** Stream of rows of the snapshot received on initial join. */
+struct applier_join_stream {
+	struct xstream base;
+	/** Number of rows applied so far. */
+	uint64_t row_count;
+};
+
+static void
+applier_apply_join_file_row(struct xstream *base, struct xrow_header *row)
+{
+	struct applier_join_stream *stream =
+		(struct applier_join_stream *) base;
+	/* The master doesn't send replica local rows either. */
+	if (row->group_id == GROUP_LOCAL)
+		return;
+	if (apply_initial_join_row(row) != 0)
+		diag_raise();
+	if (++stream->row_count % 100000 == 0) {
+		say_info("%.1fM rows loaded", stream->row_count / 1e6);
+		fiber_yield_timeout(0);
+	}
+}
+
+/**
+ * Apply rows of the memtx snapshot received on initial join.
+ * Return the number of rows applied.
+ */
+static uint64_t
+applier_load_join_snapshot(int64_t signature)
+{
+	struct memtx_engine *memtx =
+		(struct memtx_engine *) engine_by_name("memtx");
+	struct applier_join_stream stream;
+	xstream_create(&stream.base, applier_apply_join_file_row);
+	stream.row_count = 0;
+	if (memtx_engine_load_join_snapshot(memtx, signature,
+					    &stream.base) != 0)
+		diag_raise();
+	return stream.row_count;
+}
+
 /**
  * Process a no-op request.
  *
@@ -325,8 +437,12 @@ applier_join(struct applier *applier)
 	struct ev_io *coio = &applier->io;
 	struct ibuf *ibuf = &applier->ibuf;
 	struct xrow_header row;
-	xrow_encode_join_xc(&row, &INSTANCE_UUID);
+	uint32_t join_mode = replication_join_files ?
+			     IPROTO_JOIN_MODE_FILES : IPROTO_JOIN_MODE_ROWS;
+	xrow_encode_join_xc(&row, &INSTANCE_UUID, join_mode);
 	coio_write_xrow(coio, &row);
+	/* The master confirms the mode in the response. */
+	join_mode = IPROTO_JOIN_MODE_ROWS;
 
 	/**
 	 * Tarantool < 1.7.0: if JOIN is successful, there is no "OK"
@@ -347,8 +463,11 @@ applier_join(struct applier *applier)
 		 * Used to initialize the replica's initial
 		 * vclock in bootstrap_from_master()
 		 */
-		xrow_decode_vclock_xc(&row, &replicaset.vclock);
+		xrow_decode_join_response_xc(&row, &replicaset.vclock,
+					     &join_mode);
 	}
+	if (join_mode == IPROTO_JOIN_MODE_FILES)
+		say_info("receiving checkpoint files");
 
 	applier_set_state(applier, APPLIER_INITIAL_JOIN);
 
@@ -356,9 +475,28 @@ applier_join(struct applier *applier)
 	 * Receive initial data.
 	 */
 	uint64_t row_count = 0;
+	/* Signature of the received snapshot, -1 if none. */
+	int64_t snap_signature = -1;
 	while (true) {
 		coio_read_xrow(coio, ibuf, &row);
 		applier->last_row_time = ev_monotonic_now(loop());
+		if (row.type == IPROTO_FILE &&
+		    join_mode == IPROTO_JOIN_MODE_FILES) {
+			/* The snapshot is followed by its bases. */
+			int64_t signature = applier_join_file(applier, &row);
+			if (snap_signature < 0)
+				snap_signature = signature;
+			continue;
+		}
+		if (snap_signature >= 0 && !iproto_type_is_error(row.type)) {
+			/*
+			 * The files precede the rows of other engines,
+			 * which need the system spaces, so load them
+			 * as soon as they are received.
+			 */
+			row_count += applier_load_join_snapshot(snap_signature);
+			snap_signature = -1;
+		}
 		if (iproto_type_is_dml(row.type)) {
 			if (apply_initial_join_row(&row) != 0)
 				diag_raise();
@@ -458,7 +596,10 @@ applier_read_tx_row(struct applier *applier)
 	 * from the master for quite a while the connection is
 	 * broken - the master might just be idle.
 	 */
-	if (applier->version_id < version_id(1, 7, 7))
+	if (applier->is_compressed)
+		coio_read_xrow_zstd_timeout_xc(coio, &applier->zreader, ibuf,
+					       row, timeout);
+	else if (applier->version_id < version_id(1, 7, 7))
 		coio_read_xrow(coio, ibuf, row);
 	else
 		coio_read_xrow_timeout_xc(coio, ibuf, row, timeout);
@@ -622,9 +763,15 @@ applier_subscribe(struct applier *applier)
 	struct vclock vclock;
 	vclock_create(&vclock);
 	vclock_copy(&vclock, &replicaset.vclock);
+	uint32_t compression = replication_compression ?
+			       IPROTO_COMPRESSION_ZSTD :
+			       IPROTO_COMPRESSION_NONE;
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &vclock);
+				 &vclock, compression, replication_space_filter,
+				 replication_space_filter_size);
 	coio_write_xrow(coio, &row);
+	/* The master confirms the compression in the response. */
+	compression = IPROTO_COMPRESSION_NONE;
 
 	/* Read SUBSCRIBE response */
 	if (applier->version_id >= version_id(1, 6, 7)) {
@@ -646,7 +793,8 @@ applier_subscribe(struct applier *applier)
 		vclock_create(&remote_vclock_at_subscribe);
 		xrow_decode_subscribe_response_xc(&row,
 						  &cluster_id,
-						  &remote_vclock_at_subscribe);
+						  &remote_vclock_at_subscribe,
+						  &compression);
 		/*
 		 * If master didn't send us its cluster id
 		 * assume that it has done all the checks.
@@ -664,6 +812,24 @@ applier_subscribe(struct applier *applier)
 			 vclock_to_string(&remote_vclock_at_subscribe),
 			 vclock_to_string(&vclock));
 	}
+	if (compression == IPROTO_COMPRESSION_ZSTD) {
+		if (xrow_zstd_reader_create(&applier->zreader) != 0)
+			diag_raise();
+		applier->is_compressed = true;
+		/*
+		 * The first frames may have been read ahead
+		 * along with the response.
+		 */
+		struct ibuf *zbuf = &applier->zreader.zbuf;
+		size_t used = ibuf_used(ibuf);
+		if (used > 0) {
+			ibuf_reserve_xc(zbuf, used);
+			memcpy(zbuf->wpos, ibuf->rpos, used);
+			zbuf->wpos += used;
+		}
+		ibuf_reset(ibuf);
+		say_info("using compressed replication stream");
+	}
 	/*
 	 * Tarantool < 1.6.7:
 	 * If there is an error in subscribe, it's sent directly
@@ -761,8 +927,11 @@ applier_subscribe(struct applier *applier)
 		latch_unlock(latch);
 
 		if (applier->state == APPLIER_SYNC ||
-		    applier->state == APPLIER_FOLLOW)
+		    applier->state == APPLIER_FOLLOW) {
+			if (first_row->type == IPROTO_OK)
+				applier->is_heartbeat_pending = true;
 			fiber_cond_signal(&applier->writer_cond);
+		}
 		if (ibuf_used(ibuf) == 0)
 			ibuf_reset(ibuf);
 		fiber_gc();
@@ -782,6 +951,10 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
 	ibuf_reinit(&applier->ibuf);
+	if (applier->is_compressed) {
+		xrow_zstd_reader_destroy(&applier->zreader);
+		applier->is_compressed = false;
+	}
 	fiber_gc();
 }
 
@@ -943,6 +1116,7 @@ void
 applier_delete(struct applier *applier)
 {
 	assert(applier->reader == NULL && applier->writer == NULL);
+	assert(!applier->is_compressed);
 	ibuf_destroy(&applier->ibuf);
 	assert(applier->io.fd == -1);
 	trigger_destroy(&applier->on_state);
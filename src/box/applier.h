@@ -44,6 +44,7 @@
 #include "uri/uri.h"
 
 #include "xrow.h"
+#include "xrow_io.h"
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
@@ -76,6 +77,14 @@ struct applier {
 	struct fiber *writer;
 	/** Writer cond. */
 	struct fiber_cond writer_cond;
+	/** Monotonic time when the last ACK was sent. */
+	ev_tstamp last_ack_time;
+	/**
+	 * Set if a heartbeat has been received from the master
+	 * since the last ACK. The heartbeat is answered without
+	 * waiting for replication_ack_interval to pass.
+	 */
+	bool is_heartbeat_pending;
 	/** Finite-state machine */
 	enum applier_state state;
 	/** Local time of this replica when the last row has been received */
@@ -105,6 +114,16 @@ struct applier {
 	struct ev_io io;
 	/** Input buffer */
 	struct ibuf ibuf;
+	/**
+	 * Set if the master sends the rows in a compressed
+	 * stream, negotiated on SUBSCRIBE.
+	 */
+	bool is_compressed;
+	/**
+	 * Compressed stream of rows, valid if is_compressed is
+	 * set. The rows are decompressed to the input buffer.
+	 */
+	struct xrow_zstd_reader zreader;
 	/** Triggers invoked on state change */
 	struct rlist on_state;
 	/**
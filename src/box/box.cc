@@ -58,6 +58,7 @@
 #include "index.h"
 #include "port.h"
 #include "txn.h"
+#include "commit_latency.h"
 #include "user.h"
 #include "cfg.h"
 #include "coio.h"
@@ -193,8 +194,13 @@ box_process_rw(struct request *request, struct space *space,
 	 */
 	tuple_ref(tuple);
 	int rc = txn_commit_stmt(txn, request);
-	if (rc == 0)
-		tuple_bless(tuple);
+	if (rc == 0) {
+		*result = tuple_decompress(tuple);
+		if (*result != NULL)
+			tuple_bless(*result);
+		else
+			rc = -1;
+	}
 	tuple_unref(tuple);
 	return rc;
 }
@@ -404,6 +410,17 @@ box_check_replication_timeout(void)
 	return timeout;
 }
 
+static double
+box_check_replication_ack_interval(void)
+{
+	double interval = cfg_getd("replication_ack_interval");
+	if (interval < 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_ack_interval",
+			  "the value must be greater or equal to 0");
+	}
+	return interval;
+}
+
 static double
 box_check_replication_connect_timeout(void)
 {
@@ -449,6 +466,38 @@ box_check_replication_sync_timeout(void)
 	return timeout;
 }
 
+/**
+ * Parse box.cfg.replication_space_filter into a sorted array
+ * of space ids. Return NULL if the option isn't set.
+ */
+static uint32_t *
+box_check_replication_space_filter(uint32_t *count)
+{
+	*count = cfg_getarr_size("replication_space_filter");
+	if (*count == 0)
+		return NULL;
+	size_t size = *count * sizeof(uint32_t);
+	uint32_t *space_ids = (uint32_t *) malloc(size);
+	if (space_ids == NULL)
+		tnt_raise(OutOfMemory, size, "malloc", "space_ids");
+	for (uint32_t i = 0; i < *count; i++) {
+		const char *str = cfg_getarr_elem("replication_space_filter",
+						  i);
+		char *end = NULL;
+		long long id = str != NULL ? strtoll(str, &end, 10) : -1;
+		if (end == str || *end != '\0' || id < 0 ||
+		    id > BOX_SPACE_MAX) {
+			free(space_ids);
+			tnt_raise(ClientError, ER_CFG,
+				  "replication_space_filter",
+				  "expected an array of space ids");
+		}
+		space_ids[i] = id;
+	}
+	qsort(space_ids, *count, sizeof(*space_ids), xrow_cmp_space_id);
+	return space_ids;
+}
+
 static void
 box_check_instance_uuid(struct tt_uuid *uuid)
 {
@@ -497,6 +546,74 @@ box_check_checkpoint_count(int checkpoint_count)
 	}
 }
 
+static void
+box_check_memtx_delta_checkpoint_count(int count)
+{
+	if (count < 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_delta_checkpoint_count",
+			  "the value must not be less than zero");
+	}
+}
+
+static void
+box_check_memtx_checkpoint_threads(int threads)
+{
+	if (threads < 1) {
+		tnt_raise(ClientError, ER_CFG, "memtx_checkpoint_threads",
+			  "must be greater than or equal to 1");
+	}
+}
+
+static void
+box_check_sql_sorter_threads(int threads)
+{
+	if (threads < 0 || threads > SQL_SORTER_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "sql_sorter_threads",
+			  tt_sprintf("must be between 0 and %d",
+				     SQL_SORTER_THREADS_MAX));
+	}
+}
+
+static void
+box_check_sql_scan_partitions(int count)
+{
+	if (count < 0 || count > SQL_SCAN_PARTITIONS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "sql_scan_partitions",
+			  tt_sprintf("must be between 0 and %d",
+				     SQL_SCAN_PARTITIONS_MAX));
+	}
+}
+
+static int64_t
+box_check_sql_hash_join_memory(int64_t memory)
+{
+	if (memory < 0) {
+		tnt_raise(ClientError, ER_CFG, "sql_hash_join_memory",
+			  "must not be less than 0");
+	}
+	return memory;
+}
+
+static void
+box_check_compression_level(const char *option, int level)
+{
+	if (level < 0 || level > XLOG_COMPRESSION_LEVEL_MAX) {
+		tnt_raise(ClientError, ER_CFG, option,
+			  tt_sprintf("must be between 0 and %d",
+				     XLOG_COMPRESSION_LEVEL_MAX));
+	}
+}
+
+static void
+box_check_wal_compression_threads(int threads)
+{
+	if (threads < 0 || threads > XLOG_COMPRESSION_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "wal_compression_threads",
+			  tt_sprintf("must be between 0 and %d",
+				     XLOG_COMPRESSION_THREADS_MAX));
+	}
+}
+
 static int64_t
 box_check_wal_max_rows(int64_t wal_max_rows)
 {
@@ -589,17 +706,33 @@ box_check_config()
 	box_check_replicaset_uuid(&uuid);
 	box_check_replication();
 	box_check_replication_timeout();
+	box_check_replication_ack_interval();
 	box_check_replication_connect_timeout();
 	box_check_replication_connect_quorum();
 	box_check_replication_sync_lag();
 	box_check_replication_sync_timeout();
+	uint32_t space_filter_size;
+	free(box_check_replication_space_filter(&space_filter_size));
 	box_check_readahead(cfg_geti("readahead"));
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_compression_level("wal_compression_level",
+				    cfg_geti("wal_compression_level"));
+	box_check_wal_compression_threads(cfg_geti("wal_compression_threads"));
+	box_check_compression_level("memtx_compression_level",
+				    cfg_geti("memtx_compression_level"));
+	box_check_compression_level("vinyl_compression_level",
+				    cfg_geti("vinyl_compression_level"));
 	box_check_memtx_memory(cfg_geti64("memtx_memory"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_delta_checkpoint_count(
+		cfg_geti("memtx_delta_checkpoint_count"));
+	box_check_memtx_checkpoint_threads(cfg_geti("memtx_checkpoint_threads"));
+	box_check_sql_sorter_threads(cfg_geti("sql_sorter_threads"));
+	box_check_sql_scan_partitions(cfg_geti("sql_scan_partitions"));
+	box_check_sql_hash_join_memory(cfg_geti64("sql_hash_join_memory"));
 	box_check_vinyl_options();
 }
 
@@ -690,6 +823,12 @@ box_set_replication_timeout(void)
 	replication_timeout = box_check_replication_timeout();
 }
 
+void
+box_set_replication_ack_interval(void)
+{
+	replication_ack_interval = box_check_replication_ack_interval();
+}
+
 void
 box_set_replication_connect_timeout(void)
 {
@@ -722,6 +861,28 @@ box_set_replication_skip_conflict(void)
 	replication_skip_conflict = cfg_geti("replication_skip_conflict");
 }
 
+void
+box_set_replication_compression(void)
+{
+	replication_compression = cfg_geti("replication_compression");
+}
+
+void
+box_set_replication_join_files(void)
+{
+	replication_join_files = cfg_geti("replication_join_files");
+}
+
+void
+box_set_replication_space_filter(void)
+{
+	uint32_t count;
+	uint32_t *space_ids = box_check_replication_space_filter(&count);
+	free(replication_space_filter);
+	replication_space_filter = space_ids;
+	replication_space_filter_size = count;
+}
+
 void
 box_listen(void)
 {
@@ -785,6 +946,39 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_memtx_delta_checkpoint_count(void)
+{
+	int count = cfg_geti("memtx_delta_checkpoint_count");
+	box_check_memtx_delta_checkpoint_count(count);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_delta_checkpoint_count(memtx, count);
+}
+
+void
+box_set_memtx_checkpoint_threads(void)
+{
+	int threads = cfg_geti("memtx_checkpoint_threads");
+	box_check_memtx_checkpoint_threads(threads);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_checkpoint_threads(memtx, threads);
+}
+
+void
+box_set_memtx_compression_level(void)
+{
+	int level = cfg_geti("memtx_compression_level");
+	box_check_compression_level("memtx_compression_level", level);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_compression_level(memtx, level);
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -826,6 +1020,16 @@ box_set_checkpoint_wal_threshold(void)
 	wal_set_checkpoint_threshold(threshold);
 }
 
+void
+box_set_wal_compression(void)
+{
+	int level = cfg_geti("wal_compression_level");
+	box_check_compression_level("wal_compression_level", level);
+	int threads = cfg_geti("wal_compression_threads");
+	box_check_wal_compression_threads(threads);
+	wal_set_compression(level, threads);
+}
+
 void
 box_set_vinyl_memory(void)
 {
@@ -864,6 +1068,17 @@ box_set_vinyl_timeout(void)
 	vinyl_engine_set_timeout(vinyl,	cfg_getd("vinyl_timeout"));
 }
 
+void
+box_set_vinyl_compression_level(void)
+{
+	int level = cfg_geti("vinyl_compression_level");
+	box_check_compression_level("vinyl_compression_level", level);
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_compression_level(vinyl, level);
+}
+
 void
 box_set_net_msg_max(void)
 {
@@ -874,6 +1089,30 @@ box_set_net_msg_max(void)
 				IPROTO_FIBER_POOL_SIZE_FACTOR);
 }
 
+void
+box_set_sql_sorter_threads(void)
+{
+	int threads = cfg_geti("sql_sorter_threads");
+	box_check_sql_sorter_threads(threads);
+	sql_set_sorter_threads(threads);
+}
+
+void
+box_set_sql_scan_partitions(void)
+{
+	int count = cfg_geti("sql_scan_partitions");
+	box_check_sql_scan_partitions(count);
+	sql_set_scan_partitions(count);
+}
+
+void
+box_set_sql_hash_join_memory(void)
+{
+	int64_t memory = box_check_sql_hash_join_memory(
+		cfg_geti64("sql_hash_join_memory"));
+	sql_set_hash_join_memory(memory);
+}
+
 /* }}} configuration bindings */
 
 /**
@@ -1071,6 +1310,11 @@ box_select(uint32_t space_id, uint32_t index_id,
 			offset--;
 			continue;
 		}
+		tuple = tuple_decompress(tuple);
+		if (tuple == NULL) {
+			rc = -1;
+			break;
+		}
 		rc = port_tuple_add(port, tuple);
 		if (rc != 0)
 			break;
@@ -1376,11 +1620,19 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *
 	 * Replica => Master
 	 *
-	 * => JOIN { INSTANCE_UUID: replica_uuid }
-	 * <= OK { VCLOCK: start_vclock }
+	 * => JOIN { INSTANCE_UUID: replica_uuid, JOIN_MODE: mode }
+	 * <= OK { VCLOCK: start_vclock, JOIN_MODE: mode }
 	 *    Replica has enough permissions and master is ready for JOIN.
 	 *     - start_vclock - vclock of the latest master's checkpoint.
+	 *     - mode - optional, see enum iproto_join_mode. The master
+	 *     confirms the mode it is going to use, if not ROWS.
 	 *
+	 * <= FILE { FILE_NAME: name, FILE_SIZE: size } <file contents>
+	 *    ...
+	 *    Initial data in FILES mode: checkpoint files of engines
+	 *    which support it, e.g. the memtx snapshot and the ones it
+	 *    is a delta of, sent as is.
+	 *    ...
 	 * <= INSERT
 	 *    ...
 	 *    Initial data: a stream of engine-specifc rows, e.g. snapshot
@@ -1415,7 +1667,11 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 
 	/* Decode JOIN request */
 	struct tt_uuid instance_uuid = uuid_nil;
-	xrow_decode_join_xc(header, &instance_uuid);
+	uint32_t join_mode = IPROTO_JOIN_MODE_ROWS;
+	xrow_decode_join_xc(header, &instance_uuid, &join_mode);
+	/* Fall back on rows if the mode is unknown. */
+	if (join_mode != IPROTO_JOIN_MODE_FILES)
+		join_mode = IPROTO_JOIN_MODE_ROWS;
 
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
@@ -1472,17 +1728,18 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 
 	/* Respond to JOIN request with start_vclock. */
 	struct xrow_header row;
-	xrow_encode_vclock_xc(&row, &start_vclock);
+	xrow_encode_join_response_xc(&row, &start_vclock, join_mode);
 	row.sync = header->sync;
 	coio_write_xrow(io, &row);
 
-	say_info("joining replica %s at %s",
-		 tt_uuid_str(&instance_uuid), sio_socketname(io->fd));
+	say_info("joining replica %s at %s%s",
+		 tt_uuid_str(&instance_uuid), sio_socketname(io->fd),
+		 join_mode == IPROTO_JOIN_MODE_FILES ? " with files" : "");
 
 	/*
 	 * Initial stream: feed replica with dirty data from engines.
 	 */
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	relay_initial_join(io->fd, header->sync, &start_vclock, join_mode);
 	say_info("initial data sent.");
 
 	/**
@@ -1539,9 +1796,20 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	struct tt_uuid replicaset_uuid = uuid_nil, replica_uuid = uuid_nil;
 	struct vclock replica_clock;
 	uint32_t replica_version_id;
+	uint32_t compression = IPROTO_COMPRESSION_NONE;
+	const char *space_filter = NULL;
 	vclock_create(&replica_clock);
 	xrow_decode_subscribe_xc(header, &replicaset_uuid, &replica_uuid,
-				 &replica_clock, &replica_version_id);
+				 &replica_clock, &replica_version_id,
+				 &compression, &space_filter);
+	/*
+	 * Confirm the compression requested by the replica in
+	 * the response, unless it is unknown to us. Replicas
+	 * which didn't get a confirmation, including the ones
+	 * connected to an older master, expect plain rows.
+	 */
+	if (compression != IPROTO_COMPRESSION_ZSTD)
+		compression = IPROTO_COMPRESSION_NONE;
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -1585,7 +1853,8 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * the additional field.
 	 */
 	struct xrow_header row;
-	xrow_encode_subscribe_response_xc(&row, &REPLICASET_UUID, &vclock);
+	xrow_encode_subscribe_response_xc(&row, &REPLICASET_UUID, &vclock,
+					  compression);
 	/*
 	 * Identify the message with the replica id of this
 	 * instance, this is the only way for a replica to find
@@ -1615,7 +1884,8 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * indefinitely).
 	 */
 	relay_subscribe(replica, io->fd, header->sync, &replica_clock,
-			replica_version_id);
+			replica_version_id,
+			compression == IPROTO_COMPRESSION_ZSTD, space_filter);
 }
 
 void
@@ -1664,6 +1934,7 @@ box_free(void)
 		gc_free();
 		engine_shutdown();
 		wal_free();
+		commit_latency_free();
 	}
 }
 
@@ -1684,6 +1955,9 @@ engine_init()
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_delta_checkpoint_count();
+	box_set_memtx_checkpoint_threads();
+	box_set_memtx_compression_level();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -1701,6 +1975,7 @@ engine_init()
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
 	box_set_vinyl_timeout();
+	box_set_vinyl_compression_level();
 }
 
 /**
@@ -1954,7 +2229,13 @@ local_recovery(const struct tt_uuid *instance_uuid,
 	memtx_engine_recover_snapshot_xc(memtx, checkpoint_vclock);
 
 	engine_begin_final_recovery_xc();
+	/*
+	 * The initial replay reads all WALs to the end, so
+	 * it's worth reading them ahead in a separate thread.
+	 */
+	recovery->read_ahead = true;
 	recover_remaining_wals(recovery, &wal_stream.base, NULL, false);
+	recovery->read_ahead = false;
 	/*
 	 * Leave hot standby mode, if any, only after
 	 * acquiring the lock.
@@ -2065,6 +2346,8 @@ box_cfg_xc(void)
 
 	rmean_box = rmean_new(iproto_type_strs, IPROTO_TYPE_STAT_MAX);
 	rmean_error = rmean_new(rmean_error_strings, RMEAN_ERROR_LAST);
+	if (commit_latency_init() != 0)
+		diag_raise();
 
 	gc_init();
 	engine_init();
@@ -2077,11 +2360,13 @@ box_cfg_xc(void)
 	int64_t wal_max_rows = box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	int64_t wal_max_size = box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
-	if (wal_init(wal_mode, cfg_gets("wal_dir"), wal_max_rows,
-		     wal_max_size, &INSTANCE_UUID, on_wal_garbage_collection,
+	if (wal_init(wal_mode, cfg_getb("wal_direct_io"), cfg_gets("wal_dir"),
+		     wal_max_rows, wal_max_size, &INSTANCE_UUID,
+		     on_wal_garbage_collection,
 		     on_wal_checkpoint_threshold) != 0) {
 		diag_raise();
 	}
+	box_set_wal_compression();
 
 	title("loading");
 
@@ -2090,14 +2375,21 @@ box_cfg_xc(void)
 	box_check_replicaset_uuid(&replicaset_uuid);
 
 	box_set_net_msg_max();
+	box_set_sql_sorter_threads();
+	box_set_sql_scan_partitions();
+	box_set_sql_hash_join_memory();
 	box_set_readahead();
 	box_set_too_long_threshold();
 	box_set_replication_timeout();
+	box_set_replication_ack_interval();
 	box_set_replication_connect_timeout();
 	box_set_replication_connect_quorum();
 	box_set_replication_sync_lag();
 	box_set_replication_sync_timeout();
 	box_set_replication_skip_conflict();
+	box_set_replication_compression();
+	box_set_replication_join_files();
+	box_set_replication_space_filter();
 
 	struct gc_checkpoint *checkpoint = gc_last_checkpoint();
 
@@ -2243,6 +2535,7 @@ box_reset_stat(void)
 {
 	rmean_cleanup(rmean_box);
 	rmean_cleanup(rmean_error);
+	commit_latency_reset();
 	engine_reset_stat();
 	space_foreach(box_reset_space_stat, NULL);
 }
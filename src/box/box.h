@@ -199,19 +199,31 @@ void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
+void box_set_wal_compression(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_delta_checkpoint_count(void);
+void box_set_memtx_checkpoint_threads(void);
+void box_set_memtx_compression_level(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
 void box_set_vinyl_timeout(void);
+void box_set_vinyl_compression_level(void);
 void box_set_replication_timeout(void);
+void box_set_replication_ack_interval(void);
 void box_set_replication_connect_timeout(void);
 void box_set_replication_connect_quorum(void);
 void box_set_replication_sync_lag(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
+void box_set_replication_compression(void);
+void box_set_replication_join_files(void);
+void box_set_replication_space_filter(void);
 void box_set_net_msg_max(void);
+void box_set_sql_sorter_threads(void);
+void box_set_sql_scan_partitions(void);
+void box_set_sql_hash_join_memory(void);
 
 extern "C" {
 #endif /* defined(__cplusplus) */
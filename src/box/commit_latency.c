@@ -0,0 +1,106 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "commit_latency.h"
+
+#include <assert.h>
+
+#include "latency.h"
+#include "diag.h"
+#include "error.h"
+#include "info/info.h"
+#include "trivia/util.h"
+
+static const char *commit_stage_strs[] = {
+	"iproto_queue",
+	"txn",
+	"wal_queue",
+	"wal_write",
+	"wal_return",
+	"total",
+};
+
+static_assert(lengthof(commit_stage_strs) == commit_stage_MAX,
+	      "commit_stage_strs must match enum commit_stage");
+
+static struct latency commit_latency[commit_stage_MAX];
+
+int
+commit_latency_init(void)
+{
+	for (int i = 0; i < commit_stage_MAX; i++) {
+		if (latency_create(&commit_latency[i]) != 0) {
+			while (--i >= 0)
+				latency_destroy(&commit_latency[i]);
+			diag_set(OutOfMemory, 0, "histogram_new",
+				 "commit latency");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void
+commit_latency_free(void)
+{
+	for (int i = 0; i < commit_stage_MAX; i++)
+		latency_destroy(&commit_latency[i]);
+}
+
+void
+commit_latency_reset(void)
+{
+	for (int i = 0; i < commit_stage_MAX; i++)
+		latency_reset(&commit_latency[i]);
+}
+
+void
+commit_latency_collect(enum commit_stage stage, double value)
+{
+	assert(stage < commit_stage_MAX);
+	latency_collect(&commit_latency[stage], value);
+}
+
+void
+commit_latency_stat(struct info_handler *h)
+{
+	info_begin(h);
+	for (int i = 0; i < commit_stage_MAX; i++) {
+		struct latency *latency = &commit_latency[i];
+		info_table_begin(h, commit_stage_strs[i]);
+		info_append_double(h, "p50", latency_get(latency, 50));
+		info_append_double(h, "p75", latency_get(latency, 75));
+		info_append_double(h, "p90", latency_get(latency, 90));
+		info_append_double(h, "p95", latency_get(latency, 95));
+		info_append_double(h, "p99", latency_get(latency, 99));
+		info_table_end(h);
+	}
+	info_end(h);
+}
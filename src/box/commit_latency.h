@@ -0,0 +1,98 @@
+#ifndef TARANTOOL_BOX_COMMIT_LATENCY_H_INCLUDED
+#define TARANTOOL_BOX_COMMIT_LATENCY_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct info_handler;
+
+/**
+ * Stages a request passes on its way to commit. The time spent
+ * in each of them is collected into a separate histogram, so
+ * that it's possible to tell where a slow commit spends time.
+ * The boundaries are taken with clock_monotonic(), since some
+ * of them are crossed in the WAL thread.
+ */
+enum commit_stage {
+	/**
+	 * From iproto thread to the beginning of processing in
+	 * tx. Only DML requests are accounted, so that reads,
+	 * calls and SQL, which may commit nothing, don't dilute
+	 * the histogram.
+	 */
+	COMMIT_STAGE_IPROTO_QUEUE,
+	/** From txn_begin() to the submission to the journal. */
+	COMMIT_STAGE_TXN,
+	/** From the submission to the WAL thread taking the batch. */
+	COMMIT_STAGE_WAL_QUEUE,
+	/** Writing the batch, including sync in 'fsync' WAL mode. */
+	COMMIT_STAGE_WAL_WRITE,
+	/** From the end of the write to the wakeup of the fiber. */
+	COMMIT_STAGE_WAL_RETURN,
+	/** From txn_begin() to the wakeup after the WAL write. */
+	COMMIT_STAGE_TOTAL,
+	commit_stage_MAX,
+};
+
+/**
+ * Initialize the commit latency histograms.
+ * Return 0 on success, -1 on OOM (diag is set).
+ */
+int
+commit_latency_init(void);
+
+/** Free the commit latency histograms. */
+void
+commit_latency_free(void);
+
+/** Reset the commit latency histograms. */
+void
+commit_latency_reset(void);
+
+/**
+ * Account the time spent in a stage, in seconds.
+ * Must be called from the tx thread.
+ */
+void
+commit_latency_collect(enum commit_stage stage, double value);
+
+/** Dump percentiles of the time spent in each stage. */
+void
+commit_latency_stat(struct info_handler *h);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_COMMIT_LATENCY_H_INCLUDED */
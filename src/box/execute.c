@@ -385,6 +385,27 @@ port_sql_dump_msgpack(struct port *port, struct obuf *out)
 	return 0;
 }
 
+/**
+ * Pass the rows collected in @a port to @a on_chunk and release
+ * them.
+ * @param port Port with SQL response.
+ * @param on_chunk Callback to send the rows.
+ * @param ctx Context for @a on_chunk.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error.
+ */
+static int
+port_sql_flush_chunk(struct port *port, sql_chunk_f on_chunk, void *ctx)
+{
+	struct sql_stmt *stmt = ((struct port_sql *)port)->stmt;
+	port->vtab = &port_tuple_vtab;
+	int rc = on_chunk(port, ctx);
+	port_tuple_vtab.destroy(port);
+	port_sql_create(port, stmt);
+	return rc;
+}
+
 /**
  * Execute prepared SQL statement.
  *
@@ -396,13 +417,18 @@ port_sql_dump_msgpack(struct port *port, struct obuf *out)
  * @param stmt Prepared statement.
  * @param port Port to store SQL response.
  * @param region Region to allocate temporary objects.
+ * @param chunk_size Count of rows to pass to @a on_chunk at
+ *        once, 0 to store all the rows in @a port.
+ * @param on_chunk Callback to send a part of the result set.
+ * @param ctx Context for @a on_chunk.
  *
  * @retval  0 Success.
  * @retval -1 Error.
  */
 static inline int
 sql_execute(sql *db, struct sql_stmt *stmt, struct port *port,
-	    struct region *region)
+	    struct region *region, uint32_t chunk_size, sql_chunk_f on_chunk,
+	    void *ctx)
 {
 	int rc, column_count = sql_column_count(stmt);
 	if (column_count > 0) {
@@ -411,6 +437,10 @@ sql_execute(sql *db, struct sql_stmt *stmt, struct port *port,
 			if (sql_row_to_port(stmt, column_count, region,
 					    port) != 0)
 				return -1;
+			if (chunk_size != 0 &&
+			    ((struct port_tuple *)port)->size == chunk_size &&
+			    port_sql_flush_chunk(port, on_chunk, ctx) != 0)
+				return -1;
 		}
 		assert(rc == SQL_DONE || rc != SQL_OK);
 	} else {
@@ -434,6 +464,17 @@ int
 sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 			uint32_t bind_count, struct port *port,
 			struct region *region)
+{
+	return sql_prepare_and_execute_chunked(sql, len, bind, bind_count, 0,
+					       NULL, NULL, port, region);
+}
+
+int
+sql_prepare_and_execute_chunked(const char *sql, int len,
+				const struct sql_bind *bind,
+				uint32_t bind_count, uint32_t chunk_size,
+				sql_chunk_f on_chunk, void *ctx,
+				struct port *port, struct region *region)
 {
 	struct sql_stmt *stmt;
 	struct sql *db = sql_get();
@@ -449,7 +490,8 @@ sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 	assert(stmt != NULL);
 	port_sql_create(port, stmt);
 	if (sql_bind(stmt, bind, bind_count) == 0 &&
-	    sql_execute(db, stmt, port, region) == 0)
+	    sql_execute(db, stmt, port, region, chunk_size, on_chunk,
+			ctx) == 0)
 		return 0;
 	port_destroy(port);
 	return -1;
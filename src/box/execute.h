@@ -51,6 +51,18 @@ extern const char *sql_info_key_strs[];
 struct region;
 struct sql_bind;
 
+/**
+ * Callback which sends a part of a result set before the
+ * statement is done.
+ * @param port port_tuple with the rows of the part. The rows
+ *        are released after the callback returns.
+ * @param ctx Context passed to sql_prepare_and_execute_chunked().
+ *
+ * @retval  0 Success.
+ * @retval -1 Error, the statement is aborted.
+ */
+typedef int (*sql_chunk_f)(struct port *port, void *ctx);
+
 /**
  * Prepare and execute an SQL statement.
  * @param sql SQL statement.
@@ -69,6 +81,27 @@ sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 			uint32_t bind_count, struct port *port,
 			struct region *region);
 
+/**
+ * Prepare and execute an SQL statement, passing the result set
+ * to @a on_chunk by parts of @a chunk_size rows as soon as they
+ * are produced. The rows which are left when the statement is
+ * done stay in @a port along with the metadata. The callback may
+ * yield.
+ * @param chunk_size Count of rows in a part. 0 means that all
+ *        the rows are stored in @a port.
+ * @param on_chunk Callback to send a part of the result set.
+ * @param ctx Context for @a on_chunk.
+ *
+ * The other parameters and the return value are the same as
+ * for sql_prepare_and_execute().
+ */
+int
+sql_prepare_and_execute_chunked(const char *sql, int len,
+				const struct sql_bind *bind,
+				uint32_t bind_count, uint32_t chunk_size,
+				sql_chunk_f on_chunk, void *ctx,
+				struct port *port, struct region *region);
+
 /**
  * Port implementation that is used to store SQL responses and
  * output them to obuf or Lua. This port implementation is
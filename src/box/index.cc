@@ -212,8 +212,12 @@ box_index_random(uint32_t space_id, uint32_t index_id, uint32_t rnd,
 	/* No tx management, random() is for approximation anyway. */
 	if (index_random(index, rnd, result) != 0)
 		return -1;
-	if (*result != NULL)
+	if (*result != NULL) {
+		*result = tuple_decompress(*result);
+		if (*result == NULL)
+			return -1;
 		tuple_bless(*result);
+	}
 	return 0;
 }
 
@@ -245,8 +249,12 @@ box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	txn_commit_ro_stmt(txn);
 	/* Count statistics. */
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
-	if (*result != NULL)
+	if (*result != NULL) {
+		*result = tuple_decompress(*result);
+		if (*result == NULL)
+			return -1;
 		tuple_bless(*result);
+	}
 	return 0;
 }
 
@@ -277,8 +285,12 @@ box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
-	if (*result != NULL)
+	if (*result != NULL) {
+		*result = tuple_decompress(*result);
+		if (*result == NULL)
+			return -1;
 		tuple_bless(*result);
+	}
 	return 0;
 }
 
@@ -309,8 +321,12 @@ box_index_max(uint32_t space_id, uint32_t index_id, const char *key,
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
-	if (*result != NULL)
+	if (*result != NULL) {
+		*result = tuple_decompress(*result);
+		if (*result == NULL)
+			return -1;
 		tuple_bless(*result);
+	}
 	return 0;
 }
 
@@ -389,8 +405,12 @@ box_iterator_next(box_iterator_t *itr, box_tuple_t **result)
 	assert(result != NULL);
 	if (iterator_next(itr, result) != 0)
 		return -1;
-	if (*result != NULL)
+	if (*result != NULL) {
+		*result = tuple_decompress(*result);
+		if (*result == NULL)
+			return -1;
 		tuple_bless(*result);
+	}
 	return 0;
 }
 
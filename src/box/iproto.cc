@@ -61,6 +61,9 @@
 #include "iproto_constants.h"
 #include "rmean.h"
 #include "execute.h"
+#include "txn.h"
+#include "commit_latency.h"
+#include "clock.h"
 #include "errinj.h"
 
 enum {
@@ -68,6 +71,12 @@ enum {
 	IPROTO_PACKET_SIZE_MAX = 2UL * 1024 * 1024 * 1024,
 };
 
+/**
+ * How long a request streaming its response sleeps when the
+ * socket is not writable, before checking the output again.
+ */
+static const double IPROTO_OUTPUT_POLL_TIMEOUT = 0.001;
+
 /**
  * A position in connection output buffer.
  * Since we use rotating buffers to recycle memory,
@@ -187,6 +196,12 @@ struct iproto_msg
 	 * discarded only when the message returns to iproto thread.
 	 */
 	struct ibuf *p_ibuf;
+	/**
+	 * Monotonic time when the request was pushed to the tx
+	 * thread, used to account the time a DML request spends
+	 * in the queue.
+	 */
+	double recv_time;
 	/**
 	 * How much space the request takes in the
 	 * input buffer (len, header and body - all of it)
@@ -309,6 +324,13 @@ iproto_process_push(struct cmsg *m);
 static void
 tx_end_push(struct cmsg *m);
 
+/**
+ * Send to iproto thread a notification about new pushes.
+ * @param con iproto connection.
+ */
+static void
+tx_begin_push(struct iproto_connection *con);
+
 static const struct cmsg_hop push_route[] = {
 	{ iproto_process_push, &tx_pipe },
 	{ tx_end_push, NULL }
@@ -471,6 +493,15 @@ struct iproto_connection
 		 * return.
 		 */
 		bool is_push_pending;
+		/** True if the client has disconnected. */
+		bool is_disconnected;
+		/**
+		 * Signaled when Kharon returns to tx or the
+		 * client disconnects. SQL requests streaming a
+		 * result set wait on it for the output to be
+		 * written to the socket.
+		 */
+		struct fiber_cond push_cond;
 	} tx;
 	/** Authentication salt. */
 	char salt[IPROTO_SALT_SIZE];
@@ -769,6 +800,7 @@ err_msgpack:
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
+		msg->recv_time = clock_monotonic();
 		cpipe_push_input(&tx_pipe, &msg->base);
 		n_requests++;
 		/* Request is parsed */
@@ -1032,6 +1064,8 @@ iproto_connection_new(int fd)
 	con->is_destroy_sent = false;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
+	con->tx.is_disconnected = false;
+	fiber_cond_create(&con->tx.push_cond);
 	return con;
 }
 
@@ -1252,6 +1286,8 @@ tx_process_disconnect(struct cmsg *m)
 {
 	struct iproto_connection *con =
 		container_of(m, struct iproto_connection, disconnect_msg);
+	con->tx.is_disconnected = true;
+	fiber_cond_broadcast(&con->tx.push_cond);
 	if (con->session != NULL) {
 		session_close(con->session);
 		if (! rlist_empty(&session_on_disconnect)) {
@@ -1280,6 +1316,7 @@ tx_process_destroy(struct cmsg *m)
 	 */
 	obuf_destroy(&con->obuf[0]);
 	obuf_destroy(&con->obuf[1]);
+	fiber_cond_destroy(&con->tx.push_cond);
 }
 
 /**
@@ -1420,6 +1457,8 @@ static void
 tx_process1(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
+	commit_latency_collect(COMMIT_STAGE_IPROTO_QUEUE,
+			       clock_monotonic() - msg->recv_time);
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
 
@@ -1617,6 +1656,121 @@ error:
 	tx_reply_error(msg);
 }
 
+/**
+ * Size of the connection output which is not written to the
+ * socket yet, according to the write position Kharon has
+ * brought back from iproto thread.
+ */
+static inline size_t
+tx_unflushed_size(struct iproto_connection *con)
+{
+	assert(! con->tx.is_push_sent);
+	const struct iproto_wpos *wpos = &con->kharon.wpos;
+	/*
+	 * The buffer filled before the one being written is
+	 * reset by tx_accept_wpos(), so the position counts
+	 * from the beginning of the output.
+	 */
+	size_t size = obuf_size(&con->obuf[0]) + obuf_size(&con->obuf[1]);
+	return size > wpos->svp.used ? size - wpos->svp.used : 0;
+}
+
+/**
+ * Wait until iproto thread writes to the socket all the output
+ * of the connection but the last @a size bytes.
+ * @param con iproto connection.
+ * @param size Count of bytes which may stay in the output.
+ *
+ * @retval  0 Success.
+ * @retval -1 The client has disconnected, the fiber is
+ *            cancelled or the schema has changed.
+ */
+static int
+tx_wait_output(struct iproto_connection *con, size_t size)
+{
+	uint32_t old_schema_version = ::schema_version;
+	size_t prev_unflushed = SIZE_MAX;
+	while (true) {
+		if (con->tx.is_disconnected) {
+			diag_set(ClientError, ER_SESSION_CLOSED);
+			return -1;
+		}
+		if (con->tx.is_push_sent) {
+			if (fiber_cond_wait(&con->tx.push_cond) != 0)
+				return -1;
+			continue;
+		}
+		size_t unflushed = tx_unflushed_size(con);
+		if (unflushed <= size)
+			break;
+		/*
+		 * Nothing was written since the previous trip
+		 * of Kharon, so the socket is not writable. Give
+		 * the client some time rather than bounce Kharon
+		 * back and forth.
+		 */
+		if (unflushed == prev_unflushed) {
+			fiber_sleep(IPROTO_OUTPUT_POLL_TIMEOUT);
+			if (fiber_is_cancelled()) {
+				diag_set(FiberIsCancelled);
+				return -1;
+			}
+			prev_unflushed = SIZE_MAX;
+			continue;
+		}
+		prev_unflushed = unflushed;
+		tx_begin_push(con);
+	}
+	/*
+	 * The statement refers to spaces and indexes, which
+	 * could have been dropped during the yield.
+	 */
+	if (old_schema_version != ::schema_version) {
+		diag_set(ClientError, ER_WRONG_SCHEMA_VERSION,
+			 ::schema_version, old_schema_version);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Send a part of an SQL result set to the client in an
+ * IPROTO_CHUNK response. Then wait until the previous parts are
+ * written to the socket, so that the output of a big result set
+ * is bounded by two parts.
+ * @param port port_tuple with rows.
+ * @param ctx iproto message of the request.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error.
+ */
+static int
+tx_process_sql_chunk(struct port *port, void *ctx)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) ctx;
+	struct iproto_connection *con = msg->connection;
+	struct obuf *out = con->tx.p_obuf;
+	struct obuf_svp svp;
+	if (iproto_prepare_select(out, &svp) != 0)
+		return -1;
+	int count = port_dump_msgpack_16(port, out);
+	if (count < 0) {
+		obuf_rollback_to_svp(out, &svp);
+		return -1;
+	}
+	iproto_reply_sql_chunk(out, &svp, msg->header.sync, ::schema_version,
+			       count);
+	size_t size = obuf_size(out) - svp.used;
+	if (! con->tx.is_push_sent)
+		tx_begin_push(con);
+	else
+		con->tx.is_push_pending = true;
+	/* A yield would abort a memtx transaction. */
+	if (in_txn() != NULL)
+		return 0;
+	return tx_wait_output(con, size);
+}
+
 static void
 tx_process_sql(struct cmsg *m)
 {
@@ -1641,8 +1795,10 @@ tx_process_sql(struct cmsg *m)
 	}
 	sql = msg->sql.sql_text;
 	sql = mp_decode_str(&sql, &len);
-	if (sql_prepare_and_execute(sql, len, bind, bind_count, &port,
-				    &fiber()->gc) != 0)
+	if (sql_prepare_and_execute_chunked(sql, len, bind, bind_count,
+					    msg->sql.chunk_size,
+					    tx_process_sql_chunk, msg, &port,
+					    &fiber()->gc) != 0)
 		goto error;
 	/*
 	 * Take an obuf only after execute(). Else the buffer can
@@ -1961,10 +2117,6 @@ iproto_process_push(struct cmsg *m)
 		ev_feed_event(con->loop, &con->output, EV_WRITE);
 }
 
-/**
- * Send to iproto thread a notification about new pushes.
- * @param con iproto connection.
- */
 static void
 tx_begin_push(struct iproto_connection *con)
 {
@@ -1986,6 +2138,7 @@ tx_end_push(struct cmsg *m)
 	con->tx.is_push_sent = false;
 	if (con->tx.is_push_pending)
 		tx_begin_push(con);
+	fiber_cond_broadcast(&con->tx.push_cond);
 }
 
 /**
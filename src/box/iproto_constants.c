@@ -89,6 +89,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* 0x29 */	MP_MAP, /* IPROTO_BALLOT */
 	/* 0x2a */	MP_MAP, /* IPROTO_TUPLE_META */
 	/* 0x2b */	MP_MAP, /* IPROTO_OPTIONS */
+	/* 0x2c */	MP_UINT, /* IPROTO_COMPRESSION */
+	/* 0x2d */	MP_UINT, /* IPROTO_JOIN_MODE */
+	/* 0x2e */	MP_STR, /* IPROTO_FILE_NAME */
+	/* 0x2f */	MP_UINT, /* IPROTO_FILE_SIZE */
 	/* }}} */
 };
 
@@ -172,10 +176,10 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"ballot",           /* 0x29 */
 	"tuple meta",       /* 0x2a */
 	"options",          /* 0x2b */
-	NULL,               /* 0x2c */
-	NULL,               /* 0x2d */
-	NULL,               /* 0x2e */
-	NULL,               /* 0x2f */
+	"compression",      /* 0x2c */
+	"join mode",        /* 0x2d */
+	"file name",        /* 0x2e */
+	"file size",        /* 0x2f */
 	"data",             /* 0x30 */
 	"error",            /* 0x31 */
 	"metadata",         /* 0x32 */
@@ -195,6 +199,20 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"SQL text",         /* 0x40 */
 	"SQL bind",         /* 0x41 */
 	"SQL info",         /* 0x42 */
+	NULL,               /* 0x43 */
+	NULL,               /* 0x44 */
+	NULL,               /* 0x45 */
+	NULL,               /* 0x46 */
+	NULL,               /* 0x47 */
+	NULL,               /* 0x48 */
+	NULL,               /* 0x49 */
+	NULL,               /* 0x4a */
+	NULL,               /* 0x4b */
+	NULL,               /* 0x4c */
+	NULL,               /* 0x4d */
+	NULL,               /* 0x4e */
+	NULL,               /* 0x4f */
+	"space filter",     /* 0x50 */
 };
 
 const char *vy_page_info_key_strs[VY_PAGE_INFO_KEY_MAX] = {
@@ -98,6 +98,21 @@ enum iproto_key {
 	IPROTO_BALLOT = 0x29,
 	IPROTO_TUPLE_META = 0x2a,
 	IPROTO_OPTIONS = 0x2b,
+	/**
+	 * Compression of the replication stream requested in
+	 * SUBSCRIBE and confirmed by its response, see
+	 * enum iproto_compression.
+	 */
+	IPROTO_COMPRESSION = 0x2c,
+	/**
+	 * Way the initial data is sent in response to JOIN,
+	 * requested in JOIN and confirmed by its response, see
+	 * enum iproto_join_mode.
+	 */
+	IPROTO_JOIN_MODE = 0x2d,
+	/** Name and size of a file sent in IPROTO_FILE. */
+	IPROTO_FILE_NAME = 0x2e,
+	IPROTO_FILE_SIZE = 0x2f,
 
 	/* Leave a gap between request keys and response keys */
 	IPROTO_DATA = 0x30,
@@ -120,6 +135,14 @@ enum iproto_key {
 	 * }
 	 */
 	IPROTO_SQL_INFO = 0x42,
+
+	/* Leave a gap between SQL keys and replication keys. */
+	/**
+	 * Ids of the spaces a replica wants to get rows of,
+	 * sent in SUBSCRIBE. Rows of other non-system spaces
+	 * are replaced with NOPs.
+	 */
+	IPROTO_SPACE_FILTER = 0x50,
 	IPROTO_KEY_MAX
 };
 
@@ -133,6 +156,37 @@ enum iproto_metadata_key {
 	IPROTO_FIELD_TYPE = 1,
 };
 
+/**
+ * Keys of IPROTO_OPTIONS map of the EXECUTE request. Unknown
+ * keys are ignored.
+ */
+enum iproto_sql_option_key {
+	/**
+	 * Number of rows to send in each IPROTO_CHUNK response
+	 * before the final one. Zero means the whole result set
+	 * is sent in the final response.
+	 */
+	IPROTO_SQL_OPTION_CHUNK_SIZE = 0,
+};
+
+/** Values of IPROTO_COMPRESSION. */
+enum iproto_compression {
+	IPROTO_COMPRESSION_NONE = 0,
+	/** Frames of a zstd stream, see xrow_zstd_writer. */
+	IPROTO_COMPRESSION_ZSTD = 1,
+};
+
+/** Values of IPROTO_JOIN_MODE. */
+enum iproto_join_mode {
+	/** Every row of the checkpoint is sent separately. */
+	IPROTO_JOIN_MODE_ROWS = 0,
+	/**
+	 * Checkpoint files are sent as is in IPROTO_FILE where
+	 * the engine supports it, rows of other engines follow.
+	 */
+	IPROTO_JOIN_MODE_FILES = 1,
+};
+
 enum iproto_ballot_key {
 	IPROTO_BALLOT_IS_RO = 0x01,
 	IPROTO_BALLOT_VCLOCK = 0x02,
@@ -215,6 +269,11 @@ enum iproto_type {
 	IPROTO_VOTE_DEPRECATED = 67,
 	/** Vote request command for master election */
 	IPROTO_VOTE = 68,
+	/**
+	 * A checkpoint file sent on initial join, followed by
+	 * IPROTO_FILE_SIZE bytes of the file contents.
+	 */
+	IPROTO_FILE = 69,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -223,6 +282,12 @@ enum iproto_type {
 	/** Vinyl row index stored in .run file */
 	VY_RUN_ROW_INDEX = 102,
 
+	/**
+	 * Delta memtx snapshot: data of the space is stored
+	 * in the base snapshot.
+	 */
+	MEMTX_SNAP_BASE_SPACE = 110,
+
 	/** Non-final response type. */
 	IPROTO_CHUNK = 128,
 
@@ -259,6 +324,8 @@ iproto_type_name(uint32_t type)
 		return "PAGEINFO";
 	case VY_RUN_ROW_INDEX:
 		return "ROWINDEX";
+	case MEMTX_SNAP_BASE_SPACE:
+		return "BASESPACE";
 	default:
 		return NULL;
 	}
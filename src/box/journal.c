@@ -67,6 +67,8 @@ journal_entry_new(size_t n_rows)
 		return NULL;
 	}
 	entry->approx_len = 0;
+	entry->write_start_time = 0;
+	entry->write_end_time = 0;
 	entry->n_rows = n_rows;
 	entry->res = -1;
 	entry->fiber = fiber();
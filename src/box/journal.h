@@ -62,6 +62,13 @@ struct journal_entry {
 	 * Approximate size of this request when encoded.
 	 */
 	size_t approx_len;
+	/**
+	 * Monotonic time when the journal started and finished
+	 * writing the request, see commit_latency.h. Zero if the
+	 * journal doesn't track it.
+	 */
+	double write_start_time;
+	double write_end_time;
 	/**
 	 * The number of rows in the request.
 	 */
@@ -186,6 +186,17 @@ lbox_cfg_set_checkpoint_wal_threshold(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_wal_compression(struct lua_State *L)
+{
+	try {
+		box_set_wal_compression();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_read_only(struct lua_State *L)
 {
@@ -219,6 +230,39 @@ lbox_cfg_set_memtx_max_tuple_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_memtx_delta_checkpoint_count(struct lua_State *L)
+{
+	try {
+		box_set_memtx_delta_checkpoint_count();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_memtx_checkpoint_threads(struct lua_State *L)
+{
+	try {
+		box_set_memtx_checkpoint_threads();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_memtx_compression_level(struct lua_State *L)
+{
+	try {
+		box_set_memtx_compression_level();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_memory(struct lua_State *L)
 {
@@ -263,6 +307,17 @@ lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_vinyl_compression_level(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_compression_level();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_net_msg_max(struct lua_State *L)
 {
@@ -274,6 +329,39 @@ lbox_cfg_set_net_msg_max(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_sql_sorter_threads(struct lua_State *L)
+{
+	try {
+		box_set_sql_sorter_threads();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_sql_scan_partitions(struct lua_State *L)
+{
+	try {
+		box_set_sql_scan_partitions();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_sql_hash_join_memory(struct lua_State *L)
+{
+	try {
+		box_set_sql_hash_join_memory();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_worker_pool_threads(struct lua_State *L)
 {
@@ -294,6 +382,17 @@ lbox_cfg_set_replication_timeout(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_replication_ack_interval(struct lua_State *L)
+{
+	try {
+		box_set_replication_ack_interval();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_replication_connect_timeout(struct lua_State *L)
 {
@@ -346,6 +445,33 @@ lbox_cfg_set_replication_skip_conflict(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_replication_compression(struct lua_State *L)
+{
+	(void) L;
+	box_set_replication_compression();
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_join_files(struct lua_State *L)
+{
+	(void) L;
+	box_set_replication_join_files();
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_space_filter(struct lua_State *L)
+{
+	try {
+		box_set_replication_space_filter();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 void
 box_lua_cfg_init(struct lua_State *L)
 {
@@ -364,20 +490,32 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_checkpoint_count", lbox_cfg_set_checkpoint_count},
 		{"cfg_set_checkpoint_interval", lbox_cfg_set_checkpoint_interval},
 		{"cfg_set_checkpoint_wal_threshold", lbox_cfg_set_checkpoint_wal_threshold},
+		{"cfg_set_wal_compression", lbox_cfg_set_wal_compression},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
+		{"cfg_set_memtx_delta_checkpoint_count", lbox_cfg_set_memtx_delta_checkpoint_count},
+		{"cfg_set_memtx_checkpoint_threads", lbox_cfg_set_memtx_checkpoint_threads},
+		{"cfg_set_memtx_compression_level", lbox_cfg_set_memtx_compression_level},
 		{"cfg_set_vinyl_memory", lbox_cfg_set_vinyl_memory},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
+		{"cfg_set_vinyl_compression_level", lbox_cfg_set_vinyl_compression_level},
 		{"cfg_set_replication_timeout", lbox_cfg_set_replication_timeout},
+		{"cfg_set_replication_ack_interval", lbox_cfg_set_replication_ack_interval},
 		{"cfg_set_replication_connect_quorum", lbox_cfg_set_replication_connect_quorum},
 		{"cfg_set_replication_connect_timeout", lbox_cfg_set_replication_connect_timeout},
 		{"cfg_set_replication_sync_lag", lbox_cfg_set_replication_sync_lag},
 		{"cfg_set_replication_sync_timeout", lbox_cfg_set_replication_sync_timeout},
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
+		{"cfg_set_replication_compression", lbox_cfg_set_replication_compression},
+		{"cfg_set_replication_join_files", lbox_cfg_set_replication_join_files},
+		{"cfg_set_replication_space_filter", lbox_cfg_set_replication_space_filter},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
+		{"cfg_set_sql_sorter_threads", lbox_cfg_set_sql_sorter_threads},
+		{"cfg_set_sql_scan_partitions", lbox_cfg_set_sql_scan_partitions},
+		{"cfg_set_sql_hash_join_memory", lbox_cfg_set_sql_hash_join_memory},
 		{NULL, NULL}
 	};
 
@@ -41,6 +41,7 @@
 #include "box/iproto.h"
 #include "box/wal.h"
 #include "box/replication.h"
+#include "box/xrow_io.h"
 #include "info/info.h"
 #include "box/gc.h"
 #include "box/engine.h"
@@ -65,6 +66,20 @@ lbox_pushvclock(struct lua_State *L, const struct vclock *vclock)
 	luaL_setmaphint(L, -1); /* compact flow */
 }
 
+static void
+lbox_pushcompression(struct lua_State *L,
+		     const struct xrow_compression_stat *stat)
+{
+	lua_createtable(L, 0, 2);
+	lua_pushstring(L, "ratio");
+	lua_pushnumber(L, stat->size > 0 ?
+		       (double) stat->raw_size / stat->size : 1);
+	lua_settable(L, -3);
+	lua_pushstring(L, "time");
+	lua_pushnumber(L, stat->time);
+	lua_settable(L, -3);
+}
+
 static void
 lbox_pushapplier(lua_State *L, struct applier *applier)
 {
@@ -102,6 +117,12 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 		lua_pushlstring(L, name, total);
 		lua_settable(L, -3);
 
+		if (applier->is_compressed) {
+			lua_pushstring(L, "compression");
+			lbox_pushcompression(L, &applier->zreader.stat);
+			lua_settable(L, -3);
+		}
+
 		struct error *e = diag_last_error(&applier->reader->diag);
 		if (e != NULL) {
 			lua_pushstring(L, "message");
@@ -128,6 +149,13 @@ lbox_pushrelay(lua_State *L, struct relay *relay)
 		lua_pushnumber(L, ev_monotonic_now(loop()) -
 			       relay_last_row_time(relay));
 		lua_settable(L, -3);
+		const struct xrow_compression_stat *stat =
+			relay_compression_stat(relay);
+		if (stat != NULL) {
+			lua_pushstring(L, "compression");
+			lbox_pushcompression(L, stat);
+			lua_settable(L, -3);
+		}
 		break;
 	case RELAY_STOPPED:
 	{
@@ -39,6 +39,7 @@
 
 #include "box/box.h"
 #include "box/txn.h"
+#include "box/tuple.h"
 #include "box/vclock.h"
 
 #include "box/lua/error.h"
@@ -135,13 +136,20 @@ lbox_txn_iterator_next(struct lua_State *L)
 			return 0;
 		}
 	}
+	struct tuple *old_tuple = NULL, *new_tuple = NULL;
+	if (stmt->old_tuple != NULL &&
+	    (old_tuple = tuple_decompress(stmt->old_tuple)) == NULL)
+		return luaT_error(L);
+	if (stmt->new_tuple != NULL &&
+	    (new_tuple = tuple_decompress(stmt->new_tuple)) == NULL)
+		return luaT_error(L);
 	lua_pushinteger(L, lua_tointeger(L, 2) + 1);
-	if (stmt->old_tuple != NULL)
-		luaT_pushtuple(L, stmt->old_tuple);
+	if (old_tuple != NULL)
+		luaT_pushtuple(L, old_tuple);
 	else
 		lua_pushnil(L);
-	if (stmt->new_tuple != NULL)
-		luaT_pushtuple(L, stmt->new_tuple);
+	if (new_tuple != NULL)
+		luaT_pushtuple(L, new_tuple);
 	else
 		lua_pushnil(L);
 	lua_pushinteger(L, space_id(stmt->space));
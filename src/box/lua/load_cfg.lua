@@ -27,6 +27,9 @@ local default_cfg = {
     memtx_memory        = 256 * 1024 *1024,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_delta_checkpoint_count = 0,
+    memtx_checkpoint_threads = 1,
+    memtx_compression_level = 3,
     slab_alloc_factor   = 1.05,
     work_dir            = nil,
     memtx_dir           = ".",
@@ -44,6 +47,7 @@ local default_cfg = {
     vinyl_range_size          = nil, -- set automatically
     vinyl_page_size           = 8 * 1024,
     vinyl_bloom_fpr           = 0.05,
+    vinyl_compression_level   = 3,
     log                 = nil,
     log_nonblock        = nil,
     log_level           = 5,
@@ -55,6 +59,9 @@ local default_cfg = {
     wal_mode            = "write",
     rows_per_wal        = 500000,
     wal_max_size        = 256 * 1024 * 1024,
+    wal_compression_level = 3,
+    wal_compression_threads = 0,
+    wal_direct_io       = false,
     wal_dir_rescan_delay= 2,
     force_recovery      = false,
     replication         = nil,
@@ -72,15 +79,22 @@ local default_cfg = {
     checkpoint_count    = 2,
     worker_pool_threads = 4,
     replication_timeout = 1,
+    replication_ack_interval = 0,
     replication_sync_lag = 10,
     replication_sync_timeout = 300,
     replication_connect_timeout = 30,
     replication_connect_quorum = nil, -- connect all
     replication_skip_conflict = false,
+    replication_compression = false,
+    replication_join_files = false,
+    replication_space_filter = nil, -- all spaces
     feedback_enabled      = true,
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
     net_msg_max           = 768,
+    sql_sorter_threads    = 0,
+    sql_scan_partitions   = 0,
+    sql_hash_join_memory  = 16 * 1024 * 1024,
 }
 
 -- types of available options
@@ -90,6 +104,9 @@ local template_cfg = {
     memtx_memory        = 'number',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_delta_checkpoint_count = 'number',
+    memtx_checkpoint_threads = 'number',
+    memtx_compression_level = 'number',
     slab_alloc_factor   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
@@ -106,6 +123,7 @@ local template_cfg = {
     vinyl_range_size          = 'number',
     vinyl_page_size           = 'number',
     vinyl_bloom_fpr           = 'number',
+    vinyl_compression_level   = 'number',
 
     log              = 'string',
     log_nonblock     = 'boolean',
@@ -118,6 +136,9 @@ local template_cfg = {
     wal_mode            = 'string',
     rows_per_wal        = 'number',
     wal_max_size        = 'number',
+    wal_compression_level = 'number',
+    wal_compression_threads = 'number',
+    wal_direct_io       = 'boolean',
     wal_dir_rescan_delay= 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
@@ -135,15 +156,22 @@ local template_cfg = {
     hot_standby         = 'boolean',
     worker_pool_threads = 'number',
     replication_timeout = 'number',
+    replication_ack_interval = 'number',
     replication_sync_lag = 'number',
     replication_sync_timeout = 'number',
     replication_connect_timeout = 'number',
     replication_connect_quorum = 'number',
     replication_skip_conflict = 'boolean',
+    replication_compression = 'boolean',
+    replication_join_files = 'boolean',
+    replication_space_filter = 'number, table',
     feedback_enabled      = 'boolean',
     feedback_host         = 'string',
     feedback_interval     = 'number',
     net_msg_max           = 'number',
+    sql_sorter_threads    = 'number',
+    sql_scan_partitions   = 'number',
+    sql_hash_join_memory  = 'number',
 }
 
 local function normalize_uri(port)
@@ -224,13 +252,19 @@ local dynamic_cfg = {
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_delta_checkpoint_count = private.cfg_set_memtx_delta_checkpoint_count,
+    memtx_checkpoint_threads = private.cfg_set_memtx_checkpoint_threads,
+    memtx_compression_level = private.cfg_set_memtx_compression_level,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
+    vinyl_compression_level = private.cfg_set_vinyl_compression_level,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.cfg_set_checkpoint_interval,
     checkpoint_wal_threshold = private.cfg_set_checkpoint_wal_threshold,
+    wal_compression_level   = private.cfg_set_wal_compression,
+    wal_compression_threads = private.cfg_set_wal_compression,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
     feedback_enabled        = private.feedback_daemon.set_feedback_params,
     feedback_host           = private.feedback_daemon.set_feedback_params,
@@ -242,38 +276,58 @@ local dynamic_cfg = {
     end,
     force_recovery          = function() end,
     replication_timeout     = private.cfg_set_replication_timeout,
+    replication_ack_interval = private.cfg_set_replication_ack_interval,
     replication_connect_timeout = private.cfg_set_replication_connect_timeout,
     replication_connect_quorum = private.cfg_set_replication_connect_quorum,
     replication_sync_lag    = private.cfg_set_replication_sync_lag,
     replication_sync_timeout = private.cfg_set_replication_sync_timeout,
     replication_skip_conflict = private.cfg_set_replication_skip_conflict,
+    replication_compression = private.cfg_set_replication_compression,
+    replication_join_files = private.cfg_set_replication_join_files,
+    replication_space_filter = private.cfg_set_replication_space_filter,
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
+    sql_sorter_threads      = private.cfg_set_sql_sorter_threads,
+    sql_scan_partitions     = private.cfg_set_sql_scan_partitions,
+    sql_hash_join_memory    = private.cfg_set_sql_hash_join_memory,
 }
 
 local dynamic_cfg_skip_at_load = {
     listen                  = true,
     memtx_memory            = true,
     memtx_max_tuple_size    = true,
+    memtx_delta_checkpoint_count = true,
+    memtx_checkpoint_threads = true,
+    memtx_compression_level = true,
     vinyl_memory            = true,
     vinyl_max_tuple_size    = true,
     vinyl_cache             = true,
     vinyl_timeout           = true,
+    vinyl_compression_level = true,
+    wal_compression_level   = true,
+    wal_compression_threads = true,
     too_long_threshold      = true,
     replication             = true,
     replication_timeout     = true,
+    replication_ack_interval = true,
     replication_connect_timeout = true,
     replication_connect_quorum = true,
     replication_sync_lag    = true,
     replication_sync_timeout = true,
     replication_skip_conflict = true,
+    replication_compression = true,
+    replication_join_files = true,
+    replication_space_filter = true,
     wal_dir_rescan_delay    = true,
     custom_proc_title       = true,
     force_recovery          = true,
     instance_uuid           = true,
     replicaset_uuid         = true,
     net_msg_max             = true,
+    sql_sorter_threads      = true,
+    sql_scan_partitions     = true,
+    sql_hash_join_memory    = true,
     readahead               = true,
 }
 
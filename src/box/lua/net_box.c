@@ -578,7 +578,7 @@ netbox_encode_execute(lua_State *L)
 	luamp_encode_tuple(L, cfg, &stream, 4);
 
 	mpstream_encode_uint(&stream, IPROTO_OPTIONS);
-	luamp_encode_tuple(L, cfg, &stream, 5);
+	luamp_encode(L, cfg, &stream, 5);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
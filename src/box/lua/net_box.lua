@@ -40,6 +40,7 @@ local IPROTO_METADATA_KEY = 0x32
 local IPROTO_SQL_INFO_KEY = 0x42
 local SQL_INFO_ROW_COUNT_KEY = 0
 local IPROTO_FIELD_NAME_KEY = 0
+local IPROTO_SQL_OPTION_CHUNK_SIZE_KEY = 0
 local IPROTO_DATA_KEY      = 0x30
 local IPROTO_ERROR_KEY     = 0x31
 local IPROTO_GREETING_SIZE = 128
@@ -126,6 +127,12 @@ local method_decoder = {
     push    = decode_push,
 }
 
+-- A part of a result set pushed before the final response
+-- contains rows, unlike a box.session.push() message.
+local push_decoder = {
+    execute = internal.decode_select,
+}
+
 local function next_id(id) return band(id + 1, 0x7FFFFFFF) end
 
 --
@@ -575,8 +582,9 @@ local function create_transport(host, port, user, password, callback,
             request.id = nil
         else
             local msg
-            msg, real_end, request.errno =
-                method_decoder.push(body_rpos, body_end)
+            local decoder = push_decoder[request.method] or
+                            method_decoder.push
+            msg, real_end, request.errno = decoder(body_rpos, body_end)
             assert(real_end == body_end, "invalid body length")
             request.on_push(request.on_push_ctx, msg)
         end
@@ -1145,11 +1153,49 @@ end
 
 function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
     check_remote_arg(self, "execute")
+    local options = setmetatable({}, {__serialize = 'map'})
+    local chunk_size
     if sql_opts ~= nil then
-        box.error(box.error.UNSUPPORTED, "execute", "options")
+        for k in pairs(sql_opts) do
+            if k ~= 'chunk_size' then
+                box.error(box.error.UNSUPPORTED, "execute", "options")
+            end
+        end
+        chunk_size = sql_opts.chunk_size
+    end
+    if chunk_size ~= nil then
+        if type(chunk_size) ~= 'number' or chunk_size <= 0 or
+           chunk_size ~= math.floor(chunk_size) then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "chunk_size should be a positive integer")
+        end
+        options[IPROTO_SQL_OPTION_CHUNK_SIZE_KEY] = chunk_size
+    end
+    -- Parts of the result set are pushed to on_push. If it is
+    -- not set, collect them to return the whole result set.
+    local chunks
+    if chunk_size ~= nil and (netbox_opts == nil or
+       (netbox_opts.on_push == nil and not netbox_opts.is_async and
+        netbox_opts.buffer == nil)) then
+        chunks = {}
+        netbox_opts = {timeout = netbox_opts and netbox_opts.timeout,
+                       on_push = table.insert, on_push_ctx = chunks}
+    end
+    local res = self:_request('execute', netbox_opts, query,
+                              parameters or {}, options)
+    if chunks ~= nil and #chunks > 0 then
+        local rows = {}
+        for _, chunk in ipairs(chunks) do
+            for _, row in ipairs(chunk) do
+                table.insert(rows, row)
+            end
+        end
+        for _, row in ipairs(res.rows) do
+            table.insert(rows, row)
+        end
+        res.rows = rows
     end
-    return self:_request('execute', netbox_opts, query, parameters or {},
-                         sql_opts or {})
+    return res
 end
 
 function remote_methods:wait_state(state, timeout)
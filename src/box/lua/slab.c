@@ -228,9 +228,40 @@ lbox_slab_info(struct lua_State *L)
 	lua_pushstring(L, ratio_buf);
 	lua_settable(L, -3);
 
+	/*
+	 * Memory wasted in partially filled tuple slabs,
+	 * which can be reclaimed with box.slab.defrag().
+	 */
+	lua_pushstring(L, "items_frag_size");
+	luaL_pushuint64(L, totals.total - totals.used);
+	lua_settable(L, -3);
+
+	/** Tuples moved by defragmentation since startup. */
+	lua_pushstring(L, "defrag_tuple_count");
+	luaL_pushuint64(L, memtx->defrag_tuple_count);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "defrag_tuple_size");
+	luaL_pushuint64(L, memtx->defrag_tuple_size);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "defrag_in_progress");
+	lua_pushboolean(L, memtx->defrag_fiber != NULL);
+	lua_settable(L, -3);
+
 	return 1;
 }
 
+static int
+lbox_slab_defrag(struct lua_State *L)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	if (memtx_engine_defrag(memtx) != 0)
+		return luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_runtime_info(struct lua_State *L)
 {
@@ -283,6 +314,10 @@ box_lua_slab_init(struct lua_State *L)
 	lua_pushcfunction(L, lbox_slab_check);
 	lua_settable(L, -3);
 
+	lua_pushstring(L, "defrag");
+	lua_pushcfunction(L, lbox_slab_defrag);
+	lua_settable(L, -3);
+
 	lua_settable(L, -3); /* box.slab */
 
 	lua_pushstring(L, "runtime");
@@ -60,12 +60,18 @@ lbox_push_txn_stmt(struct lua_State *L, void *event)
 	struct txn_stmt *stmt = txn_current_stmt((struct txn *) event);
 
 	if (stmt->old_tuple) {
-		luaT_pushtuple(L, stmt->old_tuple);
+		struct tuple *old_tuple = tuple_decompress(stmt->old_tuple);
+		if (old_tuple == NULL)
+			diag_raise();
+		luaT_pushtuple(L, old_tuple);
 	} else {
 		lua_pushnil(L);
 	}
 	if (stmt->new_tuple) {
-		luaT_pushtuple(L, stmt->new_tuple);
+		struct tuple *new_tuple = tuple_decompress(stmt->new_tuple);
+		if (new_tuple == NULL)
+			diag_raise();
+		luaT_pushtuple(L, new_tuple);
 	} else {
 		lua_pushnil(L);
 	}
@@ -43,6 +43,7 @@
 #include "box/engine.h"
 #include "box/vinyl.h"
 #include "box/sql.h"
+#include "box/commit_latency.h"
 #include "info/info.h"
 #include "lua/info.h"
 #include "lua/utils.h"
@@ -197,6 +198,15 @@ lbox_stat_sql(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_latency(struct lua_State *L)
+{
+	struct info_handler info;
+	luaT_info_handler_create(&info, L);
+	commit_latency_stat(&info);
+	return 1;
+}
+
 static const struct luaL_Reg lbox_stat_meta [] = {
 	{"__index", lbox_stat_index},
 	{"__call",  lbox_stat_call},
@@ -217,6 +227,7 @@ box_lua_stat_init(struct lua_State *L)
 		{"vinyl", lbox_stat_vinyl},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
+		{"latency", lbox_stat_latency},
 		{NULL, NULL}
 	};
 
@@ -31,6 +31,7 @@
 #include "memtx_engine.h"
 #include "memtx_space.h"
 
+#include <fcntl.h>
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
@@ -39,6 +40,7 @@
 #include "errinj.h"
 #include "coio_file.h"
 #include "tuple.h"
+#include "tuple_compression.h"
 #include "txn.h"
 #include "memtx_tree.h"
 #include "iproto_constants.h"
@@ -116,6 +118,13 @@ struct memtx_tuple {
 	struct tuple base;
 };
 
+/** Size of the memory allocated for a memtx tuple. */
+static inline size_t
+memtx_tuple_size(struct tuple *tuple)
+{
+	return offsetof(struct memtx_tuple, base) + tuple_size(tuple);
+}
+
 enum {
 	OBJSIZE_MIN = 16,
 	SLAB_SIZE = 16 * 1024 * 1024,
@@ -188,6 +197,443 @@ memtx_engine_shutdown(struct engine *engine)
 	free(memtx);
 }
 
+/* {{{ Snapshot cursor ******************************************/
+
+/**
+ * Cursor over a memtx snapshot. If the snapshot is a delta,
+ * rows of the spaces it inherits are read from its base
+ * snapshot, and so on down the chain.
+ */
+struct memtx_snap_cursor {
+	/** Snapshot directory. */
+	struct xdir *dir;
+	/** Cursor over the snapshot file being read. */
+	struct xlog_cursor cursor;
+	/**
+	 * Sorted ids of spaces to read from the current file.
+	 * NULL if all rows of the file are read, which is the
+	 * case for the head of the chain.
+	 */
+	uint32_t *space_ids;
+	uint32_t space_count;
+	/** Ids of spaces inherited from the base of the current file. */
+	uint32_t *base_space_ids;
+	uint32_t base_space_count;
+	uint32_t base_space_capacity;
+	/** Number of delta snapshots opened so far. */
+	int delta_count;
+};
+
+static int
+memtx_snap_cursor_open(struct memtx_snap_cursor *cursor, struct xdir *dir,
+		       int64_t signature)
+{
+	memset(cursor, 0, sizeof(*cursor));
+	cursor->dir = dir;
+	if (xdir_open_cursor(dir, signature, &cursor->cursor) != 0)
+		return -1;
+	if (vclock_is_set(&cursor->cursor.meta.base_vclock))
+		cursor->delta_count++;
+	return 0;
+}
+
+static void
+memtx_snap_cursor_close(struct memtx_snap_cursor *cursor)
+{
+	if (xlog_cursor_is_open(&cursor->cursor))
+		xlog_cursor_close(&cursor->cursor, false);
+	free(cursor->space_ids);
+	free(cursor->base_space_ids);
+}
+
+/** Return true if rows of the space are read from the current file. */
+static bool
+memtx_snap_cursor_wants_space(struct memtx_snap_cursor *cursor,
+			      uint32_t space_id)
+{
+	if (cursor->space_ids == NULL)
+		return true;
+	return bsearch(&space_id, cursor->space_ids, cursor->space_count,
+		       sizeof(space_id), xrow_cmp_space_id) != NULL;
+}
+
+/** Remember that the space must be read from the base file. */
+static int
+memtx_snap_cursor_add_base_space(struct memtx_snap_cursor *cursor,
+				 uint32_t space_id)
+{
+	if (cursor->base_space_count == cursor->base_space_capacity) {
+		uint32_t capacity = MAX(cursor->base_space_capacity * 2, 16);
+		uint32_t *ids = realloc(cursor->base_space_ids,
+					capacity * sizeof(*ids));
+		if (ids == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*ids),
+				 "realloc", "base_space_ids");
+			return -1;
+		}
+		cursor->base_space_ids = ids;
+		cursor->base_space_capacity = capacity;
+	}
+	cursor->base_space_ids[cursor->base_space_count++] = space_id;
+	return 0;
+}
+
+/**
+ * Switch to the base of the current file.
+ * Return 1 if there's nothing left to read.
+ */
+static int
+memtx_snap_cursor_next_file(struct memtx_snap_cursor *cursor)
+{
+	/**
+	 * We should never try to read snapshots with no EOF
+	 * marker - such snapshots are very likely corrupted and
+	 * should not be trusted.
+	 */
+	/* TODO: replace panic with diag_set() */
+	if (!xlog_cursor_is_eof(&cursor->cursor))
+		panic("snapshot `%s' has no EOF marker", cursor->cursor.name);
+	if (cursor->base_space_count == 0)
+		return 1;
+
+	struct vclock base_vclock;
+	vclock_copy(&base_vclock, &cursor->cursor.meta.base_vclock);
+	if (!vclock_is_set(&base_vclock)) {
+		diag_set(XlogError, "%s: missing base snapshot",
+			 cursor->cursor.name);
+		return -1;
+	}
+	xlog_cursor_close(&cursor->cursor, false);
+
+	free(cursor->space_ids);
+	cursor->space_ids = cursor->base_space_ids;
+	cursor->space_count = cursor->base_space_count;
+	cursor->base_space_ids = NULL;
+	cursor->base_space_count = 0;
+	cursor->base_space_capacity = 0;
+	qsort(cursor->space_ids, cursor->space_count,
+	      sizeof(*cursor->space_ids), xrow_cmp_space_id);
+
+	int64_t signature = vclock_sum(&base_vclock);
+	if (xdir_open_cursor(cursor->dir, signature, &cursor->cursor) != 0) {
+		/* Leave the cursor in a state safe to close. */
+		memset(&cursor->cursor, 0, sizeof(cursor->cursor));
+		cursor->cursor.state = XLOG_CURSOR_CLOSED;
+		return -1;
+	}
+	say_info("reading base snapshot `%s'", cursor->cursor.name);
+	if (vclock_is_set(&cursor->cursor.meta.base_vclock))
+		cursor->delta_count++;
+	return 0;
+}
+
+/**
+ * Read the next row of a snapshot.
+ * Return 0 on success, 1 on EOF, -1 on error.
+ */
+static int
+memtx_snap_cursor_next(struct memtx_snap_cursor *cursor,
+		       struct xrow_header *row, bool force_recovery)
+{
+	while (true) {
+		int rc = xlog_cursor_next(&cursor->cursor, row,
+					  force_recovery);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
+			rc = memtx_snap_cursor_next_file(cursor);
+			if (rc != 0)
+				return rc;
+			continue;
+		}
+		if (row->type != MEMTX_SNAP_BASE_SPACE &&
+		    cursor->space_ids == NULL)
+			return 0;
+		uint32_t space_id;
+		if (xrow_decode_space_id(row, &space_id) != 0)
+			return -1;
+		if (!memtx_snap_cursor_wants_space(cursor, space_id))
+			continue;
+		if (row->type != MEMTX_SNAP_BASE_SPACE)
+			return 0;
+		if (memtx_snap_cursor_add_base_space(cursor, space_id) != 0)
+			return -1;
+	}
+}
+
+/* }}} */
+
+/* {{{ Snapshot reader ******************************************/
+
+enum {
+	/** Size of rows the snapshot reader passes at once. */
+	MEMTX_SNAP_BATCH_SIZE = 1024 * 1024,
+	/** Number of batches the snapshot reader may read ahead. */
+	MEMTX_SNAP_BATCH_COUNT = 4,
+};
+
+/** Rows read from a snapshot by the reader thread. */
+struct memtx_snap_batch {
+	/** Rows, their bodies point to @data. */
+	struct xrow_header *rows;
+	int row_count;
+	int row_capacity;
+	/** Bodies of the rows, in the order of the rows. */
+	char *data;
+	size_t data_size;
+	size_t data_capacity;
+};
+
+/**
+ * Snapshot read in a separate thread. The thread reads the
+ * file, decompresses and decodes its rows while the caller
+ * applies the rows read earlier, so loading a snapshot isn't
+ * bound by the speed of one core any more.
+ */
+struct memtx_snap_reader {
+	/** Snapshot directory. */
+	struct xdir *dir;
+	int64_t signature;
+	bool force_recovery;
+	/** Read batches, used as a ring. */
+	struct memtx_snap_batch batches[MEMTX_SNAP_BATCH_COUNT];
+	/** The batch rows are taken from by the caller. */
+	int first;
+	/** Number of batches read but not consumed yet. */
+	int count;
+	/** Next row of the first batch to return. */
+	int pos;
+	/** Set if the caller is taking rows from the first batch. */
+	bool has_batch;
+	/** Set by the reader thread when it finishes. */
+	bool is_done;
+	/** Set by the caller to stop the reader thread. */
+	bool is_stopped;
+	/** Error the reader thread failed with. */
+	struct diag diag;
+	/** Number of delta snapshots read. */
+	int delta_count;
+	/** Protects the fields above, but for the batch contents. */
+	pthread_mutex_t mutex;
+	/** Signaled when a batch is read or consumed. */
+	pthread_cond_t cond;
+	struct cord cord;
+};
+
+/** Append a copy of a row to a batch. */
+static int
+memtx_snap_batch_add(struct memtx_snap_batch *batch,
+		     const struct xrow_header *row)
+{
+	if (batch->row_count == batch->row_capacity) {
+		int capacity = MAX(batch->row_capacity * 2, 1024);
+		struct xrow_header *rows = realloc(batch->rows,
+						   capacity * sizeof(*rows));
+		if (rows == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*rows),
+				 "realloc", "snapshot rows");
+			return -1;
+		}
+		batch->rows = rows;
+		batch->row_capacity = capacity;
+	}
+	size_t size = 0;
+	for (int i = 0; i < row->bodycnt; i++)
+		size += row->body[i].iov_len;
+	if (batch->data_size + size > batch->data_capacity) {
+		size_t capacity = MAX(batch->data_capacity * 2,
+				      (size_t)MEMTX_SNAP_BATCH_SIZE);
+		while (capacity < batch->data_size + size)
+			capacity *= 2;
+		char *data = realloc(batch->data, capacity);
+		if (data == NULL) {
+			diag_set(OutOfMemory, capacity, "realloc",
+				 "snapshot data");
+			return -1;
+		}
+		batch->data = data;
+		batch->data_capacity = capacity;
+	}
+	for (int i = 0; i < row->bodycnt; i++) {
+		memcpy(batch->data + batch->data_size, row->body[i].iov_base,
+		       row->body[i].iov_len);
+		batch->data_size += row->body[i].iov_len;
+	}
+	batch->rows[batch->row_count++] = *row;
+	return 0;
+}
+
+/**
+ * Point the bodies of the rows of a batch to the batch data,
+ * which may have moved while the batch was filled.
+ */
+static void
+memtx_snap_batch_seal(struct memtx_snap_batch *batch)
+{
+	char *data = batch->data;
+	for (int i = 0; i < batch->row_count; i++) {
+		struct xrow_header *row = &batch->rows[i];
+		for (int j = 0; j < row->bodycnt; j++) {
+			row->body[j].iov_base = data;
+			data += row->body[j].iov_len;
+		}
+	}
+	assert(data == batch->data + batch->data_size);
+}
+
+/**
+ * Read rows to the next free batch.
+ * Return 0 on success, 1 on EOF or stop, -1 on error.
+ */
+static int
+memtx_snap_reader_fill(struct memtx_snap_reader *reader,
+		       struct memtx_snap_cursor *cursor)
+{
+	tt_pthread_mutex_lock(&reader->mutex);
+	while (reader->count == MEMTX_SNAP_BATCH_COUNT &&
+	       !reader->is_stopped)
+		tt_pthread_cond_wait(&reader->cond, &reader->mutex);
+	bool is_stopped = reader->is_stopped;
+	int i = (reader->first + reader->count) % MEMTX_SNAP_BATCH_COUNT;
+	tt_pthread_mutex_unlock(&reader->mutex);
+	if (is_stopped)
+		return 1;
+
+	struct memtx_snap_batch *batch = &reader->batches[i];
+	batch->row_count = 0;
+	batch->data_size = 0;
+	int rc = 0;
+	while (batch->data_size < MEMTX_SNAP_BATCH_SIZE) {
+		struct xrow_header row;
+		rc = memtx_snap_cursor_next(cursor, &row,
+					    reader->force_recovery);
+		if (rc != 0)
+			break;
+		rc = memtx_snap_batch_add(batch, &row);
+		if (rc != 0)
+			break;
+	}
+	if (batch->row_count == 0)
+		return rc;
+	memtx_snap_batch_seal(batch);
+	/* Rows read before an error are applied all the same. */
+	tt_pthread_mutex_lock(&reader->mutex);
+	reader->count++;
+	tt_pthread_cond_signal(&reader->cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+	return rc;
+}
+
+static int
+memtx_snap_reader_f(va_list ap)
+{
+	struct memtx_snap_reader *reader =
+		va_arg(ap, struct memtx_snap_reader *);
+	struct memtx_snap_cursor cursor;
+	int rc = memtx_snap_cursor_open(&cursor, reader->dir,
+					reader->signature);
+	if (rc == 0) {
+		while ((rc = memtx_snap_reader_fill(reader, &cursor)) == 0)
+			;
+		reader->delta_count = cursor.delta_count;
+		memtx_snap_cursor_close(&cursor);
+	}
+	tt_pthread_mutex_lock(&reader->mutex);
+	if (rc < 0)
+		diag_move(diag_get(), &reader->diag);
+	reader->is_done = true;
+	tt_pthread_cond_signal(&reader->cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+	return 0;
+}
+
+/** Start reading a snapshot in a separate thread. */
+static int
+memtx_snap_reader_open(struct memtx_snap_reader *reader, struct xdir *dir,
+		       int64_t signature, bool force_recovery)
+{
+	memset(reader, 0, sizeof(*reader));
+	reader->dir = dir;
+	reader->signature = signature;
+	reader->force_recovery = force_recovery;
+	diag_create(&reader->diag);
+	tt_pthread_mutex_init(&reader->mutex, NULL);
+	tt_pthread_cond_init(&reader->cond, NULL);
+	if (cord_costart(&reader->cord, "snapshot.reader",
+			 memtx_snap_reader_f, reader) != 0) {
+		tt_pthread_mutex_destroy(&reader->mutex);
+		tt_pthread_cond_destroy(&reader->cond);
+		diag_destroy(&reader->diag);
+		return -1;
+	}
+	return 0;
+}
+
+/** Stop the reader thread and free the read rows. */
+static void
+memtx_snap_reader_close(struct memtx_snap_reader *reader)
+{
+	tt_pthread_mutex_lock(&reader->mutex);
+	reader->is_stopped = true;
+	tt_pthread_cond_signal(&reader->cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+	if (cord_cojoin(&reader->cord) != 0)
+		diag_log();
+	for (int i = 0; i < MEMTX_SNAP_BATCH_COUNT; i++) {
+		free(reader->batches[i].rows);
+		free(reader->batches[i].data);
+	}
+	tt_pthread_mutex_destroy(&reader->mutex);
+	tt_pthread_cond_destroy(&reader->cond);
+	diag_destroy(&reader->diag);
+}
+
+/**
+ * Take the next row read by the reader thread. The row is valid
+ * until the next call. Return 0 on success, 1 on EOF, -1 on error.
+ */
+static int
+memtx_snap_reader_next(struct memtx_snap_reader *reader,
+		       struct xrow_header *row)
+{
+	struct memtx_snap_batch *batch = &reader->batches[reader->first];
+	if (reader->has_batch && reader->pos < batch->row_count) {
+		*row = batch->rows[reader->pos++];
+		return 0;
+	}
+	int rc = 0;
+	tt_pthread_mutex_lock(&reader->mutex);
+	if (reader->has_batch) {
+		reader->first = (reader->first + 1) % MEMTX_SNAP_BATCH_COUNT;
+		reader->count--;
+		reader->pos = 0;
+		reader->has_batch = false;
+		tt_pthread_cond_signal(&reader->cond);
+	}
+	/*
+	 * Loading a snapshot blocks the tx thread anyway, like
+	 * reading the file in this thread did.
+	 */
+	while (reader->count == 0 && !reader->is_done)
+		tt_pthread_cond_wait(&reader->cond, &reader->mutex);
+	if (reader->count > 0)
+		reader->has_batch = true;
+	else if (!diag_is_empty(&reader->diag))
+		rc = -1;
+	else
+		rc = 1;
+	tt_pthread_mutex_unlock(&reader->mutex);
+	if (rc < 0)
+		diag_move(&reader->diag, diag_get());
+	if (rc != 0)
+		return rc;
+	batch = &reader->batches[reader->first];
+	*row = batch->rows[reader->pos++];
+	return 0;
+}
+
+/* }}} */
+
 static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
@@ -203,15 +649,15 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+	struct memtx_snap_reader reader;
+	if (memtx_snap_reader_open(&reader, &memtx->snap_dir, signature,
+				   memtx->force_recovery) < 0)
 		return -1;
 
 	int rc;
 	struct xrow_header row;
 	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
-				      memtx->force_recovery)) == 0) {
+	while ((rc = memtx_snap_reader_next(&reader, &row)) == 0) {
 		row.lsn = signature;
 		rc = memtx_engine_recover_snapshot_row(memtx, &row);
 		if (rc < 0) {
@@ -227,18 +673,13 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			fiber_yield_timeout(0);
 		}
 	}
-	xlog_cursor_close(&cursor, false);
+	memtx_snap_reader_close(&reader);
 	if (rc < 0)
 		return -1;
 
-	/**
-	 * We should never try to read snapshots with no EOF
-	 * marker - such snapshots are very likely corrupted and
-	 * should not be trusted.
-	 */
-	if (!xlog_cursor_is_eof(&cursor))
-		panic("snapshot `%s' has no EOF marker", filename);
-
+	/* The data is now in sync with the snapshot. */
+	vclock_copy(&memtx->delta_base_vclock, vclock);
+	memtx->delta_chain_len = reader.delta_count;
 	return 0;
 }
 
@@ -302,6 +743,12 @@ static int
 memtx_engine_begin_final_recovery(struct engine *engine)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	/*
+	 * Spaces loaded from the snapshot are in sync with it.
+	 * Bump the version so that only changes made from now
+	 * on mark spaces as changed since the last checkpoint.
+	 */
+	memtx->snapshot_version++;
 	if (memtx->state == MEMTX_OK)
 		return 0;
 
@@ -484,21 +931,20 @@ memtx_engine_bootstrap(struct engine *engine)
 	return rc < 0 ? -1 : 0;
 }
 
+/**
+ * Write a snapshot row. @a lsn is the number of rows written
+ * to the snapshot before this one.
+ */
 static int
-checkpoint_write_row(struct xlog *l, struct xrow_header *row)
+checkpoint_write_row(struct xlog *l, struct xrow_header *row,
+		     ev_tstamp tm, int64_t lsn)
 {
 	struct errinj *errinj = errinj(ERRINJ_SNAP_WRITE_ROW_TIMEOUT,
 				       ERRINJ_DOUBLE);
 	if (errinj != NULL && errinj->dparam > 0)
 		usleep(errinj->dparam * 1000000);
 
-	static ev_tstamp last = 0;
-	if (last == 0) {
-		ev_now_update(loop());
-		last = ev_now(loop());
-	}
-
-	row->tm = last;
+	row->tm = tm;
 	row->replica_id = 0;
 	/**
 	 * Rows in snapshot are numbered from 1 to %rows.
@@ -507,23 +953,21 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 	 * WAL. @sa the place which skips old rows in
 	 * recovery_apply_row().
 	 */
-	row->lsn = l->rows + l->tx_rows;
+	row->lsn = lsn;
 	row->sync = 0; /* don't write sync to wal */
 
-	ssize_t written = xlog_write_row(l, row);
-	fiber_gc();
-	if (written < 0)
+	if (xlog_write_row(l, row) < 0)
 		return -1;
 
-	if ((l->rows + l->tx_rows) % 100000 == 0)
-		say_crit("%.1fM rows written", (l->rows + l->tx_rows) / 1000000.0);
+	if ((lsn + 1) % 100000 == 0)
+		say_crit("%.1fM rows written", (lsn + 1) / 1000000.0);
 	return 0;
-
 }
 
 static int
 checkpoint_write_tuple(struct xlog *l, struct space *space,
-		       const char *data, uint32_t size)
+		       const char *data, uint32_t size,
+		       ev_tstamp tm, int64_t lsn)
 {
 	struct request_replace_body body;
 	body.m_body = 0x82; /* map of two elements. */
@@ -542,11 +986,45 @@ checkpoint_write_tuple(struct xlog *l, struct space *space,
 	row.body[0].iov_len = sizeof(body);
 	row.body[1].iov_base = (char *)data;
 	row.body[1].iov_len = size;
-	return checkpoint_write_row(l, &row);
+	return checkpoint_write_row(l, &row, tm, lsn);
+}
+
+/**
+ * Write a row telling recovery to load the space
+ * from the base of a delta snapshot.
+ */
+static int
+checkpoint_write_base_space(struct xlog *l, struct space *space,
+			    ev_tstamp tm, int64_t lsn)
+{
+	char body[16];
+	char *data = body;
+	data = mp_encode_map(data, 1);
+	data = mp_encode_uint(data, IPROTO_SPACE_ID);
+	data = mp_encode_uint(data, space_id(space));
+	assert(data <= body + sizeof(body));
+
+	struct xrow_header row;
+	memset(&row, 0, sizeof(struct xrow_header));
+	row.type = MEMTX_SNAP_BASE_SPACE;
+	row.group_id = space_group_id(space);
+	row.bodycnt = 1;
+	row.body[0].iov_base = body;
+	row.body[0].iov_len = data - body;
+	return checkpoint_write_row(l, &row, tm, lsn);
 }
 
 struct checkpoint_entry {
 	struct space *space;
+	/**
+	 * Format of the space tuples, used to decompress
+	 * them before writing.
+	 */
+	struct tuple_format *format;
+	/**
+	 * Read view of the space. NULL if the space hasn't
+	 * changed since the base snapshot was taken.
+	 */
 	struct snapshot_iterator *iterator;
 	struct rlist link;
 };
@@ -557,11 +1035,40 @@ struct checkpoint {
 	 * read view iterators.
 	 */
 	struct rlist entries;
+	/**
+	 * The next entry to write, shared by all writer threads.
+	 * NULL if there's nothing left to write.
+	 */
+	struct checkpoint_entry *next_entry;
+	/** Set if any writer thread failed. */
+	bool is_failed;
+	/** Protects next_entry and is_failed. */
+	pthread_mutex_t entries_lock;
+	/** The snapshot file, shared by writer threads. */
+	struct xlog *snap;
+	/** Serializes writes to the snapshot file. */
+	pthread_mutex_t write_lock;
+	/** Orders writes of rows reserved by writer threads. */
+	pthread_cond_t write_cond;
+	/** Time stored in all rows of the snapshot. */
+	ev_tstamp tm;
+	/** Number of threads writing the snapshot. */
+	int threads;
 	uint64_t snap_io_rate_limit;
 	struct cord cord;
 	bool waiting_for_snap_thread;
 	/** The vclock of the snapshot file. */
 	struct vclock vclock;
+	/**
+	 * The vclock of the snapshot this one is a delta of.
+	 * Not set if a full snapshot is written.
+	 */
+	struct vclock base_vclock;
+	/**
+	 * Value of memtx_engine::snapshot_version at the time
+	 * the base snapshot was started.
+	 */
+	uint32_t base_version;
 	struct xdir dir;
 	/**
 	 * Do nothing, just touch the snapshot file - the
@@ -571,7 +1078,8 @@ struct checkpoint {
 };
 
 static struct checkpoint *
-checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
+checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit,
+	       int threads)
 {
 	struct checkpoint *ckpt = malloc(sizeof(*ckpt));
 	if (ckpt == NULL) {
@@ -580,10 +1088,20 @@ checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
 		return NULL;
 	}
 	rlist_create(&ckpt->entries);
+	ckpt->next_entry = NULL;
+	ckpt->is_failed = false;
+	tt_pthread_mutex_init(&ckpt->entries_lock, NULL);
+	tt_pthread_mutex_init(&ckpt->write_lock, NULL);
+	tt_pthread_cond_init(&ckpt->write_cond, NULL);
+	ckpt->tm = 0;
+	ckpt->threads = threads;
+	ckpt->snap = NULL;
 	ckpt->waiting_for_snap_thread = false;
 	xdir_create(&ckpt->dir, snap_dirname, SNAP, &INSTANCE_UUID);
 	ckpt->snap_io_rate_limit = snap_io_rate_limit;
 	vclock_create(&ckpt->vclock);
+	vclock_clear(&ckpt->base_vclock);
+	ckpt->base_version = 0;
 	ckpt->touch = false;
 	return ckpt;
 }
@@ -593,9 +1111,14 @@ checkpoint_delete(struct checkpoint *ckpt)
 {
 	struct checkpoint_entry *entry, *tmp;
 	rlist_foreach_entry_safe(entry, &ckpt->entries, link, tmp) {
-		entry->iterator->free(entry->iterator);
+		if (entry->iterator != NULL)
+			entry->iterator->free(entry->iterator);
+		tuple_format_unref(entry->format);
 		free(entry);
 	}
+	tt_pthread_mutex_destroy(&ckpt->entries_lock);
+	tt_pthread_mutex_destroy(&ckpt->write_lock);
+	tt_pthread_cond_destroy(&ckpt->write_cond);
 	xdir_destroy(&ckpt->dir);
 	free(ckpt);
 }
@@ -621,6 +1144,17 @@ checkpoint_add_space(struct space *sp, void *data)
 	rlist_add_tail_entry(&ckpt->entries, entry, link);
 
 	entry->space = sp;
+	entry->format = sp->format;
+	tuple_format_ref(entry->format);
+	entry->iterator = NULL;
+	/*
+	 * System spaces are always written in full, because
+	 * their rows must be recovered before any other data.
+	 */
+	struct memtx_space *memtx_space = (struct memtx_space *)sp;
+	if (vclock_is_set(&ckpt->base_vclock) && !space_is_system(sp) &&
+	    memtx_space->change_version < ckpt->base_version)
+		return 0;
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL)
 		return -1;
@@ -628,6 +1162,240 @@ checkpoint_add_space(struct space *sp, void *data)
 	return 0;
 };
 
+/**
+ * Take the next space to write. If @a system_only is set,
+ * stop at the first non-system space.
+ */
+static struct checkpoint_entry *
+checkpoint_next_entry(struct checkpoint *ckpt, bool system_only)
+{
+	tt_pthread_mutex_lock(&ckpt->entries_lock);
+	struct checkpoint_entry *entry = ckpt->next_entry;
+	if (ckpt->is_failed ||
+	    (entry != NULL && system_only && !space_is_system(entry->space)))
+		entry = NULL;
+	if (entry != NULL) {
+		ckpt->next_entry = rlist_next_entry(entry, link);
+		if (&ckpt->next_entry->link == &ckpt->entries)
+			ckpt->next_entry = NULL;
+	}
+	tt_pthread_mutex_unlock(&ckpt->entries_lock);
+	return entry;
+}
+
+/** Stop all writer threads on error. */
+static void
+checkpoint_set_failed(struct checkpoint *ckpt)
+{
+	tt_pthread_mutex_lock(&ckpt->entries_lock);
+	ckpt->is_failed = true;
+	tt_pthread_mutex_unlock(&ckpt->entries_lock);
+}
+
+enum {
+	/** Max number of rows written by a writer at once. */
+	CHECKPOINT_BATCH_ROWS = 4096,
+	/** Max size of rows written by a writer at once. */
+	CHECKPOINT_BATCH_SIZE = 128 * 1024,
+};
+
+/** A tuple read from a space to be written to the snapshot. */
+struct checkpoint_row {
+	const char *data;
+	uint32_t size;
+};
+
+/**
+ * Take the number of rows written to the snapshot before the
+ * next @a count rows of a writer. Rows written by several
+ * threads are reserved under the write lock of the file, so
+ * that they are numbered in the order they appear in the file.
+ */
+static int64_t
+checkpoint_reserve_rows(struct xlog *l, int64_t count)
+{
+	if (l->parent == NULL)
+		return l->rows + l->tx_rows;
+	return xlog_shared_reserve(l, count);
+}
+
+/**
+ * Write rows reserved with checkpoint_reserve_rows(). The rows
+ * of a shared writer are flushed at once in order not to hold
+ * the rows reserved by other threads after them.
+ */
+static int
+checkpoint_flush_rows(struct xlog *l)
+{
+	if (l->parent == NULL)
+		return 0;
+	return xlog_flush(l) < 0 ? -1 : 0;
+}
+
+static int
+checkpoint_write_batch(struct checkpoint *ckpt, struct xlog *l,
+		       struct space *space, struct checkpoint_row *rows,
+		       int count)
+{
+	int64_t lsn = checkpoint_reserve_rows(l, count);
+	for (int i = 0; i < count; i++) {
+		if (checkpoint_write_tuple(l, space, rows[i].data,
+					   rows[i].size, ckpt->tm,
+					   lsn + i) != 0)
+			return -1;
+	}
+	return checkpoint_flush_rows(l);
+}
+
+static int
+checkpoint_write_entry(struct checkpoint *ckpt, struct xlog *l,
+		       struct checkpoint_entry *entry,
+		       struct checkpoint_row *rows)
+{
+	struct snapshot_iterator *it = entry->iterator;
+	if (it == NULL) {
+		int64_t lsn = checkpoint_reserve_rows(l, 1);
+		int rc = checkpoint_write_base_space(l, entry->space,
+						     ckpt->tm, lsn);
+		fiber_gc();
+		if (rc != 0)
+			return -1;
+		return checkpoint_flush_rows(l);
+	}
+	bool eof = false;
+	while (!eof) {
+		int count = 0;
+		size_t size = 0;
+		while (count < CHECKPOINT_BATCH_ROWS &&
+		       size < CHECKPOINT_BATCH_SIZE) {
+			uint32_t tuple_size;
+			const char *data = it->next(it, &tuple_size);
+			if (data == NULL) {
+				eof = true;
+				break;
+			}
+			/*
+			 * Snapshots store tuples decompressed, so
+			 * that they don't depend on the space format.
+			 * The region is freed after each batch of
+			 * rows is written.
+			 */
+			data = tuple_decompress_raw(entry->format, data,
+						    data + tuple_size,
+						    &tuple_size);
+			if (data == NULL)
+				goto fail;
+			rows[count].data = data;
+			rows[count].size = tuple_size;
+			size += tuple_size;
+			count++;
+		}
+		if (count > 0 && checkpoint_write_batch(ckpt, l, entry->space,
+							rows, count) != 0)
+			goto fail;
+		fiber_gc();
+	}
+	return 0;
+fail:
+	fiber_gc();
+	return -1;
+}
+
+/**
+ * Write spaces to the snapshot until there are no more
+ * spaces left or another writer fails.
+ */
+static int
+checkpoint_write_entries(struct checkpoint *ckpt, struct xlog *l,
+			 bool system_only)
+{
+	size_t size = CHECKPOINT_BATCH_ROWS * sizeof(struct checkpoint_row);
+	struct checkpoint_row *rows = malloc(size);
+	if (rows == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "checkpoint rows");
+		checkpoint_set_failed(ckpt);
+		return -1;
+	}
+	int rc = 0;
+	struct checkpoint_entry *entry;
+	while ((entry = checkpoint_next_entry(ckpt, system_only)) != NULL) {
+		if (checkpoint_write_entry(ckpt, l, entry, rows) != 0) {
+			checkpoint_set_failed(ckpt);
+			rc = -1;
+			break;
+		}
+	}
+	free(rows);
+	return rc;
+}
+
+/**
+ * Write spaces to the snapshot file through a writer of
+ * its own, sharing the file with other threads.
+ */
+static int
+checkpoint_write_shared(struct checkpoint *ckpt)
+{
+	struct xlog part;
+	if (xlog_create_shared(&part, ckpt->snap, &ckpt->write_lock,
+			       &ckpt->write_cond) != 0) {
+		checkpoint_set_failed(ckpt);
+		return -1;
+	}
+	int rc = checkpoint_write_entries(ckpt, &part, false);
+	if (rc == 0 && xlog_flush(&part) < 0) {
+		checkpoint_set_failed(ckpt);
+		rc = -1;
+	}
+	xlog_close_shared(&part);
+	return rc;
+}
+
+static int
+checkpoint_writer_f(va_list ap)
+{
+	struct checkpoint *ckpt = va_arg(ap, struct checkpoint *);
+	return checkpoint_write_shared(ckpt);
+}
+
+/**
+ * Write user spaces to the snapshot in ckpt->threads threads,
+ * including the calling one. Each space is written by one
+ * thread, and blocks of rows of different spaces interleave
+ * in the file.
+ */
+static int
+checkpoint_write_parallel(struct checkpoint *ckpt)
+{
+	int count = ckpt->threads - 1;
+	struct cord *writers = calloc(count, sizeof(*writers));
+	if (writers == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*writers),
+			 "calloc", "snapshot writers");
+		return -1;
+	}
+	int rc = 0;
+	int started;
+	for (started = 0; started < count; started++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "snapshot.%d", started + 1);
+		if (cord_costart(&writers[started], name,
+				 checkpoint_writer_f, ckpt) != 0) {
+			checkpoint_set_failed(ckpt);
+			rc = -1;
+			break;
+		}
+	}
+	if (rc == 0)
+		rc = checkpoint_write_shared(ckpt);
+	for (int i = 0; i < started; i++) {
+		if (cord_cojoin(&writers[i]) != 0)
+			rc = -1;
+	}
+	free(writers);
+	return rc;
+}
+
 static int
 checkpoint_f(va_list ap)
 {
@@ -644,31 +1412,44 @@ checkpoint_f(va_list ap)
 	}
 
 	struct xlog snap;
-	if (xdir_create_xlog(&ckpt->dir, &snap, &ckpt->vclock) != 0)
+	if (xdir_create_delta_xlog(&ckpt->dir, &snap, &ckpt->vclock,
+				   vclock_is_set(&ckpt->base_vclock) ?
+				   &ckpt->base_vclock : NULL) != 0)
 		return -1;
 
 	snap.rate_limit = ckpt->snap_io_rate_limit;
 
 	say_info("saving snapshot `%s'", snap.filename);
-	struct checkpoint_entry *entry;
-	rlist_foreach_entry(entry, &ckpt->entries, link) {
-		uint32_t size;
-		const char *data;
-		struct snapshot_iterator *it = entry->iterator;
-		for (data = it->next(it, &size); data != NULL;
-		     data = it->next(it, &size)) {
-			if (checkpoint_write_tuple(&snap, entry->space,
-					data, size) != 0) {
-				xlog_close(&snap, false);
-				return -1;
-			}
-		}
+	/* All rows of the snapshot have the same time. */
+	ev_now_update(loop());
+	ckpt->tm = ev_now(loop());
+	if (!rlist_empty(&ckpt->entries)) {
+		ckpt->next_entry = rlist_first_entry(&ckpt->entries,
+						     struct checkpoint_entry,
+						     link);
 	}
-	if (xlog_flush(&snap) < 0) {
-		xlog_close(&snap, false);
-		return -1;
+	/*
+	 * System spaces go first, because recovery needs
+	 * them to create the other spaces. The rest may be
+	 * written in parallel.
+	 */
+	int rc = checkpoint_write_entries(ckpt, &snap, true);
+	if (rc == 0 && ckpt->threads > 1) {
+		/* Writers must not interleave with system spaces. */
+		rc = xlog_flush(&snap) < 0 ? -1 : 0;
+		if (rc == 0) {
+			ckpt->snap = &snap;
+			rc = checkpoint_write_parallel(ckpt);
+			ckpt->snap = NULL;
+		}
+	} else if (rc == 0) {
+		rc = checkpoint_write_entries(ckpt, &snap, false);
 	}
+	if (rc == 0 && xlog_flush(&snap) < 0)
+		rc = -1;
 	xlog_close(&snap, false);
+	if (rc != 0)
+		return -1;
 	say_info("done");
 	return 0;
 }
@@ -680,9 +1461,26 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 
 	assert(memtx->checkpoint == NULL);
 	memtx->checkpoint = checkpoint_new(memtx->snap_dir.dirname,
-					   memtx->snap_io_rate_limit);
+					   memtx->snap_io_rate_limit,
+					   memtx->checkpoint_threads);
 	if (memtx->checkpoint == NULL)
 		return -1;
+	memtx->checkpoint->dir.compression_level = memtx->compression_level;
+
+	/*
+	 * Make a delta checkpoint if the last snapshot is the
+	 * one the data is known to be in sync with, and the
+	 * chain of deltas isn't too long yet.
+	 */
+	struct vclock last;
+	if (memtx->delta_checkpoint_count > 0 &&
+	    memtx->delta_chain_len < memtx->delta_checkpoint_count &&
+	    vclock_is_set(&memtx->delta_base_vclock) &&
+	    xdir_last_vclock(&memtx->snap_dir, &last) >= 0 &&
+	    vclock_compare(&last, &memtx->delta_base_vclock) == 0) {
+		vclock_copy(&memtx->checkpoint->base_vclock, &last);
+		memtx->checkpoint->base_version = memtx->snapshot_version;
+	}
 
 	if (space_foreach(checkpoint_add_space, memtx->checkpoint) != 0) {
 		checkpoint_delete(memtx->checkpoint);
@@ -743,6 +1541,9 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
 
 	if (!memtx->checkpoint->touch) {
+		memtx->delta_chain_len =
+			vclock_is_set(&memtx->checkpoint->base_vclock) ?
+			memtx->delta_chain_len + 1 : 0;
 		int64_t lsn = vclock_sum(&memtx->checkpoint->vclock);
 		struct xdir *dir = &memtx->checkpoint->dir;
 		/* rename snapshot on completion */
@@ -769,6 +1570,7 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 		/* Add the new checkpoint to the set. */
 		xdir_add_vclock(&memtx->snap_dir, &memtx->checkpoint->vclock);
 	}
+	vclock_copy(&memtx->delta_base_vclock, &memtx->checkpoint->vclock);
 
 	checkpoint_delete(memtx->checkpoint);
 	memtx->checkpoint = NULL;
@@ -791,6 +1593,13 @@ memtx_engine_abort_checkpoint(struct engine *engine)
 
 	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
 
+	/*
+	 * Spaces changed after the base snapshot was taken, but
+	 * before this checkpoint was started, aren't tracked any
+	 * more, so the next checkpoint must be a full one.
+	 */
+	vclock_clear(&memtx->delta_base_vclock);
+
 	/** Remove garbage .inprogress file. */
 	char *filename =
 		xdir_format_filename(&memtx->checkpoint->dir,
@@ -802,12 +1611,44 @@ memtx_engine_abort_checkpoint(struct engine *engine)
 	memtx->checkpoint = NULL;
 }
 
+/**
+ * Find the signature of the snapshot following the one with
+ * the given signature in the chain of delta snapshots. Return
+ * -1 if the snapshot isn't a delta.
+ */
+static int
+memtx_snap_base(struct xdir *dir, int64_t signature, int64_t *base_signature)
+{
+	struct xlog_cursor cursor;
+	if (xdir_open_cursor(dir, signature, &cursor) != 0)
+		return -1;
+	*base_signature = -1;
+	if (vclock_is_set(&cursor.meta.base_vclock))
+		*base_signature = vclock_sum(&cursor.meta.base_vclock);
+	xlog_cursor_close(&cursor, false);
+	return 0;
+}
+
 static void
 memtx_engine_collect_garbage(struct engine *engine, const struct vclock *vclock)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	xdir_collect_garbage(&memtx->snap_dir, vclock_sum(vclock),
-			     XDIR_GC_ASYNC);
+	/*
+	 * Snapshots the given one is a delta of must be
+	 * retained, because it can't be recovered without them.
+	 */
+	int64_t signature = vclock_sum(vclock);
+	int64_t base_signature = signature;
+	do {
+		signature = base_signature;
+		if (memtx_snap_base(&memtx->snap_dir, signature,
+				    &base_signature) != 0) {
+			say_error("failed to look up the base of snapshot");
+			diag_log();
+			return;
+		}
+	} while (base_signature >= 0);
+	xdir_collect_garbage(&memtx->snap_dir, signature, XDIR_GC_ASYNC);
 }
 
 static int
@@ -815,9 +1656,18 @@ memtx_engine_backup(struct engine *engine, const struct vclock *vclock,
 		    engine_backup_cb cb, void *cb_arg)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	char *filename = xdir_format_filename(&memtx->snap_dir,
-					      vclock_sum(vclock), NONE);
-	return cb(filename, cb_arg);
+	/* Back up the snapshot with all its base snapshots. */
+	int64_t signature = vclock_sum(vclock);
+	do {
+		char *filename = xdir_format_filename(&memtx->snap_dir,
+						      signature, NONE);
+		if (cb(filename, cb_arg) != 0)
+			return -1;
+		if (memtx_snap_base(&memtx->snap_dir, signature,
+				    &signature) != 0)
+			return -1;
+	} while (signature >= 0);
+	return 0;
 }
 
 /** Used to pass arguments to memtx_initial_join_f */
@@ -827,6 +1677,26 @@ struct memtx_join_arg {
 	struct xstream *stream;
 };
 
+/**
+ * Send the snapshot with all its base snapshots as is, so that
+ * the replica reads the rows on its own.
+ */
+static int
+memtx_join_send_files(struct xdir *dir, int64_t signature,
+		      struct xstream *stream)
+{
+	do {
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s",
+			 xdir_format_filename(dir, signature, NONE));
+		if (xstream_send_file(stream, path) != 0)
+			return -1;
+		if (memtx_snap_base(dir, signature, &signature) != 0)
+			return -1;
+	} while (signature >= 0);
+	return 0;
+}
+
 /**
  * Invoked from a thread to feed snapshot rows.
  */
@@ -844,31 +1714,26 @@ memtx_initial_join_f(va_list ap)
 	 * safe to use in another thread.
 	 */
 	xdir_create(&dir, snap_dirname, SNAP, &INSTANCE_UUID);
-	struct xlog_cursor cursor;
-	int rc = xdir_open_cursor(&dir, checkpoint_lsn, &cursor);
-	xdir_destroy(&dir);
+	int rc;
+	if (stream->send_file != NULL) {
+		rc = memtx_join_send_files(&dir, checkpoint_lsn, stream);
+		goto out;
+	}
+	struct memtx_snap_cursor cursor;
+	rc = memtx_snap_cursor_open(&cursor, &dir, checkpoint_lsn);
 	if (rc < 0)
-		return -1;
+		goto out;
 
 	struct xrow_header row;
-	while ((rc = xlog_cursor_next(&cursor, &row, true)) == 0) {
+	while ((rc = memtx_snap_cursor_next(&cursor, &row, true)) == 0) {
 		rc = xstream_write(stream, &row);
 		if (rc < 0)
 			break;
 	}
-	xlog_cursor_close(&cursor, false);
-	if (rc < 0)
-		return -1;
-
-	/**
-	 * We should never try to read snapshots with no EOF
-	 * marker - such snapshots are very likely corrupted and
-	 * should not be trusted.
-	 */
-	/* TODO: replace panic with diag_set() */
-	if (!xlog_cursor_is_eof(&cursor))
-		panic("snapshot `%s' has no EOF marker", cursor.name);
-	return 0;
+	memtx_snap_cursor_close(&cursor);
+out:
+	xdir_destroy(&dir);
+	return rc < 0 ? -1 : 0;
 }
 
 static int
@@ -892,6 +1757,79 @@ memtx_engine_join(struct engine *engine, const struct vclock *vclock,
 	return cord_cojoin(&cord);
 }
 
+/**
+ * Snapshots received on initial join are stored in the snapshot
+ * directory under this extension until they are loaded. As it
+ * ends with the in-progress suffix, the files left by a failed
+ * join are removed on restart.
+ */
+static const char memtx_join_snap_ext[] = ".snap.join.inprogress";
+
+static void
+memtx_join_dir_create(struct memtx_engine *memtx, struct xdir *dir)
+{
+	/* The files come from the master, don't check the UUID. */
+	xdir_create(dir, memtx->snap_dir.dirname, SNAP, &uuid_nil);
+	dir->filename_ext = memtx_join_snap_ext;
+}
+
+int
+memtx_engine_create_join_file(struct memtx_engine *memtx, const char *name,
+			      uint32_t name_len, int64_t *signature)
+{
+	/* Accept only snapshot names, i.e. <signature>.snap */
+	const char *ext = memtx->snap_dir.filename_ext;
+	uint32_t ext_len = strlen(ext);
+	if (name_len <= ext_len ||
+	    memcmp(name + name_len - ext_len, ext, ext_len) != 0)
+		goto invalid;
+	*signature = 0;
+	for (uint32_t i = 0; i < name_len - ext_len; i++) {
+		if (name[i] < '0' || name[i] > '9' ||
+		    *signature > (INT64_MAX - (name[i] - '0')) / 10)
+			goto invalid;
+		*signature = *signature * 10 + (name[i] - '0');
+	}
+
+	struct xdir dir;
+	memtx_join_dir_create(memtx, &dir);
+	const char *filename = xdir_format_filename(&dir, *signature, NONE);
+	int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, dir.mode);
+	if (fd < 0)
+		diag_set(SystemError, "failed to create file '%s'", filename);
+	xdir_destroy(&dir);
+	return fd;
+invalid:
+	diag_set(XlogError, "invalid snapshot file name '%.*s'",
+		 (int)name_len, name);
+	return -1;
+}
+
+int
+memtx_engine_load_join_snapshot(struct memtx_engine *memtx,
+				int64_t signature, struct xstream *stream)
+{
+	struct xdir dir;
+	memtx_join_dir_create(memtx, &dir);
+	say_info("loading snapshot `%s' received from master",
+		 xdir_format_filename(&dir, signature, NONE));
+	struct memtx_snap_reader reader;
+	int rc = memtx_snap_reader_open(&reader, &dir, signature, false);
+	if (rc == 0) {
+		struct xrow_header row;
+		while ((rc = memtx_snap_reader_next(&reader, &row)) == 0) {
+			rc = xstream_write(stream, &row);
+			if (rc < 0)
+				break;
+		}
+		memtx_snap_reader_close(&reader);
+	}
+	/* The received files are of no use any more. */
+	xdir_collect_inprogress(&dir);
+	xdir_destroy(&dir);
+	return rc < 0 ? -1 : 0;
+}
+
 static int
 small_stats_noop_cb(const struct mempool_stats *stats, void *cb_ctx)
 {
@@ -1058,6 +1996,9 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
+	memtx->checkpoint_threads = 1;
+	memtx->compression_level = XLOG_COMPRESSION_LEVEL_DEFAULT;
+	vclock_clear(&memtx->delta_base_vclock);
 	memtx->force_recovery = force_recovery;
 
 	memtx->base.vtab = &memtx_engine_vtab;
@@ -1085,6 +2026,24 @@ memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit)
 	memtx->snap_io_rate_limit = limit * 1024 * 1024;
 }
 
+void
+memtx_engine_set_delta_checkpoint_count(struct memtx_engine *memtx, int count)
+{
+	memtx->delta_checkpoint_count = count;
+}
+
+void
+memtx_engine_set_checkpoint_threads(struct memtx_engine *memtx, int threads)
+{
+	memtx->checkpoint_threads = threads;
+}
+
+void
+memtx_engine_set_compression_level(struct memtx_engine *memtx, int level)
+{
+	memtx->compression_level = level;
+}
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size)
 {
@@ -1115,9 +2074,38 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	if (tuple_field_map_create(format, data, true, &field_map,
 				   &field_map_size) != 0)
 		goto end;
+	if (format->compressed_field_count > 0) {
+		uint32_t size;
+		const char *compressed = tuple_compress_raw(format, data, end,
+							    &size);
+		if (compressed == NULL)
+			goto end;
+		if (compressed != data) {
+			/*
+			 * Compressed fields aren't indexed, but
+			 * offsets of the fields following them
+			 * have changed.
+			 */
+			data = compressed;
+			end = compressed + size;
+			if (tuple_field_map_create(format, data, false,
+						   &field_map,
+						   &field_map_size) != 0)
+				goto end;
+		}
+	}
 
 	size_t tuple_len = end - data;
-	size_t total = sizeof(struct memtx_tuple) + field_map_size + tuple_len;
+	/*
+	 * Tuples without a field map are usually small, so
+	 * store them in the compact form to save on the header.
+	 */
+	bool is_compact = field_map_size == 0 &&
+			  tuple_len <= TUPLE_COMPACT_BSIZE_MAX;
+	size_t data_offset = is_compact ? TUPLE_COMPACT_HEADER_SIZE :
+			     sizeof(struct tuple) + field_map_size;
+	size_t total = offsetof(struct memtx_tuple, base) + data_offset +
+		       tuple_len;
 
 	ERROR_INJECT(ERRINJ_TUPLE_ALLOC, {
 		diag_set(OutOfMemory, total, "slab allocator", "memtx_tuple");
@@ -1143,8 +2131,6 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	tuple = &memtx_tuple->base;
 	tuple->refs = 0;
 	memtx_tuple->version = memtx->snapshot_version;
-	assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
-	tuple->bsize = tuple_len;
 	tuple->format_id = tuple_format_id(format);
 	tuple_format_ref(format);
 	/*
@@ -1152,8 +2138,16 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	 * tuple base, not from memtx_tuple, because the struct
 	 * tuple is not the first field of the memtx_tuple.
 	 */
-	tuple->data_offset = sizeof(struct tuple) + field_map_size;
-	char *raw = (char *) tuple + tuple->data_offset;
+	if (is_compact) {
+		tuple->is_compact = true;
+		tuple->compact_bsize = tuple_len;
+	} else {
+		assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
+		tuple->is_compact = false;
+		tuple->bsize = tuple_len;
+		tuple->data_offset = data_offset;
+	}
+	char *raw = (char *) tuple + data_offset;
 	memcpy(raw - field_map_size, field_map, field_map_size);
 	memcpy(raw, data, tuple_len);
 	say_debug("%s(%zu) = %p", __func__, tuple_len, memtx_tuple);
@@ -1168,8 +2162,7 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
 	say_debug("%s(%p)", __func__, tuple);
 	assert(tuple->refs == 0);
-	size_t total = sizeof(struct memtx_tuple) + format->field_map_size +
-		tuple->bsize;
+	size_t total = memtx_tuple_size(tuple);
 	tuple_format_unref(format);
 	struct memtx_tuple *memtx_tuple =
 		container_of(tuple, struct memtx_tuple, base);
@@ -1186,6 +2179,296 @@ struct tuple_format_vtab memtx_tuple_format_vtab = {
 	memtx_tuple_new,
 };
 
+/* {{{ Tuple arena defragmentation ****************************/
+
+enum {
+	/** Number of tuples relocated between two yields. */
+	MEMTX_DEFRAG_BATCH = 512,
+	/**
+	 * Number of index extents reserved before relocating
+	 * a tuple, @sa RESERVE_EXTENTS_BEFORE_REPLACE.
+	 */
+	MEMTX_DEFRAG_RESERVE_EXTENTS = 16,
+};
+
+/** How long to wait for a checkpoint to complete, in seconds. */
+static const double MEMTX_DEFRAG_CHECKPOINT_DELAY = 0.1;
+
+/** Defragmentation state, lives on the defragmentation fiber stack. */
+struct memtx_defrag {
+	/** Ids of spaces to defragment. */
+	uint32_t *space_ids;
+	/** Number of entries in @space_ids. */
+	uint32_t space_count;
+	/** Position of the space being defragmented in @space_ids. */
+	uint32_t space_pos;
+	/**
+	 * Primary key of the last tuple processed in the current
+	 * space, allocated with malloc(). NULL if the space hasn't
+	 * been visited yet.
+	 */
+	char *key;
+	/** Schema version @key was extracted at. */
+	uint32_t schema_version;
+};
+
+/**
+ * Return true if tuples of a space can be relocated.
+ * Only TREE and HASH indexes guarantee that replacing
+ * a tuple with its copy doesn't allocate memory.
+ */
+static bool
+memtx_defrag_space_is_supported(struct space *space)
+{
+	if (space->index_count == 0)
+		return false;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		enum index_type type = space->index[i]->def->type;
+		if (type != TREE && type != HASH)
+			return false;
+	}
+	return true;
+}
+
+static int
+memtx_defrag_add_space(struct space *space, void *arg)
+{
+	struct memtx_defrag *defrag = arg;
+	if (!space_is_memtx(space))
+		return 0;
+	uint32_t *ids = realloc(defrag->space_ids, (defrag->space_count + 1) *
+				sizeof(*defrag->space_ids));
+	if (ids == NULL) {
+		diag_set(OutOfMemory, (defrag->space_count + 1) *
+			 sizeof(*defrag->space_ids), "realloc", "space_ids");
+		return -1;
+	}
+	ids[defrag->space_count++] = space_id(space);
+	defrag->space_ids = ids;
+	return 0;
+}
+
+/**
+ * Allocate a copy of a memtx tuple, including its field map.
+ * The copy is not referenced.
+ */
+static struct tuple *
+memtx_tuple_dup(struct memtx_engine *memtx, struct tuple *tuple)
+{
+	size_t total = memtx_tuple_size(tuple);
+	struct memtx_tuple *memtx_tuple = smalloc(&memtx->alloc, total);
+	if (memtx_tuple == NULL) {
+		diag_set(OutOfMemory, total, "slab allocator", "memtx_tuple");
+		return NULL;
+	}
+	struct memtx_tuple *old = container_of(tuple, struct memtx_tuple,
+					       base);
+	memcpy(memtx_tuple, old, total);
+	memtx_tuple->version = memtx->snapshot_version;
+	memtx_tuple->base.refs = 0;
+	tuple_format_ref(tuple_format(tuple));
+	return &memtx_tuple->base;
+}
+
+/**
+ * Move a tuple to a denser part of the arena if possible.
+ * The tuple must be referenced by the caller.
+ */
+static void
+memtx_defrag_tuple(struct memtx_engine *memtx, struct space *space,
+		   struct tuple *old_tuple)
+{
+	/*
+	 * Tuples referenced by anyone but the space and us
+	 * (Lua, pending transactions, iterators) are pinned.
+	 */
+	if (old_tuple->refs != 2)
+		return;
+	if (memtx_index_extent_reserve(memtx,
+				       MEMTX_DEFRAG_RESERVE_EXTENTS) != 0)
+		goto fail;
+	struct tuple *new_tuple = memtx_tuple_dup(memtx, old_tuple);
+	if (new_tuple == NULL)
+		goto fail;
+	if (new_tuple > old_tuple) {
+		/* The copy isn't any better, leave the tuple where it is. */
+		tuple_delete(new_tuple);
+		return;
+	}
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct tuple *unused;
+		if (index_replace(space->index[i], old_tuple, new_tuple,
+				  DUP_REPLACE, &unused) == 0)
+			continue;
+		/* Roll back and give up. Rollback must not fail. */
+		for (uint32_t j = 0; j < i; j++) {
+			if (index_replace(space->index[j], new_tuple,
+					  old_tuple, DUP_REPLACE,
+					  &unused) != 0) {
+				diag_log();
+				panic("failed to rollback tuple relocation");
+			}
+		}
+		tuple_delete(new_tuple);
+		goto fail;
+	}
+	memtx->defrag_tuple_count++;
+	memtx->defrag_tuple_size += tuple_size(old_tuple);
+	/* Pass the space reference over to the new tuple. */
+	tuple_ref(new_tuple);
+	tuple_unref(old_tuple);
+	return;
+fail:
+	/* Not critical, the tuple stays where it is. */
+	diag_clear(diag_get());
+}
+
+/**
+ * Relocate the next batch of tuples of the current space.
+ * Set @done if there are no more tuples in the space.
+ */
+static int
+memtx_defrag_step(struct memtx_engine *memtx, struct memtx_defrag *defrag,
+		  bool *done)
+{
+	*done = true;
+	struct space *space = space_by_id(defrag->space_ids[defrag->space_pos]);
+	if (space == NULL || !memtx_defrag_space_is_supported(space))
+		return 0;
+	if (defrag->schema_version != schema_version) {
+		/*
+		 * The primary key definition might have changed
+		 * since the last step so the saved key can't be
+		 * used. Restart the space from the beginning.
+		 */
+		free(defrag->key);
+		defrag->key = NULL;
+		defrag->schema_version = schema_version;
+	}
+	struct index *pk = space->index[0];
+	uint32_t part_count = defrag->key == NULL ? 0 :
+			      pk->def->key_def->part_count;
+	struct iterator *it = index_create_iterator(pk, defrag->key == NULL ?
+						    ITER_ALL : ITER_GT,
+						    defrag->key, part_count);
+	if (it == NULL)
+		return -1;
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct tuple **batch = region_alloc(region, MEMTX_DEFRAG_BATCH *
+					    sizeof(*batch));
+	if (batch == NULL) {
+		iterator_delete(it);
+		diag_set(OutOfMemory, MEMTX_DEFRAG_BATCH * sizeof(*batch),
+			 "region", "batch");
+		return -1;
+	}
+	int rc = 0;
+	int count = 0;
+	struct tuple *tuple;
+	while (count < MEMTX_DEFRAG_BATCH &&
+	       (rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		tuple_ref(tuple);
+		batch[count++] = tuple;
+	}
+	iterator_delete(it);
+
+	if (rc == 0 && count == MEMTX_DEFRAG_BATCH) {
+		*done = false;
+		uint32_t key_size;
+		const char *key = tuple_extract_key(batch[count - 1],
+						    pk->def->key_def,
+						    &key_size);
+		char *buf = key == NULL ? NULL : realloc(defrag->key,
+							 key_size);
+		if (buf == NULL) {
+			if (key != NULL)
+				diag_set(OutOfMemory, key_size,
+					 "realloc", "key");
+			rc = -1;
+		} else {
+			memcpy(buf, key, key_size);
+			defrag->key = buf;
+		}
+	}
+	for (int i = 0; i < count; i++) {
+		if (rc == 0)
+			memtx_defrag_tuple(memtx, space, batch[i]);
+		tuple_unref(batch[i]);
+	}
+	region_truncate(region, region_svp);
+	return rc;
+}
+
+static int
+memtx_engine_defrag_f(va_list va)
+{
+	struct memtx_engine *memtx = va_arg(va, struct memtx_engine *);
+	struct memtx_defrag defrag;
+	memset(&defrag, 0, sizeof(defrag));
+	defrag.schema_version = schema_version;
+	if (space_foreach(memtx_defrag_add_space, &defrag) != 0)
+		goto out;
+
+	say_info("tuple arena defragmentation started");
+	uint64_t tuple_count = memtx->defrag_tuple_count;
+	while (defrag.space_pos < defrag.space_count) {
+		if (fiber_is_cancelled())
+			goto out;
+		/*
+		 * While a checkpoint is in progress, freed tuples
+		 * are retained for the read view so relocation
+		 * would only increase memory consumption.
+		 */
+		if (memtx->checkpoint != NULL) {
+			fiber_sleep(MEMTX_DEFRAG_CHECKPOINT_DELAY);
+			continue;
+		}
+		bool done;
+		if (memtx_defrag_step(memtx, &defrag, &done) != 0)
+			goto out;
+		if (done) {
+			free(defrag.key);
+			defrag.key = NULL;
+			defrag.space_pos++;
+		}
+		/* Let other fibers run between batches. */
+		fiber_sleep(0);
+	}
+	say_info("tuple arena defragmentation done, %llu tuples relocated",
+		 (unsigned long long)(memtx->defrag_tuple_count - tuple_count));
+out:
+	if (!diag_is_empty(diag_get())) {
+		say_error("tuple arena defragmentation failed");
+		diag_log();
+	}
+	free(defrag.key);
+	free(defrag.space_ids);
+	memtx->defrag_fiber = NULL;
+	return 0;
+}
+
+int
+memtx_engine_defrag(struct memtx_engine *memtx)
+{
+	if (memtx->defrag_fiber != NULL)
+		return 0;
+	if (memtx->state != MEMTX_OK) {
+		diag_set(ClientError, ER_UNSUPPORTED, "memtx",
+			 "defragmentation during recovery");
+		return -1;
+	}
+	memtx->defrag_fiber = fiber_new("memtx.defrag",
+					memtx_engine_defrag_f);
+	if (memtx->defrag_fiber == NULL)
+		return -1;
+	fiber_start(memtx->defrag_fiber, memtx);
+	return 0;
+}
+
+/* }}} */
+
 /**
  * Allocate a block of size MEMTX_EXTENT_SIZE for memtx index
  */
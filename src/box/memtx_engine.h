@@ -105,6 +105,16 @@ struct memtx_engine {
 	struct xdir snap_dir;
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t snap_io_rate_limit;
+	/**
+	 * Number of threads writing a snapshot in parallel,
+	 * box.cfg.memtx_checkpoint_threads.
+	 */
+	int checkpoint_threads;
+	/**
+	 * Level of zstd compression of snapshots,
+	 * box.cfg.memtx_compression_level.
+	 */
+	int compression_level;
 	/** Skip invalid snapshot records if this flag is set. */
 	bool force_recovery;
 	/** Common quota for tuples and indexes. */
@@ -137,6 +147,25 @@ struct memtx_engine {
 	size_t max_tuple_size;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
+	/**
+	 * Max number of delta checkpoints in a row, after which
+	 * a full checkpoint is made, box.cfg.memtx_delta_checkpoint_count.
+	 * Zero means that delta checkpoints are disabled.
+	 */
+	int delta_checkpoint_count;
+	/**
+	 * Vclock of the last snapshot the in-memory data is in
+	 * sync with, i.e. the snapshot that was recovered from or
+	 * written last. Spaces unchanged since then are written
+	 * to a delta checkpoint as references to this snapshot.
+	 * Not set if there is no such snapshot.
+	 */
+	struct vclock delta_base_vclock;
+	/**
+	 * Number of delta snapshots in the chain ending with
+	 * the snapshot referred to by delta_base_vclock.
+	 */
+	int delta_chain_len;
 	/** Memory pool for rtree index iterator. */
 	struct mempool rtree_iterator_pool;
 	/**
@@ -155,6 +184,16 @@ struct memtx_engine {
 	 * memtx_gc_task::link.
 	 */
 	struct stailq gc_queue;
+	/**
+	 * Tuple arena defragmentation fiber, NULL unless
+	 * defragmentation is in progress.
+	 * @sa memtx_engine_defrag().
+	 */
+	struct fiber *defrag_fiber;
+	/** Number of tuples relocated by defragmentation. */
+	uint64_t defrag_tuple_count;
+	/** Total size of tuples relocated by defragmentation. */
+	uint64_t defrag_tuple_size;
 };
 
 struct memtx_gc_task;
@@ -186,6 +225,23 @@ void
 memtx_engine_schedule_gc(struct memtx_engine *memtx,
 			 struct memtx_gc_task *task);
 
+/**
+ * Start background defragmentation of the tuple arena.
+ *
+ * Tuples of all memtx spaces are visited in small batches,
+ * yielding in between, and each tuple referenced only by its
+ * space is copied to a freshly allocated chunk. The copy is
+ * kept only if it landed at a lower address than the original,
+ * which, given that the slab allocator serves requests from
+ * the lowest-addressed partially filled slab first, moves data
+ * out of sparsely populated slabs and lets them be released.
+ * Index pointers are updated with index_replace().
+ *
+ * Does nothing if defragmentation is already in progress.
+ */
+int
+memtx_engine_defrag(struct memtx_engine *memtx);
+
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size,
@@ -195,9 +251,38 @@ int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			      const struct vclock *vclock);
 
+/**
+ * Create a file to store a snapshot received from the master
+ * on initial join. @a name is the name of the file on the
+ * master, the signature it encodes is returned in @a signature.
+ *
+ * Return the file descriptor, -1 on error.
+ */
+int
+memtx_engine_create_join_file(struct memtx_engine *memtx, const char *name,
+			      uint32_t name_len, int64_t *signature);
+
+/**
+ * Feed rows of a snapshot received on initial join, including
+ * the ones of the snapshots it is a delta of, to the stream,
+ * then remove the received files.
+ */
+int
+memtx_engine_load_join_snapshot(struct memtx_engine *memtx,
+				int64_t signature, struct xstream *stream);
+
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit);
 
+void
+memtx_engine_set_delta_checkpoint_count(struct memtx_engine *memtx, int count);
+
+void
+memtx_engine_set_checkpoint_threads(struct memtx_engine *memtx, int threads);
+
+void
+memtx_engine_set_compression_level(struct memtx_engine *memtx, int level);
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 
@@ -33,6 +33,7 @@
 #include "iproto_constants.h"
 #include "txn.h"
 #include "tuple.h"
+#include "tuple_compression.h"
 #include "tuple_update.h"
 #include "xrow.h"
 #include "memtx_hash.h"
@@ -67,6 +68,8 @@ memtx_space_update_bsize(struct space *space, struct tuple *old_tuple,
 	ssize_t new_bsize = new_tuple ? box_tuple_bsize(new_tuple) : 0;
 	assert((ssize_t)memtx_space->bsize + new_bsize - old_bsize >= 0);
 	memtx_space->bsize += new_bsize - old_bsize;
+	struct memtx_engine *memtx = (struct memtx_engine *)space->engine;
+	memtx_space->change_version = memtx->snapshot_version;
 }
 
 /**
@@ -402,7 +405,9 @@ memtx_space_execute_update(struct space *space, struct txn *txn,
 
 	/* Update the tuple; legacy, request ops are in request->tuple */
 	uint32_t new_size = 0, bsize;
-	const char *old_data = tuple_data_range(old_tuple, &bsize);
+	const char *old_data = tuple_data_range_decompressed(old_tuple, &bsize);
+	if (old_data == NULL)
+		return -1;
 	const char *new_data =
 		tuple_update_execute(region_aligned_alloc_cb, &fiber()->gc,
 				     request->tuple, request->tuple_end,
@@ -486,7 +491,10 @@ memtx_space_execute_upsert(struct space *space, struct txn *txn,
 		tuple_ref(stmt->new_tuple);
 	} else {
 		uint32_t new_size = 0, bsize;
-		const char *old_data = tuple_data_range(old_tuple, &bsize);
+		const char *old_data =
+			tuple_data_range_decompressed(old_tuple, &bsize);
+		if (old_data == NULL)
+			return -1;
 		/*
 		 * Update the tuple.
 		 * tuple_upsert_execute() fails on totally wrong
@@ -795,6 +803,14 @@ memtx_space_add_primary_key(struct space *space)
 	return 0;
 }
 
+static inline enum compression_type
+memtx_format_field_compression(struct tuple_format *format, uint32_t fieldno)
+{
+	if (fieldno >= tuple_format_field_count(format))
+		return COMPRESSION_TYPE_NONE;
+	return tuple_format_field(format, fieldno)->compression;
+}
+
 static int
 memtx_space_check_format(struct space *space, struct tuple_format *format)
 {
@@ -804,10 +820,28 @@ memtx_space_check_format(struct space *space, struct tuple_format *format)
 	if (index_size(pk) == 0)
 		return 0;
 
+	/*
+	 * Stored tuples aren't rebuilt on alter, so compression
+	 * of a field can only be changed while the space is empty.
+	 */
+	uint32_t field_count = MAX(tuple_format_field_count(space->format),
+				   tuple_format_field_count(format));
+	for (uint32_t i = 0; i < field_count; i++) {
+		if (memtx_format_field_compression(space->format, i) !=
+		    memtx_format_field_compression(format, i)) {
+			diag_set(ClientError, ER_ALTER_SPACE,
+				 space_name(space), "can not change field "
+				 "compression of a non-empty space");
+			return -1;
+		}
+	}
+
 	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
 	if (it == NULL)
 		return -1;
 
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
 	int rc;
 	struct tuple *tuple;
 	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
@@ -815,7 +849,10 @@ memtx_space_check_format(struct space *space, struct tuple_format *format)
 		 * Check that the tuple is OK according to the
 		 * new format.
 		 */
-		rc = tuple_validate(format, tuple);
+		uint32_t bsize;
+		const char *data = tuple_data_range_decompressed(tuple, &bsize);
+		rc = data != NULL ? tuple_validate_raw(format, data) : -1;
+		region_truncate(region, region_svp);
 		if (rc != 0)
 			break;
 	}
@@ -1012,6 +1049,7 @@ memtx_space_new(struct memtx_engine *memtx,
 
 	memtx_space->bsize = 0;
 	memtx_space->rowid = 0;
+	memtx_space->change_version = memtx->snapshot_version;
 	memtx_space->replace = memtx_space_replace_no_keys;
 	return (struct space *)memtx_space;
 }
@@ -49,6 +49,13 @@ struct memtx_space {
 	 * tuples within one unique primary key.
 	 */
 	uint64_t rowid;
+	/**
+	 * Value of memtx_engine::snapshot_version at the time
+	 * of the last change of the space. Used to skip spaces
+	 * unchanged since the last checkpoint when making a delta
+	 * checkpoint.
+	 */
+	uint32_t change_version;
 	/**
 	 * A pointer to replace function, set to different values
 	 * at different stages of recovery.
@@ -31,6 +31,7 @@
 #include "recovery.h"
 
 #include "small/rlist.h"
+#include "salad/stailq.h"
 #include "scoped_guard.h"
 #include "trigger.h"
 #include "fiber.h"
@@ -42,6 +43,7 @@
 #include "session.h"
 #include "coio_file.h"
 #include "error.h"
+#include "tt_pthread.h"
 
 /*
  * Recovery subsystem
@@ -200,6 +202,14 @@ out:
 	 */
 	if (vclock_compare(&r->vclock, vclock) < 0)
 		vclock_copy(&r->vclock, vclock);
+	/*
+	 * Skip the rows which have already been recovered
+	 * using the index of the file, if there's one.
+	 */
+	if (xlog_cursor_seek_vclock(&r->cursor, &r->vclock) != 0) {
+		diag_log();
+		say_warn("ignoring the index of %s", r->cursor.name);
+	}
 	return;
 
 gap_error:
@@ -229,6 +239,294 @@ recovery_delete(struct recovery *r)
 	free(r);
 }
 
+/* {{{ Read-ahead of xlogs */
+
+enum {
+	/** Max size of txs read ahead and not applied yet. */
+	RECOVERY_READ_AHEAD_MAX = 16 * 1024 * 1024,
+};
+
+/** A tx read and decoded by the recovery reader thread. */
+struct recovery_tx {
+	/** Link in recovery_reader::queue. */
+	struct stailq_entry in_queue;
+	/** Position in the file right after the tx. */
+	off_t end_offset;
+	/** Rows of the tx, the decoded rows point here. */
+	char *data;
+	/** Decoded rows. */
+	struct xrow_header *rows;
+	/** Number of decoded rows. */
+	int row_count;
+	/** Memory used by the tx. */
+	size_t size;
+};
+
+static void
+recovery_tx_delete(struct recovery_tx *tx)
+{
+	free(tx->rows);
+	free(tx->data);
+	free(tx);
+}
+
+/**
+ * Take the current tx of an xlog cursor and decode its rows.
+ * The tx may be freed in any thread.
+ */
+static struct recovery_tx *
+recovery_tx_new(struct xlog_cursor *cursor)
+{
+	size_t data_size;
+	const char *pos, *end;
+	int capacity = 0;
+	struct recovery_tx *tx = (struct recovery_tx *)
+		calloc(1, sizeof(*tx));
+	if (tx == NULL) {
+		diag_set(OutOfMemory, sizeof(*tx), "malloc",
+			 "struct recovery_tx");
+		return NULL;
+	}
+	tx->data = xlog_cursor_copy_tx(cursor, &data_size);
+	if (tx->data == NULL)
+		goto error;
+	tx->end_offset = xlog_cursor_pos(cursor);
+	pos = tx->data;
+	end = tx->data + data_size;
+	while (pos < end) {
+		if (tx->row_count == capacity) {
+			capacity = capacity > 0 ? capacity * 2 : 16;
+			size_t size = capacity * sizeof(*tx->rows);
+			struct xrow_header *rows = (struct xrow_header *)
+				realloc(tx->rows, size);
+			if (rows == NULL) {
+				diag_set(OutOfMemory, size, "realloc",
+					 "recovery tx rows");
+				goto error;
+			}
+			tx->rows = rows;
+		}
+		if (xrow_header_decode(&tx->rows[tx->row_count],
+				       &pos, end, false) != 0)
+			goto error;
+		tx->row_count++;
+	}
+	tx->size = data_size + capacity * sizeof(*tx->rows);
+	return tx;
+error:
+	recovery_tx_delete(tx);
+	return NULL;
+}
+
+/**
+ * A thread reading an xlog ahead of the recovery. It does
+ * the I/O, checks checksums, decompresses and decodes txs
+ * and queues them to be applied by the tx thread.
+ */
+struct recovery_reader {
+	/** Thread reading the file. */
+	struct cord cord;
+	/** Name of the file. */
+	char name[PATH_MAX];
+	/** Position in the file to start reading at. */
+	off_t offset;
+	/** Protects the members below. */
+	pthread_mutex_t mutex;
+	/** Signalled when the queue or the reader state changes. */
+	pthread_cond_t cond;
+	/** Txs read and not applied yet, linked by in_queue. */
+	struct stailq queue;
+	/** Total size of the txs in the queue. */
+	size_t queue_size;
+	/** Set by the reader when it has nothing more to read. */
+	bool is_done;
+	/** Set by the recovery to stop the reader. */
+	bool is_cancelled;
+};
+
+static void *
+recovery_reader_f(void *arg)
+{
+	struct recovery_reader *reader = (struct recovery_reader *)arg;
+	struct xlog_cursor cursor;
+	if (xlog_cursor_open(&cursor, reader->name) == 0) {
+		xlog_cursor_seek(&cursor, reader->offset);
+		/*
+		 * Stop at EOF or at the first tx which can't be
+		 * read: the recovery reads the rest of the file
+		 * itself and handles the EOF marker, a torn tail
+		 * and errors as usual.
+		 */
+		while (xlog_cursor_next_tx(&cursor) == 0) {
+			struct recovery_tx *tx = recovery_tx_new(&cursor);
+			if (tx == NULL)
+				break;
+			tt_pthread_mutex_lock(&reader->mutex);
+			while (reader->queue_size >= RECOVERY_READ_AHEAD_MAX &&
+			       !reader->is_cancelled)
+				tt_pthread_cond_wait(&reader->cond,
+						     &reader->mutex);
+			bool is_cancelled = reader->is_cancelled;
+			if (!is_cancelled) {
+				stailq_add_tail_entry(&reader->queue, tx,
+						      in_queue);
+				reader->queue_size += tx->size;
+				tt_pthread_cond_signal(&reader->cond);
+			}
+			tt_pthread_mutex_unlock(&reader->mutex);
+			if (is_cancelled) {
+				recovery_tx_delete(tx);
+				break;
+			}
+		}
+		xlog_cursor_close(&cursor, false);
+	}
+	/* Errors are reported by the recovery, see above. */
+	diag_clear(diag_get());
+	tt_pthread_mutex_lock(&reader->mutex);
+	reader->is_done = true;
+	tt_pthread_cond_signal(&reader->cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+	return NULL;
+}
+
+/**
+ * Start reading the file of @a cursor from its current
+ * position in a separate thread.
+ */
+static int
+recovery_reader_start(struct recovery_reader *reader,
+		      struct xlog_cursor *cursor)
+{
+	snprintf(reader->name, sizeof(reader->name), "%s", cursor->name);
+	reader->offset = xlog_cursor_pos(cursor);
+	tt_pthread_mutex_init(&reader->mutex, NULL);
+	tt_pthread_cond_init(&reader->cond, NULL);
+	stailq_create(&reader->queue);
+	reader->queue_size = 0;
+	reader->is_done = false;
+	reader->is_cancelled = false;
+	if (cord_start(&reader->cord, "recovery", recovery_reader_f,
+		       reader) != 0) {
+		tt_pthread_cond_destroy(&reader->cond);
+		tt_pthread_mutex_destroy(&reader->mutex);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Return the next tx read ahead or NULL if the reader has
+ * stopped and all the txs it read have been returned.
+ */
+static struct recovery_tx *
+recovery_reader_next(struct recovery_reader *reader)
+{
+	struct recovery_tx *tx = NULL;
+	tt_pthread_mutex_lock(&reader->mutex);
+	while (stailq_empty(&reader->queue) && !reader->is_done)
+		tt_pthread_cond_wait(&reader->cond, &reader->mutex);
+	if (!stailq_empty(&reader->queue)) {
+		tx = stailq_shift_entry(&reader->queue, struct recovery_tx,
+					in_queue);
+		reader->queue_size -= tx->size;
+		tt_pthread_cond_signal(&reader->cond);
+	}
+	tt_pthread_mutex_unlock(&reader->mutex);
+	return tx;
+}
+
+static void
+recovery_reader_stop(struct recovery_reader *reader)
+{
+	tt_pthread_mutex_lock(&reader->mutex);
+	reader->is_cancelled = true;
+	tt_pthread_cond_signal(&reader->cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+	/* The reader never fails, see recovery_reader_f(). */
+	cord_join(&reader->cord);
+	struct recovery_tx *tx, *next;
+	stailq_foreach_entry_safe(tx, next, &reader->queue, in_queue)
+		recovery_tx_delete(tx);
+	tt_pthread_cond_destroy(&reader->cond);
+	tt_pthread_mutex_destroy(&reader->mutex);
+}
+
+/* }}} */
+
+/**
+ * Apply a row read from the current xlog unless it has
+ * already been applied.
+ */
+static void
+recovery_apply_row(struct recovery *r, struct xstream *stream,
+		   struct xrow_header *row, uint64_t *row_count)
+{
+	int64_t current_lsn = vclock_get(&r->vclock, row->replica_id);
+	if (row->lsn <= current_lsn)
+		return; /* already applied, skip */
+
+	/*
+	 * All rows in xlog files have an assigned
+	 * replica id.
+	 */
+	assert(row->replica_id != 0);
+	/*
+	 * We can promote the vclock either before or
+	 * after xstream_write(): it only makes any impact
+	 * in case of forced recovery, when we skip the
+	 * failed row anyway.
+	 */
+	vclock_follow_xrow(&r->vclock, row);
+	if (xstream_write(stream, row) == 0) {
+		++*row_count;
+		if (*row_count % 100000 == 0)
+			say_info("%.1fM rows processed",
+				 *row_count / 1000000.);
+	} else {
+		if (!r->wal_dir.force_recovery)
+			diag_raise();
+
+		say_error("skipping row {%u: %lld}",
+			  (unsigned)row->replica_id, (long long)row->lsn);
+		diag_log();
+	}
+}
+
+/**
+ * Apply the rows of the current xlog read ahead by a separate
+ * thread, so that reading, checksumming, decompression and
+ * decoding of the file overlap with applying the rows. The
+ * rows are applied in the order they were written. When the
+ * reader stops, the cursor is moved right after the last tx
+ * applied, and the caller reads the rest of the file.
+ */
+static void
+recover_xlog_ahead(struct recovery *r, struct xstream *stream,
+		   uint64_t *row_count)
+{
+	struct recovery_reader reader;
+	if (recovery_reader_start(&reader, &r->cursor) != 0) {
+		/* Not an error: the file is just read in place. */
+		diag_log();
+		return;
+	}
+	off_t offset = reader.offset;
+	auto guard = make_scoped_guard([&]{
+		recovery_reader_stop(&reader);
+		xlog_cursor_seek(&r->cursor, offset);
+	});
+	struct recovery_tx *tx;
+	while ((tx = recovery_reader_next(&reader)) != NULL) {
+		auto tx_guard = make_scoped_guard([=]{
+			recovery_tx_delete(tx);
+		});
+		for (int i = 0; i < tx->row_count; i++)
+			recovery_apply_row(r, stream, &tx->rows[i], row_count);
+		offset = tx->end_offset;
+	}
+}
+
 /**
  * Read all rows in a file starting from the last position.
  * Advance the position. If end of file is reached,
@@ -242,6 +540,9 @@ recover_xlog(struct recovery *r, struct xstream *stream,
 {
 	struct xrow_header row;
 	uint64_t row_count = 0;
+	if (r->read_ahead && stop_vclock == NULL &&
+	    r->cursor.state == XLOG_CURSOR_ACTIVE)
+		recover_xlog_ahead(r, stream, &row_count);
 	while (xlog_cursor_next_xc(&r->cursor, &row,
 				   r->wal_dir.force_recovery) == 0) {
 		/*
@@ -255,35 +556,7 @@ recover_xlog(struct recovery *r, struct xstream *stream,
 		if (stop_vclock != NULL &&
 		    r->vclock.signature >= stop_vclock->signature)
 			return;
-		int64_t current_lsn = vclock_get(&r->vclock, row.replica_id);
-		if (row.lsn <= current_lsn)
-			continue; /* already applied, skip */
-
-		/*
-		 * All rows in xlog files have an assigned
-		 * replica id.
-		 */
-		assert(row.replica_id != 0);
-		/*
-		 * We can promote the vclock either before or
-		 * after xstream_write(): it only makes any impact
-		 * in case of forced recovery, when we skip the
-		 * failed row anyway.
-		 */
-		vclock_follow_xrow(&r->vclock, &row);
-		if (xstream_write(stream, &row) == 0) {
-			++row_count;
-			if (row_count % 100000 == 0)
-				say_info("%.1fM rows processed",
-					 row_count / 1000000.);
-		} else {
-			if (!r->wal_dir.force_recovery)
-				diag_raise();
-
-			say_error("skipping row {%u: %lld}",
-				  (unsigned)row.replica_id, (long long)row.lsn);
-			diag_log();
-		}
+		recovery_apply_row(r, stream, &row, &row_count);
 	}
 }
 
@@ -58,6 +58,11 @@ struct recovery {
 	struct fiber *watcher;
 	/** List of triggers invoked when the current WAL is closed. */
 	struct rlist on_close_log;
+	/**
+	 * Read xlogs ahead in a separate thread while the rows
+	 * already read are applied, see recover_xlog().
+	 */
+	bool read_ahead;
 };
 
 struct recovery *
@@ -46,6 +46,7 @@
 #include "iproto_constants.h"
 #include "recovery.h"
 #include "replication.h"
+#include "schema_def.h"
 #include "trigger.h"
 #include "vclock.h"
 #include "version.h"
@@ -54,6 +55,17 @@
 #include "xstream.h"
 #include "wal.h"
 
+#include <fcntl.h>
+#include <msgpuck.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * sendfile(2) transfers at most 2 GB at a time, so checkpoint
+ * files are sent on initial join in chunks of this size.
+ */
+enum { RELAY_FILE_CHUNK_SIZE = 16 * 1024 * 1024 };
+
 /**
  * Cbus message to send status updates from relay to tx thread.
  */
@@ -132,6 +144,16 @@ struct relay {
 	double last_row_time;
 	/** Relay sync state. */
 	enum relay_state state;
+	/** Set if the rows are sent in a compressed stream. */
+	bool is_compressed;
+	/** Compressed stream of rows. */
+	struct xrow_zstd_writer zwriter;
+	/**
+	 * Sorted ids of the spaces the replica wants to get
+	 * rows of, NULL if all spaces are replicated.
+	 */
+	uint32_t *space_filter;
+	uint32_t space_filter_size;
 
 	struct {
 		/* Align to prevent false-sharing with tx thread */
@@ -165,11 +187,19 @@ relay_last_row_time(const struct relay *relay)
 	return relay->last_row_time;
 }
 
+const struct xrow_compression_stat *
+relay_compression_stat(const struct relay *relay)
+{
+	return relay->is_compressed ? &relay->zwriter.stat : NULL;
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
+relay_send_initial_join_file(struct xstream *stream, const char *path);
+static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
 
 struct relay *
@@ -248,6 +278,13 @@ relay_stop(struct relay *relay)
 	if (relay->r != NULL)
 		recovery_delete(relay->r);
 	relay->r = NULL;
+	if (relay->is_compressed) {
+		xrow_zstd_writer_destroy(&relay->zwriter);
+		relay->is_compressed = false;
+	}
+	free(relay->space_filter);
+	relay->space_filter = NULL;
+	relay->space_filter_size = 0;
 	relay->state = RELAY_STOPPED;
 	/*
 	 * Needed to track whether relay thread is running or not
@@ -284,13 +321,16 @@ relay_set_cord_name(int fd)
 }
 
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   uint32_t join_mode)
 {
 	struct relay *relay = relay_new(NULL);
 	if (relay == NULL)
 		diag_raise();
 
 	relay_start(relay, fd, sync, relay_send_initial_join_row);
+	if (join_mode == IPROTO_JOIN_MODE_FILES)
+		relay->stream.send_file = relay_send_initial_join_file;
 	auto relay_guard = make_scoped_guard([=] {
 		relay_stop(relay);
 		relay_delete(relay);
@@ -632,10 +672,51 @@ relay_subscribe_f(va_list ap)
 	return -1;
 }
 
+/** Remember the space ids sent by the replica in SUBSCRIBE. */
+static void
+relay_set_space_filter(struct relay *relay, const char *data)
+{
+	assert(relay->space_filter == NULL);
+	uint32_t count = mp_decode_array(&data);
+	size_t size = MAX(count, 1) * sizeof(uint32_t);
+	uint32_t *space_ids = (uint32_t *) malloc(size);
+	if (space_ids == NULL)
+		tnt_raise(OutOfMemory, size, "malloc", "space_filter");
+	for (uint32_t i = 0; i < count; i++)
+		space_ids[i] = mp_decode_uint(&data);
+	qsort(space_ids, count, sizeof(*space_ids), xrow_cmp_space_id);
+	relay->space_filter = space_ids;
+	relay->space_filter_size = count;
+}
+
+/**
+ * Return true if the row is filtered out by the space filter
+ * of the replica. The schema must be the same on all replicas,
+ * so rows of system spaces are always sent.
+ */
+static bool
+relay_is_filtered(struct relay *relay, struct xrow_header *row)
+{
+	if (relay->space_filter == NULL || row->type == IPROTO_NOP)
+		return false;
+	uint32_t space_id;
+	if (xrow_decode_space_id(row, &space_id) != 0) {
+		/* Let the replica deal with the broken row. */
+		diag_clear(diag_get());
+		return false;
+	}
+	if (space_id >= BOX_SYSTEM_ID_MIN && space_id <= BOX_SYSTEM_ID_MAX)
+		return false;
+	return bsearch(&space_id, relay->space_filter,
+		       relay->space_filter_size, sizeof(space_id),
+		       xrow_cmp_space_id) == NULL;
+}
+
 /** Replication acceptor fiber handler. */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_clock, uint32_t replica_version_id)
+		struct vclock *replica_clock, uint32_t replica_version_id,
+		bool compress, const char *space_filter)
 {
 	assert(replica->id != REPLICA_ID_NIL);
 	struct relay *relay = replica->relay;
@@ -655,6 +736,13 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 		gc_consumer_advance(replica->gc, replica_clock);
 	}
 
+	if (compress) {
+		if (xrow_zstd_writer_create(&relay->zwriter) != 0)
+			diag_raise();
+		relay->is_compressed = true;
+	}
+	if (space_filter != NULL)
+		relay_set_space_filter(relay, space_filter);
 	relay_start(relay, fd, sync, relay_send_row);
 	vclock_copy(&relay->local_vclock_at_subscribe, &replicaset.vclock);
 	relay->r = recovery_new(cfg_gets("wal_dir"), false,
@@ -683,7 +771,10 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 
 	packet->sync = relay->sync;
 	relay->last_row_time = ev_monotonic_now(loop());
-	coio_write_xrow(&relay->io, packet);
+	if (relay->is_compressed)
+		coio_write_xrow_zstd(&relay->io, &relay->zwriter, packet);
+	else
+		coio_write_xrow(&relay->io, packet);
 	fiber_gc();
 
 	inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
@@ -703,6 +794,41 @@ relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 		relay_send(relay, row);
 }
 
+/**
+ * Send a checkpoint file as is: a header with the file name and
+ * size followed by the file contents, passed to the socket with
+ * sendfile(2) chunk by chunk.
+ */
+static void
+relay_send_initial_join_file(struct xstream *stream, const char *path)
+{
+	struct relay *relay = container_of(stream, struct relay, stream);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		tnt_raise(SystemError, "failed to open file '%s'", path);
+	auto fd_guard = make_scoped_guard([=] { close(fd); });
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+		tnt_raise(SystemError, "failed to stat file '%s'", path);
+
+	const char *name = strrchr(path, '/');
+	name = name != NULL ? name + 1 : path;
+	say_info("sending file `%s' (%lld bytes)", path,
+		 (long long) st.st_size);
+	struct xrow_header row;
+	xrow_encode_file_xc(&row, name, st.st_size);
+	relay_send(relay, &row);
+
+	off_t offset = 0;
+	while (offset < st.st_size) {
+		size_t chunk = MIN(st.st_size - offset,
+				   RELAY_FILE_CHUNK_SIZE);
+		coio_sendfile(&relay->io, fd, offset, chunk);
+		offset += chunk;
+		relay->last_row_time = ev_monotonic_now(loop());
+	}
+}
+
 /** Send a single row to the client. */
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *packet)
@@ -710,11 +836,12 @@ relay_send_row(struct xstream *stream, struct xrow_header *packet)
 	struct relay *relay = container_of(stream, struct relay, stream);
 	assert(iproto_type_is_dml(packet->type));
 	/*
-	 * Transform replica local requests to IPROTO_NOP so as to
-	 * promote vclock on the replica without actually modifying
-	 * any data.
+	 * Transform replica local requests and requests filtered
+	 * out by the replica to IPROTO_NOP so as to promote vclock
+	 * on the replica without actually modifying any data.
 	 */
-	if (packet->group_id == GROUP_LOCAL) {
+	if (packet->group_id == GROUP_LOCAL ||
+	    relay_is_filtered(relay, packet)) {
 		packet->type = IPROTO_NOP;
 		packet->group_id = GROUP_DEFAULT;
 		packet->bodycnt = 0;
@@ -31,6 +31,7 @@
  * SUCH DAMAGE.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #if defined(__cplusplus)
@@ -41,6 +42,7 @@ struct relay;
 struct replica;
 struct tt_uuid;
 struct vclock;
+struct xrow_compression_stat;
 
 enum relay_state {
 	/**
@@ -93,6 +95,13 @@ relay_vclock(const struct relay *relay);
 double
 relay_last_row_time(const struct relay *relay);
 
+/**
+ * Returns compression statistics of the relay stream
+ * or NULL if the stream is not compressed.
+ */
+const struct xrow_compression_stat *
+relay_compression_stat(const struct relay *relay);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -103,9 +112,11 @@ relay_last_row_time(const struct relay *relay);
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
  * @param vclock    vclock of the last checkpoint
+ * @param join_mode way to send the data, see enum iproto_join_mode
  */
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock);
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   uint32_t join_mode);
 
 /**
  * Send final JOIN rows to the replica.
@@ -120,10 +131,15 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
 /**
  * Subscribe a replica to updates.
  *
+ * @param compress Send the rows in a compressed stream,
+ *        see xrow_zstd_writer.
+ * @param space_filter MsgPack array of ids of the spaces the
+ *        replica wants to get rows of, NULL if all spaces.
  * @return none.
  */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_vclock, uint32_t replica_version_id);
+		struct vclock *replica_vclock, uint32_t replica_version_id,
+		bool compress, const char *space_filter);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
@@ -48,11 +48,16 @@ struct tt_uuid INSTANCE_UUID;
 struct tt_uuid REPLICASET_UUID;
 
 double replication_timeout = 1.0; /* seconds */
+double replication_ack_interval = 0; /* seconds */
 double replication_connect_timeout = 30.0; /* seconds */
 int replication_connect_quorum = REPLICATION_CONNECT_QUORUM_ALL;
 double replication_sync_lag = 10.0; /* seconds */
 double replication_sync_timeout = 300.0; /* seconds */
 bool replication_skip_conflict = false;
+bool replication_compression = false;
+bool replication_join_files = false;
+uint32_t *replication_space_filter = NULL;
+uint32_t replication_space_filter_size = 0;
 
 struct replicaset replicaset;
 
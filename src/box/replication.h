@@ -112,6 +112,16 @@ extern double replication_timeout;
  */
 extern double replication_connect_timeout;
 
+/**
+ * Minimal interval between two vclock ACKs sent by an applier
+ * to its master. The transactions applied within the interval
+ * are confirmed by a single ACK. A heartbeat from the master is
+ * answered right away. The interval is capped by
+ * replication_timeout. If 0, the ACK is sent as soon as the
+ * applier has nothing else to do.
+ */
+extern double replication_ack_interval;
+
 /**
  * Minimal number of replicas to sync for this instance to switch
  * to the write mode. If set to REPLICATION_CONNECT_QUORUM_ALL,
@@ -137,6 +147,28 @@ extern double replication_sync_timeout;
  */
 extern bool replication_skip_conflict;
 
+/**
+ * Request the masters to send the rows in a compressed stream.
+ * Takes effect on the next SUBSCRIBE.
+ */
+extern bool replication_compression;
+
+/**
+ * Ask the master to send its checkpoint files as is on
+ * initial join instead of row by row. Takes effect on the
+ * next JOIN.
+ */
+extern bool replication_join_files;
+
+/**
+ * Sorted ids of the spaces to get rows of from the masters,
+ * NULL if all spaces are replicated. The masters replace rows
+ * of other non-system spaces with NOPs. Takes effect on the
+ * next SUBSCRIBE.
+ */
+extern uint32_t *replication_space_filter;
+extern uint32_t replication_space_filter_size;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
@@ -42,6 +42,7 @@
 #include "sequence.h"
 #include "key_def.h"
 #include "tuple.h"
+#include "tuple_compression.h"
 #include "xrow.h"
 #include "iproto_constants.h"
 
@@ -99,7 +100,10 @@ request_create_from_tuple(struct request *request, struct space *space,
 		request->type = IPROTO_DELETE;
 	} else {
 		uint32_t size;
-		const char *data = tuple_data_range(new_tuple, &size);
+		const char *data = tuple_data_range_decompressed(new_tuple,
+								 &size);
+		if (data == NULL)
+			return -1;
 		/*
 		 * We have to copy the tuple data to region, because
 		 * the tuple is allocated on runtime arena and not
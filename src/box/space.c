@@ -38,6 +38,7 @@
 #include "session.h"
 #include "txn.h"
 #include "tuple.h"
+#include "tuple_compression.h"
 #include "tuple_update.h"
 #include "request.h"
 #include "xrow.h"
@@ -353,7 +354,9 @@ space_before_replace(struct space *space, struct txn *txn,
 			/* Nothing to update. */
 			return 0;
 		}
-		old_data = tuple_data_range(old_tuple, &old_size);
+		old_data = tuple_data_range_decompressed(old_tuple, &old_size);
+		if (old_data == NULL)
+			return -1;
 		old_data_end = old_data + old_size;
 		new_data = tuple_update_execute(region_aligned_alloc_cb, gc,
 					request->tuple, request->tuple_end,
@@ -384,7 +387,9 @@ space_before_replace(struct space *space, struct txn *txn,
 				return -1;
 			break;
 		}
-		old_data = tuple_data_range(old_tuple, &old_size);
+		old_data = tuple_data_range_decompressed(old_tuple, &old_size);
+		if (old_data == NULL)
+			return -1;
 		old_data_end = old_data + old_size;
 		new_data = tuple_upsert_execute(region_aligned_alloc_cb, gc,
 					request->ops, request->ops_end,
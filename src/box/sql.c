@@ -47,6 +47,7 @@
 #include "space_def.h"
 #include "index_def.h"
 #include "tuple.h"
+#include "tuple_compression.h"
 #include "fiber.h"
 #include "small/region.h"
 #include "session.h"
@@ -54,11 +55,17 @@
 #include "iproto_constants.h"
 #include "fk_constraint.h"
 #include "mpstream.h"
+#include "vinyl.h"
 
 static sql *db = NULL;
 
 static const char nil_key[] = { 0x90 }; /* Empty MsgPack array. */
 
+/** Value of box.cfg.sql_scan_partitions. */
+static int sql_scan_partitions = 0;
+
+uint64_t sql_hash_join_memory = SQL_HASH_JOIN_MEMORY_LIMIT;
+
 static const uint32_t default_sql_flags = SQL_ShortColNames
 					  | SQL_EnableTrigger
 					  | SQL_AutoIndex
@@ -101,6 +108,30 @@ sql_get()
 	return db;
 }
 
+static_assert(SQL_SORTER_THREADS_MAX <= SQL_MAX_WORKER_THREADS,
+	      "SQL_SORTER_THREADS_MAX must be <= SQL_MAX_WORKER_THREADS");
+
+void
+sql_set_sorter_threads(int count)
+{
+	assert(db != NULL);
+	assert(count >= 0 && count <= SQL_SORTER_THREADS_MAX);
+	sql_limit(db, SQL_LIMIT_WORKER_THREADS, count);
+}
+
+void
+sql_set_scan_partitions(int count)
+{
+	assert(count >= 0 && count <= SQL_SCAN_PARTITIONS_MAX);
+	sql_scan_partitions = count;
+}
+
+void
+sql_set_hash_join_memory(uint64_t size)
+{
+	sql_hash_join_memory = size;
+}
+
 /*********************************************************************
  * sql cursor implementation on top of Tarantool storage API-s.
  *
@@ -181,6 +212,16 @@ const void *tarantoolsqlPayloadFetch(BtCursor *pCur, u32 *pAmt)
 	return tuple_data(pCur->last_tuple);
 }
 
+const void *
+tarantoolsqlPayloadFetchDecompressed(BtCursor *pCur, u32 *pAmt)
+{
+	assert(pCur->curFlags & BTCF_TaCursor ||
+	       pCur->curFlags & BTCF_TEphemCursor);
+	assert(pCur->last_tuple != NULL);
+
+	return tuple_data_range_decompressed(pCur->last_tuple, pAmt);
+}
+
 const void *
 tarantoolsqlTupleColumnFast(BtCursor *pCur, u32 fieldno, u32 *field_size)
 {
@@ -213,6 +254,39 @@ int tarantoolsqlFirst(BtCursor *pCur, int *pRes)
 	return cursor_seek(pCur, pRes);
 }
 
+int
+tarantoolsqlFirstParallel(BtCursor *pCur, int *pRes, int *partition_count)
+{
+	struct space *space = pCur->space;
+	*partition_count = 1;
+	/*
+	 * Reader fibers don't belong to the transaction, so
+	 * they can't be used to execute DML.
+	 */
+	if (sql_scan_partitions < 2 || !space_is_vinyl(space) ||
+	    in_txn() != NULL)
+		return tarantoolsqlFirst(pCur, pRes);
+	if (key_alloc(pCur, sizeof(nil_key)) != 0)
+		return SQL_TARANTOOL_ERROR;
+	memcpy(pCur->key, nil_key, sizeof(nil_key));
+	pCur->iter_type = ITER_GE;
+	if (pCur->iter != NULL) {
+		box_iterator_free(pCur->iter);
+		pCur->iter = NULL;
+	}
+	*partition_count = sql_scan_partitions;
+	struct iterator *it =
+		vinyl_index_create_parallel_iterator(pCur->index,
+						     partition_count);
+	if (it == NULL) {
+		pCur->eState = CURSOR_INVALID;
+		return SQL_TARANTOOL_ITERATOR_FAIL;
+	}
+	pCur->iter = it;
+	pCur->eState = CURSOR_VALID;
+	return cursor_advance(pCur, pRes);
+}
+
 /* Set cursor to the last tuple in given space. */
 int tarantoolsqlLast(BtCursor *pCur, int *pRes)
 {
@@ -258,6 +332,8 @@ int tarantoolsqlPrevious(BtCursor *pCur, int *pRes)
 int tarantoolsqlMovetoUnpacked(BtCursor *pCur, UnpackedRecord *pIdxKey,
 				   int *pRes)
 {
+	/* A filter is only valid for a full scan. */
+	pCur->filter = NULL;
 	struct region *region = &fiber()->gc;
 	size_t used = region_used(region);
 	uint32_t tuple_size;
@@ -351,6 +427,262 @@ int tarantoolsqlCount(BtCursor *pCur, i64 *pnEntry)
 	return SQL_OK;
 }
 
+/** A range of the first part of an index. */
+struct index_agg_range {
+	/** Iterator type and key to find the first entry. */
+	enum iterator_type lo_type;
+	const char *lo_key;
+	uint32_t lo_part_count;
+	/** Iterator type and key to find the last entry. */
+	enum iterator_type hi_type;
+	const char *hi_key;
+	uint32_t hi_part_count;
+	/** Bounds of the range, see struct index_agg. */
+	int lo_op;
+	int hi_op;
+	char lo_buf[16];
+	char hi_buf[16];
+};
+
+/**
+ * Encode a bound of an index_agg range as a key of the index
+ * part. Return false if the value doesn't fit the part type, so
+ * the index can't be searched for it.
+ */
+static bool
+index_agg_encode_bound(const struct Mem *mem, const struct key_part *part,
+		       char *buf)
+{
+	if ((mem->flags & MEM_Int) != 0) {
+		if (mem->u.i >= 0) {
+			mp_encode_uint(buf, mem->u.i);
+			return true;
+		}
+		if (part->type == FIELD_TYPE_UNSIGNED)
+			return false;
+		mp_encode_int(buf, mem->u.i);
+		return true;
+	}
+	if ((mem->flags & MEM_Real) != 0 && part->type == FIELD_TYPE_NUMBER) {
+		mp_encode_double(buf, mem->u.r);
+		return true;
+	}
+	return false;
+}
+
+/** Check if a tuple is on the right side of a range bound. */
+static bool
+index_agg_check_bound(struct tuple *tuple, struct key_def *key_def, int op,
+		      const char *key)
+{
+	if (op == 0)
+		return true;
+	int cmp = tuple_compare_with_key(tuple, key, 1, key_def);
+	switch (op) {
+	case TK_LT:
+		return cmp < 0;
+	case TK_LE:
+		return cmp <= 0;
+	case TK_GT:
+		return cmp > 0;
+	default:
+		assert(op == TK_GE);
+		return cmp >= 0;
+	}
+}
+
+/**
+ * Create an iterator over the index and fetch the first tuple
+ * from it. The iterator is returned to keep the tuple alive,
+ * it must be deleted by the caller.
+ */
+static struct iterator *
+index_agg_first(struct space *space, struct index *index,
+		enum iterator_type type, const char *key, uint32_t part_count,
+		struct tuple **tuple)
+{
+	struct txn *txn = NULL;
+	if (space->def->id != 0 && txn_begin_ro_stmt(space, &txn) != 0)
+		return NULL;
+	struct iterator *it = index_create_iterator(index, type, key,
+						    part_count);
+	if (it == NULL) {
+		if (txn != NULL)
+			txn_rollback_stmt();
+		return NULL;
+	}
+	if (txn != NULL)
+		txn_commit_ro_stmt(txn);
+	if (iterator_next(it, tuple) != 0) {
+		iterator_delete(it);
+		return NULL;
+	}
+	return it;
+}
+
+/**
+ * Store the first part of the tuple to a register, converting
+ * integers to reals for NUMBER columns like OP_Column does.
+ */
+static int
+index_agg_set_value(struct Mem *mem, struct tuple *tuple,
+		    const struct key_part *part)
+{
+	sqlVdbeMemSetNull(mem);
+	if (tuple == NULL)
+		return 0;
+	const char *field = tuple_field(tuple, part->fieldno);
+	if (field == NULL)
+		return 0;
+	uint32_t unused;
+	if (vdbe_decode_msgpack_into_mem(field, mem, &unused) != 0)
+		return -1;
+	if ((mem->flags & MEM_Int) != 0 && part->type == FIELD_TYPE_NUMBER)
+		sqlVdbeMemSetDouble(mem, mem->u.i);
+	return 0;
+}
+
+/** Count the tuples of a range. */
+static int
+index_agg_count(struct space *space, struct index *index,
+		const struct index_agg_range *range, int64_t *count)
+{
+	struct tuple *tuple;
+	struct iterator *it = index_agg_first(space, index, range->lo_type,
+					      range->lo_key,
+					      range->lo_part_count, &tuple);
+	if (it == NULL)
+		return -1;
+	struct key_def *key_def = index->def->key_def;
+	int rc = 0;
+	*count = 0;
+	while (tuple != NULL && index_agg_check_bound(tuple, key_def,
+						      range->hi_op,
+						      range->hi_key)) {
+		++*count;
+		if ((rc = iterator_next(it, &tuple)) != 0)
+			break;
+	}
+	iterator_delete(it);
+	return rc;
+}
+
+int
+tarantoolsqlIndexAggregate(struct BtCursor *cur, const struct index_agg *agg,
+			   struct Mem *mem, bool *is_done)
+{
+	assert(cur->curFlags & BTCF_TaCursor);
+	struct space *space = cur->space;
+	struct index *index = cur->index;
+	struct key_def *key_def = index->def->key_def;
+	const struct key_part *part = &key_def->parts[0];
+	assert(index->def->type == TREE && part->sort_order != SORT_ORDER_DESC);
+
+	struct index_agg_range range;
+	range.lo_op = agg->lo_op;
+	range.hi_op = agg->hi_op;
+	range.lo_key = range.lo_buf;
+	range.hi_key = range.hi_buf;
+	if ((agg->lo_op != 0 &&
+	     !index_agg_encode_bound(&mem[agg->lo_reg], part, range.lo_buf)) ||
+	    (agg->hi_op != 0 &&
+	     !index_agg_encode_bound(&mem[agg->hi_reg], part, range.hi_buf))) {
+		*is_done = false;
+		return SQL_OK;
+	}
+	*is_done = true;
+	/*
+	 * NULLs are the least values of an index, and never
+	 * satisfy a bound. If there is no lower bound, they are
+	 * skipped with a GT NULL search.
+	 */
+	static const char nil[] = { 0xc0 };
+	if (agg->lo_op != 0) {
+		range.lo_type = agg->lo_op == TK_GT ? ITER_GT : ITER_GE;
+		range.lo_part_count = 1;
+	} else if (key_part_is_nullable(part)) {
+		range.lo_type = ITER_GT;
+		range.lo_key = nil;
+		range.lo_part_count = 1;
+	} else {
+		range.lo_type = ITER_GE;
+		range.lo_key = NULL;
+		range.lo_part_count = 0;
+	}
+	if (agg->hi_op != 0) {
+		range.hi_type = agg->hi_op == TK_LT ? ITER_LT : ITER_LE;
+		range.hi_part_count = 1;
+	} else {
+		range.hi_type = ITER_LE;
+		range.hi_key = NULL;
+		range.hi_part_count = 0;
+	}
+
+	int64_t count = -1;
+	for (uint32_t i = 0; i < agg->func_count; ++i) {
+		const struct index_agg_def *def = &agg->funcs[i];
+		struct Mem *res = &mem[def->reg];
+		struct tuple *tuple;
+		struct iterator *it;
+		switch (def->type) {
+		case INDEX_AGG_COUNT_STAR:
+			if (agg->lo_op == 0 && agg->hi_op == 0) {
+				ssize_t size = index_count(index, ITER_ALL,
+							   NULL, 0);
+				if (size < 0)
+					return SQL_TARANTOOL_ERROR;
+				sqlVdbeMemSetInt64(res, size);
+				break;
+			}
+			FALLTHROUGH;
+		case INDEX_AGG_COUNT:
+			/*
+			 * A bounded range never has NULLs, so
+			 * COUNT(*) is the same as COUNT(column)
+			 * then.
+			 */
+			if (count < 0 &&
+			    index_agg_count(space, index, &range, &count) != 0)
+				return SQL_TARANTOOL_ITERATOR_FAIL;
+			sqlVdbeMemSetInt64(res, count);
+			break;
+		case INDEX_AGG_MIN:
+			it = index_agg_first(space, index, range.lo_type,
+					     range.lo_key, range.lo_part_count,
+					     &tuple);
+			if (it == NULL)
+				return SQL_TARANTOOL_ITERATOR_FAIL;
+			if (tuple != NULL &&
+			    !index_agg_check_bound(tuple, key_def, agg->hi_op,
+						   range.hi_key))
+				tuple = NULL;
+			if (index_agg_set_value(res, tuple, part) != 0) {
+				iterator_delete(it);
+				return SQL_TARANTOOL_ERROR;
+			}
+			iterator_delete(it);
+			break;
+		case INDEX_AGG_MAX:
+			it = index_agg_first(space, index, range.hi_type,
+					     range.hi_key, range.hi_part_count,
+					     &tuple);
+			if (it == NULL)
+				return SQL_TARANTOOL_ITERATOR_FAIL;
+			if (tuple != NULL &&
+			    !index_agg_check_bound(tuple, key_def, agg->lo_op,
+						   range.lo_key))
+				tuple = NULL;
+			if (index_agg_set_value(res, tuple, part) != 0) {
+				iterator_delete(it);
+				return SQL_TARANTOOL_ERROR;
+			}
+			iterator_delete(it);
+			break;
+		}
+	}
+	return SQL_OK;
+}
+
 struct space *
 sql_ephemeral_space_create(uint32_t field_count, struct sql_key_info *key_info)
 {
@@ -769,9 +1101,9 @@ tarantoolsqlIdxKeyCompare(struct BtCursor *cursor,
 		uint32_t fieldno = key_def->parts[i].fieldno;
 
 		if (fieldno != next_fieldno) {
-			struct tuple_field *field =
-				tuple_format_field(format, fieldno);
-			if (fieldno >= field_count ||
+			struct tuple_field *field = fieldno < field_count ?
+				tuple_format_field(format, fieldno) : NULL;
+			if (field == NULL ||
 			    field->offset_slot == TUPLE_OFFSET_SLOT_NIL) {
 				/* Outdated field_map. */
 				uint32_t j = 0;
@@ -923,6 +1255,180 @@ cursor_seek(BtCursor *pCur, int *pRes)
 	return cursor_advance(pCur, pRes);
 }
 
+/*
+ * Cursor filters. A comparator is generated for every kind of
+ * constant and every operator, so that checking a term costs
+ * a single indirect call, like tuple comparators do.
+ */
+
+/**
+ * Compare a field of a tuple with the integer constant of a
+ * filter term the same way sqlMemCompare() does.
+ *
+ * @retval 0 The result of comparison is stored in @a cmp.
+ * @retval -1 The field is NULL, so the term can't be true.
+ * @retval 1 The field can't be compared here, let the VDBE
+ *         check it.
+ */
+static inline int
+cursor_filter_cmp_int(const struct cursor_filter_term *term,
+		      const char *field, int *cmp)
+{
+	int64_t value = term->value.i;
+	double r;
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		return -1;
+	case MP_UINT: {
+		uint64_t u = mp_decode_uint(&field);
+		/* OP_Column fails to read such a value. */
+		if (u > INT64_MAX)
+			return 1;
+		int64_t i = u;
+		*cmp = i < value ? -1 : i > value;
+		return 0;
+	}
+	case MP_INT: {
+		int64_t i = mp_decode_int(&field);
+		*cmp = i < value ? -1 : i > value;
+		return 0;
+	}
+	case MP_FLOAT:
+		r = mp_decode_float(&field);
+		break;
+	case MP_DOUBLE:
+		r = mp_decode_double(&field);
+		break;
+	default:
+		return 1;
+	}
+	if (sqlIsNaN(r))
+		return -1;
+	*cmp = -sqlIntFloatCompare(value, r);
+	return 0;
+}
+
+/** Same as cursor_filter_cmp_int() for a real constant. */
+static inline int
+cursor_filter_cmp_real(const struct cursor_filter_term *term,
+		       const char *field, int *cmp)
+{
+	double value = term->value.r;
+	double r;
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		return -1;
+	case MP_UINT: {
+		uint64_t u = mp_decode_uint(&field);
+		if (u > INT64_MAX)
+			return 1;
+		*cmp = sqlIntFloatCompare(u, value);
+		return 0;
+	}
+	case MP_INT:
+		*cmp = sqlIntFloatCompare(mp_decode_int(&field), value);
+		return 0;
+	case MP_FLOAT:
+		r = mp_decode_float(&field);
+		break;
+	case MP_DOUBLE:
+		r = mp_decode_double(&field);
+		break;
+	default:
+		return 1;
+	}
+	if (sqlIsNaN(r))
+		return -1;
+	*cmp = r < value ? -1 : r > value;
+	return 0;
+}
+
+/**
+ * Same as cursor_filter_cmp_int() for a string constant, which
+ * is compared with binary collation.
+ */
+static inline int
+cursor_filter_cmp_str(const struct cursor_filter_term *term,
+		      const char *field, int *cmp)
+{
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		return -1;
+	case MP_STR: {
+		uint32_t len;
+		const char *str = mp_decode_str(&field, &len);
+		uint32_t value_len = term->value.str.len;
+		int res = memcmp(str, term->value.str.data,
+				 MIN(len, value_len));
+		*cmp = res != 0 ? res : (int) len - (int) value_len;
+		return 0;
+	}
+	default:
+		return 1;
+	}
+}
+
+typedef bool
+(*cursor_filter_term_f)(const struct cursor_filter_term *term,
+			const char *field);
+
+#define CURSOR_FILTER_TERM(kind, op, cond)				\
+static bool								\
+cursor_filter_##kind##_##op(const struct cursor_filter_term *term,	\
+			    const char *field)				\
+{									\
+	int cmp;							\
+	int rc = cursor_filter_cmp_##kind(term, field, &cmp);		\
+	return rc == 0 ? (cond) : rc > 0;				\
+}
+
+#define CURSOR_FILTER_TERMS(kind)					\
+	CURSOR_FILTER_TERM(kind, eq, cmp == 0)				\
+	CURSOR_FILTER_TERM(kind, ne, cmp != 0)				\
+	CURSOR_FILTER_TERM(kind, lt, cmp < 0)				\
+	CURSOR_FILTER_TERM(kind, le, cmp <= 0)				\
+	CURSOR_FILTER_TERM(kind, gt, cmp > 0)				\
+	CURSOR_FILTER_TERM(kind, ge, cmp >= 0)
+
+CURSOR_FILTER_TERMS(int)
+CURSOR_FILTER_TERMS(real)
+CURSOR_FILTER_TERMS(str)
+
+#undef CURSOR_FILTER_TERMS
+#undef CURSOR_FILTER_TERM
+
+#define CURSOR_FILTER_TERM_ROW(kind) {					\
+	cursor_filter_##kind##_eq, cursor_filter_##kind##_ne,		\
+	cursor_filter_##kind##_lt, cursor_filter_##kind##_le,		\
+	cursor_filter_##kind##_gt, cursor_filter_##kind##_ge,		\
+}
+
+static const cursor_filter_term_f
+cursor_filter_terms[cursor_filter_kind_MAX][cursor_filter_op_MAX] = {
+	[CURSOR_FILTER_INT] = CURSOR_FILTER_TERM_ROW(int),
+	[CURSOR_FILTER_REAL] = CURSOR_FILTER_TERM_ROW(real),
+	[CURSOR_FILTER_STR] = CURSOR_FILTER_TERM_ROW(str),
+};
+
+#undef CURSOR_FILTER_TERM_ROW
+
+/**
+ * Check if a tuple may satisfy all terms of a filter. A missing
+ * field is NULL, which doesn't satisfy any comparison.
+ */
+static bool
+cursor_filter_match(const struct cursor_filter *filter, struct tuple *tuple)
+{
+	for (uint32_t i = 0; i < filter->term_count; i++) {
+		const struct cursor_filter_term *term = &filter->terms[i];
+		const char *field = tuple_field(tuple, term->fieldno);
+		if (field == NULL ||
+		    !cursor_filter_terms[term->kind][term->op](term, field))
+			return false;
+	}
+	return true;
+}
+
 /*
  * Move cursor to the next entry in space.
  * New tuple is refed and saved in cursor.
@@ -939,8 +1445,21 @@ cursor_advance(BtCursor *pCur, int *pRes)
 	assert(pCur->iter != NULL);
 
 	struct tuple *tuple;
-	if (iterator_next(pCur->iter, &tuple) != 0)
-		return SQL_TARANTOOL_ITERATOR_FAIL;
+	while (true) {
+		if (iterator_next(pCur->iter, &tuple) != 0)
+			return SQL_TARANTOOL_ITERATOR_FAIL;
+		/*
+		 * Tuples are kept as they are stored by the
+		 * engine. Compressed fields are never indexed,
+		 * so keys are compared and extracted as is, and
+		 * the filter lets compressed values through.
+		 * They are decompressed one by one when they
+		 * are read, see OP_Column.
+		 */
+		if (tuple == NULL || pCur->filter == NULL ||
+		    cursor_filter_match(pCur->filter, tuple))
+			break;
+	}
 	if (pCur->last_tuple)
 		box_tuple_unref(pCur->last_tuple);
 	if (tuple) {
@@ -1209,11 +1728,16 @@ sql_debug_info(struct info_handler *h)
 	extern int sql_sort_count;
 	extern int sql_found_count;
 	extern int sql_xfer_count;
+	extern int sql_scan_partition_count;
+	extern int sql_decompress_count;
 	info_begin(h);
 	info_append_int(h, "sql_search_count", sql_search_count);
 	info_append_int(h, "sql_sort_count", sql_sort_count);
 	info_append_int(h, "sql_found_count", sql_found_count);
 	info_append_int(h, "sql_xfer_count", sql_xfer_count);
+	info_append_int(h, "sql_scan_partition_count",
+			sql_scan_partition_count);
+	info_append_int(h, "sql_decompress_count", sql_decompress_count);
 	info_end(h);
 }
 
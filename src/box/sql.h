@@ -64,6 +64,47 @@ sql_load_schema();
 struct sql *
 sql_get();
 
+/** Max value of box.cfg.sql_sorter_threads. */
+enum { SQL_SORTER_THREADS_MAX = 8 };
+
+/**
+ * Set the number of threads the external sorter may use to
+ * sort and merge its runs in addition to the tx thread. Zero
+ * means that sorting is done entirely in the tx thread. While
+ * waiting for the workers, a statement yields to other fibers.
+ * A statement which can't yield, because it runs in a
+ * transaction or the sort is nested in a memtx scan, sorts
+ * without workers.
+ * @param count Number of worker threads, not greater than
+ *        SQL_SORTER_THREADS_MAX.
+ */
+void
+sql_set_sorter_threads(int count);
+
+/** Max value of box.cfg.sql_scan_partitions. */
+enum { SQL_SCAN_PARTITIONS_MAX = 32 };
+
+/**
+ * Set the number of key ranges a full scan of a vinyl space
+ * may be split into to read the ranges in parallel. Only disk
+ * reads are done ahead in parallel, the rows are still filtered
+ * by the statement itself. Zero and one mean that a space is
+ * always read sequentially.
+ * @param count Number of ranges, not greater than
+ *        SQL_SCAN_PARTITIONS_MAX.
+ */
+void
+sql_set_scan_partitions(int count);
+
+/**
+ * Set the max amount of memory the build table of a hash join
+ * may take on the SQL heap. Rows which don't fit are spilled
+ * to an ephemeral space.
+ * @param size Size in bytes.
+ */
+void
+sql_set_hash_join_memory(uint64_t size);
+
 struct Expr;
 struct Parse;
 struct Select;
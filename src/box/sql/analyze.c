@@ -1617,7 +1617,8 @@ index_field_tuple_est(const struct index_def *idx_def, uint32_t field)
 	/* Statistics is held only in real indexes. */
 	struct index *tnt_idx = space_index(space, idx_def->iid);
 	assert(tnt_idx != NULL);
-	if (tnt_idx->def->opts.stat == NULL) {
+	struct index_stat *stat = sql_index_stat(tnt_idx);
+	if (stat == NULL) {
 		/*
 		 * Last number for unique index is always 0:
 		 * only one tuple exists with given full key
@@ -1628,7 +1629,21 @@ index_field_tuple_est(const struct index_def *idx_def, uint32_t field)
 			return 0;
 		return default_tuple_est[field + 1 >= 6 ? 6 : field];
 	}
-	return tnt_idx->def->opts.stat->tuple_log_est[field];
+	return stat->tuple_log_est[field];
+}
+
+struct index_stat *
+sql_index_stat(struct index *index)
+{
+	struct index_stat *stat = index->def->opts.stat;
+	if (stat == NULL)
+		return NULL;
+	uint64_t analyzed = stat->tuple_stat1[0];
+	uint64_t current = index_size(index);
+	if (current > analyzed * SQL_STAT_STALE_RATIO ||
+	    current * SQL_STAT_STALE_RATIO < analyzed)
+		return NULL;
+	return stat;
 }
 
 /**
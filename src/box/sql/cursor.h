@@ -50,6 +50,11 @@ struct BtCursor {
 	enum iterator_type iter_type;
 	struct tuple *last_tuple;
 	char *key;		/* Saved key that was cursor last known position */
+	/**
+	 * Filter tuples of a scan are checked against before
+	 * they are returned, NULL if there is no filter.
+	 */
+	const struct cursor_filter *filter;
 };
 
 void sqlCursorZero(BtCursor *);
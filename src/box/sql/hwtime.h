@@ -41,14 +41,12 @@
  * The following routine only works on pentium-class (or newer) processors.
  * It uses the RDTSC opcode to read the cycle count value out of the
  * processor and returns that value.  This can be used for high-res
- * profiling.
+ * profiling, e.g. by EXPLAIN ANALYZE.
  */
-#if (defined(__GNUC__) || defined(_MSC_VER)) && \
-      (defined(i386) || defined(__i386__) || defined(_M_IX86))
+#if defined(__GNUC__) && \
+      (defined(i386) || defined(__i386__) || defined(__x86_64__))
 
-#if defined(__GNUC__)
-
-__inline__ sql_uint64
+static inline sql_uint64
 sqlHwtime(void)
 {
 	unsigned int lo, hi;
@@ -56,32 +54,19 @@ sqlHwtime(void)
 	return (sql_uint64) hi << 32 | lo;
 }
 
-#elif defined(_MSC_VER)
-
-__declspec(naked)
-__inline sql_uint64 __cdecl
-sqlHwtime(void)
-{
-	__asm {
-		rdtsc ret;
- return value at EDX:EAX}
-}
-
-#endif
-
-#elif (defined(__GNUC__) && defined(__x86_64__))
+#elif (defined(__GNUC__) && defined(__aarch64__))
 
-__inline__ sql_uint64
+static inline sql_uint64
 sqlHwtime(void)
 {
-	unsigned long val;
-	__asm__ __volatile__("rdtsc":"=A"(val));
+	sql_uint64 val;
+	__asm__ __volatile__("mrs %0, cntvct_el0":"=r"(val));
 	return val;
 }
 
 #elif (defined(__GNUC__) && defined(__ppc__))
 
-__inline__ sql_uint64
+static inline sql_uint64
 sqlHwtime(void)
 {
 	unsigned long long retval;
@@ -97,19 +82,17 @@ sqlHwtime(void)
 
 #else
 
-#error Need implementation of sqlHwtime() for your platform.
+#include "clock.h"
 
-  /*
-   * To compile without implementing sqlHwtime() for your platform,
-   * you can remove the above #error and use the following
-   * stub function.  You will lose timing support for many
-   * of the debugging and testing utilities, but it should at
-   * least compile and run.
-   */
-sql_uint64
+/*
+ * There is no cycle counter we know how to read on this
+ * platform, so count nanoseconds of the monotonic clock
+ * instead.
+ */
+static inline sql_uint64
 sqlHwtime(void)
 {
-	return ((sql_uint64) 0);
+	return clock_monotonic64();
 }
 
 #endif
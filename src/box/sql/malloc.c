@@ -34,6 +34,7 @@
  * Memory allocation functions used throughout sql.
  */
 #include "sqlInt.h"
+#include "bit/bit.h"
 #include <stdarg.h>
 
 /*
@@ -502,6 +503,57 @@ isLookaside(sql * db, void *p)
 #define isLookaside(A,B) 0
 #endif
 
+/*
+ * Return the index of the block cache class which a request of
+ * n bytes is served from, or -1 if it is too big to be cached.
+ */
+static inline int
+block_cache_class(u64 n)
+{
+	if (n > (1 << SQL_BLOCK_CACHE_MAX_LOG))
+		return -1;
+	if (n <= (1 << SQL_BLOCK_CACHE_MIN_LOG))
+		return 0;
+	return 64 - bit_clz_u64(n - 1) - SQL_BLOCK_CACHE_MIN_LOG;
+}
+
+/*
+ * Take a block of class cls from the cache of db. Return NULL
+ * if the class list is empty.
+ */
+static inline void *
+block_cache_get(sql * db, int cls)
+{
+	struct sql_block_cache *cache = &db->block_cache;
+	void *p = cache->free[cls];
+	if (p == NULL)
+		return NULL;
+	cache->free[cls] = *(void **)p;
+	cache->count[cls]--;
+	return p;
+}
+
+/*
+ * Put heap block p to the cache of db. Return 0 if the block
+ * size doesn't match any class or the class list is full, so
+ * the block must be freed.
+ */
+static inline int
+block_cache_put(sql * db, void *p)
+{
+	int size = sql_sized_sizeof(p);
+	int cls = block_cache_class(size);
+	if (cls < 0 || size != 1 << (cls + SQL_BLOCK_CACHE_MIN_LOG))
+		return 0;
+	struct sql_block_cache *cache = &db->block_cache;
+	if ((cache->count[cls] + 1) * (u64)size > SQL_BLOCK_CACHE_CLASS_BYTES)
+		return 0;
+	*(void **)p = cache->free[cls];
+	cache->free[cls] = p;
+	cache->count[cls]++;
+	return 1;
+}
+
 /*
  * Return the size of a memory allocation previously obtained from
  * sqlMalloc() or sql_malloc().
@@ -602,6 +654,8 @@ sqlDbFree(sql * db, void *p)
 	       (p, (u8) ~ (MEMTYPE_LOOKASIDE | MEMTYPE_HEAP)));
 	assert(db != 0 || sqlMemdebugNoType(p, MEMTYPE_LOOKASIDE));
 	sqlMemdebugSetType(p, MEMTYPE_HEAP);
+	if (db != 0 && block_cache_put(db, p))
+		return;
 	sql_free(p);
 }
 
@@ -710,13 +764,20 @@ sqlDbMallocZero(sql * db, u64 n)
 
 /* Finish the work of sqlDbMallocRawNN for the unusual and
  * slower case when the allocation cannot be fulfilled using lookaside.
+ * The block is taken from the block cache if possible.
  */
 static SQL_NOINLINE void *
 dbMallocRawFinish(sql * db, u64 n)
 {
-	void *p;
+	void *p = NULL;
 	assert(db != 0);
-	p = sqlMalloc(n);
+	int cls = block_cache_class(n);
+	if (cls >= 0) {
+		p = block_cache_get(db, cls);
+		n = 1 << (cls + SQL_BLOCK_CACHE_MIN_LOG);
+	}
+	if (p == NULL)
+		p = sqlMalloc(n);
 	if (!p)
 		sqlOomFault(db);
 	sqlMemdebugSetType(p,
@@ -824,6 +885,20 @@ dbReallocFinish(sql * db, void *p, u64 n)
 				memcpy(pNew, p, db->lookaside.sz);
 				sqlDbFree(db, p);
 			}
+		} else if (block_cache_class(n) >= 0) {
+			/*
+			 * Keep the block within the cache
+			 * classes so that it is reused after
+			 * being freed.
+			 */
+			int size = sqlDbMallocSize(db, p);
+			if (n <= (u64)size)
+				return p;
+			pNew = sqlDbMallocRawNN(db, n);
+			if (pNew) {
+				memcpy(pNew, p, size);
+				sqlDbFree(db, p);
+			}
 		} else {
 			assert(sqlMemdebugHasType
 			       (p, (MEMTYPE_LOOKASIDE | MEMTYPE_HEAP)));
@@ -38,6 +38,7 @@
 #include <sys/time.h>
 #include <errno.h>
 #include <sys/mman.h>
+#include "tt_pthread.h"
 
 
 /*
@@ -320,6 +321,13 @@ struct unixInodeInfo {
  */
 static unixInodeInfo *inodeList = 0;
 
+/*
+ * Mutex protecting inodeList and the objects on it. Temporary
+ * files of the sorter are opened and closed by its worker
+ * threads as well as by the main thread.
+ */
+static pthread_mutex_t inodeListMutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  *
  * This function - unixLogErrorAtLine(), is only ever called via the macro
@@ -767,6 +775,7 @@ unixClose(sql_file * id)
 	int rc;
 	unixFile *pFile = (unixFile *) id;
 	verifyDbFile(pFile);
+	tt_pthread_mutex_lock(&inodeListMutex);
 	unixUnlock(id, NO_LOCK);
 
 	/* unixFile.pInode is always valid here. Otherwise, a different close
@@ -783,6 +792,7 @@ unixClose(sql_file * id)
 	}
 	releaseInodeInfo(pFile);
 	rc = closeUnixFile(id);
+	tt_pthread_mutex_unlock(&inodeListMutex);
 	return rc;
 }
 
@@ -1498,7 +1508,9 @@ fillInUnixFile(sql_vfs * pVfs,	/* Pointer to vfs object */
 	}
 
 	if (pLockingStyle == &posixIoMethods) {
+		tt_pthread_mutex_lock(&inodeListMutex);
 		rc = findInodeInfo(pNew, &pNew->pInode);
+		tt_pthread_mutex_unlock(&inodeListMutex);
 		if (rc != SQL_OK) {
 			/* If an error occurred in findInodeInfo(), close the file descriptor
 			 * immediately. findInodeInfo() may fail
@@ -1636,6 +1648,7 @@ findReusableFd(const char *zPath, int flags)
 	if (0 == stat(zPath, &sStat)) {
 		unixInodeInfo *pInode;
 
+		tt_pthread_mutex_lock(&inodeListMutex);
 		pInode = inodeList;
 		while (pInode && (pInode->fileId.dev != sStat.st_dev
 				  || pInode->fileId.ino !=
@@ -1652,6 +1665,7 @@ findReusableFd(const char *zPath, int flags)
 				*pp = pUnused->pNext;
 			}
 		}
+		tt_pthread_mutex_unlock(&inodeListMutex);
 	}
 	return pUnused;
 }
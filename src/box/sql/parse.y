@@ -121,8 +121,11 @@ ecmd ::= SEMI. {
   pParse->is_aborted = true;
 }
 explain ::= .
-explain ::= EXPLAIN.              { pParse->explain = 1; }
+// The precedence makes "EXPLAIN ANALYZE" the prefix of the
+// statement that follows rather than EXPLAIN of ANALYZE.
+explain ::= EXPLAIN. [OR]         { pParse->explain = 1; }
 explain ::= EXPLAIN QUERY PLAN.   { pParse->explain = 2; }
+explain ::= EXPLAIN ANALYZE.      { pParse->explain = 3; }
 cmdx ::= cmd.
 
 // Define operator precedence early so that this is the first occurrence
@@ -147,6 +150,7 @@ cmdx ::= cmd.
 %left CONCAT.
 %left COLLATE.
 %right BITNOT.
+%nonassoc ANALYZE.
 
 
 ///////////////////// Begin and end transactions. ////////////////////////////
@@ -1600,6 +1604,10 @@ cmd ::= DROP TRIGGER ifexists(NOERR) fullname(X). {
   sql_drop_trigger(pParse);
 }
 
+//////////////////////// The ANALYZE command ////////////////////////////////////
+cmd ::= ANALYZE.                {sqlAnalyze(pParse, 0);}
+cmd ::= ANALYZE nm(X).          {sqlAnalyze(pParse, &X);}
+
 //////////////////////// ALTER TABLE table ... ////////////////////////////////
 %include {
   struct alter_args {
@@ -125,20 +125,29 @@ sqlPrepare(sql * db,	/* Database handle. */
 			/* 13 */ "TEXT",
 			/* 14 */ "comment",
 			/* 15 */ "TEXT",
-			/* 16 */ "selectid",
+			/* 16 */ "count",
 			/* 17 */ "INTEGER",
-			/* 18 */ "order",
+			/* 18 */ "rows",
 			/* 19 */ "INTEGER",
-			/* 20 */ "from",
+			/* 20 */ "cycles",
 			/* 21 */ "INTEGER",
-			/* 22 */ "detail",
-			/* 23 */ "TEXT",
+			/* 22 */ "selectid",
+			/* 23 */ "INTEGER",
+			/* 24 */ "order",
+			/* 25 */ "INTEGER",
+			/* 26 */ "from",
+			/* 27 */ "INTEGER",
+			/* 28 */ "detail",
+			/* 29 */ "TEXT",
 		};
 
 		int name_first, name_count;
 		if (sParse.explain == 2) {
-			name_first = 16;
+			name_first = 22;
 			name_count = 4;
+		} else if (sParse.explain == 3) {
+			name_first = 0;
+			name_count = 11;
 		} else {
 			name_first = 0;
 			name_count = 8;
@@ -37,6 +37,7 @@
  * to generate random integer keys for tables or random filenames.
  */
 #include "sqlInt.h"
+#include "tt_pthread.h"
 
 /* All threads share a single random number generator.
  * This structure is the current state of the generator.
@@ -47,6 +48,12 @@ static SQL_WSD struct sqlPrngType {
 	unsigned char s[256];	/* State variables */
 } sqlPrng;
 
+/*
+ * Worker threads of the sorter generate names of temporary
+ * files concurrently with the main thread.
+ */
+static pthread_mutex_t sqlPrngMutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Return N random bytes.
  */
@@ -75,8 +82,10 @@ sql_randomness(int N, void *pBuf)
 		return;
 #endif
 
+	tt_pthread_mutex_lock(&sqlPrngMutex);
 	if (N <= 0 || pBuf == 0) {
 		wsdPrng.isInit = 0;
+		tt_pthread_mutex_unlock(&sqlPrngMutex);
 		return;
 	}
 
@@ -117,6 +126,7 @@ sql_randomness(int N, void *pBuf)
 		t += wsdPrng.s[wsdPrng.i];
 		*(zBuf++) = wsdPrng.s[t];
 	} while (--N);
+	tt_pthread_mutex_unlock(&sqlPrngMutex);
 }
 
 #ifndef SQL_UNTESTABLE
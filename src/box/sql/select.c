@@ -5425,6 +5425,648 @@ explain_simple_count(struct Parse *parse_context, const char *table_name)
 	}
 }
 
+/**
+ * Check if the expression is a reference to a column of
+ * INTEGER, UNSIGNED or NUMBER type of the table opened by the
+ * given cursor.
+ */
+static bool
+batch_agg_is_numeric_column(struct Expr *expr, int cursor,
+			    struct space_def *def)
+{
+	if ((expr->op != TK_COLUMN && expr->op != TK_AGG_COLUMN) ||
+	    expr->iTable != cursor || expr->iColumn < 0 ||
+	    (uint32_t) expr->iColumn >= def->field_count)
+		return false;
+	enum field_type type = def->fields[expr->iColumn].type;
+	return type == FIELD_TYPE_INTEGER || type == FIELD_TYPE_UNSIGNED ||
+	       type == FIELD_TYPE_NUMBER;
+}
+
+/** Check if the expression is a possibly negated number. */
+static bool
+batch_agg_is_numeric_literal(struct Expr *expr)
+{
+	if (expr->op == TK_UMINUS)
+		expr = expr->pLeft;
+	return expr->op == TK_INTEGER || expr->op == TK_FLOAT;
+}
+
+/**
+ * Check if the WHERE term is a comparison of a numeric column
+ * with a numeric literal. On success the column and the literal
+ * are returned in @a column and @a value, and @a op is set to
+ * the operator with the column on the left side.
+ */
+static bool
+batch_agg_filter_term(struct Expr *term, int cursor, struct space_def *def,
+		      struct Expr **column, struct Expr **value, int *op)
+{
+	switch (term->op) {
+	case TK_EQ:
+	case TK_NE:
+	case TK_LT:
+	case TK_LE:
+	case TK_GT:
+	case TK_GE:
+		break;
+	default:
+		return false;
+	}
+	*op = term->op;
+	if (batch_agg_is_numeric_column(term->pLeft, cursor, def) &&
+	    batch_agg_is_numeric_literal(term->pRight)) {
+		*column = term->pLeft;
+		*value = term->pRight;
+		return true;
+	}
+	if (batch_agg_is_numeric_column(term->pRight, cursor, def) &&
+	    batch_agg_is_numeric_literal(term->pLeft)) {
+		*column = term->pRight;
+		*value = term->pLeft;
+		if (*op == TK_LT)
+			*op = TK_GT;
+		else if (*op == TK_LE)
+			*op = TK_GE;
+		else if (*op == TK_GT)
+			*op = TK_LT;
+		else if (*op == TK_GE)
+			*op = TK_LE;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Count the terms of the WHERE clause, which must be a
+ * conjunction of terms accepted by batch_agg_filter_term().
+ *
+ * @retval -1 if the clause can't be evaluated by
+ *         OP_BatchAggregate.
+ */
+static int
+batch_agg_filter_count(struct Expr *where, int cursor, struct space_def *def)
+{
+	if (where->op == TK_AND) {
+		int left = batch_agg_filter_count(where->pLeft, cursor, def);
+		if (left < 0)
+			return -1;
+		int right = batch_agg_filter_count(where->pRight, cursor, def);
+		if (right < 0)
+			return -1;
+		return left + right;
+	}
+	struct Expr *column, *value;
+	int op;
+	if (!batch_agg_filter_term(where, cursor, def, &column, &value, &op))
+		return -1;
+	return 1;
+}
+
+/**
+ * Check if a term of the WHERE clause, which must be accepted
+ * by batch_agg_filter_count(), compares the first part of an
+ * index of the space. The planner would search the index with
+ * such a term instead of scanning the whole space.
+ */
+static bool
+batch_agg_filter_is_indexed(struct Expr *where, int cursor,
+			    struct space *space)
+{
+	if (where->op == TK_AND) {
+		return batch_agg_filter_is_indexed(where->pLeft, cursor,
+						   space) ||
+		       batch_agg_filter_is_indexed(where->pRight, cursor,
+						   space);
+	}
+	struct Expr *column, *value;
+	int op;
+	MAYBE_UNUSED bool ok = batch_agg_filter_term(where, cursor,
+						     space->def, &column,
+						     &value, &op);
+	assert(ok);
+	if (op == TK_NE)
+		return false;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct key_def *key_def = space->index[i]->def->key_def;
+		if (key_def->parts[0].fieldno == (uint32_t) column->iColumn)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Return the kind of an aggregate function OP_BatchAggregate
+ * can compute or -1.
+ */
+static int
+batch_agg_func_type(struct AggInfo_func *func, int cursor,
+		    struct space_def *def)
+{
+	struct Expr *expr = func->pExpr;
+	if (func->iDistinct >= 0 || (expr->flags & EP_Distinct) != 0)
+		return -1;
+	struct ExprList *args = expr->x.pList;
+	if ((func->pFunc->funcFlags & SQL_FUNC_COUNT) != 0 &&
+	    (args == NULL || args->nExpr == 0))
+		return BATCH_AGG_COUNT_STAR;
+	if (args == NULL || args->nExpr != 1 ||
+	    !batch_agg_is_numeric_column(args->a[0].pExpr, cursor, def))
+		return -1;
+	const char *name = func->pFunc->zName;
+	if (sqlStrICmp(name, "count") == 0)
+		return BATCH_AGG_COUNT;
+	if (sqlStrICmp(name, "sum") == 0)
+		return BATCH_AGG_SUM;
+	if (sqlStrICmp(name, "total") == 0)
+		return BATCH_AGG_TOTAL;
+	if (sqlStrICmp(name, "avg") == 0)
+		return BATCH_AGG_AVG;
+	return -1;
+}
+
+/** Find or add a field number in the column list of a program. */
+static uint32_t
+batch_agg_column(struct batch_agg *agg, uint32_t fieldno)
+{
+	uint32_t i = 0;
+	while (i < agg->column_count && agg->fieldno[i] < fieldno)
+		i++;
+	if (i < agg->column_count && agg->fieldno[i] == fieldno)
+		return i;
+	memmove(&agg->fieldno[i + 1], &agg->fieldno[i],
+		(agg->column_count - i) * sizeof(agg->fieldno[0]));
+	agg->fieldno[i] = fieldno;
+	agg->column_count++;
+	return i;
+}
+
+/**
+ * Add the filters of the WHERE clause to a program and code
+ * their literals into registers.
+ */
+static void
+batch_agg_add_filters(struct Parse *parse, struct batch_agg *agg,
+		      struct Expr *where, int cursor, struct space_def *def)
+{
+	if (where->op == TK_AND) {
+		batch_agg_add_filters(parse, agg, where->pLeft, cursor, def);
+		batch_agg_add_filters(parse, agg, where->pRight, cursor, def);
+		return;
+	}
+	struct batch_agg_filter *filter = &agg->filters[agg->filter_count++];
+	struct Expr *column, *value;
+	MAYBE_UNUSED bool ok = batch_agg_filter_term(where, cursor, def,
+						     &column, &value,
+						     &filter->op);
+	assert(ok);
+	/* Store the field number until all columns are known. */
+	filter->column = column->iColumn;
+	filter->reg = ++parse->nMem;
+	sqlExprCode(parse, value, filter->reg);
+}
+
+/**
+ * Try to code an aggregate query without GROUP BY of the form
+ *
+ *   SELECT count(*), sum(a), avg(b) FROM t WHERE a > 1 AND b < 2;
+ *
+ * with OP_BatchAggregate, which scans the space a batch of
+ * tuples at a time instead of running the VDBE loop per tuple.
+ * The query must read a single space and compute only COUNT,
+ * SUM, TOTAL and AVG of its numeric columns. The WHERE clause,
+ * if any, must be a conjunction of comparisons of numeric
+ * columns with numeric literals, none of which can be used
+ * to search an index: the batch scan never beats a seek.
+ *
+ * @param parse Current parsing context.
+ * @param select The select statement in form of aggregate query.
+ * @param agg_info The associated aggregate-info object.
+ *
+ * @retval true if the query has been coded.
+ */
+static bool
+vdbe_emit_batch_aggregate(struct Parse *parse, struct Select *select,
+			  struct AggInfo *agg_info)
+{
+	assert(select->pGroupBy == NULL);
+	if (select->pHaving != NULL || select->pSrc->nSrc != 1 ||
+	    select->pSrc->a[0].pSelect != NULL ||
+	    select->pSrc->a[0].fg.isIndexedBy ||
+	    agg_info->nAccumulator != 0 || agg_info->nFunc == 0)
+		return false;
+	struct SrcList_item *src = &select->pSrc->a[0];
+	struct space *space = src->space;
+	assert(space != NULL && !space->def->opts.is_view);
+	if (space->index_count == 0)
+		return false;
+	struct space_def *def = space->def;
+	int cursor = src->iCursor;
+	int filter_count = 0;
+	if (select->pWhere != NULL) {
+		filter_count = batch_agg_filter_count(select->pWhere, cursor,
+						      def);
+		if (filter_count < 0 ||
+		    batch_agg_filter_is_indexed(select->pWhere, cursor, space))
+			return false;
+	}
+	int func_count = agg_info->nFunc;
+	for (int i = 0; i < func_count; i++) {
+		if (batch_agg_func_type(&agg_info->aFunc[i], cursor, def) < 0)
+			return false;
+	}
+
+	uint32_t max_columns = filter_count + func_count;
+	size_t size = sizeof(struct batch_agg) +
+		      filter_count * sizeof(struct batch_agg_filter) +
+		      func_count * sizeof(struct batch_agg_def) +
+		      max_columns * (sizeof(uint32_t) + sizeof(bool));
+	struct batch_agg *agg = sqlDbMallocZero(parse->db, size);
+	if (agg == NULL)
+		return false;
+	agg->filters = (struct batch_agg_filter *) &agg[1];
+	agg->funcs = (struct batch_agg_def *) &agg->filters[filter_count];
+	agg->fieldno = (uint32_t *) &agg->funcs[func_count];
+	agg->is_real = (bool *) &agg->fieldno[max_columns];
+	if (select->pWhere != NULL)
+		batch_agg_add_filters(parse, agg, select->pWhere, cursor, def);
+	assert(agg->filter_count == (uint32_t) filter_count);
+	agg->func_count = func_count;
+	for (int i = 0; i < func_count; i++) {
+		struct AggInfo_func *func = &agg_info->aFunc[i];
+		struct batch_agg_def *agg_def = &agg->funcs[i];
+		agg_def->type = batch_agg_func_type(func, cursor, def);
+		agg_def->reg = func->iMem;
+		if (agg_def->type != BATCH_AGG_COUNT_STAR) {
+			struct Expr *arg = func->pExpr->x.pList->a[0].pExpr;
+			batch_agg_column(agg, arg->iColumn);
+		}
+	}
+	for (uint32_t i = 0; i < agg->filter_count; i++)
+		batch_agg_column(agg, agg->filters[i].column);
+	/* Now the column list is final, map field numbers to it. */
+	for (uint32_t i = 0; i < agg->filter_count; i++) {
+		struct batch_agg_filter *filter = &agg->filters[i];
+		filter->column = batch_agg_column(agg, filter->column);
+	}
+	for (int i = 0; i < func_count; i++) {
+		struct batch_agg_def *agg_def = &agg->funcs[i];
+		if (agg_def->type == BATCH_AGG_COUNT_STAR)
+			continue;
+		struct Expr *arg = agg_info->aFunc[i].pExpr->x.pList->a[0].pExpr;
+		agg_def->column = batch_agg_column(agg, arg->iColumn);
+	}
+	for (uint32_t i = 0; i < agg->column_count; i++) {
+		agg->is_real[i] =
+			def->fields[agg->fieldno[i]].type == FIELD_TYPE_NUMBER;
+	}
+
+	struct Vdbe *v = parse->pVdbe;
+	vdbe_emit_open_cursor(parse, cursor, 0, space);
+	sqlVdbeAddOp4(v, OP_BatchAggregate, cursor, 0, 0, (char *) agg,
+		      P4_BATCHAGG);
+	sqlVdbeAddOp1(v, OP_Close, cursor);
+	if (parse->explain == 2) {
+		char *eqp = sqlMPrintf(parse->db, "SCAN TABLE %s", def->name);
+		sqlVdbeAddOp4(v, OP_Explain, parse->iSelectId, 0, 0, eqp,
+			      P4_DYNAMIC);
+	}
+	return true;
+}
+
+/**
+ * Plan of an aggregate query computed by OP_IndexAggregate
+ * over a range of the first part of an index.
+ */
+struct index_agg_plan {
+	/** Index to search, NULL if there is no plan. */
+	struct index *index;
+	/** Indexed column, -1 if not known yet. */
+	int column;
+	/** Lower bound: TK_GT or TK_GE and its value, if any. */
+	int lo_op;
+	struct Expr *lo;
+	/** Upper bound: TK_LT or TK_LE and its value, if any. */
+	int hi_op;
+	struct Expr *hi;
+	/**
+	 * True if a bound is a bind parameter, which may turn out
+	 * not to be a value of the column type at runtime.
+	 */
+	bool has_variables;
+};
+
+/**
+ * Check if the expression can be a bound of a range of an index
+ * part of the given numeric type.
+ */
+static bool
+index_agg_is_bound(struct Expr *expr, enum field_type type)
+{
+	if (expr->op == TK_VARIABLE)
+		return true;
+	if (expr->op == TK_UMINUS) {
+		if (type == FIELD_TYPE_UNSIGNED)
+			return false;
+		expr = expr->pLeft;
+	}
+	return expr->op == TK_INTEGER ||
+	       (expr->op == TK_FLOAT && type == FIELD_TYPE_NUMBER);
+}
+
+/**
+ * Add a "column <op> value" term to the bounds of the range.
+ *
+ * @retval false if the term is on another column or the range
+ *         already has such a bound.
+ */
+static bool
+index_agg_add_bound(struct index_agg_plan *plan, struct Expr *column, int op,
+		    struct Expr *value, struct space_def *def)
+{
+	if (plan->column >= 0 && column->iColumn != plan->column)
+		return false;
+	plan->column = column->iColumn;
+	if (!index_agg_is_bound(value, def->fields[plan->column].type))
+		return false;
+	if (value->op == TK_VARIABLE)
+		plan->has_variables = true;
+	if (op == TK_GT || op == TK_GE || op == TK_EQ) {
+		if (plan->lo_op != 0)
+			return false;
+		plan->lo_op = op == TK_EQ ? TK_GE : op;
+		plan->lo = value;
+	}
+	if (op == TK_LT || op == TK_LE || op == TK_EQ) {
+		if (plan->hi_op != 0)
+			return false;
+		plan->hi_op = op == TK_EQ ? TK_LE : op;
+		plan->hi = value;
+	}
+	return true;
+}
+
+/**
+ * Add the terms of the WHERE clause to the bounds of the range.
+ * The clause must be a conjunction of comparisons and BETWEENs
+ * of a numeric column with numeric literals or bind parameters.
+ */
+static bool
+index_agg_add_where(struct index_agg_plan *plan, struct Expr *where,
+		    int cursor, struct space_def *def)
+{
+	if (where->op == TK_AND) {
+		return index_agg_add_where(plan, where->pLeft, cursor, def) &&
+		       index_agg_add_where(plan, where->pRight, cursor, def);
+	}
+	if (where->op == TK_BETWEEN) {
+		struct ExprList *list = where->x.pList;
+		return batch_agg_is_numeric_column(where->pLeft, cursor,
+						   def) &&
+		       index_agg_add_bound(plan, where->pLeft, TK_GE,
+					   list->a[0].pExpr, def) &&
+		       index_agg_add_bound(plan, where->pLeft, TK_LE,
+					   list->a[1].pExpr, def);
+	}
+	int op = where->op;
+	if (op != TK_EQ && op != TK_LT && op != TK_LE && op != TK_GT &&
+	    op != TK_GE)
+		return false;
+	if (batch_agg_is_numeric_column(where->pLeft, cursor, def)) {
+		return index_agg_add_bound(plan, where->pLeft, op,
+					   where->pRight, def);
+	}
+	if (batch_agg_is_numeric_column(where->pRight, cursor, def)) {
+		if (op == TK_LT)
+			op = TK_GT;
+		else if (op == TK_LE)
+			op = TK_GE;
+		else if (op == TK_GT)
+			op = TK_LT;
+		else if (op == TK_GE)
+			op = TK_LE;
+		return index_agg_add_bound(plan, where->pRight, op,
+					   where->pLeft, def);
+	}
+	return false;
+}
+
+/**
+ * Return the kind of an aggregate function OP_IndexAggregate
+ * can compute or -1. All the functions except COUNT(*) must be
+ * over the same column, which is stored to @a column.
+ */
+static int
+index_agg_func_type(struct AggInfo_func *func, int cursor,
+		    struct space_def *def, int *column)
+{
+	struct Expr *expr = func->pExpr;
+	if (func->iDistinct >= 0 || (expr->flags & EP_Distinct) != 0)
+		return -1;
+	struct ExprList *args = expr->x.pList;
+	if ((func->pFunc->funcFlags & SQL_FUNC_COUNT) != 0 &&
+	    (args == NULL || args->nExpr == 0))
+		return INDEX_AGG_COUNT_STAR;
+	if (args == NULL || args->nExpr != 1 ||
+	    !batch_agg_is_numeric_column(args->a[0].pExpr, cursor, def))
+		return -1;
+	int fieldno = args->a[0].pExpr->iColumn;
+	if (*column >= 0 && fieldno != *column)
+		return -1;
+	*column = fieldno;
+	const char *name = func->pFunc->zName;
+	if (sqlStrICmp(name, "count") == 0)
+		return INDEX_AGG_COUNT;
+	if (sqlStrICmp(name, "min") == 0)
+		return INDEX_AGG_MIN;
+	if (sqlStrICmp(name, "max") == 0)
+		return INDEX_AGG_MAX;
+	return -1;
+}
+
+/**
+ * Check if an aggregate query without GROUP BY of the form
+ *
+ *   SELECT count(*), min(a), max(a) FROM t WHERE a BETWEEN ? AND ?;
+ *
+ * can be computed by OP_IndexAggregate: MIN and MAX with a
+ * single seek each and COUNT by walking the range of an ordered
+ * index on the column, without running the VDBE loop. The query
+ * must read a single space and compute only COUNT, MIN and MAX
+ * of one numeric column. The WHERE clause, if any, must restrict
+ * the same column to a range.
+ *
+ * Queries which are served as well by OP_Count, OP_BatchAggregate
+ * or a single min() or max() seek by where.c are left to them.
+ *
+ * @param select The select statement in form of aggregate query.
+ * @param agg_info The associated aggregate-info object.
+ * @param[out] plan The plan of the query.
+ *
+ * @retval true if the query can be computed by the index.
+ */
+static bool
+index_agg_plan_create(struct Select *select, struct AggInfo *agg_info,
+		      struct index_agg_plan *plan)
+{
+	assert(select->pGroupBy == NULL);
+	memset(plan, 0, sizeof(*plan));
+	plan->column = -1;
+	if (select->pSrc->nSrc != 1 || select->pSrc->a[0].pSelect != NULL ||
+	    select->pSrc->a[0].fg.isIndexedBy ||
+	    agg_info->nAccumulator != 0 || agg_info->nFunc == 0)
+		return false;
+	struct SrcList_item *src = &select->pSrc->a[0];
+	struct space *space = src->space;
+	assert(space != NULL && !space->def->opts.is_view);
+	struct space_def *def = space->def;
+	int cursor = src->iCursor;
+	bool has_min_max = false;
+	for (int i = 0; i < agg_info->nFunc; i++) {
+		int type = index_agg_func_type(&agg_info->aFunc[i], cursor,
+					       def, &plan->column);
+		if (type < 0)
+			return false;
+		if (type == INDEX_AGG_MIN || type == INDEX_AGG_MAX)
+			has_min_max = true;
+	}
+	if (select->pWhere == NULL) {
+		if (!has_min_max || agg_info->nFunc == 1)
+			return false;
+	} else if (!index_agg_add_where(plan, select->pWhere, cursor, def)) {
+		return false;
+	}
+	if (plan->column < 0)
+		return false;
+	for (uint32_t i = 0; i < space->index_count; ++i) {
+		struct index *index = space->index[i];
+		struct key_part *part = &index->def->key_def->parts[0];
+		if (index->def->type == TREE &&
+		    part->fieldno == (uint32_t) plan->column &&
+		    part->path == NULL && part->coll == NULL &&
+		    part->sort_order != SORT_ORDER_DESC) {
+			plan->index = index;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Code OP_IndexAggregate computing the aggregate functions by
+ * the plan. If a bound of the range may turn out not to fit the
+ * index at runtime, the opcode jumps to the code following this
+ * one, which must compute the aggregates by a regular scan.
+ *
+ * @param parse Current parsing context.
+ * @param select The select statement in form of aggregate query.
+ * @param plan Plan created by index_agg_plan_create().
+ * @param agg_info The associated aggregate-info object.
+ *
+ * @retval Label to resolve after the regular scan, or 0 if the
+ *         scan is not needed.
+ */
+static int
+vdbe_emit_index_aggregate(struct Parse *parse, struct Select *select,
+			  const struct index_agg_plan *plan,
+			  struct AggInfo *agg_info)
+{
+	struct SrcList_item *src = &select->pSrc->a[0];
+	struct space_def *def = src->space->def;
+	int func_count = agg_info->nFunc;
+	size_t size = sizeof(struct index_agg) +
+		      func_count * sizeof(struct index_agg_def);
+	struct index_agg *agg = sqlDbMallocZero(parse->db, size);
+	if (agg == NULL)
+		return 0;
+	agg->funcs = (struct index_agg_def *) &agg[1];
+	agg->func_count = func_count;
+	int column = plan->column;
+	for (int i = 0; i < func_count; i++) {
+		struct AggInfo_func *func = &agg_info->aFunc[i];
+		agg->funcs[i].type = index_agg_func_type(func, src->iCursor,
+							 def, &column);
+		assert((int) agg->funcs[i].type >= 0);
+		agg->funcs[i].reg = func->iMem;
+	}
+	if (plan->lo_op != 0) {
+		agg->lo_op = plan->lo_op;
+		agg->lo_reg = ++parse->nMem;
+		sqlExprCode(parse, plan->lo, agg->lo_reg);
+	}
+	if (plan->hi_op != 0) {
+		agg->hi_op = plan->hi_op;
+		if (plan->hi == plan->lo) {
+			agg->hi_reg = agg->lo_reg;
+		} else {
+			agg->hi_reg = ++parse->nMem;
+			sqlExprCode(parse, plan->hi, agg->hi_reg);
+		}
+	}
+
+	struct Vdbe *v = parse->pVdbe;
+	int cursor = parse->nTab++;
+	vdbe_emit_open_cursor(parse, cursor, plan->index->def->iid,
+			      src->space);
+	int addr = sqlVdbeAddOp4(v, OP_IndexAggregate, cursor, 0, 0,
+				 (char *) agg, P4_INDEXAGG);
+	sqlVdbeAddOp1(v, OP_Close, cursor);
+	int end = 0;
+	if (plan->has_variables) {
+		end = sqlVdbeMakeLabel(v);
+		sqlVdbeGoto(v, end);
+		sqlVdbeJumpHere(v, addr);
+		sqlVdbeAddOp1(v, OP_Close, cursor);
+	}
+	if (parse->explain == 2) {
+		const char *name = def->fields[plan->column].name;
+		const char *range = "";
+		if (plan->lo != NULL && plan->lo == plan->hi)
+			range = tt_sprintf(" (%s=?)", name);
+		else if (plan->lo != NULL && plan->hi != NULL)
+			range = tt_sprintf(" (%s>? AND %s<?)", name, name);
+		else if (plan->lo != NULL)
+			range = tt_sprintf(" (%s>?)", name);
+		else if (plan->hi != NULL)
+			range = tt_sprintf(" (%s<?)", name);
+		const char *index = plan->index->def->iid == 0 ?
+				    "PRIMARY KEY" :
+				    tt_sprintf("COVERING INDEX %s",
+					       plan->index->def->name);
+		char *eqp = sqlMPrintf(parse->db,
+				       "SEARCH TABLE %s USING %s FOR "
+				       "MIN/MAX/COUNT%s", def->name, index,
+				       range);
+		sqlVdbeAddOp4(v, OP_Explain, parse->iSelectId, 0, 0, eqp,
+			      P4_DYNAMIC);
+	}
+	return end;
+}
+
+/**
+ * Decide whether the outermost loop of the SELECT being coded
+ * may be read in parallel. Only the top-level SELECT of a
+ * statement is scanned exactly once: subqueries may be
+ * re-evaluated for each row of the outer query and trigger
+ * programs for each modified row, so splitting their scans would
+ * spawn the readers over and over again. A LIMIT stops the scan
+ * early, so reading the whole space in advance is wasted work.
+ *
+ * @param parse Current parsing context.
+ * @param select The SELECT statement being coded.
+ *
+ * @retval WHERE_PARALLEL_SCAN if the scan may be parallel, 0
+ *         otherwise.
+ */
+static u16
+select_parallel_scan_flag(struct Parse *parse, struct Select *select)
+{
+	if (parse->nSelectDepth != 1 || parse->pToplevel != NULL ||
+	    select->pLimit != NULL)
+		return 0;
+	return WHERE_PARALLEL_SCAN;
+}
+
 /**
  * Generate VDBE code that HALT program when subselect returned
  * more than one row (determined as LIMIT 1 overflow).
@@ -5490,6 +6132,7 @@ sqlSelect(Parse * pParse,		/* The parser context */
 	if (p == 0 || db->mallocFailed || pParse->is_aborted) {
 		return 1;
 	}
+	pParse->nSelectDepth++;
 	memset(&sAggInfo, 0, sizeof(sAggInfo));
 #ifdef SQL_DEBUG
 	pParse->nSelectIndent++;
@@ -5598,6 +6241,7 @@ sqlSelect(Parse * pParse,		/* The parser context */
 		SELECTTRACE(1, pParse, p, ("end compound-select processing\n"));
 		pParse->nSelectIndent--;
 #endif
+		pParse->nSelectDepth--;
 		return rc;
 	}
 #endif
@@ -5874,6 +6518,7 @@ sqlSelect(Parse * pParse,		/* The parser context */
 		u16 wctrlFlags = (sDistinct.isTnct ? WHERE_WANT_DISTINCT : 0);
 		assert(WHERE_USE_LIMIT == SF_FixedLimit);
 		wctrlFlags |= p->selFlags & SF_FixedLimit;
+		wctrlFlags |= select_parallel_scan_flag(pParse, p);
 
 		/* Begin the database scan. */
 		pWInfo =
@@ -6065,7 +6710,9 @@ sqlSelect(Parse * pParse,		/* The parser context */
 					      pGroupBy, 0,
 					      WHERE_GROUPBY | (orderByGrp ?
 							       WHERE_SORTBYGROUP
-							       : 0), 0);
+							       : 0) |
+					      select_parallel_scan_flag(pParse,
+									p), 0);
 			if (pWInfo == 0)
 				goto select_end;
 			if (sqlWhereIsOrdered(pWInfo) == pGroupBy->nExpr) {
@@ -6277,6 +6924,7 @@ sqlSelect(Parse * pParse,		/* The parser context */
 		} /* endif pGroupBy.  Begin aggregate queries without GROUP BY: */
 		else {
 			struct space *space = is_simple_count(p, &sAggInfo);
+			struct index_agg_plan index_agg;
 			if (space != NULL) {
 				/*
 				 * If is_simple_count() returns a pointer to
@@ -6300,8 +6948,40 @@ sqlSelect(Parse * pParse,		/* The parser context */
 						  sAggInfo.aFunc[0].iMem);
 				sqlVdbeAddOp1(v, OP_Close, cursor);
 				explain_simple_count(pParse, space->def->name);
+			} else if (index_agg_plan_create(p, &sAggInfo,
+							 &index_agg) &&
+				   !index_agg.has_variables) {
+				/*
+				 * The aggregates are computed with
+				 * index seeks by OP_IndexAggregate.
+				 */
+				MAYBE_UNUSED int end =
+					vdbe_emit_index_aggregate(pParse, p,
+								  &index_agg,
+								  &sAggInfo);
+				assert(end == 0);
+			} else if (index_agg.index == NULL &&
+				   vdbe_emit_batch_aggregate(pParse, p,
+							     &sAggInfo)) {
+				/*
+				 * The aggregates have been computed
+				 * by a single OP_BatchAggregate.
+				 */
 			} else
 			{
+				/*
+				 * If the bounds of the range are bind
+				 * parameters, OP_IndexAggregate falls
+				 * back to the loop below when they
+				 * don't fit the index.
+				 */
+				int index_agg_end = 0;
+				if (index_agg.index != NULL) {
+					index_agg_end =
+						vdbe_emit_index_aggregate(
+							pParse, p, &index_agg,
+							&sAggInfo);
+				}
 				/* Check if the query is of one of the following forms:
 				 *
 				 *   SELECT min(x) FROM ...
@@ -6360,9 +7040,16 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				 * of output.
 				 */
 				resetAccumulator(pParse, &sAggInfo);
+				u16 wctrlFlags = flag;
+				if (flag == WHERE_ORDERBY_NORMAL) {
+					wctrlFlags |=
+						select_parallel_scan_flag(pParse,
+									  p);
+				}
 				pWInfo =
 				    sqlWhereBegin(pParse, pTabList, pWhere,
-						      pMinMax, 0, flag, 0);
+						      pMinMax, 0, wctrlFlags,
+						      0);
 				if (pWInfo == 0) {
 					sql_expr_list_delete(db, pDel);
 					goto select_end;
@@ -6381,6 +7068,8 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				sqlWhereEnd(pWInfo);
 				finalizeAggFunctions(pParse, &sAggInfo);
 				sql_expr_list_delete(db, pDel);
+				if (index_agg_end != 0)
+					sqlVdbeResolveLabel(v, index_agg_end);
 			}
 
 			sSort.pOrderBy = 0;
@@ -6436,6 +7125,7 @@ sqlSelect(Parse * pParse,		/* The parser context */
 	SELECTTRACE(1, pParse, p, ("end processing\n"));
 	pParse->nSelectIndent--;
 #endif
+	pParse->nSelectDepth--;
 	return rc;
 }
 
@@ -1445,6 +1445,31 @@ struct LookasideSlot {
 	LookasideSlot *pNext;	/* Next buffer in the list of free buffers */
 };
 
+/*
+ * Heap blocks freed with sqlDbFree() are not returned to the
+ * system allocator. They are kept on per-size-class lists of
+ * the connection and handed out again by sqlDbMallocRaw(), so
+ * the Mem buffers, cursors and records of one statement are
+ * reused by the next ones instead of being malloc()'ed anew.
+ * Requests which fit a class are rounded up to its size: the
+ * classes are powers of two from 64 bytes to 64 kilobytes.
+ * The cached blocks are ordinary heap blocks, so any of them
+ * may still be released with sql_free().
+ */
+#define SQL_BLOCK_CACHE_MIN_LOG 6
+#define SQL_BLOCK_CACHE_MAX_LOG 16
+#define SQL_BLOCK_CACHE_CLASSES \
+	(SQL_BLOCK_CACHE_MAX_LOG - SQL_BLOCK_CACHE_MIN_LOG + 1)
+/* Maximal number of bytes kept on one class list. */
+#define SQL_BLOCK_CACHE_CLASS_BYTES (128 * 1024)
+
+struct sql_block_cache {
+	/** Lists of free blocks linked through their first word. */
+	void *free[SQL_BLOCK_CACHE_CLASSES];
+	/** Number of blocks on each list. */
+	uint32_t count[SQL_BLOCK_CACHE_CLASSES];
+};
+
 /*
  * A hash table for built-in function definitions.  (Application-defined
  * functions use a regular table table from hash.h.)
@@ -1506,6 +1531,8 @@ struct sql {
 		double notUsed1;	/* Spacer */
 	} u1;
 	Lookaside lookaside;	/* Lookaside malloc configuration */
+	/* Heap blocks kept for reuse. */
+	struct sql_block_cache block_cache;
 #ifndef SQL_OMIT_PROGRESS_CALLBACK
 	int (*xProgress) (void *);	/* The progress callback */
 	void *pProgressArg;	/* Argument to the progress callback */
@@ -1891,6 +1918,19 @@ struct UnpackedRecord {
 log_est_t
 index_field_tuple_est(const struct index_def *idx, uint32_t field);
 
+/**
+ * Return the statistics collected by ANALYZE for the index, or
+ * NULL if there are none or they are stale: the number of tuples
+ * in the index has changed more than SQL_STAT_STALE_RATIO times
+ * since the analysis, so the planner falls back to the defaults
+ * rather than relying on a histogram of data that is gone.
+ *
+ * @param index Index to get the statistics of.
+ * @retval Statistics or NULL.
+ */
+struct index_stat *
+sql_index_stat(struct index *index);
+
 #ifdef DEFAULT_TUPLE_COUNT
 #undef DEFAULT_TUPLE_COUNT
 #endif
@@ -1898,6 +1938,13 @@ index_field_tuple_est(const struct index_def *idx, uint32_t field);
 /** [10*log_{2}(1048576)] == 200 */
 #define DEFAULT_TUPLE_LOG_COUNT 200
 
+/**
+ * Statistics of an index are ignored by the planner when the
+ * number of tuples in it has grown or shrunk this many times
+ * since ANALYZE.
+ */
+#define SQL_STAT_STALE_RATIO 2
+
 /*
  * An instance of this structure contains information needed to generate
  * code for a SELECT that contains aggregate functions.
@@ -1950,6 +1997,136 @@ struct AggInfo {
 	int nFunc;		/* Number of entries in aFunc[] */
 };
 
+/** Aggregate functions OP_BatchAggregate is able to compute. */
+enum batch_agg_func {
+	BATCH_AGG_COUNT_STAR,
+	BATCH_AGG_COUNT,
+	BATCH_AGG_SUM,
+	BATCH_AGG_TOTAL,
+	BATCH_AGG_AVG,
+};
+
+/**
+ * Program of the OP_BatchAggregate opcode: aggregates over
+ * numeric columns of a single space filtered by a conjunction
+ * of "column <op> constant" terms. Arrays are allocated in the
+ * same chunk as the structure itself.
+ */
+struct batch_agg {
+	/** Number of distinct columns read from each tuple. */
+	uint32_t column_count;
+	/** Field numbers of the columns in ascending order. */
+	uint32_t *fieldno;
+	/**
+	 * True if the column has NUMBER type, so its integer
+	 * values are treated as reals, like OP_Column does.
+	 */
+	bool *is_real;
+	/** Number of filters. */
+	uint32_t filter_count;
+	struct batch_agg_filter {
+		/** Index of the column in the fieldno array. */
+		uint32_t column;
+		/** TK_EQ, TK_NE, TK_LT, TK_LE, TK_GT or TK_GE. */
+		int op;
+		/** Register holding the constant operand. */
+		int reg;
+	} *filters;
+	/** Number of aggregate functions. */
+	uint32_t func_count;
+	struct batch_agg_def {
+		enum batch_agg_func type;
+		/** Argument column, unused for COUNT(*). */
+		uint32_t column;
+		/** Register to store the result to. */
+		int reg;
+	} *funcs;
+};
+
+/** Aggregate functions OP_IndexAggregate is able to compute. */
+enum index_agg_func {
+	INDEX_AGG_COUNT_STAR,
+	INDEX_AGG_COUNT,
+	INDEX_AGG_MIN,
+	INDEX_AGG_MAX,
+};
+
+/**
+ * Program of the OP_IndexAggregate opcode: COUNT, MIN and MAX
+ * over a range of the first part of an ordered index, which are
+ * computed with index seeks rather than a scan. The array of
+ * functions is allocated in the same chunk as the structure.
+ */
+struct index_agg {
+	/** TK_GT or TK_GE, 0 if there is no lower bound. */
+	int lo_op;
+	/** Register holding the lower bound. */
+	int lo_reg;
+	/** TK_LT or TK_LE, 0 if there is no upper bound. */
+	int hi_op;
+	/** Register holding the upper bound. */
+	int hi_reg;
+	/** Number of aggregate functions. */
+	uint32_t func_count;
+	struct index_agg_def {
+		enum index_agg_func type;
+		/** Register to store the result to. */
+		int reg;
+	} *funcs;
+};
+
+/** Kind of the constant a cursor filter term compares with. */
+enum cursor_filter_kind {
+	/** Integer, the field is INTEGER, UNSIGNED or NUMBER. */
+	CURSOR_FILTER_INT,
+	/** Real, the field is INTEGER, UNSIGNED or NUMBER. */
+	CURSOR_FILTER_REAL,
+	/** String, the field is STRING without collation. */
+	CURSOR_FILTER_STR,
+	cursor_filter_kind_MAX,
+};
+
+/** Comparison operators of cursor filter terms. */
+enum cursor_filter_op {
+	CURSOR_FILTER_EQ,
+	CURSOR_FILTER_NE,
+	CURSOR_FILTER_LT,
+	CURSOR_FILTER_LE,
+	CURSOR_FILTER_GT,
+	CURSOR_FILTER_GE,
+	cursor_filter_op_MAX,
+};
+
+/**
+ * Program of the OP_CursorFilter opcode: a conjunction of
+ * "column <op> literal" terms of the WHERE clause the cursor
+ * checks against each tuple of a full scan before returning it
+ * to the VDBE. The terms are still coded as usual, so the filter
+ * only has to reject the tuples the WHERE clause would reject
+ * for sure. The array of terms and string constants are
+ * allocated in the same chunk as the structure.
+ */
+struct cursor_filter {
+	/** Number of terms. */
+	uint32_t term_count;
+	struct cursor_filter_term {
+		/** Number of the field to compare. */
+		uint32_t fieldno;
+		enum cursor_filter_kind kind;
+		/** Operator with the field on the left side. */
+		enum cursor_filter_op op;
+		/** Constant to compare the field with. */
+		union {
+			int64_t i;
+			double r;
+			struct {
+				const char *data;
+				uint32_t len;
+			} str;
+		} value;
+	} *terms;
+};
+
 typedef int ynVar;
 
 /*
@@ -2322,7 +2499,9 @@ struct SrcList {
 #define WHERE_SORTBYGROUP      0x0200	/* Support sqlWhereIsSorted() */
 #define WHERE_SEEK_TABLE       0x0400	/* Do not defer seeks on main table */
 #define WHERE_ORDERBY_LIMIT    0x0800	/* ORDERBY+LIMIT on the inner loop */
-			/*     0x1000    not currently used */
+#define WHERE_PARALLEL_SCAN    0x1000	/* Outermost scan may be read in
+					 * parallel
+					 */
 			/*     0x2000    not currently used */
 #define WHERE_USE_LIMIT        0x4000	/* Use the LIMIT in cost estimates */
 			/*     0x8000    not currently used */
@@ -2633,6 +2812,7 @@ struct Parse {
 	int nMaxArg;		/* Max args passed to user function by sub-program */
 	int nSelect;		/* Number of SELECT statements seen */
 	int nSelectIndent;	/* How far to indent SELECTTRACE() output */
+	int nSelectDepth;	/* Nesting depth of SELECTs being coded */
 	Parse *pToplevel;	/* Parse structure for main program (or NULL) */
 	u32 nQueryLoop;		/* Est number of iterations of a query (10*log2(N)) */
 	/* Mask of old.* columns referenced. */
@@ -2672,7 +2852,11 @@ struct Parse {
 
 	Token sLastToken;	/* The last token parsed */
 	ynVar nVar;		/* Number of '?' variables seen in the SQL so far */
-	u8 explain;		/* True if the EXPLAIN flag is found on the query */
+	/*
+	 * 1 for EXPLAIN, 2 for EXPLAIN QUERY PLAN and 3 for
+	 * EXPLAIN ANALYZE.
+	 */
+	u8 explain;
 	int nHeight;		/* Expression tree height of current sub-select */
 	int iSelectId;		/* ID of current select for EXPLAIN output */
 	int iNextSelectId;	/* Next available select ID for EXPLAIN output */
@@ -2754,6 +2938,9 @@ struct Parse {
 #define OPFLAG_PERMUTE       0x01	/* OP_Compare: use the permutation */
 #define OPFLAG_SAVEPOSITION  0x02	/* OP_Delete: keep cursor position */
 #define OPFLAG_AUXDELETE     0x04	/* OP_Delete: index in a DELETE op */
+#define OPFLAG_PARALLEL      0x01	/* OP_Rewind: scan may be split into
+					 * ranges read in parallel
+					 */
 
 #define OPFLAG_SAME_FRAME    0x01	/* OP_FCopy: use same frame for source
 					 * register
@@ -4696,6 +4883,17 @@ sql_index_tuple_size(struct space *space, struct index *idx);
 int
 sql_analysis_load(struct sql *db);
 
+/**
+ * Generate code for the ANALYZE command, which collects the
+ * statistics of all spaces or of the given one into _sql_stat1
+ * and _sql_stat4 and loads them.
+ *
+ * @param parse Parsing context.
+ * @param name Name of the space, NULL to analyze all spaces.
+ */
+void
+sqlAnalyze(struct Parse *parse, struct Token *name);
+
 /**
  * An instance of the following structure controls how keys
  * are compared by VDBE, see P4_KEYINFO.
@@ -5070,7 +5268,7 @@ int sqlMemdebugNoType(void *, u8);
  */
 #if SQL_MAX_WORKER_THREADS>0
 int sqlThreadCreate(sqlThread **, void *(*)(void *), void *);
-int sqlThreadJoin(sqlThread *, void **);
+int sqlThreadJoin(sqlThread *, bool, void **);
 #endif
 
 int sqlExprVectorSize(Expr * pExpr);
@@ -184,4 +184,13 @@ enum {
  */
 #define SQL_MAX_COMPILING_TRIGGERS 30
 
+/*
+ * Default maximum amount of memory (in bytes) a hash join build
+ * table may occupy on the SQL heap, see box.cfg.sql_hash_join_memory.
+ * Rows which do not fit are spilled to an ephemeral space.
+ */
+#ifndef SQL_HASH_JOIN_MEMORY_LIMIT
+#define SQL_HASH_JOIN_MEMORY_LIMIT (16 * 1024 * 1024)
+#endif
+
 #endif /* TARANTOOL_SQL_sqlLIMIT_H_INCLUDED */
@@ -36,6 +36,7 @@
  */
 #include "sqlInt.h"
 #include "vdbeInt.h"
+#include <pmatomic.h>
 /*
  * Variables in which to record status information.
  */
@@ -79,6 +80,21 @@ sqlStatusValue(int op)
 	return wsdStat.nowValue[op];
 }
 
+/*
+ * Set the highwater mark of a status record to newValue if it is
+ * lower. Memory may be allocated by the sorter worker threads, so
+ * the status records are updated atomically.
+ */
+static void
+statusRaiseHighwater(int op, sqlStatValueType newValue)
+{
+	wsdStatInit;
+	sqlStatValueType mxValue = pm_atomic_load(&wsdStat.mxValue[op]);
+	while (newValue > mxValue &&
+	       !pm_atomic_compare_exchange_weak(&wsdStat.mxValue[op],
+						&mxValue, newValue));
+}
+
 /*
  * Add N to the value of a status record.
  *
@@ -95,10 +111,9 @@ sqlStatusUp(int op, int N)
 	wsdStatInit;
 	assert(op >= 0 && op < ArraySize(wsdStat.nowValue));
 
-	wsdStat.nowValue[op] += N;
-	if (wsdStat.nowValue[op] > wsdStat.mxValue[op]) {
-		wsdStat.mxValue[op] = wsdStat.nowValue[op];
-	}
+	sqlStatValueType newValue =
+		pm_atomic_fetch_add(&wsdStat.nowValue[op], N) + N;
+	statusRaiseHighwater(op, newValue);
 }
 
 void
@@ -108,7 +123,7 @@ sqlStatusDown(int op, int N)
 	assert(N >= 0);
 
 	assert(op >= 0 && op < ArraySize(wsdStat.nowValue));
-	wsdStat.nowValue[op] -= N;
+	pm_atomic_fetch_sub(&wsdStat.nowValue[op], N);
 }
 
 /*
@@ -127,9 +142,7 @@ sqlStatusHighwater(int op, int X)
 	       || op == SQL_STATUS_PAGECACHE_SIZE
 	       || op == SQL_STATUS_SCRATCH_SIZE
 	       || op == SQL_STATUS_PARSER_STACK);
-	if (newValue > wsdStat.mxValue[op]) {
-		wsdStat.mxValue[op] = newValue;
-	}
+	statusRaiseHighwater(op, newValue);
 }
 
 /*
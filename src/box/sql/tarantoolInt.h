@@ -9,15 +9,35 @@
 #include <stdint.h>
 
 struct fk_constraint_def;
+struct index_agg;
+struct Mem;
+
+/**
+ * Max size of the build table of a hash join kept on the SQL
+ * heap, box.cfg.sql_hash_join_memory.
+ */
+extern uint64_t sql_hash_join_memory;
 
 /* Misc */
 const char *tarantoolErrorMessage();
 
 int is_tarantool_error(int rc);
 
-/* Storage interface. */
+/*
+ * Storage interface. Values of compressed fields are returned
+ * as they are stored, use tuple_field_decompress_raw() to
+ * get them.
+ */
 const void *tarantoolsqlPayloadFetch(BtCursor * pCur, u32 * pAmt);
 
+/**
+ * Same as tarantoolsqlPayloadFetch(), but with values of
+ * compressed fields decompressed.
+ * @retval NULL on error, diag is set.
+ */
+const void *
+tarantoolsqlPayloadFetchDecompressed(BtCursor *pCur, u32 *pAmt);
+
 /**
  * Try to get a current tuple field using its field map.
  * @param pCur Btree cursor holding a tuple.
@@ -31,12 +51,40 @@ const void *
 tarantoolsqlTupleColumnFast(BtCursor *pCur, u32 fieldno, u32 *field_size);
 
 int tarantoolsqlFirst(BtCursor * pCur, int *pRes);
+
+/**
+ * Set cursor to the first tuple of a full scan of a space.
+ * Unlike tarantoolsqlFirst(), the scan of a vinyl space out of
+ * a transaction is split into key ranges read in parallel, if
+ * box.cfg.sql_scan_partitions allows it. @a partition_count
+ * is set to the number of the ranges, 1 if the scan isn't split.
+ */
+int
+tarantoolsqlFirstParallel(struct BtCursor *pCur, int *pRes,
+			  int *partition_count);
 int tarantoolsqlLast(BtCursor * pCur, int *pRes);
 int tarantoolsqlNext(BtCursor * pCur, int *pRes);
 int tarantoolsqlPrevious(BtCursor * pCur, int *pRes);
 int tarantoolsqlMovetoUnpacked(BtCursor * pCur, UnpackedRecord * pIdxKey,
 				   int *pRes);
 int tarantoolsqlCount(BtCursor * pCur, i64 * pnEntry);
+
+/**
+ * Compute the aggregate functions of OP_IndexAggregate over a
+ * range of the first part of the index opened by the cursor.
+ *
+ * @param cur Cursor opened on an ascending TREE index.
+ * @param agg Program of the opcode.
+ * @param mem Registers of the VDBE.
+ * @param[out] is_done Set to false if the bounds of the range
+ *             can't be used as keys of the index and nothing
+ *             has been computed.
+ *
+ * @retval SQL_OK on success, an SQL_TARANTOOL_* error otherwise.
+ */
+int
+tarantoolsqlIndexAggregate(struct BtCursor *cur, const struct index_agg *agg,
+			   struct Mem *mem, bool *is_done);
 int tarantoolsqlInsert(struct space *space, const char *tuple,
 			   const char *tuple_end);
 int tarantoolsqlReplace(struct space *space, const char *tuple,
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * This file implements the threading interface used by the
+ * external sorter (see vdbesort.c) on top of Tarantool cords.
+ *
+ *    sqlThreadCreate()     Start a new thread running the given
+ *                          task.
+ *
+ *    sqlThreadJoin()       Wait for the thread to finish and
+ *                          return the result of its task.
+ *
+ * Worker threads never touch tuples or spaces: the sorter hands
+ * them records which were already copied out of tuples by
+ * OP_MakeRecord, and they only sort, write and merge those
+ * records in temporary files.
+ *
+ * A worker is joined in a non-blocking way when it is the tx
+ * thread that waits for it outside of a transaction and the
+ * caller allows it: the fiber executing the statement yields
+ * until the worker is done, so other fibers keep running while
+ * a big sort is in progress. A transaction can't be interrupted
+ * by a yield (memtx would abort it), and workers may start and
+ * join other workers themselves, so in all the other cases the
+ * join blocks the thread. The sorter doesn't start workers at
+ * all when it can't yield, see sqlVdbeSorterInit().
+ */
+#include "sqlInt.h"
+#include "fiber.h"
+#include "box/txn.h"
+
+#if SQL_MAX_WORKER_THREADS>0
+
+struct sqlThread {
+	/** Thread the task is run in. */
+	struct cord cord;
+	/** Task to run. */
+	void *(*xTask)(void *);
+	/** Argument of the task. */
+	void *pIn;
+	/** Value returned by the task. */
+	void *pOut;
+	/**
+	 * True if the thread couldn't be started and the
+	 * task has been run by the caller of sqlThreadCreate().
+	 */
+	bool is_done;
+};
+
+static void *
+sql_thread_f(void *arg)
+{
+	struct sqlThread *p = (struct sqlThread *)arg;
+	p->pOut = p->xTask(p->pIn);
+	return NULL;
+}
+
+int
+sqlThreadCreate(sqlThread **ppThread, void *(*xTask)(void *), void *pIn)
+{
+	assert(ppThread != NULL);
+	assert(xTask != NULL);
+	*ppThread = NULL;
+	struct sqlThread *p = sqlMallocZero(sizeof(*p));
+	if (p == NULL)
+		return SQL_NOMEM;
+	p->xTask = xTask;
+	p->pIn = pIn;
+	if (cord_start(&p->cord, "sql.sort", sql_thread_f, p) != 0) {
+		/*
+		 * Failing to start a thread is not an error:
+		 * the task is just run synchronously.
+		 */
+		diag_clear(diag_get());
+		p->pOut = xTask(pIn);
+		p->is_done = true;
+	}
+	*ppThread = p;
+	return SQL_OK;
+}
+
+int
+sqlThreadJoin(sqlThread *p, bool may_yield, void **ppOut)
+{
+	assert(ppOut != NULL);
+	if (p == NULL)
+		return SQL_NOMEM;
+	if (!p->is_done) {
+		int rc;
+		if (may_yield && cord_is_main() && in_txn() == NULL)
+			rc = cord_cojoin(&p->cord);
+		else
+			rc = cord_join(&p->cord);
+		if (rc != 0) {
+			diag_log();
+			sql_free(p);
+			return SQL_ERROR;
+		}
+	}
+	*ppOut = p->pOut;
+	sql_free(p);
+	return SQL_OK;
+}
+
+#endif /* SQL_MAX_WORKER_THREADS>0 */
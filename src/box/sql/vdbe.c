@@ -52,6 +52,7 @@
 #include "mpstream.h"
 
 #include "box/schema.h"
+#include "box/tuple_compression.h"
 #include "box/space.h"
 #include "box/sequence.h"
 
@@ -91,6 +92,26 @@ int sql_search_count = 0;
 int sql_xfer_count = 0;
 #endif
 
+#ifdef SQL_TEST
+/*
+ * The following global variable is incremented in OP_Rewind by
+ * the number of key ranges a full scan is split into, whenever
+ * the ranges are read in parallel. This is used on testing
+ * purposes only - to make sure the scan really is split.
+ */
+int sql_scan_partition_count = 0;
+#endif
+
+#ifdef SQL_TEST
+/*
+ * The following global variable is incremented in OP_Column
+ * whenever a value of a compressed field is decompressed. This
+ * is used on testing purposes only - to make sure values that
+ * are not read are not decompressed.
+ */
+int sql_decompress_count = 0;
+#endif
+
 /*
  * When this global variable is positive, it gets decremented once before
  * each instruction in the VDBE.  When it reaches zero, the u1.isInterrupted
@@ -557,15 +578,59 @@ registerTrace(int iReg, Mem *p) {
 #endif
 
 
-#ifdef VDBE_PROFILE
-
 /*
  * hwtime.h contains inline assembler code for implementing
  * high-performance timing routines.
  */
 #include "hwtime.h"
 
-#endif
+/*
+ * Account an execution of @a op in the statistics of EXPLAIN
+ * ANALYZE. @a is_jump is true if the instruction has jumped
+ * rather than fallen through to the next one. @a start is the
+ * CPU clock count when the instruction began. An instruction
+ * is considered to produce a row when it positions a cursor on
+ * a new entry, or when it is ResultRow.
+ */
+static inline void
+vdbe_op_stat_update(struct vdbe_op_stat *stat, const struct VdbeOp *op,
+		    bool is_jump, u64 start)
+{
+	u64 end = sqlHwtime();
+	if (end > start)
+		stat->cycles += end - start;
+	switch (op->opcode) {
+	case OP_Next:
+	case OP_Prev:
+	case OP_NextIfOpen:
+	case OP_PrevIfOpen:
+	case OP_SorterNext:
+	case OP_HashNext:
+	case OP_Found:
+		if (is_jump)
+			stat->rows++;
+		break;
+	case OP_Rewind:
+	case OP_Last:
+	case OP_Sort:
+	case OP_SorterSort:
+	case OP_SeekLT:
+	case OP_SeekLE:
+	case OP_SeekGE:
+	case OP_SeekGT:
+	case OP_HashProbe:
+	case OP_NotFound:
+	case OP_NoConflict:
+		if (!is_jump)
+			stat->rows++;
+		break;
+	case OP_ResultRow:
+		stat->rows++;
+		break;
+	default:
+		break;
+	}
+}
 
 /*
  * Return the register of pOp->p2 after first preparing it to be
@@ -647,9 +712,7 @@ int sqlVdbeExec(Vdbe *p)
 {
 	Op *aOp = p->aOp;          /* Copy of p->aOp */
 	Op *pOp = aOp;             /* Current operation */
-#if defined(SQL_DEBUG) || defined(VDBE_PROFILE)
 	Op *pOrigOp;               /* Value of pOp at the top of the loop */
-#endif
 #ifdef SQL_DEBUG
 	int nExtraDelete = 0;      /* Verifies FORDELETE and AUXDELETE flags */
 #endif
@@ -666,9 +729,9 @@ int sqlVdbeExec(Vdbe *p)
 	Mem *pIn3 = 0;             /* 3rd input operand */
 	Mem *pOut = 0;             /* Output operand */
 	int *aPermute = 0;         /* Permutation of columns for OP_Compare */
-#ifdef VDBE_PROFILE
-	u64 start;                 /* CPU clock count at start of opcode */
-#endif
+	u64 start = 0;             /* CPU clock count at start of opcode */
+	/* EXPLAIN ANALYZE statistics of the current opcode */
+	struct vdbe_op_stat *op_stat = NULL;
 	struct session *user_session = current_session();
 	/*** INSERT STACK UNION HERE ***/
 
@@ -731,6 +794,24 @@ int sqlVdbeExec(Vdbe *p)
 #ifdef VDBE_PROFILE
 		start = sqlHwtime();
 #endif
+		if (p->op_stats != NULL) {
+			if (p->pFrame == NULL) {
+				op_stat = &p->op_stats[pOp - aOp];
+				op_stat->count++;
+			} else {
+				/*
+				 * Cycles and rows of trigger
+				 * subprograms are added to the
+				 * OP_Program instruction of the
+				 * statement calling them.
+				 */
+				VdbeFrame *root = p->pFrame;
+				while (root->pParent != NULL)
+					root = root->pParent;
+				op_stat = &p->op_stats[root->pc];
+			}
+			start = sqlHwtime();
+		}
 		nVmStep++;
 #ifdef SQL_ENABLE_STMT_SCANSTATUS
 		if (p->anExec) p->anExec[(int)(pOp-aOp)]++;
@@ -794,9 +875,7 @@ int sqlVdbeExec(Vdbe *p)
 			}
 		}
 #endif
-#if defined(SQL_DEBUG) || defined(VDBE_PROFILE)
 		pOrigOp = pOp;
-#endif
 
 		switch( pOp->opcode) {
 
@@ -1442,7 +1521,7 @@ case OP_ResultRow: {
 	Mem *pMem;
 	int i;
 
-	assert(p->nResColumn==pOp->p2);
+	assert(p->nResColumn==pOp->p2 || p->op_stats != NULL);
 	assert(pOp->p1>0);
 	assert(pOp->p1+pOp->p2<=(p->nMem+1 - p->nCursor)+1);
 
@@ -1486,6 +1565,10 @@ case OP_ResultRow: {
 	rc = sqlVdbeCloseStatement(p, SAVEPOINT_RELEASE);
 	assert(rc==SQL_OK);
 
+	/* EXPLAIN ANALYZE doesn't return rows of the statement. */
+	if (p->op_stats != NULL)
+		break;
+
 	/* Invalidate all ephemeral cursor row caches */
 	p->cacheCtr = (p->cacheCtr + 2)|1;
 
@@ -2668,7 +2751,12 @@ case OP_Column: {
 	assert(pC->eCurType!=CURTYPE_SORTER);
 
 	if (pC->cacheStatus!=p->cacheCtr) {                /*OPTIMIZATION-IF-FALSE*/
-		if (pC->nullRow) {
+		if (pC->eCurType == CURTYPE_HASH) {
+			assert(!pC->nullRow);
+			pC->aRow = (const u8 *)sqlVdbeHashRow(pC,
+							      &pC->payloadSize);
+			pC->szRow = pC->payloadSize;
+		} else if (pC->nullRow) {
 			if (pC->eCurType==CURTYPE_PSEUDO) {
 				assert(pC->uc.pseudoTableReg>0);
 				pReg = &aMem[pC->uc.pseudoTableReg];
@@ -2776,24 +2864,51 @@ case OP_Column: {
 	if (VdbeMemDynamic(pDest)) {
 		sqlVdbeMemSetNull(pDest);
 	}
+	/* Rows of a hash join table come from its source cursor. */
+	if (pC->eCurType == CURTYPE_TARANTOOL)
+		pCrsr = pC->uc.pCursor;
+	else if (pC->eCurType == CURTYPE_HASH)
+		pCrsr = sqlVdbeHashSource(pC);
+	else
+		pCrsr = NULL;
+	const char *field = (const char *)zData + aOffset[p2];
+	uint32_t field_size = aOffset[p2 + 1] - aOffset[p2];
+	size_t region_svp = region_used(&fiber()->gc);
+	if (pCrsr != NULL && (pCrsr->curFlags & BTCF_TaCursor) != 0 &&
+	    pCrsr->space->format->compressed_field_count > 0) {
+		/*
+		 * Rows of spaces are read as they are stored,
+		 * so decompress the value if the field is
+		 * compressed.
+		 */
+		field = tuple_field_decompress_raw(pCrsr->space->format, p2,
+						   field, field + field_size,
+						   &field_size);
+		if (field == NULL) {
+			rc = SQL_TARANTOOL_ERROR;
+			goto op_column_error;
+		}
+#ifdef SQL_TEST
+		if (region_used(&fiber()->gc) != region_svp)
+			sql_decompress_count++;
+#endif
+	}
 	uint32_t unused;
-	if (vdbe_decode_msgpack_into_mem((const char *)(zData + aOffset[p2]),
-					 pDest, &unused) != 0) {
+	if (vdbe_decode_msgpack_into_mem(field, pDest, &unused) != 0) {
 		rc = SQL_TARANTOOL_ERROR;
-		goto abort_due_to_error;
+		goto op_column_error;
 	}
 	/* MsgPack map, array or extension (unsupported in sql).
 	 * Wrap it in a blob verbatim.
 	 */
 
 	if (pDest->flags == 0) {
-		pDest->n = aOffset[p2+1]-aOffset[p2];
-		pDest->z = (char *)zData+aOffset[p2];
+		pDest->n = field_size;
+		pDest->z = (char *)field;
 		pDest->flags = MEM_Blob|MEM_Ephem|MEM_Subtype;
 		pDest->subtype = SQL_SUBTYPE_MSGPACK;
 	}
-	if ((pDest->flags & MEM_Int) != 0 &&
-	    pC->eCurType == CURTYPE_TARANTOOL) {
+	if ((pDest->flags & MEM_Int) != 0 && pCrsr != NULL) {
 		enum field_type f = FIELD_TYPE_ANY;
 		/*
 		 * Ephemeral spaces feature only one index
@@ -2801,10 +2916,10 @@ case OP_Column: {
 		 * lack format. So, we can fetch type from
 		 * key parts.
 		 */
-		if (pC->uc.pCursor->curFlags & BTCF_TEphemCursor)
-			f = pC->uc.pCursor->index->def->key_def->parts[p2].type;
-		else if (pC->uc.pCursor->curFlags & BTCF_TaCursor)
-			f = pC->uc.pCursor->space->def->fields[p2].type;
+		if (pCrsr->curFlags & BTCF_TEphemCursor)
+			f = pCrsr->index->def->key_def->parts[p2].type;
+		else if (pCrsr->curFlags & BTCF_TaCursor)
+			f = pCrsr->space->def->fields[p2].type;
 		if (f == FIELD_TYPE_NUMBER)
 			sqlVdbeMemSetDouble(pDest, pDest->u.i);
 	}
@@ -2823,6 +2938,15 @@ case OP_Column: {
 		pDest->z[len] = 0;
 		pDest->flags |= MEM_Term;
 	}
+	if (region_used(&fiber()->gc) != region_svp) {
+		/* The decompressed value is freed right away. */
+		if ((pDest->flags & MEM_Ephem) != 0) {
+			rc = sqlVdbeMemMakeWriteable(pDest);
+			if (rc != SQL_OK)
+				goto op_column_error;
+		}
+		region_truncate(&fiber()->gc, region_svp);
+	}
 
 	if (zData!=pC->aRow) sqlVdbeMemRelease(&sMem);
 			op_column_out:
@@ -3000,6 +3124,58 @@ case OP_Count: {         /* out2 */
 	break;
 }
 
+/* Opcode: IndexAggregate P1 P2 * P4 *
+ * Synopsis: aggregate over index of cursor P1
+ *
+ * Compute the aggregate functions described by the index_agg
+ * structure in P4 over a range of the first part of the index
+ * opened by cursor P1 using index seeks, and store their final
+ * values to the registers specified in P4. If the bounds of the
+ * range are not values of the type of the indexed column, jump
+ * to P2 where the aggregates are computed by a regular scan.
+ */
+case OP_IndexAggregate: {       /* jump */
+	VdbeCursor *pC;
+	bool is_done;
+
+	pC = p->apCsr[pOp->p1];
+	assert(pC != NULL && pC->eCurType == CURTYPE_TARANTOOL);
+	assert(pOp->p4type == P4_INDEXAGG);
+	rc = tarantoolsqlIndexAggregate(pC->uc.pCursor, pOp->p4.index_agg,
+					aMem, &is_done);
+	if (rc != SQL_OK)
+		goto abort_due_to_error;
+	VdbeBranchTaken(!is_done, 2);
+	if (!is_done) {
+		assert(pOp->p2 > 0);
+		goto jump_to_p2;
+	}
+	break;
+}
+
+/* Opcode: BatchAggregate P1 * * P4 *
+ * Synopsis: batch aggregate over cursor P1
+ *
+ * Scan the whole space opened by cursor P1 a batch of tuples at
+ * a time and compute the aggregate functions described by the
+ * batch_agg structure in P4. Only the rows satisfying all of its
+ * filters are aggregated. The final values are stored to the
+ * registers specified in P4, so no OP_AggFinal is needed.
+ */
+case OP_BatchAggregate: {
+	VdbeCursor *pC;
+
+	pC = p->apCsr[pOp->p1];
+	assert(pC != NULL && pC->eCurType == CURTYPE_TARANTOOL);
+	assert(pOp->p4type == P4_BATCHAGG);
+	rc = sqlVdbeBatchAggregate(p, pC->uc.pCursor, pOp->p4.batch_agg);
+	pC->nullRow = 1;
+	pC->cacheStatus = CACHE_STALE;
+	if (rc != SQL_OK)
+		goto abort_due_to_error;
+	break;
+}
+
 /* Opcode: Savepoint P1 * * P4 *
  *
  * Open, release or rollback the savepoint named by parameter P4, depending
@@ -3332,7 +3508,7 @@ case OP_SorterOpen: {
 	pCx = allocateCursor(p, pOp->p1, pOp->p2, CURTYPE_SORTER);
 	if (pCx==0) goto no_mem;
 	pCx->key_def = def;
-	rc = sqlVdbeSorterInit(db, pCx);
+	rc = sqlVdbeSorterInit(db, p, pCx);
 	if (rc) goto abort_due_to_error;
 	break;
 }
@@ -3384,6 +3560,30 @@ case OP_OpenPseudo: {
 	break;
 }
 
+/* Opcode: HashOpen P1 P2 P3 * *
+ *
+ * Open a new cursor P1 over an empty hash join table with rows
+ * of P2 columns. The rows are read by OP_HashInsert from the
+ * table cursor P3.
+ */
+case OP_HashOpen: {
+	VdbeCursor *pCx;
+	VdbeCursor *pSrc;
+
+	assert(pOp->p1 >= 0 && pOp->p2 >= 0);
+	assert(pOp->p3 >= 0 && pOp->p3 < p->nCursor);
+	pSrc = p->apCsr[pOp->p3];
+	assert(pSrc != NULL && pSrc->eCurType == CURTYPE_TARANTOOL);
+	pCx = allocateCursor(p, pOp->p1, pOp->p2, CURTYPE_HASH);
+	if (pCx == NULL)
+		goto no_mem;
+	pCx->nullRow = 1;
+	rc = sqlVdbeHashInit(db, pCx, pSrc->uc.pCursor);
+	if (rc != 0)
+		goto abort_due_to_error;
+	break;
+}
+
 /* Opcode: Close P1 * * * *
  *
  * Close a cursor previously opened as P1.  If P1 is not
@@ -4123,7 +4323,12 @@ case OP_RowData: {
 	assert(pCrsr->eState == CURSOR_VALID);
 	assert(pCrsr->curFlags & BTCF_TaCursor ||
 	       pCrsr->curFlags & BTCF_TEphemCursor);
-	tarantoolsqlPayloadFetch(pCrsr, &n);
+	/* The row is copied as a whole, so decompress it. */
+	const char *data = tarantoolsqlPayloadFetchDecompressed(pCrsr, &n);
+	if (data == NULL) {
+		rc = SQL_TARANTOOL_ERROR;
+		goto abort_due_to_error;
+	}
 	if (n>(u32)db->aLimit[SQL_LIMIT_LENGTH]) {
 		goto too_big;
 	}
@@ -4133,8 +4338,7 @@ case OP_RowData: {
 	rc = sql_vdbe_mem_alloc_region(pOut, n);
 	if (rc)
 		goto no_mem;
-	rc = sqlCursorPayload(pCrsr, 0, n, pOut->z);
-	if (rc) goto abort_due_to_error;
+	memcpy(pOut->z, data, n);
 	UPDATE_MAX_BLOBSIZE(pOut);
 	REGISTER_TRACE(pOp->p2, pOut);
 	break;
@@ -4161,6 +4365,23 @@ case OP_NullRow: {
 	break;
 }
 
+/* Opcode: CursorFilter P1 * * P4 *
+ *
+ * Make the following scan of cursor P1 skip the tuples which
+ * don't satisfy the filter P4, so they don't need to be checked
+ * by the VDBE. The filter is reset when the cursor seeks a key.
+ */
+case OP_CursorFilter: {
+	VdbeCursor *pC;
+
+	assert(pOp->p1>=0 && pOp->p1<p->nCursor);
+	assert(pOp->p4type == P4_CURSORFILTER);
+	pC = p->apCsr[pOp->p1];
+	assert(pC!=0 && pC->eCurType==CURTYPE_TARANTOOL);
+	pC->uc.pCursor->filter = pOp->p4.cursor_filter;
+	break;
+}
+
 /* Opcode: Last P1 P2 P3 * *
  *
  * The next use of the Column or Prev instruction for P1
@@ -4243,7 +4464,7 @@ case OP_Sort: {        /* jump */
 			/* Fall through into OP_Rewind */
 			FALLTHROUGH;
 		}
-/* Opcode: Rewind P1 P2 * * *
+/* Opcode: Rewind P1 P2 * * P5
  *
  * The next use of the Column or Next instruction for P1
  * will refer to the first entry in the database table or index.
@@ -4251,6 +4472,9 @@ case OP_Sort: {        /* jump */
  * If the table or index is not empty, fall through to the following
  * instruction.
  *
+ * If P5 has OPFLAG_PARALLEL set, the space may be read by several
+ * fibers at once, each scanning its own key range.
+ *
  * This opcode leaves the cursor configured to move in forward order,
  * from the beginning toward the end.  In other words, the cursor is
  * configured to use Next, not Prev.
@@ -4274,7 +4498,17 @@ case OP_Rewind: {        /* jump */
 		assert(pC->eCurType==CURTYPE_TARANTOOL);
 		pCrsr = pC->uc.pCursor;
 		assert(pCrsr);
-		rc = tarantoolsqlFirst(pCrsr, &res);
+		if ((pOp->p5 & OPFLAG_PARALLEL) != 0) {
+			int partition_count;
+			rc = tarantoolsqlFirstParallel(pCrsr, &res,
+						       &partition_count);
+#ifdef SQL_TEST
+			if (partition_count > 1)
+				sql_scan_partition_count += partition_count;
+#endif
+		} else {
+			rc = tarantoolsqlFirst(pCrsr, &res);
+		}
 		pC->cacheStatus = CACHE_STALE;
 	}
 	if (rc) goto abort_due_to_error;
@@ -4362,6 +4596,18 @@ case OP_SorterNext: {  /* jump */
 	res = 0;
 	rc = sqlVdbeSorterNext(db, pC, &res);
 	goto next_tail;
+/* Opcode: HashNext P1 P2 * * *
+ *
+ * Advance hash join cursor P1 to the next row stored under the
+ * key of the last OP_HashProbe and jump to P2. Fall through if
+ * there are no more such rows.
+ */
+case OP_HashNext:      /* jump */
+	pC = p->apCsr[pOp->p1];
+	assert(pC->eCurType == CURTYPE_HASH);
+	res = 0;
+	rc = sqlVdbeHashNext(pC, &res);
+	goto next_tail;
 case OP_PrevIfOpen:    /* jump */
 case OP_NextIfOpen:    /* jump */
 	if (p->apCsr[pOp->p1]==0) break;
@@ -4432,6 +4678,57 @@ case OP_SorterInsert: {      /* in2 */
 	break;
 }
 
+/* Opcode: HashInsert P1 P2 * * *
+ * Synopsis: key=r[P2]
+ *
+ * Store the row the source table cursor of hash join cursor P1
+ * points to under the key in register P2. Rows with a NULL key
+ * are skipped, since they can't match anything.
+ */
+case OP_HashInsert: {      /* in2 */
+	assert(pOp->p1 >= 0 && pOp->p1 < p->nCursor);
+	struct VdbeCursor *cursor = p->apCsr[pOp->p1];
+	assert(cursor != NULL && cursor->eCurType == CURTYPE_HASH);
+	pIn2 = &aMem[pOp->p2];
+	rc = ExpandBlob(pIn2);
+	if (rc != 0)
+		goto abort_due_to_error;
+	rc = sqlVdbeHashWrite(db, cursor, pIn2);
+	if (rc != 0)
+		goto abort_due_to_error;
+	break;
+}
+
+/* Opcode: HashProbe P1 P2 P3 * *
+ * Synopsis: key=r[P3]
+ *
+ * Position hash join cursor P1 on the first row stored under
+ * the key in register P3. If there is no such row or the key
+ * is NULL, jump to P2.
+ *
+ * Rows are matched by the key hash, so the join condition must
+ * still be checked for every row returned.
+ */
+case OP_HashProbe: {       /* jump, in3 */
+	assert(pOp->p1 >= 0 && pOp->p1 < p->nCursor);
+	struct VdbeCursor *cursor = p->apCsr[pOp->p1];
+	assert(cursor != NULL && cursor->eCurType == CURTYPE_HASH);
+	pIn3 = &aMem[pOp->p3];
+	rc = ExpandBlob(pIn3);
+	if (rc != 0)
+		goto abort_due_to_error;
+	int res;
+	rc = sqlVdbeHashProbe(cursor, pIn3, &res);
+	if (rc != 0)
+		goto abort_due_to_error;
+	cursor->cacheStatus = CACHE_STALE;
+	cursor->nullRow = res;
+	VdbeBranchTaken(res != 0, 2);
+	if (res != 0)
+		goto jump_to_p2;
+	break;
+}
+
 /* Opcode: IdxInsert P1 P2 * P4 P5
  * Synopsis: key=r[P1]
  *
@@ -5478,6 +5775,10 @@ default: {          /* This is really OP_Noop and OP_Explain */
 			pOrigOp->cnt++;
 		}
 #endif
+		if (op_stat != NULL) {
+			vdbe_op_stat_update(op_stat, pOrigOp, pOp != pOrigOp,
+					    start);
+		}
 
 		/* The following code adds nothing to the actual functionality
 		 * of the program.  It is only here for testing and debugging.
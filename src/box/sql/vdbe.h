@@ -84,6 +84,12 @@ struct VdbeOp {
 		struct sql_key_info *key_info;
 		/** Used when p4type is P4_SPACEPTR. */
 		struct space *space;
+		/** Used when p4type is P4_BATCHAGG. */
+		struct batch_agg *batch_agg;
+		/** Used when p4type is P4_INDEXAGG. */
+		struct index_agg *index_agg;
+		/** Used when p4type is P4_CURSORFILTER. */
+		struct cursor_filter *cursor_filter;
 		/**
 		 * Used to apply types when making a record, or
 		 * doing a cast.
@@ -136,6 +142,9 @@ struct SubProgram {
 #define P4_PTR      (-18)	/* P4 is a generic pointer */
 #define P4_KEYINFO  (-19)       /* P4 is a pointer to sql_key_info structure. */
 #define P4_SPACEPTR (-20)       /* P4 is a space pointer */
+#define P4_BATCHAGG (-21)       /* P4 is a pointer to batch_agg structure */
+#define P4_INDEXAGG (-22)       /* P4 is a pointer to index_agg structure */
+#define P4_CURSORFILTER (-23)   /* P4 is a pointer to cursor_filter structure */
 
 /* Error message codes for OP_Halt */
 #define P5_ConstraintNotNull 1
@@ -62,6 +62,9 @@ typedef unsigned Bool;
 /* Opaque type used by code in vdbesort.c */
 typedef struct VdbeSorter VdbeSorter;
 
+/* Opaque type used by code in vdbehash.c */
+typedef struct VdbeHash VdbeHash;
+
 /* Elements of the linked list at Vdbe.pAuxData */
 typedef struct AuxData AuxData;
 
@@ -69,6 +72,7 @@ typedef struct AuxData AuxData;
 #define CURTYPE_TARANTOOL   0
 #define CURTYPE_SORTER      1
 #define CURTYPE_PSEUDO      2
+#define CURTYPE_HASH        3
 
 /*
  * A VdbeCursor is an superclass (a wrapper) for various cursor objects:
@@ -108,6 +112,7 @@ struct VdbeCursor {
 		BtCursor *pCursor;	/* CURTYPE_TARANTOOL */
 		int pseudoTableReg;	/* CURTYPE_PSEUDO. Reg holding content. */
 		VdbeSorter *pSorter;	/* CURTYPE_SORTER. Sorter object */
+		VdbeHash *pHash;	/* CURTYPE_HASH. Hash join table */
 	} uc;
 	/** Info about keys needed by index cursors. */
 	struct key_def *key_def;
@@ -345,6 +350,24 @@ struct ScanStatus {
 	char *zName;		/* Name of table or index */
 };
 
+/**
+ * Execution statistics of a single opcode of the main program
+ * collected by EXPLAIN ANALYZE. Rows and cycles of trigger
+ * subprograms are added to the OP_Program calling them.
+ */
+struct vdbe_op_stat {
+	/** Number of times the opcode was executed. */
+	uint64_t count;
+	/**
+	 * Number of rows the opcode produced: how many times
+	 * it positioned its cursor on an entry or, for
+	 * OP_ResultRow, how many result rows it built.
+	 */
+	uint64_t rows;
+	/** Time spent executing the opcode, see sqlHwtime(). */
+	uint64_t cycles;
+};
+
 /*
  * An instance of the virtual machine.  This structure contains the complete
  * state of the virtual machine.
@@ -434,6 +457,11 @@ struct Vdbe {
 	AuxData *pAuxData;	/* Linked list of auxdata allocations */
 	/* Anonymous savepoint for aborts only */
 	Savepoint *anonymous_savepoint;
+	/**
+	 * Statistics of each opcode of the program, not NULL
+	 * only for EXPLAIN ANALYZE.
+	 */
+	struct vdbe_op_stat *op_stats;
 #ifdef SQL_ENABLE_STMT_SCANSTATUS
 	i64 *anExec;		/* Number of times each op has been executed */
 	int nScan;		/* Entries in aScan[] */
@@ -468,6 +496,7 @@ void sqlVdbeDeleteAuxData(sql *, AuxData **, int, int);
 
 int sqlVdbeExec(Vdbe *);
 int sqlVdbeList(Vdbe *);
+int sqlVdbeListStats(Vdbe *);
 int
 sql_txn_begin(Vdbe *p);
 Savepoint *
@@ -501,6 +530,7 @@ int sqlVdbeMemCast(Mem *, enum field_type type);
 int sqlVdbeMemFromBtree(BtCursor *, u32, u32, Mem *);
 void sqlVdbeMemRelease(Mem * p);
 int sqlVdbeMemFinalize(Mem *, FuncDef *);
+int sqlIntFloatCompare(i64 i, double r);
 const char *sqlOpcodeName(int);
 int sqlVdbeMemGrow(Mem * pMem, int n, int preserve);
 int sqlVdbeMemClearAndResize(Mem * pMem, int n);
@@ -509,7 +539,27 @@ void sqlVdbeFrameDelete(VdbeFrame *);
 int sqlVdbeFrameRestore(VdbeFrame *);
 int sqlVdbeTransferError(Vdbe * p);
 
-int sqlVdbeSorterInit(struct sql *db, struct VdbeCursor *cursor);
+/**
+ * Check if the statement may yield to other fibers. It may not
+ * outside of the tx thread or in a transaction, which would be
+ * aborted by a yield if it has memtx statements, and while a
+ * scan of a memtx space is in progress, since other fibers
+ * could change the space under it.
+ */
+bool
+sql_vdbe_may_yield(struct Vdbe *p);
+
+/**
+ * Free the iterators and tuples held by the memtx cursors of the
+ * statement, so that it may yield. The scans of the cursors must
+ * be over: they are invalidated, and the next seek reads the
+ * space anew.
+ */
+void
+sql_vdbe_release_memtx(struct Vdbe *p);
+
+int sqlVdbeSorterInit(struct sql *db, struct Vdbe *vdbe,
+		      struct VdbeCursor *cursor);
 void sqlVdbeSorterReset(sql *, VdbeSorter *);
 void sqlVdbeSorterClose(sql *, VdbeCursor *);
 int sqlVdbeSorterRowkey(const VdbeCursor *, Mem *);
@@ -518,6 +568,20 @@ int sqlVdbeSorterRewind(const VdbeCursor *, int *);
 int sqlVdbeSorterWrite(const VdbeCursor *, Mem *);
 int sqlVdbeSorterCompare(const VdbeCursor *, Mem *, int, int *);
 
+int sqlVdbeHashInit(struct sql *db, struct VdbeCursor *cursor,
+		    struct BtCursor *source);
+void sqlVdbeHashClose(struct sql *db, struct VdbeCursor *cursor);
+int sqlVdbeHashWrite(struct sql *db, const struct VdbeCursor *cursor,
+		     struct Mem *key);
+int sqlVdbeHashProbe(const struct VdbeCursor *cursor, struct Mem *key,
+		     int *res);
+int sqlVdbeHashNext(const struct VdbeCursor *cursor, int *res);
+const char *sqlVdbeHashRow(const struct VdbeCursor *cursor, uint32_t *size);
+struct BtCursor *sqlVdbeHashSource(const struct VdbeCursor *cursor);
+
+int sqlVdbeBatchAggregate(struct Vdbe *p, struct BtCursor *cursor,
+			  const struct batch_agg *agg);
+
 #ifdef SQL_DEBUG
 void sqlVdbeMemAboutToChange(Vdbe *, Mem *);
 int sqlVdbeCheckMemInvariants(Mem *);
@@ -575,6 +575,12 @@ sqlStep(Vdbe * p)
 		db->nVdbeExec++;
 		rc = sqlVdbeExec(p);
 		db->nVdbeExec--;
+		/*
+		 * EXPLAIN ANALYZE lists the program once it
+		 * has run to completion.
+		 */
+		if (rc == SQL_DONE && p->op_stats != NULL)
+			rc = sqlVdbeListStats(p);
 	}
 
 #ifndef SQL_OMIT_TRACE
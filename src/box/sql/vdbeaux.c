@@ -863,7 +863,10 @@ freeP4(sql * db, int p4type, void *p4)
 	case P4_REAL:
 	case P4_INT64:
 	case P4_DYNAMIC:
-	case P4_INTARRAY:{
+	case P4_INTARRAY:
+	case P4_BATCHAGG:
+	case P4_INDEXAGG:
+	case P4_CURSORFILTER:{
 			sqlDbFree(db, p4);
 			break;
 		}
@@ -1403,6 +1406,22 @@ displayP4(Op * pOp, char *zTemp, int nTemp)
 		sqlXPrintf(&x, "space<name=%s>", space_name(pOp->p4.space));
 		break;
 	}
+	case P4_BATCHAGG: {
+		sqlXPrintf(&x, "batch<filters=%u,funcs=%u>",
+			   pOp->p4.batch_agg->filter_count,
+			   pOp->p4.batch_agg->func_count);
+		break;
+	}
+	case P4_INDEXAGG: {
+		sqlXPrintf(&x, "index<funcs=%u>",
+			   pOp->p4.index_agg->func_count);
+		break;
+	}
+	case P4_CURSORFILTER: {
+		sqlXPrintf(&x, "filter<terms=%u>",
+			   pOp->p4.cursor_filter->term_count);
+		break;
+	}
 	default:{
 			zP4 = pOp->p4.z;
 			if (zP4 == 0) {
@@ -1545,6 +1564,10 @@ sqlVdbeFrameDelete(VdbeFrame * p)
  *
  * When p->explain==1, first the main program is listed, then each of
  * the trigger subprograms are listed one by one.
+ *
+ * When p->explain==3, the main program has already been run by
+ * EXPLAIN ANALYZE, and each of its instructions is listed along
+ * with the statistics collected during the run.
  */
 int
 sqlVdbeList(Vdbe * p)
@@ -1567,7 +1590,7 @@ sqlVdbeList(Vdbe * p)
 	 * the result, result columns may become dynamic if the user calls
 	 * sql_column_text16(), causing a translation to UTF-16 encoding.
 	 */
-	releaseMemArray(pMem, 8);
+	releaseMemArray(pMem, p->explain == 3 ? 11 : 8);
 	p->pResultSet = 0;
 
 	if (p->rc == SQL_NOMEM) {
@@ -1635,7 +1658,7 @@ sqlVdbeList(Vdbe * p)
 			}
 			pOp = &apSub[j]->aOp[i];
 		}
-		if (p->explain == 1) {
+		if (p->explain != 2) {
 			pMem->flags = MEM_Int;
 			pMem->u.i = i;	/* Program counter */
 			pMem++;
@@ -1651,7 +1674,7 @@ sqlVdbeList(Vdbe * p)
 			 * kept in p->aMem[9].z to hold the new program - assuming this subprogram
 			 * has not already been seen.
 			 */
-			if (pOp->p4type == P4_SUBPROGRAM) {
+			if (p->explain == 1 && pOp->p4type == P4_SUBPROGRAM) {
 				int nByte = (nSub + 1) * sizeof(SubProgram *);
 				int j;
 				for (j = 0; j < nSub; j++) {
@@ -1699,7 +1722,7 @@ sqlVdbeList(Vdbe * p)
 		}
 		pMem++;
 
-		if (p->explain == 1) {
+		if (p->explain != 2) {
 			if (sqlVdbeMemClearAndResize(pMem, 4)) {
 				assert(p->db->mallocFailed);
 				return SQL_ERROR;
@@ -1721,7 +1744,21 @@ sqlVdbeList(Vdbe * p)
 #endif
 		}
 
-		p->nResColumn = 8 - 4 * (p->explain - 1);
+		if (p->explain == 3) {
+			struct vdbe_op_stat *stat = &p->op_stats[i];
+			pMem++;
+			pMem->flags = MEM_Int;
+			pMem->u.i = stat->count;
+			pMem++;
+			pMem->flags = MEM_Int;
+			pMem->u.i = stat->rows;
+			pMem++;
+			pMem->flags = MEM_Int;
+			pMem->u.i = stat->cycles;
+			p->nResColumn = 11;
+		} else {
+			p->nResColumn = 8 - 4 * (p->explain - 1);
+		}
 		p->pResultSet = &p->aMem[1];
 		p->rc = SQL_OK;
 		rc = SQL_ROW;
@@ -1729,6 +1766,29 @@ sqlVdbeList(Vdbe * p)
 	return rc;
 }
 
+/*
+ * This is called when the program of EXPLAIN ANALYZE has been
+ * run to completion. Instead of finishing the statement, switch
+ * the VDBE to listing its program along with the collected
+ * statistics, and return the first row of the listing.
+ */
+int
+sqlVdbeListStats(Vdbe * p)
+{
+	assert(p->op_stats != NULL && p->explain == 0);
+	assert(p->magic == VDBE_MAGIC_HALT && p->pc >= 0);
+	/*
+	 * The VDBE has been halted, so it is not counted as an
+	 * active one anymore. It is halted once again when
+	 * reset or finalized.
+	 */
+	p->magic = VDBE_MAGIC_RUN;
+	p->db->nVdbeActive++;
+	p->explain = 3;
+	p->pc = 0;
+	return sqlVdbeList(p);
+}
+
 #ifdef SQL_DEBUG
 /*
  * Print the SQL that was used to generate a VDBE program.
@@ -1864,6 +1924,10 @@ sqlVdbeRewind(Vdbe * p)
 	p->cacheCtr = 1;
 	p->iStatement = 0;
 	p->nFkConstraint = 0;
+	if (p->op_stats != NULL) {
+		p->explain = 0;
+		memset(p->op_stats, 0, p->nOp * sizeof(p->op_stats[0]));
+	}
 #ifdef VDBE_PROFILE
 	for (i = 0; i < p->nOp; i++) {
 		p->aOp[i].cnt = 0;
@@ -1936,7 +2000,10 @@ sqlVdbeMakeReady(Vdbe * p,	/* The VDBE */
 	assert(EIGHT_BYTE_ALIGNMENT(&x.pSpace[x.nFree]));
 
 	resolveP2Values(p, &nArg);
-	if (pParse->explain && nMem < 10) {
+	if (pParse->explain == 3 && nMem < 12) {
+		/* The listing of EXPLAIN ANALYZE has 11 columns. */
+		nMem = 12;
+	} else if (pParse->explain && nMem < 10) {
 		nMem = 10;
 	}
 	p->expired = 0;
@@ -1958,6 +2025,10 @@ sqlVdbeMakeReady(Vdbe * p,	/* The VDBE */
 		p->apArg = allocSpace(&x, p->apArg, nArg * sizeof(Mem *));
 		p->apCsr =
 		    allocSpace(&x, p->apCsr, nCursor * sizeof(VdbeCursor *));
+		if (pParse->explain == 3) {
+			p->op_stats = allocSpace(&x, p->op_stats, p->nOp *
+						 sizeof(struct vdbe_op_stat));
+		}
 #ifdef SQL_ENABLE_STMT_SCANSTATUS
 		p->anExec = allocSpace(&x, p->anExec, p->nOp * sizeof(i64));
 #endif
@@ -1969,7 +2040,11 @@ sqlVdbeMakeReady(Vdbe * p,	/* The VDBE */
 
 	p->pVList = pParse->pVList;
 	pParse->pVList = 0;
-	p->explain = pParse->explain;
+	/*
+	 * EXPLAIN ANALYZE runs the program first and lists it
+	 * afterwards, see sqlVdbeListStats().
+	 */
+	p->explain = pParse->explain == 3 ? 0 : pParse->explain;
 	if (db->mallocFailed) {
 		p->nVar = 0;
 		p->nCursor = 0;
@@ -2003,6 +2078,10 @@ sqlVdbeFreeCursor(Vdbe * p, VdbeCursor * pCx)
 			sqlVdbeSorterClose(p->db, pCx);
 			break;
 		}
+	case CURTYPE_HASH:{
+			sqlVdbeHashClose(p->db, pCx);
+			break;
+		}
 	case CURTYPE_TARANTOOL:{
 		assert(pCx->uc.pCursor != 0);
 		sql_cursor_close(pCx->uc.pCursor);
@@ -2552,6 +2631,67 @@ sqlVdbeTransferError(Vdbe * p)
 	return rc;
 }
 
+/** Return the cursor if it reads a memtx space, NULL otherwise. */
+static struct BtCursor *
+vdbe_memtx_cursor(struct VdbeCursor *c)
+{
+	if (c == NULL || c->eCurType != CURTYPE_TARANTOOL)
+		return NULL;
+	struct BtCursor *cursor = c->uc.pCursor;
+	if ((cursor->curFlags & BTCF_TEphemCursor) != 0 ||
+	    cursor->space == NULL || !space_is_memtx(cursor->space))
+		return NULL;
+	return cursor;
+}
+
+/** Check if any of the cursors is in the middle of a memtx scan. */
+static bool
+vdbe_cursors_scan_memtx(struct VdbeCursor **cursors, int count)
+{
+	for (int i = 0; i < count; i++) {
+		struct BtCursor *cursor = vdbe_memtx_cursor(cursors[i]);
+		if (cursor != NULL && cursor->eState == CURSOR_VALID)
+			return true;
+	}
+	return false;
+}
+
+bool
+sql_vdbe_may_yield(struct Vdbe *p)
+{
+	if (!cord_is_main() || in_txn() != NULL)
+		return false;
+	if (vdbe_cursors_scan_memtx(p->apCsr, p->nCursor))
+		return false;
+	/* Cursors of the callers of a sub-program are kept open. */
+	for (struct VdbeFrame *f = p->pFrame; f != NULL; f = f->pParent) {
+		if (vdbe_cursors_scan_memtx(f->apCsr, f->nCursor))
+			return false;
+	}
+	return true;
+}
+
+/** Free the iterators and tuples of the memtx cursors. */
+static void
+vdbe_cursors_release_memtx(struct VdbeCursor **cursors, int count)
+{
+	for (int i = 0; i < count; i++) {
+		struct BtCursor *cursor = vdbe_memtx_cursor(cursors[i]);
+		if (cursor == NULL)
+			continue;
+		sql_cursor_cleanup(cursor);
+		cursors[i]->cacheStatus = CACHE_STALE;
+	}
+}
+
+void
+sql_vdbe_release_memtx(struct Vdbe *p)
+{
+	vdbe_cursors_release_memtx(p->apCsr, p->nCursor);
+	for (struct VdbeFrame *f = p->pFrame; f != NULL; f = f->pParent)
+		vdbe_cursors_release_memtx(f->apCsr, f->nCursor);
+}
+
 #ifdef SQL_ENABLE_SQLLOG
 /*
  * If an SQL_CONFIG_SQLLOG hook is registered and the VM has been run,
@@ -3323,7 +3463,7 @@ sqlBlobCompare(const Mem * pB1, const Mem * pB2)
  * number.  Return negative, zero, or positive if the first (i64) is less than,
  * equal to, or greater than the second (double).
  */
-static int
+int
 sqlIntFloatCompare(i64 i, double r)
 {
 	if (sizeof(LONGDOUBLE_TYPE) > 8) {
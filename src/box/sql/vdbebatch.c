@@ -0,0 +1,387 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * This file contains the implementation of OP_BatchAggregate,
+ * a batch-at-a-time scan computing simple aggregates:
+ *
+ *   SELECT count(*), sum(a), avg(b) FROM t WHERE a > 10 AND b < 5;
+ *
+ * Instead of running the VDBE loop once per tuple, the whole
+ * space is read in batches of BATCH_SIZE tuples. Each batch is
+ * decoded once into column vectors holding only the fields the
+ * query needs, then every filter is applied to the whole batch
+ * producing a selection vector, and finally every aggregate is
+ * accumulated over the selected rows in a tight loop.
+ *
+ * The results are exactly the same the row-at-a-time program
+ * would produce with the aggregate functions from func.c.
+ */
+#include "fiber.h"
+#include "msgpuck/msgpuck.h"
+#include "sqlInt.h"
+#include "vdbeInt.h"
+#include "tarantoolInt.h"
+#include "box/tuple.h"
+
+/** Number of tuples fetched from the cursor at once. */
+enum { BATCH_SIZE = 256 };
+
+/** Type of a value stored in a column vector. */
+enum batch_value_type {
+	BATCH_VALUE_NULL,
+	BATCH_VALUE_INT,
+	BATCH_VALUE_REAL,
+};
+
+/** Values of a single field of all tuples in a batch. */
+struct batch_column {
+	/** Type of each value, enum batch_value_type. */
+	uint8_t type[BATCH_SIZE];
+	union {
+		int64_t i;
+		double r;
+	} value[BATCH_SIZE];
+};
+
+/** Accumulator of an aggregate function, see SumCtx. */
+struct batch_acc {
+	/** Number of non-NULL values or rows for COUNT(*). */
+	int64_t count;
+	/** Integer sum, valid unless approx or overflow is set. */
+	int64_t i_sum;
+	/** Floating point sum. */
+	double r_sum;
+	/** Set if the integer sum has overflowed. */
+	bool overflow;
+	/** Set if a non-integer value has been added. */
+	bool approx;
+};
+
+/**
+ * Decode a MsgPack field into a column vector slot. Conversions
+ * mimic vdbe_decode_msgpack_into_mem() and OP_Column.
+ */
+static int
+batch_decode_value(const char **data, bool is_real,
+		   struct batch_column *column, uint32_t row)
+{
+	switch (mp_typeof(**data)) {
+	case MP_NIL:
+		mp_decode_nil(data);
+		column->type[row] = BATCH_VALUE_NULL;
+		return 0;
+	case MP_BOOL:
+		column->value[row].i = mp_decode_bool(data);
+		column->type[row] = BATCH_VALUE_INT;
+		break;
+	case MP_UINT: {
+		uint64_t v = mp_decode_uint(data);
+		if (v > INT64_MAX) {
+			diag_set(ClientError, ER_SQL_EXECUTE,
+				 "integer is overflowed");
+			return -1;
+		}
+		column->value[row].i = v;
+		column->type[row] = BATCH_VALUE_INT;
+		break;
+	}
+	case MP_INT:
+		column->value[row].i = mp_decode_int(data);
+		column->type[row] = BATCH_VALUE_INT;
+		break;
+	case MP_FLOAT:
+		column->value[row].r = mp_decode_float(data);
+		goto real;
+	case MP_DOUBLE:
+		column->value[row].r = mp_decode_double(data);
+real:
+		column->type[row] = sqlIsNaN(column->value[row].r) ?
+				    BATCH_VALUE_NULL : BATCH_VALUE_REAL;
+		return 0;
+	default:
+		/* Only numeric columns are read by the batch scan. */
+		assert(false);
+		mp_next(data);
+		column->type[row] = BATCH_VALUE_NULL;
+		return 0;
+	}
+	if (is_real) {
+		column->value[row].r = (double) column->value[row].i;
+		column->type[row] = BATCH_VALUE_REAL;
+	}
+	return 0;
+}
+
+/**
+ * Decode the needed fields of a batch of tuples into column
+ * vectors. Each tuple is walked only once since the field
+ * numbers are sorted. Tuples are read as they are stored, which
+ * is fine, because numeric values are too short to be
+ * compressed (see TUPLE_COMPRESSION_MIN_SIZE).
+ */
+static int
+batch_decode(const struct batch_agg *agg, struct tuple **tuples,
+	     uint32_t count, struct batch_column *columns)
+{
+	for (uint32_t row = 0; row < count; ++row) {
+		const char *data = tuple_data(tuples[row]);
+		uint32_t field_count = mp_decode_array(&data);
+		uint32_t fieldno = 0;
+		for (uint32_t i = 0; i < agg->column_count; ++i) {
+			uint32_t target = agg->fieldno[i];
+			if (target >= field_count) {
+				columns[i].type[row] = BATCH_VALUE_NULL;
+				continue;
+			}
+			for (; fieldno < target; ++fieldno)
+				mp_next(&data);
+			if (batch_decode_value(&data, agg->is_real[i],
+					       &columns[i], row) != 0)
+				return -1;
+			++fieldno;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Compare a non-NULL column value with a numeric constant the
+ * same way sqlMemCompare() does.
+ */
+static inline int
+batch_compare(const struct batch_column *column, uint32_t row,
+	      const struct Mem *value)
+{
+	if (column->type[row] == BATCH_VALUE_INT) {
+		int64_t i = column->value[row].i;
+		if ((value->flags & MEM_Int) != 0)
+			return i < value->u.i ? -1 : i > value->u.i;
+		return sqlIntFloatCompare(i, value->u.r);
+	}
+	double r = column->value[row].r;
+	if ((value->flags & MEM_Int) != 0)
+		return -sqlIntFloatCompare(value->u.i, r);
+	return r < value->u.r ? -1 : r > value->u.r;
+}
+
+/** Check the result of a comparison against a TK_ operator. */
+static inline bool
+batch_compare_is_true(int op, int res)
+{
+	switch (op) {
+	case TK_EQ: return res == 0;
+	case TK_NE: return res != 0;
+	case TK_LT: return res < 0;
+	case TK_LE: return res <= 0;
+	case TK_GT: return res > 0;
+	default:
+		assert(op == TK_GE);
+		return res >= 0;
+	}
+}
+
+/**
+ * Apply a filter to the selection vector. Comparison with NULL
+ * is never true, so rows with NULL are deselected as well as
+ * all rows when the constant is NULL.
+ */
+static void
+batch_filter(const struct batch_column *column, uint32_t count, int op,
+	     const struct Mem *value, uint8_t *selected)
+{
+	if ((value->flags & MEM_Null) != 0) {
+		memset(selected, 0, count);
+		return;
+	}
+	assert((value->flags & (MEM_Int | MEM_Real)) != 0);
+	for (uint32_t row = 0; row < count; ++row) {
+		if (!selected[row])
+			continue;
+		if (column->type[row] == BATCH_VALUE_NULL) {
+			selected[row] = 0;
+			continue;
+		}
+		int res = batch_compare(column, row, value);
+		selected[row] = batch_compare_is_true(op, res);
+	}
+}
+
+/** Add the selected values of a column to an accumulator. */
+static void
+batch_accumulate(const struct batch_column *column, uint32_t count,
+		 const uint8_t *selected, struct batch_acc *acc)
+{
+	for (uint32_t row = 0; row < count; ++row) {
+		if (!selected[row] || column->type[row] == BATCH_VALUE_NULL)
+			continue;
+		acc->count++;
+		if (column->type[row] == BATCH_VALUE_INT) {
+			int64_t v = column->value[row].i;
+			acc->r_sum += v;
+			if (!acc->approx && !acc->overflow &&
+			    sqlAddInt64(&acc->i_sum, v) != 0)
+				acc->overflow = true;
+		} else {
+			acc->r_sum += column->value[row].r;
+			acc->approx = true;
+		}
+	}
+}
+
+/** Count the selected non-NULL values of a column. */
+static void
+batch_count(const struct batch_column *column, uint32_t count,
+	    const uint8_t *selected, struct batch_acc *acc)
+{
+	for (uint32_t row = 0; row < count; ++row) {
+		acc->count += selected[row] &&
+			      column->type[row] != BATCH_VALUE_NULL;
+	}
+}
+
+/** Process a batch of tuples. */
+static int
+batch_process(struct Vdbe *p, const struct batch_agg *agg,
+	      struct tuple **tuples, uint32_t count,
+	      struct batch_column *columns, uint8_t *selected,
+	      struct batch_acc *accs)
+{
+	if (batch_decode(agg, tuples, count, columns) != 0)
+		return -1;
+	memset(selected, 1, count);
+	for (uint32_t i = 0; i < agg->filter_count; ++i) {
+		const struct batch_agg_filter *filter = &agg->filters[i];
+		batch_filter(&columns[filter->column], count, filter->op,
+			     &p->aMem[filter->reg], selected);
+	}
+	uint32_t selected_count = 0;
+	for (uint32_t row = 0; row < count; ++row)
+		selected_count += selected[row];
+	if (selected_count == 0)
+		return 0;
+	for (uint32_t i = 0; i < agg->func_count; ++i) {
+		const struct batch_agg_def *func = &agg->funcs[i];
+		switch (func->type) {
+		case BATCH_AGG_COUNT_STAR:
+			accs[i].count += selected_count;
+			break;
+		case BATCH_AGG_COUNT:
+			batch_count(&columns[func->column], count, selected,
+				    &accs[i]);
+			break;
+		default:
+			batch_accumulate(&columns[func->column], count,
+					 selected, &accs[i]);
+			break;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Store the final value of an aggregate function to a register,
+ * see countFinalize(), sumFinalize(), totalFinalize() and
+ * avgFinalize().
+ */
+static int
+batch_finalize(struct Vdbe *p, const struct batch_agg_def *func,
+	       const struct batch_acc *acc)
+{
+	struct Mem *mem = &p->aMem[func->reg];
+	switch (func->type) {
+	case BATCH_AGG_COUNT_STAR:
+	case BATCH_AGG_COUNT:
+		sqlVdbeMemSetInt64(mem, acc->count);
+		break;
+	case BATCH_AGG_SUM:
+		if (acc->count == 0) {
+			sqlVdbeMemSetNull(mem);
+		} else if (acc->overflow) {
+			sqlVdbeError(p, "integer overflow");
+			return SQL_ERROR;
+		} else if (acc->approx) {
+			sqlVdbeMemSetDouble(mem, acc->r_sum);
+		} else {
+			sqlVdbeMemSetInt64(mem, acc->i_sum);
+		}
+		break;
+	case BATCH_AGG_TOTAL:
+		sqlVdbeMemSetDouble(mem, acc->r_sum);
+		break;
+	case BATCH_AGG_AVG:
+		if (acc->count == 0)
+			sqlVdbeMemSetNull(mem);
+		else
+			sqlVdbeMemSetDouble(mem, acc->r_sum /
+						 (double) acc->count);
+		break;
+	}
+	return SQL_OK;
+}
+
+int
+sqlVdbeBatchAggregate(struct Vdbe *p, struct BtCursor *cursor,
+		      const struct batch_agg *agg)
+{
+	struct sql *db = p->db;
+	size_t size = sizeof(struct tuple *) * BATCH_SIZE + BATCH_SIZE +
+		      sizeof(struct batch_acc) * agg->func_count +
+		      sizeof(struct batch_column) * agg->column_count;
+	struct batch_column *columns = sqlDbMallocZero(db, size);
+	if (columns == NULL)
+		return SQL_NOMEM;
+	struct batch_acc *accs =
+		(struct batch_acc *) &columns[agg->column_count];
+	struct tuple **tuples = (struct tuple **) &accs[agg->func_count];
+	uint8_t *selected = (uint8_t *) &tuples[BATCH_SIZE];
+
+	int res;
+	int rc = tarantoolsqlFirst(cursor, &res);
+	while (rc == SQL_OK && res == 0) {
+		uint32_t count = 0;
+		do {
+			tuples[count] = cursor->last_tuple;
+			tuple_ref(tuples[count++]);
+			rc = tarantoolsqlNext(cursor, &res);
+		} while (rc == SQL_OK && res == 0 && count < BATCH_SIZE);
+		if (rc == SQL_OK &&
+		    batch_process(p, agg, tuples, count, columns, selected,
+				  accs) != 0)
+			rc = SQL_TARANTOOL_ERROR;
+		for (uint32_t i = 0; i < count; ++i)
+			tuple_unref(tuples[i]);
+	}
+	for (uint32_t i = 0; i < agg->func_count && rc == SQL_OK; ++i)
+		rc = batch_finalize(p, &agg->funcs[i], &accs[i]);
+	sqlDbFree(db, columns);
+	return rc;
+}
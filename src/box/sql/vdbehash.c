@@ -0,0 +1,411 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * This file contains code for the VdbeHash object, the build
+ * table of a hash join. The build side of the join is scanned
+ * once and each of its rows is stored in the table under the
+ * hash of the join key. Then every row of the probe side looks
+ * up the rows with the same key hash.
+ *
+ * Here is the (internal, non-API) interface between this module
+ * and the rest of the sql system:
+ *
+ *    sqlVdbeHashInit()     Create a new VdbeHash object reading
+ *                          rows from the given table cursor.
+ *
+ *    sqlVdbeHashWrite()    Add the row the table cursor currently
+ *                          points to under the given key.
+ *
+ *    sqlVdbeHashProbe()    Position the hash cursor on the first
+ *                          row stored under the given key.
+ *
+ *    sqlVdbeHashNext()     Advance the hash cursor to the next row
+ *                          stored under the same key.
+ *
+ *    sqlVdbeHashRow()      Return the MsgPack of the row under the
+ *                          hash cursor.
+ *
+ *    sqlVdbeHashClose()    Close the VdbeHash object and reclaim
+ *                          all resources.
+ *
+ * Rows are kept on the SQL heap until they exceed
+ * box.cfg.sql_hash_join_memory bytes. All rows written after that
+ * are spilled to an ephemeral space indexed by the key hash.
+ *
+ * Only the key hash is stored, so a probe may return rows whose
+ * keys collide with the probe key. The code generator leaves the
+ * join term in the WHERE clause, which filters such rows out.
+ */
+#include "fiber.h"
+#include "msgpuck/msgpuck.h"
+#include "sqlInt.h"
+#include "vdbeInt.h"
+#include "tarantoolInt.h"
+#include "box/index.h"
+#include "box/space.h"
+#include "box/tuple.h"
+#include "third_party/PMurHash.h"
+
+/** Initial number of buckets in the in-memory table. */
+enum { HASH_JOIN_MIN_BUCKETS = 64 };
+
+/** Hash seeds. Numbers of all types share the same seed. */
+enum {
+	HASH_JOIN_SEED_NUMBER = 13,
+	HASH_JOIN_SEED_STRING = 17,
+	HASH_JOIN_SEED_BLOB = 19,
+	HASH_JOIN_SEED_BOOL = 23,
+};
+
+/** A row of the build table kept on the SQL heap. */
+struct hash_join_entry {
+	/** Next entry in the same bucket. */
+	struct hash_join_entry *next;
+	/** Hash of the join key. */
+	uint32_t hash;
+	/** Size of the row MsgPack. */
+	uint32_t size;
+	/** Row MsgPack. */
+	char data[0];
+};
+
+struct VdbeHash {
+	/** Table cursor the build rows are read from. */
+	struct BtCursor *source;
+	/** Buckets of the in-memory table. */
+	struct hash_join_entry **buckets;
+	/** Number of buckets, always a power of two. */
+	uint32_t bucket_count;
+	/** Number of entries in the in-memory table. */
+	uint32_t entry_count;
+	/** Bytes allocated for the in-memory table. */
+	size_t mem_used;
+	/**
+	 * Ephemeral space with spilled rows or NULL. Its
+	 * tuples have format [hash, seq, row].
+	 */
+	struct space *spill;
+	/** Sequence number making spilled tuples unique. */
+	uint64_t spill_seq;
+	/** Key hash of the current probe. */
+	uint32_t probe_hash;
+	/** Current in-memory entry or NULL. */
+	struct hash_join_entry *entry;
+	/** Iterator over spilled rows of the current probe. */
+	struct iterator *spill_iter;
+	/** Current spilled tuple, referenced, or NULL. */
+	struct tuple *spill_tuple;
+};
+
+/**
+ * Compute the hash of a join key. Integers and reals with an
+ * integral value hash equally, since they compare equal.
+ *
+ * @param key Join key value.
+ * @param[out] hash Key hash.
+ *
+ * @retval true on success.
+ * @retval false if the key is NULL and can't match anything.
+ */
+static bool
+hash_join_key_hash(struct Mem *key, uint32_t *hash)
+{
+	if ((key->flags & MEM_Null) != 0)
+		return false;
+	if ((key->flags & MEM_Int) != 0) {
+		*hash = PMurHash32(HASH_JOIN_SEED_NUMBER, &key->u.i,
+				   sizeof(key->u.i));
+	} else if ((key->flags & MEM_Real) != 0) {
+		double r = key->u.r;
+		if (r >= (double) INT64_MIN && r < -(double) INT64_MIN &&
+		    r == (double) (int64_t) r) {
+			int64_t i = (int64_t) r;
+			*hash = PMurHash32(HASH_JOIN_SEED_NUMBER, &i,
+					   sizeof(i));
+		} else {
+			*hash = PMurHash32(HASH_JOIN_SEED_NUMBER, &r,
+					   sizeof(r));
+		}
+	} else if ((key->flags & MEM_Bool) != 0) {
+		uint8_t b = key->u.b;
+		*hash = PMurHash32(HASH_JOIN_SEED_BOOL, &b, sizeof(b));
+	} else if ((key->flags & MEM_Str) != 0) {
+		*hash = PMurHash32(HASH_JOIN_SEED_STRING, key->z, key->n);
+	} else {
+		assert((key->flags & MEM_Blob) != 0);
+		*hash = PMurHash32(HASH_JOIN_SEED_BLOB, key->z, key->n);
+	}
+	return true;
+}
+
+int
+sqlVdbeHashInit(struct sql *db, struct VdbeCursor *cursor,
+		struct BtCursor *source)
+{
+	assert(cursor->eCurType == CURTYPE_HASH);
+	assert(source->curFlags & BTCF_TaCursor ||
+	       source->curFlags & BTCF_TEphemCursor);
+	struct VdbeHash *hash = sqlDbMallocZero(db, sizeof(*hash));
+	if (hash == NULL)
+		return SQL_NOMEM;
+	hash->buckets = sqlMallocZero(HASH_JOIN_MIN_BUCKETS *
+				      sizeof(hash->buckets[0]));
+	if (hash->buckets == NULL) {
+		sqlDbFree(db, hash);
+		return SQL_NOMEM;
+	}
+	hash->bucket_count = HASH_JOIN_MIN_BUCKETS;
+	hash->source = source;
+	cursor->uc.pHash = hash;
+	return SQL_OK;
+}
+
+/** Drop the current spilled tuple and iterator, if any. */
+static void
+hash_join_spill_reset(struct VdbeHash *hash)
+{
+	if (hash->spill_tuple != NULL) {
+		tuple_unref(hash->spill_tuple);
+		hash->spill_tuple = NULL;
+	}
+	if (hash->spill_iter != NULL) {
+		iterator_delete(hash->spill_iter);
+		hash->spill_iter = NULL;
+	}
+}
+
+void
+sqlVdbeHashClose(struct sql *db, struct VdbeCursor *cursor)
+{
+	assert(cursor->eCurType == CURTYPE_HASH);
+	struct VdbeHash *hash = cursor->uc.pHash;
+	if (hash == NULL)
+		return;
+	hash_join_spill_reset(hash);
+	if (hash->spill != NULL)
+		space_delete(hash->spill);
+	for (uint32_t i = 0; i < hash->bucket_count; i++) {
+		struct hash_join_entry *entry = hash->buckets[i];
+		while (entry != NULL) {
+			struct hash_join_entry *next = entry->next;
+			sqlDbFree(db, entry);
+			entry = next;
+		}
+	}
+	sql_free(hash->buckets);
+	sqlDbFree(db, hash);
+	cursor->uc.pHash = NULL;
+}
+
+/**
+ * Double the number of buckets once the table gets denser than
+ * one entry per bucket. Failure to grow is not an error: the
+ * table keeps working, only with longer chains.
+ */
+static void
+hash_join_grow(struct VdbeHash *hash)
+{
+	uint32_t new_count = hash->bucket_count * 2;
+	struct hash_join_entry **new_buckets =
+		sqlMallocZero(new_count * sizeof(new_buckets[0]));
+	if (new_buckets == NULL)
+		return;
+	for (uint32_t i = 0; i < hash->bucket_count; i++) {
+		struct hash_join_entry *entry = hash->buckets[i];
+		while (entry != NULL) {
+			struct hash_join_entry *next = entry->next;
+			uint32_t b = entry->hash & (new_count - 1);
+			entry->next = new_buckets[b];
+			new_buckets[b] = entry;
+			entry = next;
+		}
+	}
+	sql_free(hash->buckets);
+	hash->mem_used += (new_count - hash->bucket_count) *
+			  sizeof(new_buckets[0]);
+	hash->buckets = new_buckets;
+	hash->bucket_count = new_count;
+}
+
+/** Store a row in the ephemeral space. */
+static int
+hash_join_spill(struct VdbeHash *hash, uint32_t key_hash,
+		const char *row, uint32_t row_size)
+{
+	if (hash->spill == NULL) {
+		hash->spill = sql_ephemeral_space_create(3, NULL);
+		if (hash->spill == NULL)
+			return SQL_TARANTOOL_ERROR;
+	}
+	size_t size = mp_sizeof_array(3) + mp_sizeof_uint(key_hash) +
+		      mp_sizeof_uint(hash->spill_seq) + mp_sizeof_bin(row_size);
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	char *tuple = region_alloc(region, size);
+	if (tuple == NULL) {
+		diag_set(OutOfMemory, size, "region", "tuple");
+		return SQL_TARANTOOL_ERROR;
+	}
+	char *pos = mp_encode_array(tuple, 3);
+	pos = mp_encode_uint(pos, key_hash);
+	pos = mp_encode_uint(pos, hash->spill_seq++);
+	pos = mp_encode_bin(pos, row, row_size);
+	assert(pos == tuple + size);
+	int rc = tarantoolsqlEphemeralInsert(hash->spill, tuple, pos);
+	region_truncate(region, used);
+	return rc;
+}
+
+int
+sqlVdbeHashWrite(struct sql *db, const struct VdbeCursor *cursor,
+		 struct Mem *key)
+{
+	assert(cursor->eCurType == CURTYPE_HASH);
+	struct VdbeHash *hash = cursor->uc.pHash;
+	uint32_t key_hash;
+	if (!hash_join_key_hash(key, &key_hash))
+		return SQL_OK;
+	uint32_t row_size;
+	const char *row = tarantoolsqlPayloadFetch(hash->source, &row_size);
+	size_t size = sizeof(struct hash_join_entry) + row_size;
+	if (hash->spill != NULL ||
+	    hash->mem_used + size > sql_hash_join_memory)
+		return hash_join_spill(hash, key_hash, row, row_size);
+	struct hash_join_entry *entry = sqlDbMallocRawNN(db, size);
+	if (entry == NULL)
+		return SQL_NOMEM;
+	entry->hash = key_hash;
+	entry->size = row_size;
+	memcpy(entry->data, row, row_size);
+	uint32_t b = key_hash & (hash->bucket_count - 1);
+	entry->next = hash->buckets[b];
+	hash->buckets[b] = entry;
+	hash->mem_used += size;
+	if (++hash->entry_count > hash->bucket_count)
+		hash_join_grow(hash);
+	return SQL_OK;
+}
+
+/**
+ * Position the probe on the first matching row at or after
+ * the current in-memory entry, falling back to spilled rows.
+ *
+ * @param hash Hash object.
+ * @param[out] res Set to 0 if positioned, 1 if exhausted.
+ *
+ * @retval SQL_OK on success, SQL_TARANTOOL_ERROR otherwise.
+ */
+static int
+hash_join_seek(struct VdbeHash *hash, int *res)
+{
+	while (hash->entry != NULL && hash->entry->hash != hash->probe_hash)
+		hash->entry = hash->entry->next;
+	if (hash->entry != NULL) {
+		*res = 0;
+		return SQL_OK;
+	}
+	if (hash->spill == NULL) {
+		*res = 1;
+		return SQL_OK;
+	}
+	if (hash->spill_iter == NULL) {
+		char key[16];
+		char *key_end = mp_encode_uint(key, hash->probe_hash);
+		assert(key_end <= key + sizeof(key));
+		(void) key_end;
+		hash->spill_iter = index_create_iterator(hash->spill->index[0],
+							 ITER_EQ, key, 1);
+		if (hash->spill_iter == NULL)
+			return SQL_TARANTOOL_ITERATOR_FAIL;
+	}
+	struct tuple *tuple;
+	if (iterator_next(hash->spill_iter, &tuple) != 0)
+		return SQL_TARANTOOL_ITERATOR_FAIL;
+	if (hash->spill_tuple != NULL)
+		tuple_unref(hash->spill_tuple);
+	hash->spill_tuple = tuple;
+	if (tuple == NULL) {
+		*res = 1;
+		return SQL_OK;
+	}
+	tuple_ref(tuple);
+	*res = 0;
+	return SQL_OK;
+}
+
+int
+sqlVdbeHashProbe(const struct VdbeCursor *cursor, struct Mem *key, int *res)
+{
+	assert(cursor->eCurType == CURTYPE_HASH);
+	struct VdbeHash *hash = cursor->uc.pHash;
+	hash_join_spill_reset(hash);
+	if (!hash_join_key_hash(key, &hash->probe_hash)) {
+		hash->entry = NULL;
+		*res = 1;
+		return SQL_OK;
+	}
+	hash->entry =
+		hash->buckets[hash->probe_hash & (hash->bucket_count - 1)];
+	return hash_join_seek(hash, res);
+}
+
+int
+sqlVdbeHashNext(const struct VdbeCursor *cursor, int *res)
+{
+	assert(cursor->eCurType == CURTYPE_HASH);
+	struct VdbeHash *hash = cursor->uc.pHash;
+	if (hash->entry != NULL)
+		hash->entry = hash->entry->next;
+	return hash_join_seek(hash, res);
+}
+
+const char *
+sqlVdbeHashRow(const struct VdbeCursor *cursor, uint32_t *size)
+{
+	assert(cursor->eCurType == CURTYPE_HASH);
+	struct VdbeHash *hash = cursor->uc.pHash;
+	if (hash->entry != NULL) {
+		*size = hash->entry->size;
+		return hash->entry->data;
+	}
+	assert(hash->spill_tuple != NULL);
+	const char *field = tuple_field(hash->spill_tuple, 2);
+	assert(field != NULL && mp_typeof(*field) == MP_BIN);
+	return mp_decode_bin(&field, size);
+}
+
+struct BtCursor *
+sqlVdbeHashSource(const struct VdbeCursor *cursor)
+{
+	assert(cursor->eCurType == CURTYPE_HASH);
+	return cursor->uc.pHash->source;
+}
@@ -120,8 +120,8 @@
  *
  * The sorter is running in multi-threaded mode if (a) the library was built
  * with pre-processor symbol SQL_MAX_WORKER_THREADS set to a value greater
- * than zero, and (b) worker threads have been enabled at runtime by calling
- * "PRAGMA threads=N" with some value of N greater than 0.
+ * than zero, and (b) worker threads have been enabled at runtime by setting
+ * box.cfg.sql_sorter_threads to some value of N greater than 0.
  *
  * When Rewind() is called, any data remaining in memory is flushed to a
  * final PMA. So at this point the data is stored in some number of sorted
@@ -158,6 +158,7 @@
  */
 #include "sqlInt.h"
 #include "vdbeInt.h"
+#include "fiber.h"
 
 /*
  * If SQL_DEBUG_SORTER_THREADS is defined, this module outputs various
@@ -286,7 +287,7 @@ struct MergeEngine {
  * Exactly VdbeSorter.nTask instances of this object are allocated
  * as part of each VdbeSorter object. Instances are never allocated any
  * other way. VdbeSorter.nTask is set to the number of worker threads allowed
- * (see SQL_CONFIG_WORKER_THREADS) plus one (the main thread).  Thus for
+ * (see box.cfg.sql_sorter_threads) plus one (the main thread).  Thus for
  * single-threaded operation, there is exactly one instance of this object
  * and for multi-threaded operation there are two or more instances.
  *
@@ -343,6 +344,7 @@ struct VdbeSorter {
 	PmaReader *pReader;	/* Readr data from here after Rewind() */
 	MergeEngine *pMerger;	/* Or here, if bUseThreads==0 */
 	sql *db;		/* Database connection */
+	Vdbe *pVdbe;		/* Statement the sorter is used by */
 	struct key_def *key_def;
 	UnpackedRecord *pUnpacked;	/* Used by VdbeSorterCompare() */
 	SorterList list;	/* List of in-memory records */
@@ -350,6 +352,7 @@ struct VdbeSorter {
 	int nMemory;		/* Size of list.aMemory allocation in bytes */
 	u8 bUsePMA;		/* True if one or more PMAs created */
 	u8 bUseThreads;		/* True to use background threads */
+	u8 bMayYield;		/* True to yield while joining threads */
 	u8 iPrev;		/* Previous thread used to flush PMA */
 	u8 nTask;		/* Size of aTask[] array */
 	u8 typeMask;
@@ -848,6 +851,7 @@ vdbeSorterCompare(struct SortSubtask *task, bool *key2_cached,
  */
 int
 sqlVdbeSorterInit(sql * db,	/* Database connection (for malloc()) */
+		      Vdbe * pVdbe,	/* Statement the sorter is used by */
 		      VdbeCursor * pCsr	/* Cursor that holds the new sorter */
     )
 {
@@ -875,10 +879,22 @@ sqlVdbeSorterInit(sql * db,	/* Database connection (for malloc()) */
 	}
 #endif
 
+#if SQL_MAX_WORKER_THREADS>0
+	/*
+	 * Waiting for a worker blocks the tx thread unless the
+	 * statement yields. If it can't, e.g. the sorter is fed
+	 * by a memtx scan of an enclosing loop, sort in the tx
+	 * thread without workers.
+	 */
+	if (nWorker > 0 && !sql_vdbe_may_yield(pVdbe))
+		nWorker = 0;
+#endif
+
 	assert(pCsr->key_def != NULL);
 	assert(pCsr->eCurType == CURTYPE_SORTER);
 
-	pSorter = (VdbeSorter *) sqlDbMallocZero(db, sizeof(VdbeSorter));
+	pSorter = (VdbeSorter *) sqlDbMallocZero(db, sizeof(VdbeSorter) +
+						 nWorker * sizeof(SortSubtask));
 	pCsr->uc.pSorter = pSorter;
 	if (pSorter == 0) {
 		rc = SQL_NOMEM;
@@ -889,6 +905,7 @@ sqlVdbeSorterInit(sql * db,	/* Database connection (for malloc()) */
 		pSorter->iPrev = (u8) (nWorker - 1);
 		pSorter->bUseThreads = (pSorter->nTask > 1);
 		pSorter->db = db;
+		pSorter->pVdbe = pVdbe;
 		for (i = 0; i < pSorter->nTask; i++) {
 			SortSubtask *pTask = &pSorter->aTask[i];
 			pTask->pSorter = pSorter;
@@ -1018,6 +1035,24 @@ vdbeSorterBlockDebug(SortSubtask * pTask, int bBlocked, const char *zEvent)
 #endif
 
 #if SQL_MAX_WORKER_THREADS>0
+/*
+ * Return true if the main thread may yield while it waits for a
+ * worker of the sorter. Until the sorter is rewound its source
+ * scans may be in progress, and the only joins are the ones of
+ * finished workers, which don't block. After that the sorter
+ * holds copies of all its records, so the memtx cursors, whose
+ * scans are over, are released before every yield.
+ */
+static bool
+vdbeSorterMayYield(VdbeSorter * pSorter)
+{
+	/* Workers join their own nested workers. */
+	if (!pSorter->bMayYield || !cord_is_main())
+		return false;
+	sql_vdbe_release_memtx(pSorter->pVdbe);
+	return true;
+}
+
 /*
  * Join thread pTask->thread.
  */
@@ -1031,7 +1066,8 @@ vdbeSorterJoinThread(SortSubtask * pTask)
 #endif
 		void *pRet = SQL_INT_TO_PTR(SQL_ERROR);
 		vdbeSorterBlockDebug(pTask, !bDone, "enter");
-		(void)sqlThreadJoin(pTask->pThread, &pRet);
+		(void)sqlThreadJoin(pTask->pThread,
+				    vdbeSorterMayYield(pTask->pSorter), &pRet);
 		vdbeSorterBlockDebug(pTask, !bDone, "exit");
 		rc = SQL_PTR_TO_INT(pRet);
 		assert(pTask->bDone == 1);
@@ -1161,6 +1197,7 @@ sqlVdbeSorterReset(sql * db, VdbeSorter * pSorter)
 {
 	int i;
 	(void)vdbeSorterJoinAll(pSorter, SQL_OK);
+	pSorter->bMayYield = 0;
 	assert(pSorter->bUseThreads || pSorter->pReader == 0);
 #if SQL_MAX_WORKER_THREADS>0
 	if (pSorter->pReader) {
@@ -1269,9 +1306,14 @@ static int
 vdbeSortAllocUnpacked(SortSubtask * pTask)
 {
 	if (pTask->pUnpacked == 0) {
+		/*
+		 * Lookaside memory of the connection may be used
+		 * by the main thread only.
+		 */
+		struct sql *db = pTask->pSorter->bUseThreads ?
+				 NULL : pTask->pSorter->db;
 		pTask->pUnpacked =
-			sqlVdbeAllocUnpackedRecord(pTask->pSorter->db,
-						       pTask->pSorter->key_def);
+			sqlVdbeAllocUnpackedRecord(db, pTask->pSorter->key_def);
 		if (pTask->pUnpacked == 0)
 			return SQL_NOMEM;
 		pTask->pUnpacked->nField = pTask->pSorter->key_def->part_count;
@@ -2673,6 +2715,7 @@ sqlVdbeSorterRewind(const VdbeCursor * pCsr, int *pbEof)
 	 * So the list is never empty at this point.
 	 */
 	assert(pSorter->list.pList);
+	pSorter->bMayYield = pSorter->bUseThreads;
 	rc = vdbeSorterFlushPMA(pSorter);
 
 	/* Join all threads */
@@ -684,6 +684,97 @@ translateColumnToCopy(Vdbe * v,		/* The VDBE containing code to translate */
 	}
 }
 
+/*
+ * Return the class of values of type @a type as a hash join key.
+ * Keys of different classes never compare equal without a type
+ * conversion, which a hash lookup can't do. Zero means values of
+ * this type can't be used as a hash join key at all.
+ */
+static int
+hash_join_key_class(enum field_type type)
+{
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_NUMBER:
+		return 1;
+	case FIELD_TYPE_STRING:
+		return 2;
+	case FIELD_TYPE_BOOLEAN:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Return true if the WHERE clause term pTerm is an equality which
+ * can be used to probe a hash table built from the rows of pSrc.
+ * The other side of the term must depend on other tables only,
+ * both sides must hash alike and compare using the binary
+ * collation.
+ */
+static bool
+termCanDriveHashJoin(Parse * pParse,		/* Parsing context */
+		     WhereTerm * pTerm,		/* WHERE clause term to check */
+		     struct SrcList_item *pSrc,	/* Table to build the hash from */
+		     Bitmask mSelf)		/* Mask of pSrc */
+{
+	if (pTerm->leftCursor != pSrc->iCursor)
+		return false;
+	if ((pTerm->eOperator & WO_EQ) == 0)
+		return false;
+	if (pTerm->u.leftColumn < 0)
+		return false;
+	if (pTerm->prereqRight == 0 || (pTerm->prereqRight & mSelf) != 0)
+		return false;
+	Expr *pLeft = pTerm->pExpr->pLeft;
+	Expr *pRight = pTerm->pExpr->pRight;
+	enum field_type type =
+		pSrc->space->def->fields[pTerm->u.leftColumn].type;
+	int key_class = hash_join_key_class(type);
+	if (key_class == 0 ||
+	    key_class != hash_join_key_class(sql_expr_type(pRight)))
+		return false;
+	uint32_t coll_id;
+	if (sql_binary_compare_coll_seq(pParse, pLeft, pRight, &coll_id) != 0)
+		return false;
+	return coll_id == COLL_NONE;
+}
+
+/*
+ * Generate code to fill the hash table of a hash join level with
+ * all rows of its table. The table is built once, before the
+ * first probe, and rows are then read from it via the cursor
+ * pLevel->iIdxCur.
+ */
+static void
+whereHashJoinBuild(Parse * pParse,		/* The parsing context */
+		   struct SrcList_item *pSrc,	/* The FROM clause term to hash */
+		   WhereLevel * pLevel)		/* The hash join level */
+{
+	Vdbe *v = pParse->pVdbe;
+	WhereTerm *pTerm = pLevel->pWLoop->aLTerm[0];
+	assert((pLevel->pWLoop->wsFlags & WHERE_HASH_JOIN) != 0);
+	int addrInit = sqlVdbeAddOp0(v, OP_Once);
+	VdbeCoverage(v);
+	pLevel->iIdxCur = pParse->nTab++;
+	sqlVdbeAddOp3(v, OP_HashOpen, pLevel->iIdxCur,
+		      pSrc->space->def->field_count, pLevel->iTabCur);
+	VdbeComment((v, "hash table for %s", pSrc->space->def->name));
+	int regKey = sqlGetTempReg(pParse);
+	int addrTop = sqlVdbeAddOp1(v, OP_Rewind, pLevel->iTabCur);
+	VdbeCoverage(v);
+	sqlVdbeAddOp3(v, OP_Column, pLevel->iTabCur, pTerm->u.leftColumn,
+		      regKey);
+	sqlVdbeAddOp2(v, OP_HashInsert, pLevel->iIdxCur, regKey);
+	sqlVdbeAddOp2(v, OP_Next, pLevel->iTabCur, addrTop + 1);
+	VdbeCoverage(v);
+	sqlVdbeJumpHere(v, addrTop);
+	sqlReleaseTempReg(pParse, regKey);
+	sqlVdbeJumpHere(v, addrInit);
+}
+
 #ifndef SQL_OMIT_AUTOMATIC_INDEX
 /*
  * Return TRUE if the WHERE clause term pTerm is of a form where it
@@ -1320,10 +1411,11 @@ whereRangeScanEst(Parse * pParse,	/* Parsing & code generating context */
 	assert(space != NULL);
 	struct index *idx = space_index(space, p->iid);
 	assert(idx != NULL);
-	struct index_stat *stat = idx->def->opts.stat;
+	struct index_stat *stat = sql_index_stat(idx);
 	/*
 	 * Create surrogate stat in case ANALYZE command hasn't
-	 * been ran. Simply fill it with zeros.
+	 * been ran or its results are stale. Simply fill it with
+	 * zeros.
 	 */
 	struct index_stat surrogate_stat;
 	memset(&surrogate_stat, 0, sizeof(surrogate_stat));
@@ -1966,9 +2058,10 @@ whereLoopFindLesser(WhereLoop ** ppPrev, const WhereLoop * pTemplate)
 
 		/* Any loop using an appliation-defined index (or PRIMARY KEY or
 		 * UNIQUE constraint) with one or more == constraints is better
-		 * than an automatic index. Unless it is a skip-scan.
+		 * than an automatic index or a hash join. Unless it is a
+		 * skip-scan.
 		 */
-		if ((p->wsFlags & WHERE_AUTO_INDEX) != 0
+		if ((p->wsFlags & (WHERE_AUTO_INDEX | WHERE_HASH_JOIN)) != 0
 		    && (pTemplate->nSkip) == 0
 		    && (pTemplate->wsFlags & WHERE_INDEXED) != 0
 		    && (pTemplate->wsFlags & WHERE_COLUMN_EQ) != 0
@@ -2344,11 +2437,12 @@ whereLoopAddBtreeIndex(WhereLoopBuilder * pBuilder,	/* The WhereLoop factory */
 	if (space != NULL && probe->iid != UINT32_MAX) {
 		struct index *idx = space_index(space, probe->iid);
 		assert(idx != NULL);
-		stat = idx->def->opts.stat;
+		stat = sql_index_stat(idx);
 	}
 	/*
 	 * Create surrogate stat in case ANALYZE command hasn't
-	 * been ran. Simply fill it with zeros.
+	 * been ran or its results are stale. Simply fill it with
+	 * zeros.
 	 */
 	struct index_stat surrogate_stat;
 	memset(&surrogate_stat, 0, sizeof(surrogate_stat));
@@ -2677,6 +2771,27 @@ whereLoopAddBtreeIndex(WhereLoopBuilder * pBuilder,	/* The WhereLoop factory */
 	return rc;
 }
 
+/**
+ * Check whether ANALYZE found that the index does not deliver
+ * tuples in key order, so it can't be used for ORDER BY or range
+ * scans. Stale statistics are ignored the same way as in the
+ * cost estimates.
+ *
+ * @param idx_def Definition of the index to check.
+ * @retval True if the index is known to be unordered.
+ */
+static bool
+index_is_unordered(const struct index_def *idx_def)
+{
+	struct space *space = space_by_id(idx_def->space_id);
+	if (space == NULL || idx_def->iid == UINT32_MAX)
+		return false;
+	struct index *idx = space_index(space, idx_def->iid);
+	assert(idx != NULL);
+	struct index_stat *stat = sql_index_stat(idx);
+	return stat != NULL && stat->is_unordered;
+}
+
 /*
  * Return True if it is possible that pIndex might be useful in
  * implementing the ORDER BY clause in pBuilder.
@@ -2692,7 +2807,7 @@ indexMightHelpWithOrderBy(WhereLoopBuilder * pBuilder,
 	ExprList *pOB;
 	int ii, jj;
 	int part_count = idx_def->key_def->part_count;
-	if (idx_def->opts.stat != NULL && idx_def->opts.stat->is_unordered)
+	if (index_is_unordered(idx_def))
 		return 0;
 	if ((pOB = pBuilder->pWInfo->pOrderBy) == 0)
 		return 0;
@@ -2883,6 +2998,55 @@ tnt_error:
 		}
 	}
 #endif				/* SQL_OMIT_AUTOMATIC_INDEX */
+	/* Hash joins */
+	if (!pBuilder->pOrSet	/* Not part of an OR optimization */
+	    && (pWInfo->wctrlFlags &
+		(WHERE_OR_SUBCLAUSE | WHERE_ONEPASS_DESIRED)) == 0
+	    && pSrc->pIBIndex == NULL	/* Has no INDEXED BY clause */
+	    && !pSrc->fg.notIndexed	/* Has no NOT INDEXED clause */
+	    && !pSrc->fg.isCorrelated	/* Not a correlated subquery */
+	    && !pSrc->fg.isRecursive	/* Not a recursive common table expression. */
+	    && !pSrc->fg.viaCoroutine	/* Can be scanned more than once */
+	    && space->def->id != 0	/* Has a row count estimate */
+	    && !space->def->opts.is_view	/* Not a view */
+	    && (pSrc->fg.jointype & JT_LEFT) == 0) {
+		/* Generate hash join WhereLoops */
+		LogEst rSize = sql_space_tuple_log_count(space);
+		WhereTerm *pTerm;
+		WhereTerm *pWCEnd = pWC->a + pWC->nTerm;
+		for (pTerm = pWC->a; rc == SQL_OK && pTerm < pWCEnd; pTerm++) {
+			if (!termCanDriveHashJoin(pWInfo->pParse, pTerm, pSrc,
+						  pNew->maskSelf))
+				continue;
+			pNew->nEq = 1;
+			pNew->nBtm = 0;
+			pNew->nTop = 0;
+			pNew->nSkip = 0;
+			pNew->nLTerm = 1;
+			pNew->aLTerm[0] = pTerm;
+			pNew->iSortIdx = 0;
+			pNew->index_def = NULL;
+			/* TUNING: One-time cost of building the hash table
+			 * is a full scan of the table (N*3.0) plus hashing
+			 * and copying of every row, estimated as X*N where
+			 * X is 7 (LogEst=28), as for automatic indexes.
+			 */
+			pNew->rSetup = rSize + 16 + 28;
+			/* TUNING: Each probe yields a quarter of the table,
+			 * but no more than 20 rows, the same guess as for
+			 * automatic indexes. A probe costs a constant 2
+			 * (LogEst=10) on top of visiting the rows.
+			 */
+			pNew->nOut = MIN(rSize - 20, 43);
+			assert(43 == sqlLogEst(20));
+			if (pNew->nOut < 0)
+				pNew->nOut = 0;
+			pNew->rRun = sqlLogEstAdd(10, pNew->nOut);
+			pNew->wsFlags = WHERE_HASH_JOIN;
+			pNew->prereq = mPrereq | pTerm->prereqRight;
+			rc = whereLoopInsert(pBuilder, pNew);
+		}
+	}
 	/*
 	 * If there was an INDEXED BY clause, then only that one
 	 * index is considered.
@@ -3279,8 +3443,7 @@ wherePathSatisfiesOrderBy(WhereInfo * pWInfo,	/* The WHERE clause */
 				idx_def = NULL;
 				nColumn = 1;
 			} else if ((idx_def = pLoop->index_def) == NULL ||
-				   (idx_def->opts.stat != NULL &&
-				    idx_def->opts.stat->is_unordered)) {
+				   index_is_unordered(idx_def)) {
 				return 0;
 			} else {
 				nColumn = idx_def->key_def->part_count;
@@ -3686,10 +3849,12 @@ wherePathSolver(WhereInfo * pWInfo, LogEst nRowEst)
 					continue;
 				if ((pWLoop->maskSelf & pFrom->maskLoop) != 0)
 					continue;
-				if ((pWLoop->wsFlags & WHERE_AUTO_INDEX) != 0
+				if ((pWLoop->wsFlags &
+				     (WHERE_AUTO_INDEX | WHERE_HASH_JOIN)) != 0
 				    && pFrom->nRow < 10) {
-					/* Do not use an automatic index if the this loop is expected
-					 * to run less than 2 times.
+					/* Do not use an automatic index or a hash join
+					 * if the this loop is expected to run less
+					 * than 2 times.
 					 */
 					assert(10 == sqlLogEst(2));
 					continue;
@@ -4691,6 +4856,10 @@ sqlWhereBegin(Parse * pParse,	/* The parser context */
 				goto whereBeginError;
 		}
 #endif
+		if ((pLevel->pWLoop->wsFlags & WHERE_HASH_JOIN) != 0) {
+			whereHashJoinBuild(pParse, &pTabList->a[pLevel->iFrom],
+					   pLevel);
+		}
 		addrExplain =
 		    sqlWhereExplainOneScan(pParse, pTabList, pLevel, ii,
 					       pLevel->iFrom, wctrlFlags);
@@ -4828,6 +4997,23 @@ sqlWhereEnd(WhereInfo * pWInfo)
 			continue;
 		}
 
+		/* A hash join level reads rows from its hash table
+		 * rather than from the table cursor, which has been
+		 * exhausted building that hash table.
+		 */
+		if ((pLoop->wsFlags & WHERE_HASH_JOIN) != 0 &&
+		    !db->mallocFailed) {
+			last = sqlVdbeCurrentAddr(v);
+			k = pLevel->addrBody;
+			pOp = sqlVdbeGetOp(v, k);
+			for (; k < last; k++, pOp++) {
+				if (pOp->p1 == pLevel->iTabCur &&
+				    pOp->opcode == OP_Column)
+					pOp->p1 = pLevel->iIdxCur;
+			}
+			continue;
+		}
+
 		/* If this scan uses an index, make VDBE code substitutions to read data
 		 * from the index instead of from the table where possible.  In some cases
 		 * this optimization prevents the table from ever being read, which can
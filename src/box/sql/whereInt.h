@@ -79,7 +79,7 @@ typedef struct WhereOrSet WhereOrSet;
 struct WhereLevel {
 	int iLeftJoin;		/* Memory cell used to implement LEFT OUTER JOIN */
 	int iTabCur;		/* The VDBE cursor used to access the table */
-	int iIdxCur;		/* The VDBE cursor used to access pIdx */
+	int iIdxCur;		/* The VDBE cursor used to access pIdx or hash table */
 	int addrBrk;		/* Jump here to break out of the loop */
 	int addrNxt;		/* Jump here to start the next IN combination */
 	int addrSkip;		/* Jump here for next iteration of skip-scan */
@@ -533,3 +533,4 @@ void sqlWhereTabFuncArgs(Parse *, struct SrcList_item *, WhereClause *);
 #define WHERE_AUTO_INDEX   0x00004000	/* Uses an ephemeral index */
 #define WHERE_SKIPSCAN     0x00008000	/* Uses the skip-scan algorithm */
 #define WHERE_UNQ_WANTED   0x00010000	/* WHERE_ONEROW would have been helpful */
+#define WHERE_HASH_JOIN    0x00020000	/* Probes a hash table of the rows */
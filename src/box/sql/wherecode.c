@@ -38,6 +38,7 @@
  * that actually generate the bulk of the WHERE loop code.  The original where.c
  * file retains the code that does query planning and analysis.
  */
+#include "box/coll_id.h"
 #include "box/schema.h"
 #include "sqlInt.h"
 #include "whereInt.h"
@@ -158,7 +159,8 @@ explainIndexRange(StrAccum * pStr, WhereLoop * pLoop)
 
 /*
  * This function is a no-op unless currently processing an EXPLAIN QUERY PLAN
- * command, or if either SQL_DEBUG or SQL_ENABLE_STMT_SCANSTATUS was
+ * or EXPLAIN ANALYZE command, or if either SQL_DEBUG or
+ * SQL_ENABLE_STMT_SCANSTATUS was
  * defined at compile-time. If it is not a no-op, a single OP_Explain opcode
  * is added to the output to describe the table scan strategy in pLevel.
  *
@@ -175,7 +177,7 @@ sqlWhereExplainOneScan(Parse * pParse,	/* Parse context */
 {
 	int ret = 0;
 #if !defined(SQL_DEBUG) && !defined(SQL_ENABLE_STMT_SCANSTATUS)
-	if (pParse->explain == 2)
+	if (pParse->explain == 2 || pParse->explain == 3)
 #endif
 	{
 		struct SrcList_item *pItem = &pTabList->a[pLevel->iFrom];
@@ -211,7 +213,11 @@ sqlWhereExplainOneScan(Parse * pParse,	/* Parse context */
 		if (pItem->zAlias) {
 			sqlXPrintf(&str, " AS %s", pItem->zAlias);
 		}
-		if ((flags & WHERE_IPK) == 0) {
+		if ((flags & WHERE_HASH_JOIN) != 0) {
+			int iCol = pLoop->aLTerm[0]->u.leftColumn;
+			sqlXPrintf(&str, " USING HASH TABLE (%s=?)",
+				   pItem->space->def->fields[iCol].name);
+		} else if ((flags & WHERE_IPK) == 0) {
 			const char *zFmt = 0;
 			struct index_def *idx_def = pLoop->index_def;
 			if (idx_def == NULL)
@@ -818,6 +824,181 @@ codeExprOrVector(Parse * pParse, Expr * p, int iReg, int nReg)
 	}
 }
 
+/**
+ * Check if the expression is a column of the space opened by
+ * the cursor which a cursor filter can compare with a literal
+ * of the given kind.
+ */
+static bool
+cursor_filter_is_column(struct Expr *expr, int cursor, struct space_def *def,
+			enum cursor_filter_kind kind)
+{
+	if (expr->op != TK_COLUMN || expr->iTable != cursor ||
+	    expr->iColumn < 0 || (uint32_t) expr->iColumn >= def->field_count)
+		return false;
+	struct field_def *field = &def->fields[expr->iColumn];
+	if (kind == CURSOR_FILTER_STR)
+		return field->type == FIELD_TYPE_STRING &&
+		       field->coll_id == COLL_NONE;
+	return field->type == FIELD_TYPE_INTEGER ||
+	       field->type == FIELD_TYPE_UNSIGNED ||
+	       field->type == FIELD_TYPE_NUMBER;
+}
+
+/**
+ * Check if the expression is a possibly negated number or a
+ * string and store its kind and value to the filter term. The
+ * string is not copied.
+ */
+static bool
+cursor_filter_literal(struct Expr *expr, struct cursor_filter_term *term)
+{
+	bool is_neg = false;
+	if (expr->op == TK_UMINUS) {
+		is_neg = true;
+		expr = expr->pLeft;
+	}
+	switch (expr->op) {
+	case TK_INTEGER: {
+		int64_t value;
+		if ((expr->flags & EP_IntValue) != 0)
+			value = expr->u.iValue;
+		else if (sql_dec_or_hex_to_i64(expr->u.zToken, &value) != 0)
+			return false;
+		term->kind = CURSOR_FILTER_INT;
+		term->value.i = is_neg ? -value : value;
+		return true;
+	}
+	case TK_FLOAT: {
+		double value;
+		const char *z = expr->u.zToken;
+		if (sqlAtoF(z, &value, sqlStrlen30(z)) == 0)
+			return false;
+		term->kind = CURSOR_FILTER_REAL;
+		term->value.r = is_neg ? -value : value;
+		return true;
+	}
+	case TK_STRING:
+		if (is_neg)
+			return false;
+		term->kind = CURSOR_FILTER_STR;
+		term->value.str.data = expr->u.zToken;
+		term->value.str.len = strlen(expr->u.zToken);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Check if the WHERE term is a comparison of a column with a
+ * literal a cursor filter can evaluate and fill the filter
+ * term describing it.
+ */
+static bool
+cursor_filter_term(struct WhereTerm *where_term, int cursor,
+		   struct space_def *def, struct cursor_filter_term *term)
+{
+	if ((where_term->wtFlags & (TERM_VIRTUAL | TERM_CODED)) != 0)
+		return false;
+	struct Expr *expr = where_term->pExpr;
+	if (ExprHasProperty(expr, EP_FromJoin))
+		return false;
+	/* Operators for the column on the left and on the right. */
+	enum cursor_filter_op op, commuted_op;
+	switch (expr->op) {
+	case TK_EQ:
+		op = commuted_op = CURSOR_FILTER_EQ;
+		break;
+	case TK_NE:
+		op = commuted_op = CURSOR_FILTER_NE;
+		break;
+	case TK_LT:
+		op = CURSOR_FILTER_LT;
+		commuted_op = CURSOR_FILTER_GT;
+		break;
+	case TK_LE:
+		op = CURSOR_FILTER_LE;
+		commuted_op = CURSOR_FILTER_GE;
+		break;
+	case TK_GT:
+		op = CURSOR_FILTER_GT;
+		commuted_op = CURSOR_FILTER_LT;
+		break;
+	case TK_GE:
+		op = CURSOR_FILTER_GE;
+		commuted_op = CURSOR_FILTER_LE;
+		break;
+	default:
+		return false;
+	}
+	struct Expr *column = expr->pLeft;
+	struct Expr *value = expr->pRight;
+	if (column->op != TK_COLUMN) {
+		SWAP(column, value);
+		op = commuted_op;
+	}
+	if (!cursor_filter_literal(value, term) ||
+	    !cursor_filter_is_column(column, cursor, def, term->kind))
+		return false;
+	term->fieldno = column->iColumn;
+	term->op = op;
+	return true;
+}
+
+/**
+ * Emit OP_CursorFilter before a full scan of a space, if some
+ * terms of the WHERE clause compare its columns with literals.
+ * Tuples which don't satisfy them are skipped by the cursor
+ * without running the VDBE code of the loop. The terms are
+ * coded as usual, so they are still checked for the tuples
+ * passed by the filter.
+ */
+static void
+vdbe_emit_cursor_filter(struct Parse *parse, struct WhereClause *wc,
+			struct WhereLevel *level, struct SrcList_item *src)
+{
+	struct space *space = src->space;
+	if (level->iLeftJoin != 0 || src->pSelect != NULL || space == NULL ||
+	    space->def->opts.is_view)
+		return;
+	struct space_def *def = space->def;
+	int cursor = src->iCursor;
+	uint32_t term_count = 0;
+	size_t str_size = 0;
+	struct cursor_filter_term term;
+	for (int i = 0; i < wc->nTerm; i++) {
+		if (!cursor_filter_term(&wc->a[i], cursor, def, &term))
+			continue;
+		term_count++;
+		if (term.kind == CURSOR_FILTER_STR)
+			str_size += term.value.str.len;
+	}
+	if (term_count == 0)
+		return;
+	size_t size = sizeof(struct cursor_filter) +
+		      term_count * sizeof(struct cursor_filter_term) + str_size;
+	struct cursor_filter *filter = sqlDbMallocZero(parse->db, size);
+	if (filter == NULL)
+		return;
+	filter->terms = (struct cursor_filter_term *) &filter[1];
+	char *str = (char *) &filter->terms[term_count];
+	for (int i = 0; i < wc->nTerm; i++) {
+		struct cursor_filter_term *t = &filter->terms[filter->term_count];
+		if (!cursor_filter_term(&wc->a[i], cursor, def, t))
+			continue;
+		filter->term_count++;
+		if (t->kind != CURSOR_FILTER_STR)
+			continue;
+		memcpy(str, t->value.str.data, t->value.str.len);
+		t->value.str.data = str;
+		str += t->value.str.len;
+	}
+	assert(filter->term_count == term_count);
+	sqlVdbeAddOp4(parse->pVdbe, OP_CursorFilter, cursor, 0, 0,
+		      (char *) filter, P4_CURSORFILTER);
+}
+
 /*
  * Generate code for the start of the iLevel-th loop in the WHERE clause
  * implementation described by pWInfo.
@@ -891,6 +1072,26 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 		VdbeCoverage(v);
 		VdbeComment((v, "next row of \"%s\"", pTabItem->space->def->name));
 		pLevel->op = OP_Goto;
+	} else if ((pLoop->wsFlags & WHERE_HASH_JOIN) != 0) {
+		/* Case 3: A hash join.
+		 *
+		 *         The table has been loaded into a hash table
+		 *         keyed by the column of an == term. Probe it
+		 *         with the other side of the term. The term is
+		 *         not disabled, since it has to filter out rows
+		 *         whose keys merely share the hash with the
+		 *         probe key.
+		 */
+		pTerm = pLoop->aLTerm[0];
+		assert(pTerm != NULL && (pTerm->eOperator & WO_EQ) != 0);
+		int iReg = sqlGetTempReg(pParse);
+		int r1 = sqlExprCodeTarget(pParse, pTerm->pExpr->pRight, iReg);
+		sqlVdbeAddOp3(v, OP_HashProbe, pLevel->iIdxCur, addrBrk, r1);
+		VdbeCoverage(v);
+		sqlReleaseTempReg(pParse, iReg);
+		pLevel->op = OP_HashNext;
+		pLevel->p1 = pLevel->iIdxCur;
+		pLevel->p2 = sqlVdbeCurrentAddr(v);
 	} else if (pLoop->wsFlags & WHERE_INDEXED) {
 		/* Case 4: A scan using an index.
 		 *
@@ -1569,11 +1770,25 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 		} else {
 			pLevel->op = aStep[bRev];
 			pLevel->p1 = iCur;
+			vdbe_emit_cursor_filter(pParse, pWC, pLevel, pTabItem);
 			pLevel->p2 =
 			    1 + sqlVdbeAddOp2(v, aStart[bRev], iCur,
 						  addrBrk);
 			VdbeCoverageIf(v, bRev == 0);
 			VdbeCoverageIf(v, bRev != 0);
+			/*
+			 * Only the outermost loop of the
+			 * top-level SELECT is started once per
+			 * statement, and the caller passes
+			 * WHERE_PARALLEL_SCAN only for it. The
+			 * loops of subqueries, OR-subclauses and
+			 * triggers may be restarted for every
+			 * outer row. Whether the scan is actually
+			 * split is decided at runtime.
+			 */
+			if (bRev == 0 && iLevel == 0 &&
+			    (pWInfo->wctrlFlags & WHERE_PARALLEL_SCAN) != 0)
+				sqlVdbeChangeP5(v, OPFLAG_PARALLEL);
 			pLevel->p5 = SQL_STMTSTATUS_FULLSCAN_STEP;
 		}
 	}
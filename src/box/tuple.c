@@ -38,6 +38,7 @@
 
 #include "tuple_update.h"
 #include "coll_id_cache.h"
+#include "tuple_compression.h"
 
 static struct mempool tuple_iterator_pool;
 static struct small_alloc runtime_alloc;
@@ -93,6 +94,7 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 	}
 
 	tuple->refs = 0;
+	tuple->is_compact = false;
 	tuple->bsize = data_len;
 	tuple->format_id = tuple_format_id(format);
 	tuple_format_ref(format);
@@ -320,6 +322,9 @@ tuple_init(field_name_hash_f hash)
 	if (coll_id_cache_init() != 0)
 		return -1;
 
+	if (tuple_compression_init() != 0)
+		return -1;
+
 	return 0;
 }
 
@@ -373,6 +378,38 @@ tuple_free(void)
 	coll_id_cache_destroy();
 
 	bigref_list_destroy();
+
+	tuple_compression_free();
+}
+
+struct tuple *
+tuple_decompress(struct tuple *tuple)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	if (format->compressed_field_count == 0)
+		return tuple;
+	if (format->decompressed_format == NULL) {
+		struct tuple_format *decompressed_format =
+			tuple_format_new(&tuple_format_runtime_vtab, NULL,
+					 NULL, 0, NULL, 0, 0, format->dict,
+					 false, false);
+		if (decompressed_format == NULL)
+			return NULL;
+		tuple_format_ref(decompressed_format);
+		format->decompressed_format = decompressed_format;
+	}
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t size;
+	const char *data = tuple_data_range_decompressed(tuple, &size);
+	struct tuple *result = NULL;
+	if (data == tuple_data(tuple))
+		result = tuple;
+	else if (data != NULL)
+		result = runtime_tuple_new(format->decompressed_format,
+					   data, data + size);
+	region_truncate(region, region_svp);
+	return result;
 }
 
 /* {{{ tuple_field_* getters */
@@ -583,7 +620,7 @@ size_t
 box_tuple_bsize(box_tuple_t *tuple)
 {
 	assert(tuple != NULL);
-	return tuple->bsize;
+	return tuple_bsize(tuple);
 }
 
 ssize_t
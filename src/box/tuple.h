@@ -295,6 +295,13 @@ box_tuple_upsert(box_tuple_t *tuple, const char *expr, const char *expr_end);
  * +---------------------------------------data_offset
  *
  * Each 'off_i' is the offset to the i-th indexed field.
+ *
+ * A tuple without a field map and with data not longer than
+ * TUPLE_COMPACT_BSIZE_MAX may be stored in the compact form
+ * (see is_compact), which lacks bsize and data_offset: the
+ * length of the data is stored in place of data_offset and
+ * the data immediately follows it. Use tuple_bsize() and
+ * tuple_data_offset() to access these members.
  */
 struct PACKED tuple
 {
@@ -310,15 +317,30 @@ struct PACKED tuple
 	};
 	/** Format identifier. */
 	uint16_t format_id;
-	/**
-	 * Length of the MessagePack data in raw part of the
-	 * tuple.
-	 */
-	uint32_t bsize;
-	/**
-	 * Offset to the MessagePack from the begin of the tuple.
-	 */
-	uint16_t data_offset;
+	union {
+		struct PACKED {
+			/**
+			 * Offset to the MessagePack from the
+			 * begin of the tuple.
+			 */
+			uint16_t data_offset : 15;
+			/** Set if the tuple is compact. */
+			bool is_compact : 1;
+			/**
+			 * Length of the MessagePack data in raw
+			 * part of the tuple.
+			 */
+			uint32_t bsize;
+		};
+		struct PACKED {
+			/**
+			 * Length of the MessagePack data of
+			 * a compact tuple.
+			 */
+			uint16_t compact_bsize : 15;
+			bool : 1;
+		};
+	};
 	/**
 	 * Engine specific fields and offsets array concatenated
 	 * with MessagePack fields array.
@@ -326,12 +348,41 @@ struct PACKED tuple
 	 */
 };
 
+enum {
+	/** Size of the header of a compact tuple. */
+	TUPLE_COMPACT_HEADER_SIZE = offsetof(struct tuple, bsize),
+	/** Max length of the data of a compact tuple. */
+	TUPLE_COMPACT_BSIZE_MAX = INT16_MAX,
+};
+
+/**
+ * Get length of the MessagePack data of the tuple.
+ * @param tuple tuple.
+ * @return Size in bytes of the MessagePack array.
+ */
+static inline uint32_t
+tuple_bsize(struct tuple *tuple)
+{
+	return tuple->is_compact ? tuple->compact_bsize : tuple->bsize;
+}
+
+/**
+ * Get offset to the MessagePack data from the begin of the
+ * tuple, including the tuple header and the field map.
+ */
+static inline uint16_t
+tuple_data_offset(struct tuple *tuple)
+{
+	return tuple->is_compact ? TUPLE_COMPACT_HEADER_SIZE :
+				   tuple->data_offset;
+}
+
 /** Size of the tuple including size of struct tuple. */
 static inline size_t
 tuple_size(struct tuple *tuple)
 {
 	/* data_offset includes sizeof(struct tuple). */
-	return tuple->data_offset + tuple->bsize;
+	return tuple_data_offset(tuple) + tuple_bsize(tuple);
 }
 
 /**
@@ -342,7 +393,7 @@ tuple_size(struct tuple *tuple)
 static inline const char *
 tuple_data(struct tuple *tuple)
 {
-	return (const char *) tuple + tuple->data_offset;
+	return (const char *) tuple + tuple_data_offset(tuple);
 }
 
 /**
@@ -363,8 +414,8 @@ tuple_data_or_null(struct tuple *tuple)
 static inline const char *
 tuple_data_range(struct tuple *tuple, uint32_t *p_size)
 {
-	*p_size = tuple->bsize;
-	return (const char *) tuple + tuple->data_offset;
+	*p_size = tuple_bsize(tuple);
+	return tuple_data(tuple);
 }
 
 /**
@@ -474,6 +525,18 @@ tuple_validate(struct tuple_format *format, struct tuple *tuple)
 	return tuple_validate_raw(format, tuple_data(tuple));
 }
 
+/**
+ * Get a tuple that can be passed to the user: if the tuple
+ * format has compressed fields, create a runtime tuple with
+ * their values decompressed, otherwise return the tuple itself.
+ *
+ * @param tuple Tuple to decompress.
+ * @retval Tuple with all fields decompressed.
+ * @retval NULL on error, diag is set.
+ */
+struct tuple *
+tuple_decompress(struct tuple *tuple);
+
 /*
  * Return a field map for the tuple.
  * @param tuple tuple
@@ -483,7 +546,7 @@ tuple_validate(struct tuple_format *format, struct tuple *tuple)
 static inline const uint32_t *
 tuple_field_map(struct tuple *tuple)
 {
-	return (const uint32_t *) ((const char *) tuple + tuple->data_offset);
+	return (const uint32_t *) tuple_data(tuple);
 }
 
 /**
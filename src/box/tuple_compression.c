@@ -0,0 +1,344 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "tuple_compression.h"
+
+#include <string.h>
+#include <msgpuck.h>
+#include <zstd.h>
+#include "diag.h"
+#include "error.h"
+#include "fiber.h"
+#include "tt_pthread.h"
+
+enum {
+	/** ext 32 marker, 32-bit length and type. */
+	MP_COMPRESSION_HEADER_SIZE = 6,
+	/** zstd compression level. */
+	TUPLE_COMPRESSION_LEVEL = 3,
+};
+
+/**
+ * Compression contexts are per thread, because tuples are
+ * decompressed not only in tx, but also in snapshot threads.
+ */
+static pthread_key_t tuple_zcctx_key;
+static pthread_key_t tuple_zdctx_key;
+
+static void
+tuple_zcctx_free(void *arg)
+{
+	ZSTD_freeCCtx(arg);
+}
+
+static void
+tuple_zdctx_free(void *arg)
+{
+	ZSTD_freeDCtx(arg);
+}
+
+int
+tuple_compression_init(void)
+{
+	tt_pthread_key_create(&tuple_zcctx_key, tuple_zcctx_free);
+	tt_pthread_key_create(&tuple_zdctx_key, tuple_zdctx_free);
+	return 0;
+}
+
+void
+tuple_compression_free(void)
+{
+	ZSTD_CCtx *zcctx = tt_pthread_getspecific(tuple_zcctx_key);
+	if (zcctx != NULL)
+		ZSTD_freeCCtx(zcctx);
+	ZSTD_DCtx *zdctx = tt_pthread_getspecific(tuple_zdctx_key);
+	if (zdctx != NULL)
+		ZSTD_freeDCtx(zdctx);
+	tt_pthread_key_delete(tuple_zcctx_key);
+	tt_pthread_key_delete(tuple_zdctx_key);
+}
+
+static ZSTD_CCtx *
+tuple_zcctx(void)
+{
+	ZSTD_CCtx *zcctx = tt_pthread_getspecific(tuple_zcctx_key);
+	if (zcctx == NULL) {
+		zcctx = ZSTD_createCCtx();
+		if (zcctx == NULL) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 "failed to create context");
+			return NULL;
+		}
+		tt_pthread_setspecific(tuple_zcctx_key, zcctx);
+	}
+	return zcctx;
+}
+
+static ZSTD_DCtx *
+tuple_zdctx(void)
+{
+	ZSTD_DCtx *zdctx = tt_pthread_getspecific(tuple_zdctx_key);
+	if (zdctx == NULL) {
+		zdctx = ZSTD_createDCtx();
+		if (zdctx == NULL) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 "failed to create context");
+			return NULL;
+		}
+		tt_pthread_setspecific(tuple_zdctx_key, zdctx);
+	}
+	return zdctx;
+}
+
+/** Check if values of a top-level field are compressed. */
+static inline bool
+tuple_format_field_is_compressed(struct tuple_format *format,
+				 uint32_t fieldno)
+{
+	return fieldno < tuple_format_field_count(format) &&
+	       tuple_format_field(format, fieldno)->compression !=
+	       COMPRESSION_TYPE_NONE;
+}
+
+/**
+ * Check if a value is worth compressing. Extension values
+ * are always wrapped, so that they can't be confused with
+ * compressed ones.
+ */
+static inline bool
+tuple_value_needs_compression(const char *field, const char *field_end)
+{
+	return field_end - field >= TUPLE_COMPRESSION_MIN_SIZE ||
+	       mp_typeof(*field) == MP_EXT;
+}
+
+/** Check if a value is a compressed one. */
+static inline bool
+tuple_value_is_compressed(const char *field, const char *field_end)
+{
+	return field_end - field > MP_COMPRESSION_HEADER_SIZE &&
+	       (uint8_t)field[0] == 0xc9 &&
+	       (int8_t)field[MP_COMPRESSION_HEADER_SIZE - 1] ==
+	       MP_COMPRESSION;
+}
+
+const char *
+tuple_compress_raw(struct tuple_format *format, const char *data,
+		   const char *end, uint32_t *size)
+{
+	*size = end - data;
+	if (format->compressed_field_count == 0)
+		return data;
+	/* Find out if there is anything to compress. */
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	size_t bound = end - data;
+	bool found = false;
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		if (tuple_format_field_is_compressed(format, i) &&
+		    tuple_value_needs_compression(field, pos)) {
+			bound += MP_COMPRESSION_HEADER_SIZE +
+				 ZSTD_compressBound(pos - field);
+			found = true;
+		}
+	}
+	if (!found)
+		return data;
+
+	ZSTD_CCtx *zcctx = tuple_zcctx();
+	if (zcctx == NULL)
+		return NULL;
+	char *buf = region_alloc(&fiber()->gc, bound);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, bound, "region", "compressed tuple");
+		return NULL;
+	}
+	pos = data;
+	field_count = mp_decode_array(&pos);
+	char *out = mp_encode_array(buf, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		size_t len = pos - field;
+		if (!tuple_format_field_is_compressed(format, i) ||
+		    !tuple_value_needs_compression(field, pos)) {
+			memcpy(out, field, len);
+			out += len;
+			continue;
+		}
+		char *frame = out + MP_COMPRESSION_HEADER_SIZE;
+		size_t zsize = ZSTD_compressCCtx(zcctx, frame,
+						 ZSTD_compressBound(len),
+						 field, len,
+						 TUPLE_COMPRESSION_LEVEL);
+		if (ZSTD_isError(zsize)) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 ZSTD_getErrorName(zsize));
+			return NULL;
+		}
+		if (zsize + MP_COMPRESSION_HEADER_SIZE >= len &&
+		    mp_typeof(*field) != MP_EXT) {
+			/* Incompressible, store as is. */
+			memcpy(out, field, len);
+			out += len;
+			continue;
+		}
+		char *header = out;
+		header = mp_store_u8(header, 0xc9);
+		header = mp_store_u32(header, zsize);
+		header = mp_store_u8(header, MP_COMPRESSION);
+		assert(header == frame);
+		out = frame + zsize;
+	}
+	assert(out <= buf + bound);
+	*size = out - buf;
+	return buf;
+}
+
+/**
+ * Get the size of a compressed value once it is decompressed.
+ * @retval 0 Success.
+ * @retval -1 Invalid zstd frame, diag is set.
+ */
+static inline int
+tuple_value_decompressed_size(const char *field, const char *field_end,
+			      size_t *size)
+{
+	const char *frame = field + MP_COMPRESSION_HEADER_SIZE;
+	unsigned long long len =
+		ZSTD_getFrameContentSize(frame, field_end - frame);
+	if (len == ZSTD_CONTENTSIZE_UNKNOWN ||
+	    len == ZSTD_CONTENTSIZE_ERROR) {
+		diag_set(ClientError, ER_COMPRESSION,
+			 "invalid compressed field");
+		return -1;
+	}
+	*size = len;
+	return 0;
+}
+
+const char *
+tuple_decompress_raw(struct tuple_format *format, const char *data,
+		     const char *end, uint32_t *size)
+{
+	*size = end - data;
+	if (format->compressed_field_count == 0)
+		return data;
+	/* Calculate the size of the decompressed tuple. */
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	size_t new_size = end - data;
+	bool found = false;
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		if (!tuple_format_field_is_compressed(format, i) ||
+		    !tuple_value_is_compressed(field, pos))
+			continue;
+		size_t len;
+		if (tuple_value_decompressed_size(field, pos, &len) != 0)
+			return NULL;
+		new_size += len;
+		new_size -= pos - field;
+		found = true;
+	}
+	if (!found)
+		return data;
+
+	ZSTD_DCtx *zdctx = tuple_zdctx();
+	if (zdctx == NULL)
+		return NULL;
+	char *buf = region_alloc(&fiber()->gc, new_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, new_size, "region",
+			 "decompressed tuple");
+		return NULL;
+	}
+	char *buf_end = buf + new_size;
+	pos = data;
+	field_count = mp_decode_array(&pos);
+	char *out = mp_encode_array(buf, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		if (!tuple_format_field_is_compressed(format, i) ||
+		    !tuple_value_is_compressed(field, pos)) {
+			memcpy(out, field, pos - field);
+			out += pos - field;
+			continue;
+		}
+		const char *frame = field + MP_COMPRESSION_HEADER_SIZE;
+		size_t len = ZSTD_decompressDCtx(zdctx, out, buf_end - out,
+						 frame, pos - frame);
+		if (ZSTD_isError(len)) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 ZSTD_getErrorName(len));
+			return NULL;
+		}
+		out += len;
+	}
+	assert(out == buf_end);
+	*size = new_size;
+	return buf;
+}
+
+const char *
+tuple_field_decompress_raw(struct tuple_format *format, uint32_t fieldno,
+			   const char *field, const char *field_end,
+			   uint32_t *size)
+{
+	*size = field_end - field;
+	if (!tuple_format_field_is_compressed(format, fieldno) ||
+	    !tuple_value_is_compressed(field, field_end))
+		return field;
+	size_t len;
+	if (tuple_value_decompressed_size(field, field_end, &len) != 0)
+		return NULL;
+	ZSTD_DCtx *zdctx = tuple_zdctx();
+	if (zdctx == NULL)
+		return NULL;
+	char *buf = region_alloc(&fiber()->gc, len);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, len, "region", "decompressed field");
+		return NULL;
+	}
+	const char *frame = field + MP_COMPRESSION_HEADER_SIZE;
+	size_t rc = ZSTD_decompressDCtx(zdctx, buf, len, frame,
+					field_end - frame);
+	if (ZSTD_isError(rc)) {
+		diag_set(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+		return NULL;
+	}
+	assert(rc == len);
+	*size = len;
+	return buf;
+}
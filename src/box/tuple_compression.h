@@ -0,0 +1,134 @@
+#ifndef TARANTOOL_BOX_TUPLE_COMPRESSION_H_INCLUDED
+#define TARANTOOL_BOX_TUPLE_COMPRESSION_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include "tuple.h"
+#include "tuple_format.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Values of fields with compression enabled in the space
+ * format (see field_def::compression) are stored by memtx
+ * as MsgPack extensions of this type wrapping a zstd frame
+ * with the original MsgPack value. Such values never leave
+ * the engine: tuples are decompressed before they are passed
+ * to the user, written to a snapshot or updated.
+ */
+enum { MP_COMPRESSION = 1 };
+
+enum {
+	/**
+	 * Values shorter than this are stored as is: they
+	 * wouldn't shrink much, but would cost a decompression
+	 * on each access.
+	 */
+	TUPLE_COMPRESSION_MIN_SIZE = 64,
+};
+
+/** Create per-thread compression contexts. */
+int
+tuple_compression_init(void);
+
+void
+tuple_compression_free(void);
+
+/**
+ * Compress values of fields of a tuple that have compression
+ * enabled in @a format. The tuple must be valid.
+ *
+ * @param format Format of the tuple.
+ * @param data, end MessagePack array of the tuple fields.
+ * @param[out] size Size of the result.
+ * @retval @a data if nothing was compressed.
+ * @retval Compressed tuple data allocated on the fiber region.
+ * @retval NULL on error, diag is set.
+ */
+const char *
+tuple_compress_raw(struct tuple_format *format, const char *data,
+		   const char *end, uint32_t *size);
+
+/**
+ * Decompress values of fields of a tuple compressed with
+ * tuple_compress_raw().
+ *
+ * @param format Format of the tuple.
+ * @param data, end MessagePack array of the tuple fields.
+ * @param[out] size Size of the result.
+ * @retval @a data if nothing was compressed.
+ * @retval Decompressed tuple data allocated on the fiber region.
+ * @retval NULL on error, diag is set.
+ */
+const char *
+tuple_decompress_raw(struct tuple_format *format, const char *data,
+		     const char *end, uint32_t *size);
+
+/**
+ * Decompress a single value of a tuple field compressed with
+ * tuple_compress_raw(). Unlike tuple_decompress_raw(), this
+ * doesn't copy the rest of the tuple.
+ *
+ * @param format Format of the tuple.
+ * @param fieldno Number of the field, 0-based.
+ * @param field, field_end MessagePack value of the field.
+ * @param[out] size Size of the result.
+ * @retval @a field if the value isn't compressed.
+ * @retval Decompressed value allocated on the fiber region.
+ * @retval NULL on error, diag is set.
+ */
+const char *
+tuple_field_decompress_raw(struct tuple_format *format, uint32_t fieldno,
+			   const char *field, const char *field_end,
+			   uint32_t *size);
+
+/**
+ * Get MessagePack data of a tuple with values of compressed
+ * fields decompressed, like tuple_data_range() does.
+ * @retval NULL on error, diag is set.
+ */
+static inline const char *
+tuple_data_range_decompressed(struct tuple *tuple, uint32_t *size)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	const char *data = tuple_data_range(tuple, size);
+	if (format->compressed_field_count == 0)
+		return data;
+	return tuple_decompress_raw(format, data, data + *size, size);
+}
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_TUPLE_COMPRESSION_H_INCLUDED */
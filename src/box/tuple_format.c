@@ -96,6 +96,9 @@ tuple_format_cmp(const struct tuple_format *format1,
 		if (field_a->is_key_part != field_b->is_key_part)
 			return (int)field_a->is_key_part -
 				(int)field_b->is_key_part;
+		if (field_a->compression != field_b->compression)
+			return (int)field_a->compression -
+				(int)field_b->compression;
 	}
 
 	return 0;
@@ -119,6 +122,7 @@ tuple_format_hash(struct tuple_format *format)
 		TUPLE_FIELD_MEMBER_HASH(f, coll_id, h, carry, size)
 		TUPLE_FIELD_MEMBER_HASH(f, nullable_action, h, carry, size)
 		TUPLE_FIELD_MEMBER_HASH(f, is_key_part, h, carry, size)
+		TUPLE_FIELD_MEMBER_HASH(f, compression, h, carry, size)
 	}
 #undef TUPLE_FIELD_MEMBER_HASH
 	return PMurHash32_Result(h, carry, size);
@@ -152,6 +156,7 @@ tuple_field_new(void)
 	field->offset_slot = TUPLE_OFFSET_SLOT_NIL;
 	field->coll_id = COLL_NONE;
 	field->nullable_action = ON_CONFLICT_ACTION_NONE;
+	field->compression = COMPRESSION_TYPE_NONE;
 	return field;
 }
 
@@ -305,6 +310,17 @@ tuple_format_use_key_part(struct tuple_format *format, uint32_t field_count,
 			  int *current_slot, char **path_pool)
 {
 	assert(part->fieldno < tuple_format_field_count(format));
+	/*
+	 * Compressed values can't be compared, so the field
+	 * and its subfields can't be indexed.
+	 */
+	if (tuple_format_field(format, part->fieldno)->compression !=
+	    COMPRESSION_TYPE_NONE) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 part->fieldno + TUPLE_INDEX_BASE,
+			 "compressed field can't be indexed");
+		return -1;
+	}
 	struct tuple_field *field =
 		tuple_format_add_field(format, part->fieldno, part->path,
 				       part->path_len, is_sequential,
@@ -400,6 +416,9 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 		}
 		field->coll = coll;
 		field->coll_id = cid;
+		field->compression = fields[i].compression;
+		if (field->compression != COMPRESSION_TYPE_NONE)
+			format->compressed_field_count++;
 	}
 
 	int current_slot = 0;
@@ -428,8 +447,16 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 	assert(tuple_format_field(format, 0)->offset_slot ==
 	       TUPLE_OFFSET_SLOT_NIL);
 	size_t field_map_size = -current_slot * sizeof(uint32_t);
-	if (field_map_size > UINT16_MAX) {
-		/** tuple->data_offset is 16 bits */
+	if (field_map_size > TUPLE_DATA_OFFSET_MAX - TUPLE_HEADER_SIZE_MAX) {
+		/*
+		 * tuple->data_offset is 15 bits. Note, the
+		 * limit used to be twice as high (16383
+		 * indexed fields) before the compact tuple
+		 * form was introduced, so a space created by
+		 * an older version with more than 8175 indexed
+		 * fields can't be recovered: drop some of its
+		 * indexes before upgrade.
+		 */
 		diag_set(ClientError, ER_INDEX_FIELD_COUNT_LIMIT,
 			 -current_slot);
 		return -1;
@@ -592,6 +619,8 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 	format->exact_field_count = 0;
 	format->min_field_count = 0;
 	format->epoch = 0;
+	format->compressed_field_count = 0;
+	format->decompressed_format = NULL;
 	return format;
 error:
 	tuple_format_destroy_fields(format);
@@ -606,6 +635,8 @@ tuple_format_destroy(struct tuple_format *format)
 	free(format->required_fields);
 	tuple_format_destroy_fields(format);
 	tuple_dictionary_unref(format->dict);
+	if (format->decompressed_format != NULL)
+		tuple_format_unref(format->decompressed_format);
 }
 
 /**
@@ -729,6 +760,8 @@ tuple_format1_can_store_format2_tuples(struct tuple_format *format1,
 {
 	if (format1->exact_field_count != format2->exact_field_count)
 		return false;
+	if (format1->compressed_field_count != format2->compressed_field_count)
+		return false;
 	struct tuple_field *field1;
 	json_tree_foreach_entry_preorder(field1, &format1->fields.root,
 					 struct tuple_field, token) {
@@ -763,6 +796,12 @@ tuple_format1_can_store_format2_tuples(struct tuple_format *format1,
 		if (tuple_field_is_nullable(field2) &&
 		    !tuple_field_is_nullable(field1))
 			return false;
+		/*
+		 * Stored tuples have to be recompressed if
+		 * compression of a field changes.
+		 */
+		if (field1->compression != field2->compression)
+			return false;
 	}
 	return true;
 }
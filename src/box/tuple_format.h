@@ -62,6 +62,15 @@ enum { TUPLE_INDEX_BASE = 1 };
  */
 enum { TUPLE_OFFSET_SLOT_NIL = INT32_MAX };
 
+/**
+ * Max offset of the MessagePack data from the begin of a
+ * tuple, which includes the field map and the tuple header
+ * (struct tuple::data_offset is 15 bits). Engine specific
+ * headers are assumed to be not longer than
+ * TUPLE_HEADER_SIZE_MAX.
+ */
+enum { TUPLE_DATA_OFFSET_MAX = INT16_MAX, TUPLE_HEADER_SIZE_MAX = 64 };
+
 struct tuple;
 struct tuple_format;
 struct coll;
@@ -116,6 +125,8 @@ struct tuple_field {
 	struct coll *coll;
 	/** Collation identifier. */
 	uint32_t coll_id;
+	/** Compression of the field values, top-level fields only. */
+	enum compression_type compression;
 	/** Link in tuple_format::fields. */
 	struct json_token token;
 };
@@ -202,6 +213,17 @@ struct tuple_format {
 	 * Shared names storage used by all formats of a space.
 	 */
 	struct tuple_dictionary *dict;
+	/**
+	 * Number of fields which values are stored compressed,
+	 * see tuple_field::compression.
+	 */
+	uint32_t compressed_field_count;
+	/**
+	 * Runtime format sharing the dictionary with this one,
+	 * used for decompressed copies of tuples of this format.
+	 * Created on demand, @sa tuple_decompress().
+	 */
+	struct tuple_format *decompressed_format;
 	/**
 	 * A maximum depth of format::fields subtree.
 	 */
@@ -32,6 +32,8 @@
 #include "engine.h"
 #include "tuple.h"
 #include "journal.h"
+#include "commit_latency.h"
+#include "clock.h"
 #include <fiber.h>
 #include "xrow.h"
 
@@ -155,6 +157,7 @@ txn_begin(bool is_autocommit)
 	txn->in_sub_stmt = 0;
 	txn->id = ++tsn;
 	txn->signature = -1;
+	txn->start_time = clock_monotonic();
 	txn->engine = NULL;
 	txn->engine_tx = NULL;
 	txn->psql_txn = NULL;
@@ -314,9 +317,9 @@ txn_write_to_wal(struct txn *txn)
 	assert(remote_row == req->rows + txn->n_applier_rows);
 	assert(local_row == remote_row + txn->n_new_rows);
 
-	ev_tstamp start = ev_monotonic_now(loop());
+	double start = clock_monotonic();
 	int64_t res = journal_write(req);
-	ev_tstamp stop = ev_monotonic_now(loop());
+	double stop = clock_monotonic();
 
 	if (res < 0) {
 		/* Cascading rollback. */
@@ -329,11 +332,37 @@ txn_write_to_wal(struct txn *txn)
 		fiber_reschedule();
 		diag_set(ClientError, ER_WAL_IO);
 		diag_log();
-	} else if (stop - start > too_long_threshold) {
-		int n_rows = txn->n_new_rows + txn->n_applier_rows;
-		say_warn_ratelimited("too long WAL write: %d rows at "
-				     "LSN %lld: %.3f sec", n_rows,
-				     res - n_rows + 1, stop - start);
+	} else if (req->write_end_time == 0) {
+		/* The journal doesn't track the time of writes. */
+		if (stop - start > too_long_threshold) {
+			int n_rows = txn->n_new_rows + txn->n_applier_rows;
+			say_warn_ratelimited("too long WAL write: %d rows at "
+					     "LSN %lld: %.3f sec", n_rows,
+					     res - n_rows + 1, stop - start);
+		}
+	} else {
+		double stages[] = {
+			[COMMIT_STAGE_TXN] = start - txn->start_time,
+			[COMMIT_STAGE_WAL_QUEUE] = req->write_start_time - start,
+			[COMMIT_STAGE_WAL_WRITE] = req->write_end_time -
+						   req->write_start_time,
+			[COMMIT_STAGE_WAL_RETURN] = stop - req->write_end_time,
+			[COMMIT_STAGE_TOTAL] = stop - txn->start_time,
+		};
+		for (int i = COMMIT_STAGE_TXN; i <= COMMIT_STAGE_TOTAL; i++)
+			commit_latency_collect(i, stages[i]);
+		if (stop - start > too_long_threshold) {
+			int n_rows = txn->n_new_rows + txn->n_applier_rows;
+			say_warn_ratelimited("too long WAL write: %d rows at "
+					     "LSN %lld: %.3f sec (txn %.3f, "
+					     "queue %.3f, write %.3f, "
+					     "return %.3f)", n_rows,
+					     res - n_rows + 1, stop - start,
+					     stages[COMMIT_STAGE_TXN],
+					     stages[COMMIT_STAGE_WAL_QUEUE],
+					     stages[COMMIT_STAGE_WAL_WRITE],
+					     stages[COMMIT_STAGE_WAL_RETURN]);
+		}
 	}
 	/*
 	 * Use vclock_sum() from WAL writer as transaction signature.
@@ -173,6 +173,8 @@ struct txn {
 	struct stailq_entry *sub_stmt_begin[TXN_SUB_STMT_MAX];
 	/** LSN of this transaction when written to WAL. */
 	int64_t signature;
+	/** Monotonic time when the transaction began. */
+	double start_time;
 	/** Engine involved in multi-statement transaction. */
 	struct engine *engine;
 	/** Engine-specific transaction data */
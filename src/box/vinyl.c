@@ -604,6 +604,13 @@ vinyl_engine_create_space(struct engine *engine, struct space_def *def,
 			  struct rlist *key_list)
 {
 	struct vy_env *env = vy_env(engine);
+	for (uint32_t i = 0; i < def->field_count; i++) {
+		if (def->fields[i].compression != COMPRESSION_TYPE_NONE) {
+			diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+				 "field compression");
+			return NULL;
+		}
+	}
 	struct space *space = malloc(sizeof(*space));
 	if (space == NULL) {
 		diag_set(OutOfMemory, sizeof(*space),
@@ -2733,6 +2740,12 @@ vinyl_engine_set_snap_io_rate_limit(struct vinyl_engine *vinyl, double limit)
 					  limit_in_bytes);
 }
 
+void
+vinyl_engine_set_compression_level(struct vinyl_engine *vinyl, int level)
+{
+	vinyl->env->run_env.compression_level = level;
+}
+
 /** }}} Environment */
 
 /* {{{ Checkpoint */
@@ -3911,6 +3924,337 @@ vinyl_index_create_iterator(struct index *base, enum iterator_type type,
 	return (struct iterator *)it;
 }
 
+/**
+ * Max number of tuples a partition reader of a parallel
+ * scan may read ahead of the consumer.
+ */
+enum { VINYL_SCAN_READ_AHEAD = 64 };
+
+struct vinyl_scan_iterator;
+
+/**
+ * A key range of an index read by a separate fiber. Tuples
+ * read by the fiber are kept in a ring buffer until they are
+ * consumed.
+ */
+struct vinyl_scan_partition {
+	/** Parallel scan this partition belongs to. */
+	struct vinyl_scan_iterator *scan;
+	/** Iterator positioned at the partition beginning. */
+	struct iterator *iterator;
+	/**
+	 * Key the next partition starts with, or NULL for
+	 * the last partition.
+	 */
+	const char *end;
+	/** Tuples read ahead. Referenced. */
+	struct tuple *tuples[VINYL_SCAN_READ_AHEAD];
+	/** Position of the first tuple in @tuples. */
+	int first;
+	/** Number of tuples in @tuples. */
+	int count;
+	/** True if the reader fiber has finished. */
+	bool is_done;
+	/** Error the reader fiber failed with. */
+	struct diag diag;
+	/**
+	 * Signaled when a tuple is read or consumed and when
+	 * the reader fiber finishes.
+	 */
+	struct fiber_cond cond;
+	/** Reader fiber, NULL when it has finished. */
+	struct fiber *fiber;
+};
+
+/**
+ * Iterator over all the tuples of an index which reads several
+ * key ranges of the index at once, so that disk reads of these
+ * ranges are done in parallel by vinyl reader threads. The
+ * ranges are returned one by one, so the order is the same as
+ * the one of a regular iterator.
+ */
+struct vinyl_scan_iterator {
+	struct iterator base;
+	/** LSM tree the iterator is for. */
+	struct vy_lsm *lsm;
+	/**
+	 * Number of references: one of the consumer and one
+	 * of each running reader fiber.
+	 */
+	int refs;
+	/** Index of the partition being consumed. */
+	int current;
+	/** Number of partitions. */
+	int partition_count;
+	/** Partitions, followed by their keys. */
+	struct vinyl_scan_partition partitions[0];
+};
+
+static void
+vinyl_scan_iterator_unref(struct vinyl_scan_iterator *scan)
+{
+	assert(scan->refs > 0);
+	if (--scan->refs > 0)
+		return;
+	for (int i = 0; i < scan->partition_count; i++) {
+		struct vinyl_scan_partition *part = &scan->partitions[i];
+		assert(part->fiber == NULL);
+		if (part->iterator != NULL)
+			iterator_delete(part->iterator);
+		for (int j = 0; j < part->count; j++) {
+			tuple_unref(part->tuples[(part->first + j) %
+						 VINYL_SCAN_READ_AHEAD]);
+		}
+		diag_destroy(&part->diag);
+		fiber_cond_destroy(&part->cond);
+	}
+	vy_lsm_unref(scan->lsm);
+	free(scan);
+}
+
+static int
+vinyl_scan_partition_f(va_list ap)
+{
+	struct vinyl_scan_partition *part =
+		va_arg(ap, struct vinyl_scan_partition *);
+	struct vinyl_scan_iterator *scan = part->scan;
+	struct key_def *cmp_def = scan->lsm->cmp_def;
+	while (!fiber_is_cancelled()) {
+		if (part->count == VINYL_SCAN_READ_AHEAD) {
+			fiber_cond_wait(&part->cond);
+			continue;
+		}
+		struct tuple *tuple;
+		if (iterator_next(part->iterator, &tuple) != 0) {
+			diag_move(diag_get(), &part->diag);
+			break;
+		}
+		if (tuple == NULL)
+			break;
+		if (part->end != NULL) {
+			const char *key = part->end;
+			uint32_t part_count = mp_decode_array(&key);
+			if (tuple_compare_with_key(tuple, key, part_count,
+						   cmp_def) >= 0)
+				break;
+		}
+		tuple_ref(tuple);
+		part->tuples[(part->first + part->count) %
+			     VINYL_SCAN_READ_AHEAD] = tuple;
+		part->count++;
+		fiber_cond_signal(&part->cond);
+	}
+	part->is_done = true;
+	part->fiber = NULL;
+	fiber_cond_signal(&part->cond);
+	vinyl_scan_iterator_unref(scan);
+	return 0;
+}
+
+static int
+vinyl_scan_iterator_next(struct iterator *base, struct tuple **ret)
+{
+	struct vinyl_scan_iterator *scan = (struct vinyl_scan_iterator *)base;
+	while (scan->current < scan->partition_count) {
+		struct vinyl_scan_partition *part =
+			&scan->partitions[scan->current];
+		if (part->count > 0) {
+			struct tuple *tuple = part->tuples[part->first];
+			part->first = (part->first + 1) % VINYL_SCAN_READ_AHEAD;
+			part->count--;
+			fiber_cond_signal(&part->cond);
+			*ret = tuple_bless(tuple);
+			tuple_unref(tuple);
+			return 0;
+		}
+		if (!part->is_done) {
+			if (fiber_cond_wait(&part->cond) != 0)
+				return -1;
+			continue;
+		}
+		if (!diag_is_empty(&part->diag)) {
+			diag_move(&part->diag, diag_get());
+			return -1;
+		}
+		scan->current++;
+	}
+	*ret = NULL;
+	return 0;
+}
+
+static void
+vinyl_scan_iterator_free(struct iterator *base)
+{
+	struct vinyl_scan_iterator *scan = (struct vinyl_scan_iterator *)base;
+	for (int i = 0; i < scan->partition_count; i++) {
+		struct vinyl_scan_partition *part = &scan->partitions[i];
+		if (part->fiber != NULL)
+			fiber_cancel(part->fiber);
+	}
+	vinyl_scan_iterator_unref(scan);
+}
+
+/**
+ * Collect keys which split an LSM tree into @a count partitions
+ * holding about the same number of statements on disk. The keys
+ * are taken from the page index of the biggest run slice of
+ * each range.
+ * @param lsm LSM tree to split.
+ * @param count Max number of partitions.
+ * @param[out] keys Keys of partitions but the first one.
+ *
+ * @return Number of keys found, less than @a count.
+ */
+static int
+vinyl_scan_split(struct vy_lsm *lsm, int count, const char **keys)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	/* Candidate keys along with the rows they start. */
+	int candidate_count = 0, candidate_max = 0;
+	struct vy_range *range;
+	for (range = vy_range_tree_first(&lsm->range_tree); range != NULL;
+	     range = vy_range_tree_next(&lsm->range_tree, range)) {
+		candidate_max++;
+		struct vy_slice *slice;
+		rlist_foreach_entry(slice, &range->slices, in_range)
+			candidate_max += slice->last_page_no -
+					 slice->first_page_no + 1;
+	}
+	size_t size = candidate_max * (sizeof(const char *) +
+				       sizeof(uint32_t));
+	const char **candidates = region_alloc(region, size);
+	if (candidates == NULL) {
+		region_truncate(region, region_svp);
+		return 0;
+	}
+	uint32_t *rows = (uint32_t *)(candidates + candidate_max);
+	uint64_t total_rows = 0;
+	for (range = vy_range_tree_first(&lsm->range_tree); range != NULL;
+	     range = vy_range_tree_next(&lsm->range_tree, range)) {
+		struct vy_slice *slice, *biggest = NULL;
+		rlist_foreach_entry(slice, &range->slices, in_range) {
+			if (biggest == NULL ||
+			    slice->last_page_no - slice->first_page_no >
+			    biggest->last_page_no - biggest->first_page_no)
+				biggest = slice;
+		}
+		candidates[candidate_count] = range->begin.stmt == NULL ?
+				NULL : tuple_data(range->begin.stmt);
+		rows[candidate_count++] = 0;
+		if (biggest == NULL)
+			continue;
+		struct vy_run *run = biggest->run;
+		for (uint32_t i = biggest->first_page_no;
+		     i <= biggest->last_page_no; i++) {
+			struct vy_page_info *page = vy_run_page_info(run, i);
+			if (i > biggest->first_page_no)
+				candidates[candidate_count++] = page->min_key;
+			rows[candidate_count - 1] += page->row_count;
+			total_rows += page->row_count;
+		}
+	}
+	int key_count = 0;
+	uint64_t offset = 0;
+	for (int i = 0; i < candidate_count && key_count < count - 1 &&
+	     total_rows > 0; i++) {
+		if (i > 0 && candidates[i] != NULL &&
+		    offset >= total_rows * (key_count + 1) / count)
+			keys[key_count++] = candidates[i];
+		offset += rows[i];
+	}
+	/*
+	 * The keys point to memory of ranges and runs, which
+	 * isn't freed until the next yield.
+	 */
+	region_truncate(region, region_svp);
+	return key_count;
+}
+
+struct iterator *
+vinyl_index_create_parallel_iterator(struct index *base, int *count)
+{
+	struct vy_lsm *lsm = vy_lsm(base);
+	int partition_count = *count;
+	assert(partition_count > 0);
+	assert(in_txn() == NULL);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	const char **keys = (const char **)
+		region_alloc(region, partition_count * sizeof(*keys));
+	if (keys == NULL) {
+		diag_set(OutOfMemory, partition_count * sizeof(*keys),
+			 "region", "keys");
+		return NULL;
+	}
+	int key_count = vinyl_scan_split(lsm, partition_count, keys);
+	if (key_count == 0) {
+		region_truncate(region, region_svp);
+		*count = 1;
+		return vinyl_index_create_iterator(base, ITER_ALL, NULL, 0);
+	}
+	partition_count = key_count + 1;
+	*count = partition_count;
+	size_t size = sizeof(struct vinyl_scan_iterator) +
+		      partition_count * sizeof(struct vinyl_scan_partition);
+	size_t keys_size = 0;
+	for (int i = 0; i < key_count; i++) {
+		const char *end = keys[i];
+		mp_next(&end);
+		keys_size += end - keys[i];
+	}
+	struct vinyl_scan_iterator *scan = calloc(1, size + keys_size);
+	if (scan == NULL) {
+		region_truncate(region, region_svp);
+		diag_set(OutOfMemory, size + keys_size, "calloc",
+			 "struct vinyl_scan_iterator");
+		return NULL;
+	}
+	iterator_create(&scan->base, base);
+	scan->base.next = vinyl_scan_iterator_next;
+	scan->base.free = vinyl_scan_iterator_free;
+	scan->lsm = lsm;
+	vy_lsm_ref(lsm);
+	scan->refs = 1;
+	scan->partition_count = partition_count;
+	char *data = (char *)scan + size;
+	for (int i = 0; i < partition_count; i++) {
+		struct vinyl_scan_partition *part = &scan->partitions[i];
+		part->scan = scan;
+		diag_create(&part->diag);
+		fiber_cond_create(&part->cond);
+		if (i == key_count)
+			continue;
+		const char *end = keys[i];
+		mp_next(&end);
+		memcpy(data, keys[i], end - keys[i]);
+		part->end = data;
+		data += end - keys[i];
+	}
+	region_truncate(region, region_svp);
+	for (int i = 0; i < partition_count; i++) {
+		struct vinyl_scan_partition *part = &scan->partitions[i];
+		const char *key = i == 0 ? NULL : scan->partitions[i - 1].end;
+		uint32_t part_count = key == NULL ? 0 : mp_decode_array(&key);
+		part->iterator = vinyl_index_create_iterator(base, ITER_GE, key,
+							     part_count);
+		if (part->iterator == NULL)
+			goto fail;
+	}
+	for (int i = 0; i < partition_count; i++) {
+		struct vinyl_scan_partition *part = &scan->partitions[i];
+		part->fiber = fiber_new("vinyl.scan", vinyl_scan_partition_f);
+		if (part->fiber == NULL)
+			goto fail;
+		scan->refs++;
+		fiber_start(part->fiber, part);
+	}
+	return &scan->base;
+fail:
+	vinyl_scan_iterator_free(&scan->base);
+	return NULL;
+}
+
 static int
 vinyl_index_get(struct index *index, const char *key,
 		uint32_t part_count, struct tuple **ret)
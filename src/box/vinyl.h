@@ -40,6 +40,8 @@ extern "C" {
 
 struct info_handler;
 struct vinyl_engine;
+struct index;
+struct iterator;
 
 struct vinyl_engine *
 vinyl_engine_new(const char *dir, size_t memory,
@@ -88,6 +90,25 @@ vinyl_engine_set_too_long_threshold(struct vinyl_engine *vinyl,
 void
 vinyl_engine_set_snap_io_rate_limit(struct vinyl_engine *vinyl, double limit);
 
+/**
+ * Update vinyl_compression_level.
+ */
+void
+vinyl_engine_set_compression_level(struct vinyl_engine *vinyl, int level);
+
+/**
+ * Create an iterator over all the tuples of a vinyl index in
+ * the ascending order, which splits the index into at most
+ * @a partition_count key ranges holding about the same amount
+ * of data and reads them concurrently in separate fibers, so
+ * that the ranges are fetched from disk in parallel. Must be
+ * called out of a transaction. On return @a partition_count
+ * is set to the number of ranges the index was split into.
+ */
+struct iterator *
+vinyl_index_create_parallel_iterator(struct index *index,
+				     int *partition_count);
+
 #ifdef __cplusplus
 } /* extern "C" */
 
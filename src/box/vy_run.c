@@ -165,6 +165,7 @@ vy_run_env_create(struct vy_run_env *env, int read_threads)
 {
 	memset(env, 0, sizeof(*env));
 	env->reader_pool_size = read_threads;
+	env->compression_level = XLOG_COMPRESSION_LEVEL_DEFAULT;
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
@@ -2036,6 +2037,7 @@ vy_run_write_index(struct vy_run *run, const char *dirpath,
 		return -1;
 
 	index_xlog.rate_limit = run->env->snap_io_rate_limit;
+	index_xlog.compression_level = run->env->compression_level;
 
 	xlog_tx_begin(&index_xlog);
 	struct region *region = &fiber()->gc;
@@ -2131,6 +2133,8 @@ vy_run_writer_create_xlog(struct vy_run_writer *writer)
 	if (xlog_create(&writer->data_xlog, path, 0, &meta) != 0)
 		return -1;
 	writer->data_xlog.rate_limit = writer->run->env->snap_io_rate_limit;
+	writer->data_xlog.compression_level =
+		writer->run->env->compression_level;
 	return 0;
 }
 
@@ -56,6 +56,8 @@ struct vy_run_reader;
 struct vy_run_env {
 	/** Write rate limit, in bytes per second. */
 	uint64_t snap_io_rate_limit;
+	/** Level of zstd compression of run files. */
+	int compression_level;
 	/** Mempool for struct vy_page_read_task */
 	struct mempool read_task_pool;
 	/** Key for thread-local ZSTD context */
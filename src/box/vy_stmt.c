@@ -175,6 +175,7 @@ vy_stmt_alloc(struct tuple_format *format, uint32_t bsize)
 	tuple->format_id = tuple_format_id(format);
 	if (cord_is_main())
 		tuple_format_ref(format);
+	tuple->is_compact = false;
 	tuple->bsize = bsize;
 	tuple->data_offset = sizeof(struct vy_stmt) + format->field_map_size;
 	vy_stmt_set_lsn(tuple, 0);
@@ -32,6 +32,7 @@
 
 #include "vclock.h"
 #include "fiber.h"
+#include "clock.h"
 #include "fio.h"
 #include "errinj.h"
 #include "error.h"
@@ -342,8 +343,9 @@ tx_notify_checkpoint(struct cmsg *msg)
  */
 static void
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
-		  const char *wal_dirname, int64_t wal_max_rows,
-		  int64_t wal_max_size, const struct tt_uuid *instance_uuid,
+		  bool wal_direct_io, const char *wal_dirname,
+		  int64_t wal_max_rows, int64_t wal_max_size,
+		  const struct tt_uuid *instance_uuid,
 		  wal_on_garbage_collection_f on_garbage_collection,
 		  wal_on_checkpoint_threshold_f on_checkpoint_threshold)
 {
@@ -355,8 +357,14 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid);
 	xlog_clear(&writer->current_wal);
+	writer->wal_dir.direct_io = wal_direct_io;
+	/*
+	 * With direct I/O the data doesn't linger in the page
+	 * cache, so only the metadata needed to read it back,
+	 * i.e. the file size, has to be synced.
+	 */
 	if (wal_mode == WAL_FSYNC)
-		writer->wal_dir.open_wflags |= O_SYNC;
+		writer->wal_dir.open_wflags |= wal_direct_io ? O_DSYNC : O_SYNC;
 
 	stailq_create(&writer->rollback);
 	cmsg_init(&writer->in_rollback, NULL);
@@ -392,7 +400,18 @@ wal_open_f(struct cbus_call_msg *msg)
 	const char *path = xdir_format_filename(&writer->wal_dir,
 				vclock_sum(&writer->vclock), NONE);
 	assert(!xlog_is_open(&writer->current_wal));
-	return xlog_open(&writer->current_wal, path);
+	if (xlog_open(&writer->current_wal, path) != 0)
+		return -1;
+	if (writer->wal_dir.direct_io &&
+	    xlog_set_direct_io(&writer->current_wal) != 0) {
+		xlog_close(&writer->current_wal, false);
+		return -1;
+	}
+	writer->current_wal.compression_level =
+		writer->wal_dir.compression_level;
+	writer->current_wal.compression_threads =
+		writer->wal_dir.compression_threads;
+	return 0;
 }
 
 /**
@@ -454,8 +473,9 @@ wal_open(struct wal_writer *writer)
 }
 
 int
-wal_init(enum wal_mode wal_mode, const char *wal_dirname, int64_t wal_max_rows,
-	 int64_t wal_max_size, const struct tt_uuid *instance_uuid,
+wal_init(enum wal_mode wal_mode, bool wal_direct_io, const char *wal_dirname,
+	 int64_t wal_max_rows, int64_t wal_max_size,
+	 const struct tt_uuid *instance_uuid,
 	 wal_on_garbage_collection_f on_garbage_collection,
 	 wal_on_checkpoint_threshold_f on_checkpoint_threshold)
 {
@@ -463,9 +483,9 @@ wal_init(enum wal_mode wal_mode, const char *wal_dirname, int64_t wal_max_rows,
 
 	/* Initialize the state. */
 	struct wal_writer *writer = &wal_writer_singleton;
-	wal_writer_create(writer, wal_mode, wal_dirname, wal_max_rows,
-			  wal_max_size, instance_uuid, on_garbage_collection,
-			  on_checkpoint_threshold);
+	wal_writer_create(writer, wal_mode, wal_direct_io, wal_dirname,
+			  wal_max_rows, wal_max_size, instance_uuid,
+			  on_garbage_collection, on_checkpoint_threshold);
 
 	/* Start WAL thread. */
 	if (cord_costart(&writer->cord, "wal", wal_writer_f, NULL) != 0)
@@ -654,6 +674,43 @@ wal_set_checkpoint_threshold(int64_t threshold)
 	fiber_set_cancellable(cancellable);
 }
 
+struct wal_set_compression_msg {
+	struct cbus_call_msg base;
+	int level;
+	int threads;
+};
+
+static int
+wal_set_compression_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_compression_msg *msg;
+	msg = (struct wal_set_compression_msg *)data;
+	writer->wal_dir.compression_level = msg->level;
+	writer->wal_dir.compression_threads = msg->threads;
+	if (xlog_is_open(&writer->current_wal)) {
+		writer->current_wal.compression_level = msg->level;
+		writer->current_wal.compression_threads = msg->threads;
+	}
+	return 0;
+}
+
+void
+wal_set_compression(int level, int threads)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_compression_msg msg;
+	msg.level = level;
+	msg.threads = threads;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_compression_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
 struct wal_gc_msg
 {
 	struct cbus_call_msg base;
@@ -920,6 +977,7 @@ wal_write_to_disk(struct cmsg *msg)
 	struct wal_writer *writer = &wal_writer_singleton;
 	struct wal_msg *wal_msg = (struct wal_msg *) msg;
 	struct error *error;
+	double start_time = clock_monotonic();
 
 	/*
 	 * Track all vclock changes made by this batch into
@@ -1006,6 +1064,16 @@ wal_write_to_disk(struct cmsg *msg)
 	last_committed = stailq_last(&wal_msg->commit);
 	vclock_merge(&writer->vclock, &vclock_diff);
 
+	/*
+	 * Let readers skip the rows written so far without
+	 * decoding them. The index is optional, so don't fail
+	 * the write if it can't be updated.
+	 */
+	if (xlog_index_add(l, &writer->vclock) != 0) {
+		diag_log();
+		diag_clear(diag_get());
+	}
+
 	/*
 	 * Notify TX if the checkpoint threshold has been exceeded.
 	 * Use malloc() for allocating the notification message and
@@ -1059,6 +1127,12 @@ done:
 		stailq_concat(&wal_msg->rollback, &rollback);
 		wal_writer_begin_rollback(writer);
 	}
+	/* Let tx account the time the batch spent in WAL. */
+	double end_time = clock_monotonic();
+	stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
+		entry->write_start_time = start_time;
+		entry->write_end_time = end_time;
+	}
 	fiber_gc();
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
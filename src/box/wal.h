@@ -69,11 +69,13 @@ typedef void (*wal_on_garbage_collection_f)(const struct vclock *vclock);
 typedef void (*wal_on_checkpoint_threshold_f)(void);
 
 /**
- * Start WAL thread and initialize WAL writer.
+ * Start WAL thread and initialize WAL writer. If @wal_direct_io
+ * is set, WAL files are written bypassing the page cache.
  */
 int
-wal_init(enum wal_mode wal_mode, const char *wal_dirname, int64_t wal_max_rows,
-	 int64_t wal_max_size, const struct tt_uuid *instance_uuid,
+wal_init(enum wal_mode wal_mode, bool wal_direct_io, const char *wal_dirname,
+	 int64_t wal_max_rows, int64_t wal_max_size,
+	 const struct tt_uuid *instance_uuid,
 	 wal_on_garbage_collection_f on_garbage_collection,
 	 wal_on_checkpoint_threshold_f on_checkpoint_threshold);
 
@@ -218,6 +220,13 @@ wal_commit_checkpoint(struct wal_checkpoint *checkpoint);
 void
 wal_set_checkpoint_threshold(int64_t threshold);
 
+/**
+ * Set the level of zstd compression of WAL files and the
+ * number of blocks of a write batch compressed in parallel.
+ */
+void
+wal_set_compression(int level, int threads);
+
 /**
  * Remove WAL files that are not needed by consumers reading
  * rows at @vclock or newer.
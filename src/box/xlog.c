@@ -41,6 +41,7 @@
 #include <msgpuck.h>
 
 #include "coio_file.h"
+#include "coio_task.h"
 
 #include "error.h"
 #include "xrow.h"
@@ -70,6 +71,11 @@ static const log_magic_t row_marker = mp_bswap_u32(0xd5ba0bab); /* host byte ord
 static const log_magic_t zrow_marker = mp_bswap_u32(0xd5ba0bba); /* host byte order */
 static const log_magic_t eof_marker = mp_bswap_u32(0xd510aded); /* host byte order */
 
+/** Suffix of the file with the sparse index of an xlog. */
+static const char xlog_index_suffix[] = ".index";
+/** First line of a file with the sparse index of an xlog. */
+static const char xlog_index_header[] = "XLOG INDEX\n";
+
 enum {
 	/**
 	 * When the number of rows in xlog_tx write buffer
@@ -105,6 +111,7 @@ enum {
 #define VCLOCK_KEY "VClock"
 #define VERSION_KEY "Version"
 #define PREV_VCLOCK_KEY "PrevVClock"
+#define BASE_VCLOCK_KEY "BaseVClock"
 
 static const char v13[] = "0.13";
 static const char v12[] = "0.12";
@@ -125,6 +132,7 @@ xlog_meta_create(struct xlog_meta *meta, const char *filetype,
 		vclock_copy(&meta->prev_vclock, prev_vclock);
 	else
 		vclock_clear(&meta->prev_vclock);
+	vclock_clear(&meta->base_vclock);
 }
 
 /**
@@ -158,6 +166,10 @@ xlog_meta_format(const struct xlog_meta *meta, char *buf, int size)
 		SNPRINT(total, snprintf, buf, size, PREV_VCLOCK_KEY ": %s\n",
 			vclock_to_string(&meta->prev_vclock));
 	}
+	if (vclock_is_set(&meta->base_vclock)) {
+		SNPRINT(total, snprintf, buf, size, BASE_VCLOCK_KEY ": %s\n",
+			vclock_to_string(&meta->base_vclock));
+	}
 	SNPRINT(total, snprintf, buf, size, "\n");
 	assert(total > 0);
 	return total;
@@ -249,6 +261,7 @@ xlog_meta_parse(struct xlog_meta *meta, const char **data,
 
 	vclock_clear(&meta->vclock);
 	vclock_clear(&meta->prev_vclock);
+	vclock_clear(&meta->base_vclock);
 
 	/*
 	 * Parse "key: value" pairs
@@ -299,6 +312,12 @@ xlog_meta_parse(struct xlog_meta *meta, const char **data,
 			 */
 			if (parse_vclock(val, val_end, &meta->prev_vclock) != 0)
 				return -1;
+		} else if (xlog_meta_key_equal(key, key_end, BASE_VCLOCK_KEY)) {
+			/*
+			 * BaseVClock: <vclock>
+			 */
+			if (parse_vclock(val, val_end, &meta->base_vclock) != 0)
+				return -1;
 		} else if (xlog_meta_key_equal(key, key_end, VERSION_KEY)) {
 			/* Ignore Version: for now */
 		} else {
@@ -331,6 +350,7 @@ xdir_create(struct xdir *dir, const char *dirname,
 	dir->instance_uuid = instance_uuid;
 	snprintf(dir->dirname, PATH_MAX, "%s", dirname);
 	dir->open_wflags = 0;
+	dir->compression_level = XLOG_COMPRESSION_LEVEL_DEFAULT;
 	switch (type) {
 	case SNAP:
 		dir->filetype = "SNAP";
@@ -685,6 +705,16 @@ xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 			eio_unlink(filename, 0, xdir_complete_gc, NULL);
 		else
 			xdir_say_gc(unlink(filename), errno, filename);
+		if (dir->type == XLOG) {
+			/* Remove the sparse index of the file, if any. */
+			char index[PATH_MAX];
+			snprintf(index, sizeof(index), "%s%s", filename,
+				 xlog_index_suffix);
+			if (flags & XDIR_GC_ASYNC)
+				eio_unlink(index, 0, xdir_complete_gc, NULL);
+			else
+				xdir_say_gc(unlink(index), errno, index);
+		}
 		vclockset_remove(&dir->index, vclock);
 		free(vclock);
 
@@ -767,6 +797,7 @@ xlog_init(struct xlog *xlog)
 	xlog->sync_interval = SNAP_SYNC_INTERVAL;
 	xlog->sync_time = ev_monotonic_time();
 	xlog->is_autocommit = true;
+	xlog->compression_level = XLOG_COMPRESSION_LEVEL_DEFAULT;
 	obuf_create(&xlog->obuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	obuf_create(&xlog->zbuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	xlog->zctx = ZSTD_createCCtx();
@@ -785,6 +816,9 @@ xlog_clear(struct xlog *l)
 	l->fd = -1;
 }
 
+static void
+xlog_destroy_blocks(struct xlog *xlog);
+
 static void
 xlog_destroy(struct xlog *xlog)
 {
@@ -793,6 +827,9 @@ xlog_destroy(struct xlog *xlog)
 	obuf_destroy(&xlog->obuf);
 	obuf_destroy(&xlog->zbuf);
 	ZSTD_freeCCtx(xlog->zctx);
+	xlog_destroy_blocks(xlog);
+	free(xlog->direct_buf);
+	free(xlog->index);
 	TRASH(xlog);
 	xlog->fd = -1;
 }
@@ -866,6 +903,87 @@ err:
 	return -1;
 }
 
+int
+xlog_create_shared(struct xlog *xlog, struct xlog *parent,
+		   pthread_mutex_t *write_lock, pthread_cond_t *write_cond)
+{
+	assert(parent->parent == NULL);
+	if (xlog_init(xlog) != 0)
+		return -1;
+	xlog->meta = parent->meta;
+	xlog->fd = parent->fd;
+	strncpy(xlog->filename, parent->filename, PATH_MAX);
+	xlog->is_inprogress = parent->is_inprogress;
+	xlog->compression_level = parent->compression_level;
+	xlog->parent = parent;
+	xlog->write_lock = write_lock;
+	xlog->write_cond = write_cond;
+	xlog->ticket = -1;
+	return 0;
+}
+
+int64_t
+xlog_shared_reserve(struct xlog *xlog, int64_t count)
+{
+	assert(xlog->parent != NULL);
+	assert(xlog->ticket < 0 && xlog->tx_rows == 0);
+	assert(count > 0);
+	struct xlog *parent = xlog->parent;
+	tt_pthread_mutex_lock(xlog->write_lock);
+	int64_t rows = parent->rows + parent->tx_rows + parent->pending_rows;
+	parent->pending_rows += count;
+	xlog->ticket = parent->next_ticket++;
+	xlog->reserved_rows = count;
+	tt_pthread_mutex_unlock(xlog->write_lock);
+	return rows;
+}
+
+/**
+ * Wait until the reservation of a shared writer, if any,
+ * is the one to be written. Called under the write lock.
+ */
+static void
+xlog_shared_wait(struct xlog *xlog)
+{
+	while (xlog->ticket >= 0 &&
+	       xlog->parent->write_ticket != xlog->ticket)
+		tt_pthread_cond_wait(xlog->write_cond, xlog->write_lock);
+}
+
+/**
+ * Account @a rows written from the reservation of a shared
+ * writer and let the next reservation be written when this
+ * one is done. Called under the write lock.
+ */
+static void
+xlog_shared_account(struct xlog *xlog, int64_t rows)
+{
+	if (xlog->ticket < 0)
+		return;
+	assert(rows <= xlog->reserved_rows);
+	xlog->reserved_rows -= rows;
+	xlog->parent->pending_rows -= rows;
+	if (xlog->reserved_rows > 0)
+		return;
+	xlog->ticket = -1;
+	xlog->parent->write_ticket++;
+	tt_pthread_cond_broadcast(xlog->write_cond);
+}
+
+void
+xlog_close_shared(struct xlog *xlog)
+{
+	assert(xlog->parent != NULL);
+	if (xlog->ticket >= 0) {
+		/* Give up the rest of the reservation. */
+		tt_pthread_mutex_lock(xlog->write_lock);
+		xlog_shared_wait(xlog);
+		xlog_shared_account(xlog, xlog->reserved_rows);
+		tt_pthread_mutex_unlock(xlog->write_lock);
+	}
+	xlog_destroy(xlog);
+}
+
 int
 xlog_open(struct xlog *xlog, const char *name)
 {
@@ -964,6 +1082,14 @@ xdir_touch_xlog(struct xdir *dir, const struct vclock *vclock)
 int
 xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		 const struct vclock *vclock)
+{
+	return xdir_create_delta_xlog(dir, xlog, vclock, NULL);
+}
+
+int
+xdir_create_delta_xlog(struct xdir *dir, struct xlog *xlog,
+		       const struct vclock *vclock,
+		       const struct vclock *base_vclock)
 {
 	int64_t signature = vclock_sum(vclock);
 	assert(signature >= 0);
@@ -980,6 +1106,8 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	struct xlog_meta meta;
 	xlog_meta_create(&meta, dir->filetype, dir->instance_uuid,
 			 vclock, prev_vclock);
+	if (base_vclock != NULL)
+		vclock_copy(&meta.base_vclock, base_vclock);
 
 	char *filename = xdir_format_filename(dir, signature, NONE);
 	if (xlog_create(xlog, filename, dir->open_wflags, &meta) != 0)
@@ -988,11 +1116,20 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	/* Inherit xdir settings. */
 	xlog->sync_is_async = dir->sync_is_async;
 	xlog->sync_interval = dir->sync_interval;
+	xlog->compression_level = dir->compression_level;
+	xlog->compression_threads = dir->compression_threads;
 
 	/* free file cache if dir should be synced */
 	xlog->free_cache = dir->sync_interval != 0 ? true: false;
 	xlog->rate_limit = 0;
 
+	if (dir->direct_io && xlog_set_direct_io(xlog) != 0) {
+		int save_errno = errno;
+		xlog_close(xlog, false);
+		errno = save_errno;
+		return -1;
+	}
+
 	/* Rename xlog file */
 	if (dir->suffix != INPROGRESS && xlog_rename(xlog)) {
 		int save_errno = errno;
@@ -1040,31 +1177,108 @@ xlog_fallocate(struct xlog *log, size_t len)
 }
 
 /**
- * Write a sequence of uncompressed xrow objects.
- *
- * @retval -1 error
- * @retval >= 0 the number of bytes written
+ * Load the last incomplete page of a log written with direct
+ * I/O to the beginning of the aligned buffer.
  */
-static off_t
-xlog_tx_write_plain(struct xlog *log)
+static int
+xlog_load_direct_tail(struct xlog *log)
+{
+	size_t tail = log->offset % XLOG_DIRECT_IO_ALIGN;
+	if (tail > 0) {
+		ssize_t n = fio_pread(log->fd, log->direct_buf,
+				      XLOG_DIRECT_IO_ALIGN,
+				      log->offset - tail);
+		if (n < 0) {
+			diag_set(SystemError, "failed to read '%s' file",
+				 log->filename);
+			return -1;
+		}
+		if ((size_t)n < tail) {
+			diag_set(XlogError, "%s: unexpected end of file",
+				 log->filename);
+			return -1;
+		}
+	}
+	log->direct_tail = tail;
+	return 0;
+}
+
+int
+xlog_set_direct_io(struct xlog *log)
+{
+	assert(log->direct_buf == NULL);
+	static bool direct_io_not_supported = false;
+	if (direct_io_not_supported)
+		return 0;
+#if defined(O_DIRECT)
+	void *buf;
+	if (posix_memalign(&buf, XLOG_DIRECT_IO_ALIGN,
+			   XLOG_DIRECT_IO_BUF_SIZE) != 0) {
+		diag_set(OutOfMemory, XLOG_DIRECT_IO_BUF_SIZE,
+			 "posix_memalign", "direct I/O buffer");
+		return -1;
+	}
+	log->direct_buf = (char *)buf;
+	if (xlog_load_direct_tail(log) != 0)
+		goto fail;
+	int flags = fcntl(log->fd, F_GETFL);
+	if (flags < 0 || fcntl(log->fd, F_SETFL, flags | O_DIRECT) != 0) {
+		if (errno == EINVAL) {
+			say_warn("direct I/O is not supported by the "
+				 "file system, proceeding without it");
+			direct_io_not_supported = true;
+			free(log->direct_buf);
+			log->direct_buf = NULL;
+			return 0;
+		}
+		diag_set(SystemError, "%s: failed to enable direct I/O",
+			 log->filename);
+		goto fail;
+	}
+	return 0;
+fail:
+	free(log->direct_buf);
+	log->direct_buf = NULL;
+	return -1;
+#elif defined(F_NOCACHE)
+	/* No alignment restrictions, no need in the buffer. */
+	if (fcntl(log->fd, F_NOCACHE, 1) != 0) {
+		diag_set(SystemError, "%s: failed to enable direct I/O",
+			 log->filename);
+		return -1;
+	}
+	return 0;
+#else
+	(void)log;
+	say_warn("direct I/O is not supported, proceeding without it");
+	direct_io_not_supported = true;
+	return 0;
+#endif
+}
+
+/**
+ * Prepare a sequence of uncompressed xrow objects for
+ * writing: populate the fixheader of the output buffer.
+ */
+static void
+xlog_tx_encode_plain(struct obuf *obuf)
 {
 	/**
 	 * We created an obuf savepoint at start of xlog_tx,
 	 * now populate it with data.
 	 */
-	char *fixheader = (char *)log->obuf.iov[0].iov_base;
+	char *fixheader = (char *)obuf->iov[0].iov_base;
 	*(log_magic_t *)fixheader = row_marker;
 	char *data = fixheader + sizeof(log_magic_t);
 
-	data = mp_encode_uint(data,
-			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE);
+	data = mp_encode_uint(data, obuf_size(obuf) - XLOG_FIXHEADER_SIZE);
 	/* Encode crc32 for previous row */
 	data = mp_encode_uint(data, 0);
 	/* Encode crc32 for current row */
 	uint32_t crc32c = 0;
 	struct iovec *iov;
 	size_t offset = XLOG_FIXHEADER_SIZE;
-	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
+	for (iov = obuf->iov; iov->iov_len; ++iov) {
 		crc32c = crc32_calc(crc32c,
 				    (char *)iov->iov_base + offset,
 				    iov->iov_len - offset);
@@ -1083,71 +1297,66 @@ xlog_tx_write_plain(struct xlog *log)
 			data += padding - 1;
 		}
 	}
+}
 
-	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		return -1;
-	});
-
-	ssize_t written = fio_writevn(log->fd, log->obuf.iov, log->obuf.pos + 1);
-	if (written < 0) {
-		diag_set(SystemError, "failed to write to '%s' file",
-			 log->filename);
-		return -1;
+/**
+ * Return the max size of a block of xrow objects compressed
+ * with xlog_tx_compress().
+ */
+static size_t
+xlog_tx_compress_bound(struct obuf *obuf)
+{
+	size_t bound = XLOG_FIXHEADER_SIZE;
+	size_t offset = XLOG_FIXHEADER_SIZE;
+	for (struct iovec *iov = obuf->iov; iov->iov_len; ++iov) {
+		bound += ZSTD_compressBound(iov->iov_len - offset);
+		offset = 0;
 	}
-	return obuf_size(&log->obuf);
+	return bound;
 }
 
 /**
- * Write a compressed block of xrow objects.
+ * Compress a block of xrow objects to a buffer of
+ * xlog_tx_compress_bound() bytes. Doesn't allocate memory,
+ * so can be called in any thread.
  * @retval -1  error
- * @retval >= 0 the number of bytes written
+ * @retval >0 the size of the compressed block
  */
-static off_t
-xlog_tx_write_zstd(struct xlog *log)
+static ssize_t
+xlog_tx_compress(struct obuf *obuf, char *dst, size_t size,
+		 ZSTD_CCtx *zctx, int level)
 {
-	char *fixheader = (char *)obuf_alloc(&log->zbuf,
-					     XLOG_FIXHEADER_SIZE);
+	char *fixheader = dst;
+	char *zdst = dst + XLOG_FIXHEADER_SIZE;
+	char *zend = dst + size;
 
 	uint32_t crc32c = 0;
 	struct iovec *iov;
-	/* 3 is compression level. */
-	ZSTD_compressBegin(log->zctx, 3);
+	ZSTD_compressBegin(zctx, level);
 	size_t offset = XLOG_FIXHEADER_SIZE;
-	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
-		/* Estimate max output buffer size. */
-		size_t zmax_size = ZSTD_compressBound(iov->iov_len - offset);
-		/* Allocate a destination buffer. */
-		void *zdst = obuf_reserve(&log->zbuf, zmax_size);
-		if (!zdst) {
-			diag_set(OutOfMemory, zmax_size, "runtime arena",
-				  "compression buffer");
-			goto error;
-		}
+	for (iov = obuf->iov; iov->iov_len; ++iov) {
 		size_t (*fcompress)(ZSTD_CCtx *, void *, size_t,
 				    const void *, size_t);
 		/*
 		 * If it's the last iov or the last
 		 * log has 0 bytes, end the stream.
 		 */
-		if (iov == log->obuf.iov + log->obuf.pos ||
-		    !(iov + 1)->iov_len) {
+		if (iov == obuf->iov + obuf->pos || !(iov + 1)->iov_len) {
 			fcompress = ZSTD_compressEnd;
 		} else {
 			fcompress = ZSTD_compressContinue;
 		}
-		size_t zsize = fcompress(log->zctx, zdst, zmax_size,
+		size_t zsize = fcompress(zctx, zdst, zend - zdst,
 					 (char *)iov->iov_base + offset,
 					 iov->iov_len - offset);
 		if (ZSTD_isError(zsize)) {
 			diag_set(ClientError, ER_COMPRESSION,
 				 ZSTD_getErrorName(zsize));
-			goto error;
+			return -1;
 		}
-		/* Advance output buffer to the end of compressed data. */
-		obuf_alloc(&log->zbuf, zsize);
 		/* Update crc32c */
-		crc32c = crc32_calc(crc32c, (char *)zdst, zsize);
+		crc32c = crc32_calc(crc32c, zdst, zsize);
+		zdst += zsize;
 		/* Discount fixheader size for all iovs after first. */
 		offset = 0;
 	}
@@ -1155,8 +1364,7 @@ xlog_tx_write_zstd(struct xlog *log)
 	*(log_magic_t *)fixheader = zrow_marker;
 	char *data;
 	data = fixheader + sizeof(log_magic_t);
-	data = mp_encode_uint(data,
-			      obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE);
+	data = mp_encode_uint(data, zdst - fixheader - XLOG_FIXHEADER_SIZE);
 	/* Encode crc32 for previous row */
 	data = mp_encode_uint(data, 0);
 	/* Encode crc32 for current row */
@@ -1171,26 +1379,115 @@ xlog_tx_write_zstd(struct xlog *log)
 			data += padding - 1;
 		}
 	}
+	return zdst - fixheader;
+}
 
+/**
+ * Compress a block of xrow objects to the compressed
+ * output buffer.
+ * @retval -1  error
+ * @retval 0 success
+ */
+static int
+xlog_tx_encode_zstd(struct obuf *obuf, struct obuf *zbuf,
+		    ZSTD_CCtx *zctx, int level)
+{
+	size_t bound = xlog_tx_compress_bound(obuf);
+	char *dst = (char *)obuf_reserve(zbuf, bound);
+	if (dst == NULL) {
+		diag_set(OutOfMemory, bound, "runtime arena",
+			  "compression buffer");
+		return -1;
+	}
+	ssize_t size = xlog_tx_compress(obuf, dst, bound, zctx, level);
+	if (size < 0)
+		return -1;
+	obuf_alloc(zbuf, size);
+	return 0;
+}
+
+/**
+ * Write a block to a log with direct I/O: append it to the
+ * last incomplete page in the aligned buffer and write the
+ * buffer in whole pages, padding the last one with zeros.
+ * The last incomplete page stays in the buffer to be
+ * rewritten with the next block.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes of the block written
+ */
+static ssize_t
+xlog_writev_direct(struct xlog *log, struct iovec *iov, int iovcnt)
+{
+	char *buf = log->direct_buf;
+	size_t used = log->direct_tail;
+	off_t pos = log->offset - used;
+	ssize_t written = 0;
+	for (int i = 0; i < iovcnt; i++) {
+		const char *data = (const char *)iov[i].iov_base;
+		size_t len = iov[i].iov_len;
+		written += len;
+		while (len > 0) {
+			size_t n = MIN(len, XLOG_DIRECT_IO_BUF_SIZE - used);
+			memcpy(buf + used, data, n);
+			used += n;
+			data += n;
+			len -= n;
+			if (used < XLOG_DIRECT_IO_BUF_SIZE)
+				continue;
+			if (fio_pwriten(log->fd, buf, used, pos) != 0)
+				goto error;
+			pos += used;
+			used = 0;
+		}
+	}
+	size_t tail = used % XLOG_DIRECT_IO_ALIGN;
+	size_t size = used - tail;
+	if (tail > 0) {
+		memset(buf + used, 0, XLOG_DIRECT_IO_ALIGN - tail);
+		size += XLOG_DIRECT_IO_ALIGN;
+	}
+	if (size > 0 && fio_pwriten(log->fd, buf, size, pos) != 0)
+		goto error;
+	if (used > tail)
+		memmove(buf, buf + used - tail, tail);
+	log->direct_tail = tail;
+	return written;
+error:
+	diag_set(SystemError, "failed to write to '%s' file",
+		 log->filename);
+	return -1;
+}
+
+/**
+ * Write an encoded block of xrow objects to the log file.
+ * @retval -1  error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_writev(struct xlog *log, struct iovec *iov, int iovcnt)
+{
 	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		obuf_reset(&log->zbuf);
-		goto error;
+		return -1;
 	});
 
-	ssize_t written;
-	written = fio_writevn(log->fd, log->zbuf.iov,
-			      log->zbuf.pos + 1);
+	if (log->direct_buf != NULL)
+		return xlog_writev_direct(log, iov, iovcnt);
+
+	ssize_t written = fio_writevn(log->fd, iov, iovcnt);
 	if (written < 0) {
 		diag_set(SystemError, "failed to write to '%s' file",
 			 log->filename);
-		goto error;
+		return -1;
 	}
-	obuf_reset(&log->zbuf);
 	return written;
-error:
-	obuf_reset(&log->zbuf);
-	return -1;
+}
+
+static ssize_t
+xlog_write_block(struct xlog *log, struct obuf *block)
+{
+	return xlog_writev(log, block->iov, block->pos + 1);
 }
 
 /* file syncing and posix_fadvise() should be rounded by a page boundary */
@@ -1199,26 +1496,20 @@ error:
 #define SYNC_ROUND_UP(size)	(SYNC_ROUND_DOWN(size + SYNC_MASK))
 
 /**
- * Writes xlog batch to file
+ * Advance the write position of a log after writing a block
+ * to it, sync the file and throttle the writer if needed.
+ * On write error, truncate the file to the last good block.
+ * If @a throttle_time isn't NULL, the writer isn't put to
+ * sleep, but the time it should sleep is stored there, so
+ * that it can sleep after releasing the write lock.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
  */
 static ssize_t
-xlog_tx_write(struct xlog *log)
+xlog_account_block(struct xlog *log, ssize_t written, int64_t rows,
+		   double *throttle_time)
 {
-	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
-		return 0;
-	ssize_t written;
-
-	if (obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
-		written = xlog_tx_write_zstd(log);
-	} else {
-		written = xlog_tx_write_plain(log);
-	}
-	ERROR_INJECT(ERRINJ_WAL_WRITE, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		written = -1;
-	});
-
-	obuf_reset(&log->obuf);
 	/*
 	 * Simplify recovery after a temporary write failure:
 	 * truncate the file to the best known good write
@@ -1228,6 +1519,9 @@ xlog_tx_write(struct xlog *log)
 		if (lseek(log->fd, log->offset, SEEK_SET) < 0 ||
 		    ftruncate(log->fd, log->offset) != 0)
 			panic_syserror("failed to truncate xlog after write error");
+		if (log->direct_buf != NULL &&
+		    xlog_load_direct_tail(log) != 0)
+			panic("failed to reload xlog tail after write error");
 		log->allocated = 0;
 		return -1;
 	}
@@ -1236,8 +1530,7 @@ xlog_tx_write(struct xlog *log)
 	else
 		log->allocated = 0;
 	log->offset += written;
-	log->rows += log->tx_rows;
-	log->tx_rows = 0;
+	log->rows += rows;
 	if ((log->sync_interval && log->offset >=
 	    (off_t)(log->synced_size + log->sync_interval)) ||
 	    (log->rate_limit && log->offset >=
@@ -1245,12 +1538,12 @@ xlog_tx_write(struct xlog *log)
 		off_t sync_from = SYNC_ROUND_DOWN(log->synced_size);
 		size_t sync_len = SYNC_ROUND_UP(log->offset) -
 				  sync_from;
+		double delay = 0;
 		if (log->rate_limit > 0) {
-			double throttle_time;
-			throttle_time = (double)sync_len / log->rate_limit -
-					(ev_monotonic_time() - log->sync_time);
-			if (throttle_time > 0)
-				ev_sleep(throttle_time);
+			delay = (double)sync_len / log->rate_limit -
+				(ev_monotonic_time() - log->sync_time);
+			if (delay > 0 && throttle_time == NULL)
+				ev_sleep(delay);
 		}
 		/** sync data from cache to disk */
 #ifdef HAVE_SYNC_FILE_RANGE
@@ -1262,6 +1555,11 @@ xlog_tx_write(struct xlog *log)
 		fdatasync(log->fd);
 #endif /* HAVE_SYNC_FILE_RANGE */
 		log->sync_time = ev_monotonic_time();
+		if (delay > 0 && throttle_time != NULL) {
+			/* The writer resumes after sleeping. */
+			*throttle_time = delay;
+			log->sync_time += delay;
+		}
 		if (log->free_cache) {
 #ifdef HAVE_POSIX_FADVISE
 			/** free page cache */
@@ -1279,6 +1577,314 @@ xlog_tx_write(struct xlog *log)
 	return written;
 }
 
+/**
+ * Writes xlog batch to file
+ */
+static ssize_t
+xlog_tx_write(struct xlog *log)
+{
+	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
+		return 0;
+	struct obuf *block = &log->obuf;
+	if (log->compression_level > 0 &&
+	    obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
+		if (xlog_tx_encode_zstd(&log->obuf, &log->zbuf, log->zctx,
+					log->compression_level) == 0)
+			block = &log->zbuf;
+		else
+			block = NULL;
+	} else {
+		xlog_tx_encode_plain(&log->obuf);
+	}
+	/*
+	 * A shared writer encodes blocks on its own, but
+	 * appends them to the file of the parent xlog, so
+	 * that the file offset, syncing and write rate limit
+	 * are common for all writers.
+	 */
+	struct xlog *out = log;
+	if (log->parent != NULL) {
+		out = log->parent;
+		tt_pthread_mutex_lock(log->write_lock);
+		xlog_shared_wait(log);
+	}
+	ssize_t written = block != NULL ? xlog_write_block(out, block) : -1;
+	ERROR_INJECT(ERRINJ_WAL_WRITE, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		written = -1;
+	});
+
+	obuf_reset(&log->obuf);
+	obuf_reset(&log->zbuf);
+	double throttle_time = 0;
+	written = xlog_account_block(out, written, log->tx_rows,
+				     log != out ? &throttle_time : NULL);
+	if (log->parent != NULL) {
+		if (written >= 0)
+			xlog_shared_account(log, log->tx_rows);
+		tt_pthread_mutex_unlock(log->write_lock);
+		/* Don't hold the other writers while throttled. */
+		if (throttle_time > 0)
+			ev_sleep(throttle_time);
+	}
+	if (written >= 0) {
+		if (log != out)
+			log->rows += log->tx_rows;
+		log->tx_rows = 0;
+	}
+	return written;
+}
+
+/* {{{ Parallel compression */
+
+/**
+ * A block of rows parked by an xlog with parallel compression,
+ * see xlog::compression_threads.
+ */
+struct xlog_block {
+	/** Rows of the block, starting with a fixheader. */
+	struct obuf obuf;
+	/** Compressed block. */
+	struct obuf zbuf;
+	/** Compression context, created on demand. */
+	ZSTD_CCtx *zctx;
+	/** Number of rows in the block. */
+	int64_t rows;
+	/** Space reserved in @zbuf, NULL if not compressed. */
+	char *zdst;
+	/** Size of the space reserved in @zbuf. */
+	size_t zcapacity;
+	/** Size of the compressed block. */
+	ssize_t zsize;
+};
+
+static void
+xlog_destroy_blocks(struct xlog *log)
+{
+	if (log->blocks == NULL)
+		return;
+	for (int i = 0; i < XLOG_COMPRESSION_THREADS_MAX; i++) {
+		struct xlog_block *block = &log->blocks[i];
+		obuf_destroy(&block->obuf);
+		obuf_destroy(&block->zbuf);
+		ZSTD_freeCCtx(block->zctx);
+	}
+	free(log->blocks);
+	log->blocks = NULL;
+	log->block_count = 0;
+}
+
+static void
+xlog_reset_blocks(struct xlog *log)
+{
+	for (int i = 0; i < log->block_count; i++) {
+		obuf_reset(&log->blocks[i].obuf);
+		obuf_reset(&log->blocks[i].zbuf);
+	}
+	log->block_count = 0;
+}
+
+/**
+ * Move the rows of the output buffer to a new block,
+ * leaving the output buffer empty.
+ */
+static int
+xlog_park_block(struct xlog *log)
+{
+	assert(log->block_count < XLOG_COMPRESSION_THREADS_MAX);
+	if (log->blocks == NULL) {
+		size_t size = XLOG_COMPRESSION_THREADS_MAX *
+			      sizeof(*log->blocks);
+		log->blocks = (struct xlog_block *)calloc(1, size);
+		if (log->blocks == NULL) {
+			diag_set(OutOfMemory, size, "malloc",
+				 "struct xlog_block");
+			return -1;
+		}
+		for (int i = 0; i < XLOG_COMPRESSION_THREADS_MAX; i++) {
+			struct xlog_block *block = &log->blocks[i];
+			obuf_create(&block->obuf, &cord()->slabc,
+				    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+			obuf_create(&block->zbuf, &cord()->slabc,
+				    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+		}
+	}
+	struct xlog_block *block = &log->blocks[log->block_count];
+	if (block->zctx == NULL) {
+		block->zctx = ZSTD_createCCtx();
+		if (block->zctx == NULL) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 "failed to create context");
+			return -1;
+		}
+	}
+	/* The buffers are empty and come from the same slab cache. */
+	struct obuf tmp = block->obuf;
+	block->obuf = log->obuf;
+	log->obuf = tmp;
+	block->rows = log->tx_rows;
+	log->tx_rows = 0;
+	log->block_count++;
+	return 0;
+}
+
+static ssize_t
+xlog_compress_block_f(va_list ap)
+{
+	struct xlog_block *block = va_arg(ap, struct xlog_block *);
+	int level = va_arg(ap, int);
+	block->zsize = xlog_tx_compress(&block->obuf, block->zdst,
+					block->zcapacity, block->zctx, level);
+	return block->zsize < 0 ? -1 : 0;
+}
+
+static int
+xlog_compress_block_fiber_f(va_list ap)
+{
+	struct xlog_block *block = va_arg(ap, struct xlog_block *);
+	int level = va_arg(ap, int);
+	if (coio_call(xlog_compress_block_f, block, level) != 0) {
+		if (diag_is_empty(diag_get())) {
+			diag_set(OutOfMemory, sizeof(struct coio_task),
+				 "malloc", "struct coio_task");
+		}
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Compress the parked blocks in parallel: each block but one
+ * is compressed in a coio thread, the remaining one in the
+ * current thread. Then write all the blocks with a single
+ * writev().
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_write_blocks(struct xlog *log)
+{
+	assert(log->parent == NULL);
+	struct fiber *workers[XLOG_COMPRESSION_THREADS_MAX];
+	int worker_count = 0;
+	struct xlog_block *local = NULL;
+	int64_t rows = 0;
+	int rc = 0;
+	for (int i = 0; i < log->block_count; i++) {
+		struct xlog_block *block = &log->blocks[i];
+		rows += block->rows;
+		block->zdst = NULL;
+		if (log->compression_level == 0 ||
+		    obuf_size(&block->obuf) < XLOG_TX_COMPRESS_THRESHOLD) {
+			xlog_tx_encode_plain(&block->obuf);
+			continue;
+		}
+		block->zcapacity = xlog_tx_compress_bound(&block->obuf);
+		block->zdst = (char *)obuf_reserve(&block->zbuf,
+						   block->zcapacity);
+		if (block->zdst == NULL) {
+			diag_set(OutOfMemory, block->zcapacity,
+				 "runtime arena", "compression buffer");
+			rc = -1;
+			break;
+		}
+		if (local == NULL) {
+			local = block;
+			continue;
+		}
+		struct fiber *f = fiber_new("xlog_compress",
+					    xlog_compress_block_fiber_f);
+		if (f == NULL) {
+			rc = -1;
+			break;
+		}
+		fiber_set_joinable(f, true);
+		fiber_start(f, block, log->compression_level);
+		workers[worker_count++] = f;
+	}
+	if (rc == 0 && local != NULL) {
+		local->zsize = xlog_tx_compress(&local->obuf, local->zdst,
+						local->zcapacity, local->zctx,
+						log->compression_level);
+		if (local->zsize < 0)
+			rc = -1;
+	}
+	for (int i = 0; i < worker_count; i++) {
+		if (fiber_join(workers[i]) != 0)
+			rc = -1;
+	}
+
+	ssize_t written = -1;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	if (rc == 0) {
+		int iovcnt = 0;
+		for (int i = 0; i < log->block_count; i++) {
+			struct xlog_block *block = &log->blocks[i];
+			if (block->zdst != NULL)
+				obuf_alloc(&block->zbuf, block->zsize);
+			struct obuf *out = block->zdst != NULL ?
+					   &block->zbuf : &block->obuf;
+			iovcnt += out->pos + 1;
+		}
+		size_t size = iovcnt * sizeof(struct iovec);
+		struct iovec *iov = (struct iovec *)region_alloc(region, size);
+		if (iov == NULL) {
+			diag_set(OutOfMemory, size, "region", "iovec");
+		} else {
+			struct iovec *pos = iov;
+			for (int i = 0; i < log->block_count; i++) {
+				struct xlog_block *block = &log->blocks[i];
+				struct obuf *out = block->zdst != NULL ?
+						   &block->zbuf : &block->obuf;
+				memcpy(pos, out->iov,
+				       (out->pos + 1) * sizeof(*pos));
+				pos += out->pos + 1;
+			}
+			written = xlog_writev(log, iov, iovcnt);
+		}
+	}
+	ERROR_INJECT(ERRINJ_WAL_WRITE, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		written = -1;
+	});
+	region_truncate(region, region_svp);
+	xlog_reset_blocks(log);
+	return xlog_account_block(log, written, rows, NULL);
+}
+
+/**
+ * Write the rows buffered by a log. With parallel compression,
+ * the rows are parked until there are enough blocks to keep
+ * all the compression threads busy or the log is flushed.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_tx_submit(struct xlog *log, bool is_flush)
+{
+	bool is_parallel = log->compression_level > 0 &&
+			   log->compression_threads > 1 &&
+			   log->parent == NULL;
+	if (!is_parallel && log->block_count == 0)
+		return xlog_tx_write(log);
+	if (obuf_size(&log->obuf) > XLOG_FIXHEADER_SIZE &&
+	    xlog_park_block(log) != 0) {
+		obuf_reset(&log->obuf);
+		log->tx_rows = 0;
+		xlog_reset_blocks(log);
+		return -1;
+	}
+	if (!is_flush && is_parallel &&
+	    log->block_count < log->compression_threads)
+		return 0;
+	return xlog_write_blocks(log);
+}
+
+/* }}} */
+
 /*
  * Add a row to a log and possibly flush the log.
  *
@@ -1335,7 +1941,7 @@ xlog_write_row(struct xlog *log, const struct xrow_header *packet)
 	size_t row_size = obuf_size(&log->obuf) - page_offset;
 	if (log->is_autocommit &&
 	    obuf_size(&log->obuf) >= XLOG_TX_AUTOCOMMIT_THRESHOLD &&
-	    xlog_tx_write(log) < 0)
+	    xlog_tx_submit(log, false) < 0)
 		return -1;
 
 	return row_size;
@@ -1365,7 +1971,7 @@ xlog_tx_commit(struct xlog *log)
 {
 	log->is_autocommit = true;
 	if (obuf_size(&log->obuf) >= XLOG_TX_AUTOCOMMIT_THRESHOLD) {
-		return xlog_tx_write(log);
+		return xlog_tx_submit(log, false);
 	}
 	return 0;
 }
@@ -1389,9 +1995,97 @@ ssize_t
 xlog_flush(struct xlog *log)
 {
 	assert(log->is_autocommit);
-	if (log->obuf.used == 0)
+	if (log->obuf.used == 0 && log->block_count == 0)
 		return 0;
-	return xlog_tx_write(log);
+	return xlog_tx_submit(log, true);
+}
+
+int
+xlog_index_add(struct xlog *log, const struct vclock *vclock)
+{
+	assert(log->obuf.used == 0 && log->block_count == 0);
+	off_t last = log->index_count > 0 ?
+		     log->index[log->index_count - 1].offset : 0;
+	if (log->offset < last + XLOG_INDEX_STEP)
+		return 0;
+	if (log->index_count == log->index_capacity) {
+		int capacity = log->index_capacity > 0 ?
+			       2 * log->index_capacity : 16;
+		size_t size = capacity * sizeof(*log->index);
+		struct xlog_index_entry *index = realloc(log->index, size);
+		if (index == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "xlog index");
+			return -1;
+		}
+		log->index = index;
+		log->index_capacity = capacity;
+	}
+	struct xlog_index_entry *entry = &log->index[log->index_count++];
+	entry->offset = log->offset;
+	vclock_copy(&entry->vclock, vclock);
+	return 0;
+}
+
+/**
+ * Save the sparse index of a log closed with @size bytes
+ * in the file. The index is written to a temporary file,
+ * which is renamed when complete.
+ */
+static int
+xlog_write_index(struct xlog *log, off_t size)
+{
+	char path[PATH_MAX];
+	char tmp_path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s%s", log->filename,
+		 xlog_index_suffix);
+	snprintf(tmp_path, sizeof(tmp_path), "%s%s", path,
+		 inprogress_suffix);
+
+	struct ibuf buf;
+	ibuf_create(&buf, &cord()->slabc, 16 * 1024);
+	int rc = -1;
+	int fd = -1;
+	/* An offset, a vclock and separators. */
+	enum { LINE_LEN_MAX = VCLOCK_STR_LEN_MAX + 32 };
+	char *pos = ibuf_reserve(&buf, LINE_LEN_MAX);
+	if (pos == NULL)
+		goto oom;
+	ibuf_alloc(&buf, snprintf(pos, LINE_LEN_MAX, "%sSize: %lld\n",
+				  xlog_index_header, (long long)size));
+	for (int i = 0; i < log->index_count; i++) {
+		struct xlog_index_entry *entry = &log->index[i];
+		pos = ibuf_reserve(&buf, LINE_LEN_MAX);
+		if (pos == NULL)
+			goto oom;
+		ibuf_alloc(&buf, snprintf(pos, LINE_LEN_MAX, "%lld %s\n",
+					  (long long)entry->offset,
+					  vclock_to_string(&entry->vclock)));
+	}
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to create file '%s'", tmp_path);
+		goto out;
+	}
+	if (fio_writen(fd, buf.rpos, ibuf_used(&buf)) != 0) {
+		diag_set(SystemError, "failed to write file '%s'", tmp_path);
+		goto out;
+	}
+	if (rename(tmp_path, path) != 0) {
+		diag_set(SystemError, "failed to rename '%s' file", tmp_path);
+		goto out;
+	}
+	rc = 0;
+	goto out;
+oom:
+	diag_set(OutOfMemory, LINE_LEN_MAX, "ibuf", "xlog index");
+out:
+	if (fd >= 0) {
+		close(fd);
+		if (rc != 0)
+			unlink(tmp_path);
+	}
+	ibuf_destroy(&buf);
+	return rc;
 }
 
 static int
@@ -1443,6 +2137,20 @@ xlog_write_eof(struct xlog *l)
 		return -1;
 	}
 
+	if (l->direct_buf != NULL) {
+		/* Write the marker and cut off the padding. */
+		struct iovec iov;
+		iov.iov_base = (void *)&eof_marker;
+		iov.iov_len = sizeof(eof_marker);
+		if (xlog_writev_direct(l, &iov, 1) < 0)
+			return -1;
+		if (ftruncate(l->fd, l->offset + sizeof(eof_marker)) < 0) {
+			diag_set(SystemError, "ftruncate() failed");
+			return -1;
+		}
+		return 0;
+	}
+
 	if (fio_writen(l->fd, &eof_marker, sizeof(eof_marker)) < 0) {
 		diag_set(SystemError, "write() failed");
 		return -1;
@@ -1458,6 +2166,12 @@ xlog_close(struct xlog *l, bool reuse_fd)
 		say_error("%s: failed to write EOF marker: %s", l->filename,
 			  diag_last_error(diag_get())->errmsg);
 
+	/* The index is optional, readers can do without it. */
+	if (rc == 0 && l->index_count > 0 && !l->is_inprogress &&
+	    xlog_write_index(l, l->offset + sizeof(eof_marker)) != 0)
+		say_warn("%s: failed to write index: %s", l->filename,
+			 diag_last_error(diag_get())->errmsg);
+
 	/*
 	 * Sync the file before closing, since
 	 * otherwise we can end up with a partially
@@ -1847,6 +2561,40 @@ xlog_cursor_find_tx_magic(struct xlog_cursor *i)
 	return 0;
 }
 
+/**
+ * A log written with direct I/O is padded with zeros up to
+ * a page boundary, the padding is overwritten by the next
+ * block. Check if the cursor is positioned at the padding.
+ * The buffered data may be stale, so it's reread from the
+ * file, and dropped if it's the padding so that the blocks
+ * written over it are read later.
+ *
+ * @retval -1 error
+ * @retval  0 not padding
+ * @retval  1 padding, the end of written data
+ */
+static int
+xlog_cursor_check_padding(struct xlog_cursor *i)
+{
+	if (i->fd < 0)
+		return 0;
+	off_t pos = xlog_cursor_pos(i);
+	size_t size = XLOG_DIRECT_IO_ALIGN - pos % XLOG_DIRECT_IO_ALIGN;
+	ibuf_reset(&i->rbuf);
+	i->read_offset = pos;
+	/* Padding is always followed by the end of file. */
+	int rc = xlog_cursor_ensure(i, size + 1);
+	if (rc <= 0)
+		return rc;
+	for (const char *p = i->rbuf.rpos; p < i->rbuf.wpos; p++) {
+		if (*p != 0)
+			return 0;
+	}
+	ibuf_reset(&i->rbuf);
+	i->read_offset = pos;
+	return 1;
+}
+
 int
 xlog_cursor_next_tx(struct xlog_cursor *i)
 {
@@ -1859,6 +2607,16 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		return -1;
 	if (rc > 0)
 		return 1;
+	if (load_u32(i->rbuf.rpos) == 0) {
+		rc = xlog_cursor_check_padding(i);
+		if (rc != 0)
+			return rc;
+		rc = xlog_cursor_ensure(i, sizeof(log_magic_t));
+		if (rc < 0)
+			return -1;
+		if (rc > 0)
+			return 1;
+	}
 	if (load_u32(i->rbuf.rpos) == eof_marker) {
 		/* eof marker found */
 		goto eof_found;
@@ -1913,6 +2671,117 @@ xlog_cursor_next_row(struct xlog_cursor *cursor, struct xrow_header *xrow)
 	return rc;
 }
 
+char *
+xlog_cursor_copy_tx(struct xlog_cursor *cursor, size_t *size)
+{
+	assert(cursor->state == XLOG_CURSOR_TX);
+	struct ibuf *rows = &cursor->tx_cursor.rows;
+	*size = ibuf_used(rows);
+	char *buf = (char *)malloc(*size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, *size, "malloc", "xlog tx rows");
+		return NULL;
+	}
+	memcpy(buf, rows->rpos, *size);
+	xlog_tx_cursor_destroy(&cursor->tx_cursor);
+	cursor->state = XLOG_CURSOR_ACTIVE;
+	return buf;
+}
+
+void
+xlog_cursor_seek(struct xlog_cursor *cursor, off_t offset)
+{
+	assert(cursor->fd >= 0);
+	assert(cursor->state == XLOG_CURSOR_ACTIVE ||
+	       cursor->state == XLOG_CURSOR_TX);
+	if (cursor->state == XLOG_CURSOR_TX)
+		xlog_tx_cursor_destroy(&cursor->tx_cursor);
+	ibuf_reset(&cursor->rbuf);
+	cursor->read_offset = offset;
+	cursor->state = XLOG_CURSOR_ACTIVE;
+}
+
+int
+xlog_cursor_seek_vclock(struct xlog_cursor *cursor,
+			const struct vclock *vclock)
+{
+	assert(cursor->state == XLOG_CURSOR_ACTIVE);
+	if (cursor->fd < 0)
+		return 0;
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s%s", cursor->name,
+		 xlog_index_suffix);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		if (errno == ENOENT)
+			return 0;
+		diag_set(SystemError, "failed to open file '%s'", path);
+		return -1;
+	}
+	int rc = -1;
+	char *buf = NULL;
+	struct stat st, log_st;
+	if (fstat(fd, &st) != 0 || fstat(cursor->fd, &log_st) != 0) {
+		diag_set(SystemError, "failed to stat file '%s'", path);
+		goto out;
+	}
+	buf = (char *)malloc(st.st_size + 1);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, st.st_size + 1, "malloc", "xlog index");
+		goto out;
+	}
+	if (fio_pread(fd, buf, st.st_size, 0) != st.st_size) {
+		diag_set(SystemError, "failed to read file '%s'", path);
+		goto out;
+	}
+	buf[st.st_size] = '\0';
+
+	size_t header_len = strlen(xlog_index_header);
+	char *line = buf + header_len;
+	long long size;
+	if (strncmp(buf, xlog_index_header, header_len) != 0 ||
+	    sscanf(line, "Size: %lld\n", &size) != 1)
+		goto invalid;
+	/*
+	 * The log file is appended to when it's reopened
+	 * after restart, ignore the index then.
+	 */
+	if (size != (long long)log_st.st_size) {
+		rc = 0;
+		goto out;
+	}
+	off_t offset = xlog_cursor_pos(cursor);
+	while ((line = strchr(line, '\n')) != NULL && *(++line) != '\0') {
+		char *end = strchr(line, '\n');
+		if (end == NULL)
+			goto invalid;
+		*end = '\0';
+		char *pos;
+		long long entry_offset = strtoll(line, &pos, 10);
+		struct vclock entry_vclock;
+		vclock_create(&entry_vclock);
+		if (pos == line || *pos != ' ' ||
+		    entry_offset <= 0 || entry_offset > size ||
+		    vclock_from_string(&entry_vclock, pos + 1) != 0)
+			goto invalid;
+		*end = '\n';
+		int cmp = vclock_compare(&entry_vclock, vclock);
+		if (cmp != 0 && cmp != -1)
+			break;
+		offset = MAX(offset, (off_t)entry_offset);
+	}
+	if (offset > xlog_cursor_pos(cursor))
+		xlog_cursor_seek(cursor, offset);
+	rc = 0;
+	goto out;
+invalid:
+	diag_set(XlogError, "%s: invalid xlog index", path);
+out:
+	free(buf);
+	close(fd);
+	return rc;
+}
+
 int
 xlog_cursor_next(struct xlog_cursor *cursor,
 		 struct xrow_header *xrow, bool force_recovery)
@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <sys/stat.h>
+#include <pthread.h>
 #include "uuid/tt_uuid.h"
 #include "vclock.h"
 
@@ -44,6 +45,7 @@
 
 struct iovec;
 struct xrow_header;
+struct xlog_block;
 
 #if defined(__cplusplus)
 extern "C" {
@@ -74,6 +76,27 @@ enum log_suffix { NONE, INPROGRESS };
  */
 #define inprogress_suffix ".inprogress"
 
+enum {
+	/** Default level of zstd compression of xlog blocks. */
+	XLOG_COMPRESSION_LEVEL_DEFAULT = 3,
+	/** Max level of zstd compression, see ZSTD_maxCLevel(). */
+	XLOG_COMPRESSION_LEVEL_MAX = 22,
+	/** Max number of xlog blocks compressed in parallel. */
+	XLOG_COMPRESSION_THREADS_MAX = 32,
+	/**
+	 * Alignment of file offsets, sizes and memory buffers
+	 * of writes done with direct I/O.
+	 */
+	XLOG_DIRECT_IO_ALIGN = 4096,
+	/** Size of the buffer used for writes with direct I/O. */
+	XLOG_DIRECT_IO_BUF_SIZE = 1024 * 1024,
+	/**
+	 * Min distance in bytes between entries of the sparse
+	 * index of an xlog file, see xlog_index_add().
+	 */
+	XLOG_INDEX_STEP = 1024 * 1024,
+};
+
 /**
  * A handle for a data directory with write ahead logs, snapshots,
  * vylogs.
@@ -140,6 +163,21 @@ struct xdir {
 	 * corresponding file cache will be marked as free
 	 */
 	uint64_t sync_interval;
+	/**
+	 * Level of zstd compression of the files written to
+	 * this directory, 0 disables compression.
+	 */
+	int compression_level;
+	/**
+	 * How many blocks of rows may be compressed in
+	 * parallel, see struct xlog.
+	 */
+	int compression_threads;
+	/**
+	 * Write the files created in this directory bypassing
+	 * the page cache, see xlog_set_direct_io().
+	 */
+	bool direct_io;
 };
 
 /**
@@ -286,6 +324,13 @@ struct xlog_meta {
 	 * directory for missing WALs.
 	 */
 	struct vclock prev_vclock;
+	/**
+	 * Text file header: vector clock of the snapshot this
+	 * file is a delta of. Only set for delta snapshots, which
+	 * don't contain data of spaces unchanged since the base
+	 * snapshot was taken.
+	 */
+	struct vclock base_vclock;
 };
 
 /**
@@ -302,6 +347,17 @@ xlog_meta_create(struct xlog_meta *meta, const char *filetype,
 
 /* }}} */
 
+/**
+ * An entry of the sparse index of a log file: all rows stored
+ * in the file before @offset are not newer than @vclock.
+ */
+struct xlog_index_entry {
+	/** Offset of a tx boundary in the file. */
+	off_t offset;
+	/** Vclock of the rows written before @offset. */
+	struct vclock vclock;
+};
+
 /**
  * A single log file - a snapshot, a vylog or a write ahead log.
  */
@@ -385,6 +441,68 @@ struct xlog {
 	uint64_t rate_limit;
 	/** Time when xlog wast synced last time */
 	double sync_time;
+	/**
+	 * The xlog which file this one appends blocks to,
+	 * NULL unless created with xlog_create_shared().
+	 */
+	struct xlog *parent;
+	/** Serializes writes of all xlogs sharing the file. */
+	pthread_mutex_t *write_lock;
+	/** Signaled when a reservation of rows is written. */
+	pthread_cond_t *write_cond;
+	/**
+	 * Sequence number of the reservation of rows held by
+	 * a shared writer, -1 if there's none.
+	 * @sa xlog_shared_reserve().
+	 */
+	int64_t ticket;
+	/** The number of reserved rows not written yet. */
+	int64_t reserved_rows;
+	/*
+	 * The state of reservations of the shared writers kept
+	 * by the parent xlog and protected by @write_lock: the
+	 * number of rows reserved but not written yet, the
+	 * sequence number of the next reservation and the one
+	 * allowed to be written.
+	 */
+	int64_t pending_rows;
+	int64_t next_ticket;
+	int64_t write_ticket;
+	/**
+	 * Level of zstd compression of blocks of rows,
+	 * 0 disables compression.
+	 */
+	int compression_level;
+	/**
+	 * If greater than 1, full blocks of rows aren't written
+	 * one by one, but are kept in @blocks until there are
+	 * that many of them or the log is flushed. Then the
+	 * blocks are compressed in parallel by coio threads and
+	 * written at once.
+	 */
+	int compression_threads;
+	/** Blocks of rows waiting to be compressed and written. */
+	struct xlog_block *blocks;
+	/** Number of used blocks in @blocks. */
+	int block_count;
+	/**
+	 * Aligned buffer for writes with direct I/O, NULL if
+	 * the file is written through the page cache. Starts
+	 * with the last incomplete page of the file, which is
+	 * rewritten along with the next block.
+	 */
+	char *direct_buf;
+	/** Size of the last incomplete page in @direct_buf. */
+	size_t direct_tail;
+	/**
+	 * Sparse index of the file, saved next to it when the
+	 * file is closed, see xlog_index_add().
+	 */
+	struct xlog_index_entry *index;
+	/** Number of entries in @index. */
+	int index_count;
+	/** Number of entries allocated for @index. */
+	int index_capacity;
 };
 
 /**
@@ -418,6 +536,17 @@ int
 xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		 const struct vclock *vclock);
 
+/**
+ * Same as xdir_create_xlog(), but mark the new file as a delta
+ * of the file with vclock @base_vclock, i.e. a file that lacks
+ * some data, which must be looked up in the base file instead.
+ * Used for incremental memtx checkpoints.
+ */
+int
+xdir_create_delta_xlog(struct xdir *dir, struct xlog *xlog,
+		       const struct vclock *vclock,
+		       const struct vclock *base_vclock);
+
 /**
  * Create new xlog writer based on fd.
  * @param fd            file descriptor
@@ -482,6 +611,21 @@ xlog_rename(struct xlog *l);
 ssize_t
 xlog_fallocate(struct xlog *log, size_t size);
 
+/**
+ * Switch a log open for writing to direct I/O (O_DIRECT):
+ * blocks are copied to an aligned buffer and written in
+ * whole pages, the last page is padded with zeros, which
+ * are overwritten by the next write and truncated when the
+ * log is closed. Readers take the padding for the end of
+ * the file.
+ *
+ * Returns -1 on error and sets diag. If the OS or the file
+ * system doesn't support direct I/O, logs a warning and
+ * returns 0, the log is written through the page cache then.
+ */
+int
+xlog_set_direct_io(struct xlog *log);
+
 /**
  * Write a row to xlog, 
  *
@@ -520,6 +664,23 @@ xlog_tx_rollback(struct xlog *log);
 ssize_t
 xlog_flush(struct xlog *log);
 
+/**
+ * Add an entry to the sparse index of a log: the rows written
+ * so far are not newer than @vclock. Must be called at a tx
+ * boundary, after xlog_flush(). Entries closer than
+ * XLOG_INDEX_STEP bytes to the previous one are dropped.
+ *
+ * The index is written to the file with the log name and
+ * ".index" suffix when the log is closed and is used by
+ * xlog_cursor_seek_vclock() to skip the rows a reader
+ * doesn't need without decoding them.
+ *
+ * @retval 0 success
+ * @retval -1 error
+ */
+int
+xlog_index_add(struct xlog *log, const struct vclock *vclock);
+
 
 /**
  * Sync a log file. The exact action is defined
@@ -540,6 +701,53 @@ xlog_sync(struct xlog *l);
 int
 xlog_close(struct xlog *l, bool reuse_fd);
 
+/**
+ * Create a writer appending to the file of another xlog.
+ * The writer accumulates and compresses rows on its own, but
+ * each complete block is written to the file of @a parent
+ * under @a write_lock, so several threads can write the same
+ * file in parallel. Blocks written by different writers are
+ * interleaved in the file, while the order of rows written
+ * by the same writer is preserved. The sync interval and the
+ * write rate limit of @a parent apply to all its writers.
+ * @a write_cond is used to write reserved rows in order,
+ * see xlog_shared_reserve().
+ *
+ * Must be called in the thread that is going to use
+ * the writer. The parent must not be written to until all
+ * its writers are closed.
+ *
+ * @retval 0 success
+ * @retval -1 error
+ */
+int
+xlog_create_shared(struct xlog *xlog, struct xlog *parent,
+		   pthread_mutex_t *write_lock, pthread_cond_t *write_cond);
+
+/**
+ * Reserve @a count rows of the file of a shared writer.
+ * The next @a count rows of the writer go to the file
+ * right after the rows reserved before them by all writers
+ * of the file, so the caller may number them knowing the
+ * returned number of rows preceding them. Until the reserved
+ * rows are written, blocks of reservations made later wait.
+ * The writer must write and flush all the reserved rows
+ * before making another reservation.
+ *
+ * @return the number of rows in the file before the
+ *         reserved ones
+ */
+int64_t
+xlog_shared_reserve(struct xlog *xlog, int64_t count);
+
+/**
+ * Free a writer created with xlog_create_shared().
+ * Rows not flushed with xlog_flush() are discarded,
+ * and so are the rest of its reservation.
+ */
+void
+xlog_close_shared(struct xlog *xlog);
+
 /**
  * atfork() handler function to close the log pointed
  * at by xlog in the child.
@@ -754,6 +962,42 @@ int
 xlog_cursor_next(struct xlog_cursor *cursor,
 		 struct xrow_header *xrow, bool force_recovery);
 
+/**
+ * Copy the rows of the current xlog tx to a malloc'ed buffer
+ * and finish the tx. Unlike the cursor buffers, the copy may be
+ * passed to and freed in another thread.
+ *
+ * @param cursor cursor positioned at a tx
+ * @param[out] size size of the rows
+ * @retval buffer with the rows, must be freed with free()
+ * @retval NULL error, check diag
+ */
+char *
+xlog_cursor_copy_tx(struct xlog_cursor *cursor, size_t *size);
+
+/**
+ * Reposition a file cursor at @a offset, discarding the
+ * buffered data and the current tx. The offset must point
+ * to a tx boundary, e.g. one returned by xlog_cursor_pos()
+ * of another cursor opened for the same file.
+ */
+void
+xlog_cursor_seek(struct xlog_cursor *cursor, off_t offset);
+
+/**
+ * Position a cursor just opened for a file past the rows not
+ * newer than @vclock using the sparse index of the file, see
+ * xlog_index_add(). Some of the rows may still need to be
+ * skipped by the reader. Does nothing if the file has no
+ * index or the index is stale.
+ *
+ * @retval 0 success
+ * @retval -1 error, e.g. the index is corrupted
+ */
+int
+xlog_cursor_seek_vclock(struct xlog_cursor *cursor,
+			const struct vclock *vclock);
+
 /**
  * Move to the next xlog tx
  *
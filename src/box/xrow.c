@@ -548,6 +548,36 @@ iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 	memcpy(pos + IPROTO_HEADER_LEN, &body, sizeof(body));
 }
 
+/**
+ * Decode IPROTO_OPTIONS of the EXECUTE request. Old clients send
+ * an empty array here, so everything but a map is ignored.
+ */
+static int
+xrow_decode_sql_options(const char *data, struct sql_request *request)
+{
+	if (mp_typeof(*data) != MP_MAP)
+		return 0;
+	uint32_t map_size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if (mp_typeof(*data) != MP_UINT) {
+			mp_next(&data);         /* skip the key */
+			mp_next(&data);         /* skip the value */
+			continue;
+		}
+		if (mp_decode_uint(&data) != IPROTO_SQL_OPTION_CHUNK_SIZE) {
+			mp_next(&data);         /* skip the value */
+			continue;
+		}
+		if (mp_typeof(*data) != MP_UINT)
+			return -1;
+		uint64_t chunk_size = mp_decode_uint(&data);
+		if (chunk_size > UINT32_MAX)
+			return -1;
+		request->chunk_size = chunk_size;
+	}
+	return 0;
+}
+
 int
 xrow_decode_sql(const struct xrow_header *row, struct sql_request *request)
 {
@@ -570,9 +600,11 @@ error:
 	uint32_t map_size = mp_decode_map(&data);
 	request->sql_text = NULL;
 	request->bind = NULL;
+	request->chunk_size = 0;
 	for (uint32_t i = 0; i < map_size; ++i) {
 		uint8_t key = *data;
-		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT) {
+		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT &&
+		    key != IPROTO_OPTIONS) {
 			mp_check(&data, end);   /* skip the key */
 			mp_check(&data, end);   /* skip the value */
 			continue;
@@ -580,10 +612,14 @@ error:
 		const char *value = ++data;     /* skip the key */
 		if (mp_check(&data, end) != 0)  /* check the value */
 			goto error;
-		if (key == IPROTO_SQL_BIND)
+		if (key == IPROTO_SQL_BIND) {
 			request->bind = value;
-		else
+		} else if (key == IPROTO_OPTIONS) {
+			if (xrow_decode_sql_options(value, request) != 0)
+				goto error;
+		} else {
 			request->sql_text = value;
+		}
 	}
 	if (request->sql_text == NULL) {
 		xrow_on_decode_err(row->body[0].iov_base, end, ER_MISSING_REQUEST_FIELD,
@@ -595,6 +631,18 @@ error:
 	return 0;
 }
 
+void
+iproto_reply_sql_chunk(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+		       uint32_t schema_version, uint32_t count)
+{
+	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
+	iproto_header_encode(pos, IPROTO_CHUNK, sync, schema_version,
+			     obuf_size(buf) - svp->used - IPROTO_HEADER_LEN);
+	struct iproto_body_bin body = iproto_body_bin;
+	body.v_data_len = mp_bswap_u32(count);
+	memcpy(pos + IPROTO_HEADER_LEN, &body, sizeof(body));
+}
+
 void
 iproto_reply_sql(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		 uint32_t schema_version)
@@ -708,6 +756,35 @@ done:
 	return 0;
 }
 
+int
+xrow_decode_space_id(const struct xrow_header *row, uint32_t *space_id)
+{
+	if (row->bodycnt == 0)
+		goto error;
+	const char *data = (const char *) row->body[0].iov_base;
+	const char *end = data + row->body[0].iov_len;
+	const char *tmp = data;
+	if (mp_check(&tmp, end) != 0 || mp_typeof(*data) != MP_MAP)
+		goto error;
+	uint32_t size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < size; i++) {
+		if (mp_typeof(*data) != MP_UINT) {
+			mp_next(&data); /* key */
+			mp_next(&data); /* value */
+			continue;
+		}
+		uint64_t key = mp_decode_uint(&data);
+		if (key == IPROTO_SPACE_ID && mp_typeof(*data) == MP_UINT) {
+			*space_id = mp_decode_uint(&data);
+			return 0;
+		}
+		mp_next(&data);
+	}
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "missing space id");
+	return -1;
+}
+
 static int
 request_snprint(char *buf, int size, const struct request *request)
 {
@@ -1133,17 +1210,25 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock)
+		      const struct vclock *vclock, uint32_t compression,
+		      const uint32_t *space_filter, uint32_t space_filter_size)
 {
 	memset(row, 0, sizeof(*row));
-	size_t size = XROW_BODY_LEN_MAX + mp_sizeof_vclock(vclock);
+	size_t size = XROW_BODY_LEN_MAX + mp_sizeof_vclock(vclock) +
+		      mp_sizeof_array(space_filter_size) +
+		      space_filter_size * mp_sizeof_uint(UINT32_MAX);
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
 		diag_set(OutOfMemory, size, "region_alloc", "buf");
 		return -1;
 	}
+	uint32_t map_size = 4;
+	if (compression != IPROTO_COMPRESSION_NONE)
+		map_size++;
+	if (space_filter != NULL)
+		map_size++;
 	char *data = buf;
-	data = mp_encode_map(data, 4);
+	data = mp_encode_map(data, map_size);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -1152,6 +1237,16 @@ xrow_encode_subscribe(struct xrow_header *row,
 	data = mp_encode_vclock(data, vclock);
 	data = mp_encode_uint(data, IPROTO_SERVER_VERSION);
 	data = mp_encode_uint(data, tarantool_version_id());
+	if (compression != IPROTO_COMPRESSION_NONE) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
+	if (space_filter != NULL) {
+		data = mp_encode_uint(data, IPROTO_SPACE_FILTER);
+		data = mp_encode_array(data, space_filter_size);
+		for (uint32_t i = 0; i < space_filter_size; i++)
+			data = mp_encode_uint(data, space_filter[i]);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1160,10 +1255,29 @@ xrow_encode_subscribe(struct xrow_header *row,
 	return 0;
 }
 
+/**
+ * Check that IPROTO_SPACE_FILTER is an array of space ids
+ * and go past it.
+ */
+static int
+xrow_skip_space_filter(const char **data)
+{
+	if (mp_typeof(**data) != MP_ARRAY)
+		return -1;
+	uint32_t count = mp_decode_array(data);
+	for (uint32_t i = 0; i < count; i++) {
+		if (mp_typeof(**data) != MP_UINT ||
+		    mp_decode_uint(data) > UINT32_MAX)
+			return -1;
+	}
+	return 0;
+}
+
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id)
+		      uint32_t *version_id, uint32_t *compression,
+		      uint32_t *join_mode, const char **space_filter)
 {
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
@@ -1226,6 +1340,36 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 			}
 			*version_id = mp_decode_uint(&d);
 			break;
+		case IPROTO_COMPRESSION:
+			if (compression == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_UINT) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid COMPRESSION");
+				return -1;
+			}
+			*compression = mp_decode_uint(&d);
+			break;
+		case IPROTO_JOIN_MODE:
+			if (join_mode == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_UINT) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid JOIN_MODE");
+				return -1;
+			}
+			*join_mode = mp_decode_uint(&d);
+			break;
+		case IPROTO_SPACE_FILTER:
+			if (space_filter == NULL)
+				goto skip;
+			*space_filter = d;
+			if (xrow_skip_space_filter(&d) != 0) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid SPACE_FILTER");
+				return -1;
+			}
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
@@ -1234,7 +1378,8 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 }
 
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 uint32_t join_mode)
 {
 	memset(row, 0, sizeof(*row));
 
@@ -1245,10 +1390,14 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 1);
+	data = mp_encode_map(data, join_mode != IPROTO_JOIN_MODE_ROWS ? 2 : 1);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
 	/* Greet the remote replica with our replica UUID */
 	data = xrow_encode_uuid(data, instance_uuid);
+	if (join_mode != IPROTO_JOIN_MODE_ROWS) {
+		data = mp_encode_uint(data, IPROTO_JOIN_MODE);
+		data = mp_encode_uint(data, join_mode);
+	}
 	assert(data <= buf + size);
 
 	row->body[0].iov_base = buf;
@@ -1282,27 +1431,145 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 	return 0;
 }
 
+int
+xrow_encode_join_response(struct xrow_header *row, const struct vclock *vclock,
+			  uint32_t join_mode)
+{
+	memset(row, 0, sizeof(*row));
+	uint32_t map_size = join_mode != IPROTO_JOIN_MODE_ROWS ? 2 : 1;
+	size_t size = mp_sizeof_map(map_size) +
+		      mp_sizeof_uint(IPROTO_VCLOCK) + mp_sizeof_vclock(vclock) +
+		      mp_sizeof_uint(IPROTO_JOIN_MODE) +
+		      mp_sizeof_uint(join_mode);
+	char *buf = (char *) region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, map_size);
+	data = mp_encode_uint(data, IPROTO_VCLOCK);
+	data = mp_encode_vclock(data, vclock);
+	if (join_mode != IPROTO_JOIN_MODE_ROWS) {
+		data = mp_encode_uint(data, IPROTO_JOIN_MODE);
+		data = mp_encode_uint(data, join_mode);
+	}
+	assert(data <= buf + size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	row->type = IPROTO_OK;
+	return 0;
+}
+
+int
+xrow_encode_file(struct xrow_header *row, const char *name, uint64_t size)
+{
+	memset(row, 0, sizeof(*row));
+	uint32_t name_len = strlen(name);
+	size_t buf_size = mp_sizeof_map(2) +
+			  mp_sizeof_uint(IPROTO_FILE_NAME) +
+			  mp_sizeof_str(name_len) +
+			  mp_sizeof_uint(IPROTO_FILE_SIZE) +
+			  mp_sizeof_uint(size);
+	char *buf = (char *) region_alloc(&fiber()->gc, buf_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, buf_size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, 2);
+	data = mp_encode_uint(data, IPROTO_FILE_NAME);
+	data = mp_encode_str(data, name, name_len);
+	data = mp_encode_uint(data, IPROTO_FILE_SIZE);
+	data = mp_encode_uint(data, size);
+	assert(data <= buf + buf_size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	row->type = IPROTO_FILE;
+	return 0;
+}
+
+int
+xrow_decode_file(struct xrow_header *row, const char **name,
+		 uint32_t *name_len, uint64_t *size)
+{
+	if (row->bodycnt == 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
+		return -1;
+	}
+	assert(row->bodycnt == 1);
+	const char * const data = (const char *) row->body[0].iov_base;
+	const char *end = data + row->body[0].iov_len;
+	const char *d = data;
+	if (mp_check(&d, end) != 0 || mp_typeof(*data) != MP_MAP) {
+		xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+				   "request body");
+		return -1;
+	}
+	*name = NULL;
+	*size = 0;
+	d = data;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		uint64_t key = mp_decode_uint(&d);
+		switch (key) {
+		case IPROTO_FILE_NAME:
+			if (mp_typeof(*d) != MP_STR)
+				goto error;
+			*name = mp_decode_str(&d, name_len);
+			break;
+		case IPROTO_FILE_SIZE:
+			if (mp_typeof(*d) != MP_UINT)
+				goto error;
+			*size = mp_decode_uint(&d);
+			break;
+		default:
+			mp_next(&d); /* value */
+		}
+	}
+	if (*name != NULL)
+		return 0;
+error:
+	xrow_on_decode_err(data, end, ER_INVALID_MSGPACK, "invalid FILE");
+	return -1;
+}
+
 int
 xrow_encode_subscribe_response(struct xrow_header *row,
 			       const struct tt_uuid *replicaset_uuid,
-			       const struct vclock *vclock)
+			       const struct vclock *vclock,
+			       uint32_t compression)
 {
 	memset(row, 0, sizeof(*row));
-	size_t size = mp_sizeof_map(2) +
+	uint32_t map_size = compression != IPROTO_COMPRESSION_NONE ? 3 : 2;
+	size_t size = mp_sizeof_map(map_size) +
 		      mp_sizeof_uint(IPROTO_VCLOCK) + mp_sizeof_vclock(vclock) +
 		      mp_sizeof_uint(IPROTO_CLUSTER_UUID) +
-		      mp_sizeof_str(UUID_STR_LEN);
+		      mp_sizeof_str(UUID_STR_LEN) +
+		      mp_sizeof_uint(IPROTO_COMPRESSION) +
+		      mp_sizeof_uint(compression);
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
 		diag_set(OutOfMemory, size, "region_alloc", "buf");
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 2);
+	data = mp_encode_map(data, map_size);
 	data = mp_encode_uint(data, IPROTO_VCLOCK);
 	data = mp_encode_vclock(data, vclock);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
+	if (compression != IPROTO_COMPRESSION_NONE) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
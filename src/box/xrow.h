@@ -192,6 +192,29 @@ int
 xrow_decode_dml(struct xrow_header *xrow, struct request *request,
 		uint64_t key_map);
 
+/**
+ * Extract the space id from a DML request without decoding
+ * the rest of it.
+ * @param row request header.
+ * @param[out] space_id.
+ * @retval 0 on success
+ * @retval -1 on error
+ */
+int
+xrow_decode_space_id(const struct xrow_header *row, uint32_t *space_id);
+
+/**
+ * Compare two space ids. Suitable for qsort() and bsearch()
+ * over an array of uint32_t.
+ */
+static inline int
+xrow_cmp_space_id(const void *a, const void *b)
+{
+	uint32_t id_a = *(const uint32_t *) a;
+	uint32_t id_b = *(const uint32_t *) b;
+	return id_a < id_b ? -1 : id_a > id_b;
+}
+
 /**
  * Encode the request fields to iovec using region_alloc().
  * @param request request to encode
@@ -297,6 +320,11 @@ xrow_encode_vote(struct xrow_header *row);
  * @param replicaset_uuid Replica set uuid.
  * @param instance_uuid Instance uuid.
  * @param vclock Replication clock.
+ * @param compression Requested compression of the stream,
+ *        see enum iproto_compression.
+ * @param space_filter Ids of the spaces to get rows of,
+ *        NULL if all spaces are replicated.
+ * @param space_filter_size Number of ids in @a space_filter.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -305,7 +333,8 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock);
+		      const struct vclock *vclock, uint32_t compression,
+		      const uint32_t *space_filter, uint32_t space_filter_size);
 
 /**
  * Decode SUBSCRIBE command.
@@ -314,6 +343,10 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] instance_uuid.
  * @param[out] vclock.
  * @param[out] version_id.
+ * @param[out] compression. Left intact if not present.
+ * @param[out] join_mode. Left intact if not present.
+ * @param[out] space_filter MsgPack array of space ids, points
+ *        to the row body. Left intact if not present.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -321,33 +354,97 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id);
+		      uint32_t *version_id, uint32_t *compression,
+		      uint32_t *join_mode, const char **space_filter);
 
 /**
  * Encode JOIN command.
  * @param[out] row Row to encode into.
  * @param instance_uuid.
+ * @param join_mode Requested way to send the initial data,
+ *        see enum iproto_join_mode.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
  */
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid);
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 uint32_t join_mode);
 
 /**
  * Decode JOIN command.
  * @param row Row to decode.
  * @param[out] instance_uuid.
+ * @param[out] join_mode. Left intact if not present.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
  */
 static inline int
-xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 uint32_t *join_mode)
 {
-	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL,
+				     NULL, join_mode, NULL);
 }
 
+/**
+ * Encode a response to JOIN command.
+ * @param row[out] Row to encode into.
+ * @param vclock Vclock of the checkpoint sent to the replica.
+ * @param join_mode Way the initial data is sent,
+ *        see enum iproto_join_mode.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_response(struct xrow_header *row, const struct vclock *vclock,
+			  uint32_t join_mode);
+
+/**
+ * Decode a response to JOIN command.
+ * @param row Row to decode.
+ * @param[out] vclock.
+ * @param[out] join_mode. Left intact if not present.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+static inline int
+xrow_decode_join_response(struct xrow_header *row, struct vclock *vclock,
+			  uint32_t *join_mode)
+{
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL,
+				     join_mode, NULL);
+}
+
+/**
+ * Encode the header of a file sent on initial join.
+ * @param row[out] Row to encode into.
+ * @param name Name of the file, without the directory.
+ * @param size Size of the file contents following the row.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_file(struct xrow_header *row, const char *name, uint64_t size);
+
+/**
+ * Decode the header of a file sent on initial join.
+ * @param row Row to decode.
+ * @param[out] name Name of the file, not zero-terminated.
+ * @param[out] name_len Length of the name.
+ * @param[out] size Size of the file contents following the row.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_file(struct xrow_header *row, const char **name,
+		 uint32_t *name_len, uint64_t *size);
+
 /**
  * Encode end of stream command (a response to JOIN command).
  * @param row[out] Row to encode into.
@@ -370,7 +467,8 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 static inline int
 xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL,
+				     NULL, NULL);
 }
 
 /**
@@ -378,6 +476,8 @@ xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
  * @param row[out] Row to encode into.
  * @param replicaset_uuid.
  * @param vclock.
+ * @param compression Compression of the stream which follows
+ *        the response, see enum iproto_compression.
  *
  * @retval 0 Success.
  * @retval -1 Memory error.
@@ -385,13 +485,15 @@ xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 int
 xrow_encode_subscribe_response(struct xrow_header *row,
 			      const struct tt_uuid *replicaset_uuid,
-			      const struct vclock *vclock);
+			      const struct vclock *vclock,
+			      uint32_t compression);
 
 /**
  * Decode a response to subscribe request.
  * @param row Row to decode.
  * @param[out] replicaset_uuid.
  * @param[out] vclock.
+ * @param[out] compression.
  *
  * @retval 0 Success.
  * @retval -1 Memory or format error.
@@ -399,9 +501,10 @@ xrow_encode_subscribe_response(struct xrow_header *row,
 static inline int
 xrow_decode_subscribe_response(struct xrow_header *row,
 			       struct tt_uuid *replicaset_uuid,
-			       struct vclock *vclock)
+			       struct vclock *vclock, uint32_t *compression)
 {
-	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL,
+				     compression, NULL, NULL);
 }
 
 /**
@@ -522,6 +625,11 @@ struct sql_request {
 	const char *sql_text;
 	/** MessagePack array of parameters. */
 	const char *bind;
+	/**
+	 * Number of rows to send in each IPROTO_CHUNK response,
+	 * 0 if the result set is not split.
+	 */
+	uint32_t chunk_size;
 };
 
 /**
@@ -535,6 +643,19 @@ struct sql_request {
 int
 xrow_decode_sql(const struct xrow_header *row, struct sql_request *request);
 
+/**
+ * Write the header of a part of an SQL result set, which is
+ * sent before the final response.
+ * @param buf Out buffer.
+ * @param svp Savepoint of the header beginning.
+ * @param sync Request sync.
+ * @param schema_version Schema version.
+ * @param count Count of rows in the part.
+ */
+void
+iproto_reply_sql_chunk(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+		       uint32_t schema_version, uint32_t count);
+
 /**
  * Write the SQL header.
  * @param buf Out buffer.
@@ -763,10 +884,13 @@ static inline void
 xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
-			 const struct vclock *vclock)
+			 const struct vclock *vclock, uint32_t compression,
+			 const uint32_t *space_filter,
+			 uint32_t space_filter_size)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock) != 0)
+				  vclock, compression, space_filter,
+				  space_filter_size) != 0)
 		diag_raise();
 }
 
@@ -775,27 +899,65 @@ static inline void
 xrow_decode_subscribe_xc(struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 		         struct tt_uuid *instance_uuid, struct vclock *vclock,
-			 uint32_t *replica_version_id)
+			 uint32_t *replica_version_id, uint32_t *compression,
+			 const char **space_filter)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, replica_version_id) != 0)
+				  vclock, replica_version_id, compression,
+				  NULL, space_filter) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_encode_join. */
 static inline void
 xrow_encode_join_xc(struct xrow_header *row,
-		    const struct tt_uuid *instance_uuid)
+		    const struct tt_uuid *instance_uuid, uint32_t join_mode)
 {
-	if (xrow_encode_join(row, instance_uuid) != 0)
+	if (xrow_encode_join(row, instance_uuid, join_mode) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_decode_join. */
 static inline void
-xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		    uint32_t *join_mode)
+{
+	if (xrow_decode_join(row, instance_uuid, join_mode) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_join_response. */
+static inline void
+xrow_encode_join_response_xc(struct xrow_header *row,
+			     const struct vclock *vclock, uint32_t join_mode)
+{
+	if (xrow_encode_join_response(row, vclock, join_mode) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_response. */
+static inline void
+xrow_decode_join_response_xc(struct xrow_header *row, struct vclock *vclock,
+			     uint32_t *join_mode)
+{
+	if (xrow_decode_join_response(row, vclock, join_mode) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_file. */
+static inline void
+xrow_encode_file_xc(struct xrow_header *row, const char *name, uint64_t size)
+{
+	if (xrow_encode_file(row, name, size) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_file. */
+static inline void
+xrow_decode_file_xc(struct xrow_header *row, const char **name,
+		    uint32_t *name_len, uint64_t *size)
 {
-	if (xrow_decode_join(row, instance_uuid) != 0)
+	if (xrow_decode_file(row, name, name_len, size) != 0)
 		diag_raise();
 }
 
@@ -819,9 +981,11 @@ xrow_decode_vclock_xc(struct xrow_header *row, struct vclock *vclock)
 static inline void
 xrow_encode_subscribe_response_xc(struct xrow_header *row,
 				  const struct tt_uuid *replicaset_uuid,
-				  const struct vclock *vclock)
+				  const struct vclock *vclock,
+				  uint32_t compression)
 {
-	if (xrow_encode_subscribe_response(row, replicaset_uuid, vclock) != 0)
+	if (xrow_encode_subscribe_response(row, replicaset_uuid, vclock,
+					   compression) != 0)
 		diag_raise();
 }
 
@@ -829,9 +993,11 @@ xrow_encode_subscribe_response_xc(struct xrow_header *row,
 static inline void
 xrow_decode_subscribe_response_xc(struct xrow_header *row,
 				  struct tt_uuid *replicaset_uuid,
-				  struct vclock *vclock)
+				  struct vclock *vclock,
+				  uint32_t *compression)
 {
-	if (xrow_decode_subscribe_response(row, replicaset_uuid, vclock) != 0)
+	if (xrow_decode_subscribe_response(row, replicaset_uuid, vclock,
+					   compression) != 0)
 		diag_raise();
 }
 
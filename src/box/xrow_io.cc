@@ -33,6 +33,9 @@
 #include "coio.h"
 #include "coio_buf.h"
 #include "error.h"
+#include "clock.h"
+#include "trivia/util.h"
+#include "fiber.h"
 #include "msgpuck/msgpuck.h"
 
 void
@@ -103,3 +106,236 @@ coio_write_xrow(struct ev_io *coio, const struct xrow_header *row)
 	coio_writev(coio, iov, iovcnt, 0);
 }
 
+/** zstd compression level of a replication stream. */
+enum { XROW_ZSTD_LEVEL = 3 };
+
+/** Size of the frame length, encoded as MP_UINT32. */
+enum { XROW_ZSTD_FIXHEADER_SIZE = 5 };
+
+int
+xrow_zstd_writer_create(struct xrow_zstd_writer *writer)
+{
+	memset(writer, 0, sizeof(*writer));
+	writer->zstream = ZSTD_createCStream();
+	if (writer->zstream == NULL) {
+		diag_set(ClientError, ER_COMPRESSION,
+			 "failed to create context");
+		return -1;
+	}
+	size_t rc = ZSTD_initCStream(writer->zstream, XROW_ZSTD_LEVEL);
+	if (ZSTD_isError(rc)) {
+		diag_set(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+		ZSTD_freeCStream(writer->zstream);
+		writer->zstream = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+void
+xrow_zstd_writer_destroy(struct xrow_zstd_writer *writer)
+{
+	ZSTD_freeCStream(writer->zstream);
+	free(writer->buf);
+	writer->zstream = NULL;
+	writer->buf = NULL;
+	writer->capacity = 0;
+}
+
+/**
+ * Make sure the output buffer of a writer has at least
+ * @a size bytes after @a used ones.
+ */
+static void
+xrow_zstd_writer_reserve_xc(struct xrow_zstd_writer *writer, size_t used,
+			    size_t size)
+{
+	if (used + size <= writer->capacity)
+		return;
+	size_t capacity = MAX(writer->capacity * 2, used + size);
+	char *buf = (char *) realloc(writer->buf, capacity);
+	if (buf == NULL)
+		tnt_raise(OutOfMemory, capacity, "realloc", "zstd buffer");
+	writer->buf = buf;
+	writer->capacity = capacity;
+}
+
+void
+coio_write_xrow_zstd(struct ev_io *coio, struct xrow_zstd_writer *writer,
+		     const struct xrow_header *row)
+{
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(row, iov);
+	double start = clock_thread();
+	size_t raw_size = 0;
+	size_t used = XROW_ZSTD_FIXHEADER_SIZE;
+	for (int i = 0; i < iovcnt; i++)
+		raw_size += iov[i].iov_len;
+	xrow_zstd_writer_reserve_xc(writer, used, ZSTD_compressBound(raw_size));
+	for (int i = 0; i < iovcnt; i++) {
+		ZSTD_inBuffer input = {iov[i].iov_base, iov[i].iov_len, 0};
+		while (input.pos < input.size) {
+			if (used == writer->capacity)
+				xrow_zstd_writer_reserve_xc(writer, used,
+							    ZSTD_CStreamOutSize());
+			ZSTD_outBuffer output = {writer->buf + used,
+						 writer->capacity - used, 0};
+			size_t rc = ZSTD_compressStream(writer->zstream,
+							&output, &input);
+			if (ZSTD_isError(rc)) {
+				tnt_raise(ClientError, ER_COMPRESSION,
+					  ZSTD_getErrorName(rc));
+			}
+			used += output.pos;
+		}
+	}
+	/*
+	 * Flush the stream, so that the receiver can decode
+	 * the row without waiting for the next frame.
+	 */
+	size_t rc;
+	do {
+		xrow_zstd_writer_reserve_xc(writer, used, ZSTD_CStreamOutSize());
+		ZSTD_outBuffer output = {writer->buf + used,
+					 writer->capacity - used, 0};
+		rc = ZSTD_flushStream(writer->zstream, &output);
+		if (ZSTD_isError(rc)) {
+			tnt_raise(ClientError, ER_COMPRESSION,
+				  ZSTD_getErrorName(rc));
+		}
+		used += output.pos;
+	} while (rc != 0);
+
+	char *data = writer->buf;
+	*(data++) = 0xce; /* MP_UINT32 */
+	*(uint32_t *) data = mp_bswap_u32(used - XROW_ZSTD_FIXHEADER_SIZE);
+
+	writer->stat.raw_size += raw_size;
+	writer->stat.size += used;
+	writer->stat.time += clock_thread() - start;
+	coio_write(coio, writer->buf, used);
+}
+
+int
+xrow_zstd_reader_create(struct xrow_zstd_reader *reader)
+{
+	memset(reader, 0, sizeof(*reader));
+	reader->zstream = ZSTD_createDStream();
+	if (reader->zstream == NULL) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 "failed to create context");
+		return -1;
+	}
+	size_t rc = ZSTD_initDStream(reader->zstream);
+	if (ZSTD_isError(rc)) {
+		diag_set(ClientError, ER_DECOMPRESSION, ZSTD_getErrorName(rc));
+		ZSTD_freeDStream(reader->zstream);
+		reader->zstream = NULL;
+		return -1;
+	}
+	ibuf_create(&reader->zbuf, &cord()->slabc, 1024);
+	return 0;
+}
+
+void
+xrow_zstd_reader_destroy(struct xrow_zstd_reader *reader)
+{
+	ZSTD_freeDStream(reader->zstream);
+	reader->zstream = NULL;
+	ibuf_destroy(&reader->zbuf);
+}
+
+/**
+ * Check if the input buffer holds a complete row. A malformed
+ * length is left to the row decoder to report.
+ */
+static bool
+ibuf_has_xrow(struct ibuf *in)
+{
+	if (ibuf_used(in) < 1)
+		return false;
+	const char *data = in->rpos;
+	if (mp_typeof(*data) != MP_UINT)
+		return true;
+	if (mp_check_uint(data, in->wpos) > 0)
+		return false;
+	uint32_t len = mp_decode_uint(&data);
+	return (size_t)(in->wpos - data) >= len;
+}
+
+/** Decompress a frame to the end of the input buffer. */
+static void
+xrow_zstd_decompress_xc(struct xrow_zstd_reader *reader, struct ibuf *in,
+			const char *data, size_t size)
+{
+	double start = clock_thread();
+	size_t raw_size = 0;
+	ZSTD_inBuffer input = {data, size, 0};
+	ZSTD_outBuffer output;
+	do {
+		ibuf_reserve_xc(in, ZSTD_DStreamOutSize());
+		output.dst = in->wpos;
+		output.size = ibuf_unused(in);
+		output.pos = 0;
+		size_t rc = ZSTD_decompressStream(reader->zstream,
+						  &output, &input);
+		if (ZSTD_isError(rc)) {
+			tnt_raise(ClientError, ER_DECOMPRESSION,
+				  ZSTD_getErrorName(rc));
+		}
+		in->wpos += output.pos;
+		raw_size += output.pos;
+		/*
+		 * A full output buffer means zstd may hold
+		 * more data to flush.
+		 */
+	} while (input.pos < input.size || output.pos == output.size);
+
+	reader->stat.raw_size += raw_size;
+	reader->stat.size += size + mp_sizeof_uint(size);
+	reader->stat.time += clock_thread() - start;
+}
+
+void
+coio_read_xrow_zstd_timeout_xc(struct ev_io *coio,
+			       struct xrow_zstd_reader *reader,
+			       struct ibuf *in, struct xrow_header *row,
+			       ev_tstamp timeout)
+{
+	struct ibuf *zbuf = &reader->zbuf;
+	ev_tstamp start, delay;
+	coio_timeout_init(&start, &delay, timeout);
+	while (!ibuf_has_xrow(in)) {
+		/* Read frame length */
+		if (ibuf_used(zbuf) < 1)
+			coio_breadn_timeout(coio, zbuf, 1, delay);
+		coio_timeout_update(&start, &delay);
+		if (mp_typeof(*zbuf->rpos) != MP_UINT) {
+			tnt_raise(ClientError, ER_INVALID_MSGPACK,
+				  "frame length");
+		}
+		ssize_t to_read = mp_check_uint(zbuf->rpos, zbuf->wpos);
+		if (to_read > 0)
+			coio_breadn_timeout(coio, zbuf, to_read, delay);
+		coio_timeout_update(&start, &delay);
+		uint32_t len = mp_decode_uint((const char **) &zbuf->rpos);
+
+		/* Read the frame and decompress it */
+		to_read = len - ibuf_used(zbuf);
+		if (to_read > 0)
+			coio_breadn_timeout(coio, zbuf, to_read, delay);
+		coio_timeout_update(&start, &delay);
+		xrow_zstd_decompress_xc(reader, in, zbuf->rpos, len);
+		zbuf->rpos += len;
+		if (ibuf_used(zbuf) == 0)
+			ibuf_reset(zbuf);
+	}
+
+	if (mp_typeof(*in->rpos) != MP_UINT) {
+		tnt_raise(ClientError, ER_INVALID_MSGPACK,
+			  "packet length");
+	}
+	uint32_t len = mp_decode_uint((const char **) &in->rpos);
+	xrow_header_decode_xc(row, (const char **) &in->rpos, in->rpos + len,
+			      true);
+}
@@ -30,12 +30,16 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stddef.h>
+#include <stdint.h>
+#include <small/ibuf.h>
+#include "zstd.h"
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 struct ev_io;
-struct ibuf;
 struct xrow_header;
 
 void
@@ -48,6 +52,86 @@ coio_read_xrow_timeout_xc(struct ev_io *coio, struct ibuf *in,
 void
 coio_write_xrow(struct ev_io *coio, const struct xrow_header *row);
 
+/**
+ * A compressed stream of rows is a sequence of frames. Each
+ * frame is an MP_UINT length followed by a piece of a zstd
+ * stream, flushed so that it can be decompressed to complete
+ * rows given all the preceding frames.
+ */
+
+/** Statistics of a compressed stream of rows. */
+struct xrow_compression_stat {
+	/** Size of the rows before compression, in bytes. */
+	uint64_t raw_size;
+	/** Size of the frames, in bytes. */
+	uint64_t size;
+	/** Thread CPU time spent on the codec, in seconds. */
+	double time;
+};
+
+/** Sender side of a compressed stream of rows. */
+struct xrow_zstd_writer {
+	/** zstd compression context. */
+	ZSTD_CStream *zstream;
+	/**
+	 * Output buffer. Allocated with malloc() so that
+	 * the writer may be used by any thread.
+	 */
+	char *buf;
+	/** Size of the output buffer. */
+	size_t capacity;
+	/** Compression statistics. */
+	struct xrow_compression_stat stat;
+};
+
+/**
+ * Initialize a compressed stream writer.
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_zstd_writer_create(struct xrow_zstd_writer *writer);
+
+void
+xrow_zstd_writer_destroy(struct xrow_zstd_writer *writer);
+
+/** Compress a row and send it in a frame. */
+void
+coio_write_xrow_zstd(struct ev_io *coio, struct xrow_zstd_writer *writer,
+		     const struct xrow_header *row);
+
+/** Receiver side of a compressed stream of rows. */
+struct xrow_zstd_reader {
+	/** zstd decompression context. */
+	ZSTD_DStream *zstream;
+	/** Frames read from the socket. */
+	struct ibuf zbuf;
+	/** Decompression statistics. */
+	struct xrow_compression_stat stat;
+};
+
+/**
+ * Initialize a compressed stream reader.
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_zstd_reader_create(struct xrow_zstd_reader *reader);
+
+void
+xrow_zstd_reader_destroy(struct xrow_zstd_reader *reader);
+
+/**
+ * Read a row from a compressed stream. The frames are
+ * decompressed to the input buffer @a in, and the row
+ * points to it, as with coio_read_xrow().
+ */
+void
+coio_read_xrow_zstd_timeout_xc(struct ev_io *coio,
+			       struct xrow_zstd_reader *reader,
+			       struct ibuf *in, struct xrow_header *row,
+			       double timeout);
+
 
 #if defined(__cplusplus)
 } /* extern "C" */
@@ -42,3 +42,15 @@ xstream_write(struct xstream *stream, struct xrow_header *row)
 	}
 	return 0;
 }
+
+int
+xstream_send_file(struct xstream *stream, const char *path)
+{
+	assert(stream->send_file != NULL);
+	try {
+		stream->send_file(stream, path);
+	} catch (Exception *e) {
+		return -1;
+	}
+	return 0;
+}
@@ -42,20 +42,30 @@ struct xrow_header;
 struct xstream;
 
 typedef void (*xstream_write_f)(struct xstream *, struct xrow_header *);
+typedef void (*xstream_send_file_f)(struct xstream *, const char *);
 
 struct xstream {
 	xstream_write_f write;
+	/**
+	 * Send a checkpoint file as is, given its path.
+	 * NULL if the stream accepts rows only.
+	 */
+	xstream_send_file_f send_file;
 };
 
 static inline void
 xstream_create(struct xstream *xstream, xstream_write_f write)
 {
 	xstream->write = write;
+	xstream->send_file = NULL;
 }
 
 int
 xstream_write(struct xstream *stream, struct xrow_header *row);
 
+int
+xstream_send_file(struct xstream *stream, const char *path);
+
 #if defined(__cplusplus)
 } /* extern C */
 
@@ -36,6 +36,10 @@
 #include <stdio.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <unistd.h>
+#if defined(HAVE_SENDFILE_LINUX)
+#include <sys/sendfile.h>
+#endif /* HAVE_SENDFILE_LINUX */
 
 #include "sio.h"
 #include "scoped_guard.h"
@@ -504,6 +508,90 @@ coio_writev_timeout(struct ev_io *coio, struct iovec *iov, int iovcnt,
 	return total;
 }
 
+#if defined(HAVE_SENDFILE_LINUX)
+
+ssize_t
+coio_sendfile_timeout(struct ev_io *coio, int fd, off_t offset, size_t sz,
+		      ev_tstamp timeout)
+{
+	size_t towrite = sz;
+	ev_tstamp start, delay;
+	coio_timeout_init(&start, &delay, timeout);
+
+	CoioGuard coio_guard(coio);
+
+	while (towrite > 0) {
+		/* Write as much data as the socket accepts. */
+		ssize_t nwr = sendfile(coio->fd, fd, &offset, towrite);
+		if (nwr > 0) {
+			towrite -= nwr;
+			continue;
+		}
+		if (nwr == 0) {
+			/* The file is shorter than expected. */
+			tnt_raise(SocketError, sio_socketname(coio->fd),
+				  "sendfile: unexpected end of file");
+		}
+		if (!sio_wouldblock(errno)) {
+			tnt_raise(SocketError, sio_socketname(coio->fd),
+				  "sendfile(%zu)", towrite);
+		}
+		if (! ev_is_active(coio)) {
+			ev_io_set(coio, coio->fd, EV_WRITE);
+			ev_io_start(loop(), coio);
+		}
+		/* Yield control to other fibers. */
+		fiber_testcancel();
+		bool is_timedout = coio_fiber_yield_timeout(coio, delay);
+		fiber_testcancel();
+
+		if (is_timedout)
+			tnt_raise(TimedOut);
+		coio_timeout_update(&start, &delay);
+	}
+	return sz;
+}
+
+#else /* !defined(HAVE_SENDFILE_LINUX) */
+
+ssize_t
+coio_sendfile_timeout(struct ev_io *coio, int fd, off_t offset, size_t sz,
+		      ev_tstamp timeout)
+{
+	/*
+	 * No zero-copy here: read the file in chunks and
+	 * write them to the socket.
+	 */
+	enum { CHUNK_SIZE = 64 * 1024 };
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	size_t buf_size = MIN(sz, (size_t) CHUNK_SIZE);
+	char *buf = (char *) region_alloc(region, buf_size);
+	if (buf == NULL)
+		tnt_raise(OutOfMemory, buf_size, "region_alloc", "buf");
+	ev_tstamp start, delay;
+	coio_timeout_init(&start, &delay, timeout);
+
+	size_t towrite = sz;
+	while (towrite > 0) {
+		ssize_t nrd = pread(fd, buf, MIN(towrite, buf_size), offset);
+		if (nrd < 0)
+			tnt_raise(SystemError, "pread");
+		if (nrd == 0) {
+			tnt_raise(SocketError, sio_socketname(coio->fd),
+				  "sendfile: unexpected end of file");
+		}
+		coio_write_timeout(coio, buf, nrd, delay);
+		coio_timeout_update(&start, &delay);
+		offset += nrd;
+		towrite -= nrd;
+	}
+	region_truncate(region, used);
+	return sz;
+}
+
+#endif /* !defined(HAVE_SENDFILE_LINUX) */
+
 /**
  * Send up to sz bytes to a UDP socket.
  * Return the number of bytes sent.
@@ -149,6 +149,21 @@ coio_writev(struct ev_io *coio, struct iovec *iov, int iovcnt, size_t size)
 	return coio_writev_timeout(coio, iov, iovcnt, size, TIMEOUT_INFINITY);
 }
 
+/**
+ * Write @a sz bytes of file @a fd starting at @a offset to
+ * the socket. Uses sendfile(2) where available, so the data
+ * doesn't get copied to the user space.
+ */
+ssize_t
+coio_sendfile_timeout(struct ev_io *coio, int fd, off_t offset, size_t sz,
+		      ev_tstamp timeout);
+
+static inline ssize_t
+coio_sendfile(struct ev_io *coio, int fd, off_t offset, size_t sz)
+{
+	return coio_sendfile_timeout(coio, fd, offset, sz, TIMEOUT_INFINITY);
+}
+
 ssize_t
 coio_sendto_timeout(struct ev_io *coio, const void *buf, size_t sz, int flags,
 		    const struct sockaddr *dest_addr, socklen_t addrlen,
@@ -42,6 +42,11 @@ replication_sync_timeout = box.cfg.replication_sync_timeout
 box.cfg{replication_sync_timeout = 123}
 box.cfg.replication_sync_timeout
 box.cfg{replication_sync_timeout = replication_sync_timeout}
+replication_ack_interval = box.cfg.replication_ack_interval
+box.cfg{replication_ack_interval = -1}
+box.cfg{replication_ack_interval = 0.01}
+box.cfg.replication_ack_interval
+box.cfg{replication_ack_interval = replication_ack_interval}
 
 box.cfg{instance_uuid = box.info.uuid}
 box.cfg{instance_uuid = '12345678-0123-5678-1234-abcdefabcdef'}
@@ -0,0 +1,48 @@
+test_run = require('test_run').new()
+
+--
+-- Online tuple arena defragmentation.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {type = 'hash', parts = {2, 'unsigned'}})
+pad = string.rep('x', 100)
+box.begin() for i = 1, 10000 do s:replace{i, i, pad} end box.commit()
+-- Leave slabs sparsely populated.
+box.begin() for i = 1, 10000 do if i % 10 ~= 0 then s:delete{i} end end box.commit()
+
+info = box.slab.info()
+type(info.items_frag_size)
+info.items_frag_size == info.items_size - info.items_used
+count = info.defrag_tuple_count
+type(count)
+type(info.defrag_tuple_size)
+info.defrag_in_progress
+
+box.slab.defrag()
+-- Repeated calls are no-op while defragmentation is in progress.
+box.slab.defrag()
+test_run:wait_cond(function() return not box.slab.info().defrag_in_progress end)
+box.slab.info().defrag_tuple_count >= count
+
+-- Relocated tuples are still accessible via all indexes.
+s:count()
+s.index.sk:count()
+s:get{10}[2]
+s.index.sk:get{10000}[1]
+#s:select({9990}, {iterator = 'GE'})
+sum = 0
+for _, t in s:pairs() do if t[3] == pad then sum = sum + t[1] end end
+sum
+
+-- Spaces with indexes other than TREE and HASH are skipped.
+r = box.schema.space.create('rtree')
+_ = r:create_index('pk')
+_ = r:create_index('rt', {type = 'rtree', parts = {2, 'array'}, unique = false})
+_ = r:insert{1, {1, 1}}
+box.slab.defrag()
+test_run:wait_cond(function() return not box.slab.info().defrag_in_progress end)
+r.index.rt:select({1, 1})
+
+r:drop()
+s:drop()
@@ -26,6 +26,13 @@ box.stat.SELECT.total
 space:get('Impossible value')
 box.stat.ERROR.total
 
+-- commit latency
+lat = box.stat.latency()
+t = {} for k in pairs(lat) do table.insert(t, k) end table.sort(t)
+t
+lat.total.p99 > 0
+lat.wal_write.p50 <= lat.total.p99
+
 -- reset
 box.stat.reset()
 box.stat.INSERT.total
@@ -34,6 +41,7 @@ box.stat.UPDATE.total
 box.stat.REPLACE.total
 box.stat.SELECT.total
 box.stat.ERROR.total
+box.stat.latency().total.p99
 
 test_run:cmd('restart server default')
 
@@ -0,0 +1,68 @@
+test_run = require('test_run').new()
+--
+-- Small memtx tuples without a field map are stored in the
+-- compact form.
+--
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+s:insert{1, 'a'}
+s:get{1}:bsize()
+long = string.rep('x', 40000)
+s:insert{2, long}[2] == long
+s:get{2}:bsize()
+s:update({1}, {{'=', 2, long}})[2] == long
+s:update({2}, {{'=', 2, 'b'}})
+s:bsize()
+s:update({1}, {{'=', 2, 'a'}})
+-- A field map turns the compact form off.
+sk = s:create_index('sk', {parts = {2, 'string'}})
+s:insert{3, 'c'}
+sk:get{'c'}
+sk:select()
+s:drop()
+
+--
+-- The compact form saves memory on small tuples.
+--
+compact = box.schema.space.create('compact')
+_ = compact:create_index('pk')
+full = box.schema.space.create('full')
+_ = full:create_index('pk')
+_ = full:create_index('sk', {parts = {2, 'unsigned'}})
+test_run:cmd("setopt delimiter ';'")
+function items_used_by(s, count)
+    local used = box.slab.info().items_used
+    for i = 1, count do s:insert{i, i} end
+    return box.slab.info().items_used - used
+end;
+test_run:cmd("setopt delimiter ''");
+compact_used = items_used_by(compact, 1000)
+full_used = items_used_by(full, 1000)
+compact_used < full_used
+compact:drop()
+full:drop()
+
+--
+-- data_offset is 15 bits, so a tuple may have at most
+-- (TUPLE_DATA_OFFSET_MAX - TUPLE_HEADER_SIZE_MAX) / 4 = 8175
+-- indexed fields (the first field doesn't need an offset).
+--
+test_run:cmd("setopt delimiter ';'")
+function index_fields(s, name, first, last)
+    local parts = {}
+    for i = first, last do
+        table.insert(parts, {i, 'unsigned'})
+    end
+    return s:create_index(name, {parts = parts, unique = false})
+end;
+test_run:cmd("setopt delimiter ''");
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 0, 31 do index_fields(s, 'sk' .. i, 2 + i * 250, 251 + i * 250) end
+_ = index_fields(s, 'sk32', 8002, 8176)
+index_fields(s, 'sk33', 8177, 8177)
+t = {}
+for i = 1, 8176 do t[i] = i end
+#s:insert(t)
+s:get{1}[8176]
+s:drop()
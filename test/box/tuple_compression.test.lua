@@ -0,0 +1,51 @@
+test_run = require('test_run').new()
+
+--
+-- Compression of tuple fields.
+--
+format = {{'id', 'unsigned'}, {'data', 'string', compression = 'foo'}}
+box.schema.space.create('t', {format = format})
+format[2].compression = 'zstd'
+s = box.schema.space.create('t', {format = format})
+pk = s:create_index('pk')
+-- Compressed fields can't be indexed.
+s:create_index('sk', {parts = {2, 'string'}})
+
+data = string.rep('0123456789', 100)
+s:insert{1, data, 'a'}[2] == data
+s:get{1}[2] == data
+s:get{1}[3]
+s:bsize() < #data
+-- Short values are stored as is.
+s:insert{2, 'short'}
+s:select{2}
+s:update({1}, {{'=', 3, 'b'}})[2] == data
+s:upsert({1, 'x'}, {{'=', 3, 'c'}})
+s:get{1}[2] == data
+s:get{1}[3]
+s:replace{3, data .. data}[2] == data .. data
+-- Compression can't be changed in a non-empty space.
+s:format({{'id', 'unsigned'}, {'data', 'string'}})
+
+-- Snapshots store decompressed data.
+box.snapshot()
+test_run:cmd('restart server default')
+data = string.rep('0123456789', 100)
+s = box.space.t
+s:get{1}[2] == data
+s:get{3}[2] == data .. data
+s:get{2}
+s:bsize() < #data * 3
+-- SQL decompresses only the values it reads.
+count = box.stat.sql().sql_decompress_count
+#box.execute('SELECT "id" FROM "t"').rows
+box.execute('SELECT "id" FROM "t" WHERE "id" = 3').rows[1][1]
+box.stat.sql().sql_decompress_count - count
+box.execute('SELECT "data" FROM "t" WHERE "id" = 3').rows[1][1] == data .. data
+box.stat.sql().sql_decompress_count - count
+#box.execute('SELECT LENGTH("data") FROM "t"').rows
+box.stat.sql().sql_decompress_count - count
+s:drop()
+
+-- Vinyl doesn't support field compression.
+box.schema.space.create('v', {engine = 'vinyl', format = {{'id', 'unsigned'}, {'data', 'string', compression = 'zstd'}}})
@@ -0,0 +1,72 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+space = box.schema.space.create('test', {engine = engine})
+index = space:create_index('primary')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+
+--
+-- The transactions applied within replication_ack_interval are
+-- confirmed by a single ACK. The interval is capped by
+-- replication_timeout, so the master gets the ACK anyway.
+--
+box.cfg{replication_ack_interval = 100}
+box.info.replication[1].upstream.status
+
+test_run:cmd("switch default")
+for i = 1, 1000 do space:insert{i} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+test_run:wait_cond(function() return box.info.replication[2].downstream.vclock[1] == box.info.vclock[1] end)
+box.info.replication[2].downstream.status
+
+--
+-- Check that ACKs are coalesced. Raise replication_timeout on
+-- both sides, so that the interval isn't capped and the master
+-- doesn't take the replica for dead. Keep heartbeats frequent
+-- with the error injection until the new timeouts are in effect.
+--
+fiber = require('fiber')
+box.error.injection.set('ERRINJ_RELAY_REPORT_INTERVAL', 0.1)
+box.cfg{replication_timeout = 100}
+test_run:cmd("switch replica")
+box.cfg{replication_timeout = 100}
+test_run:cmd("switch default")
+-- Stop heartbeats and let the last one be answered.
+box.error.injection.set('ERRINJ_RELAY_REPORT_INTERVAL', 0)
+fiber.sleep(0.2)
+-- The replica applies the transactions, but doesn't confirm them.
+for i = 1001, 1100 do space:insert{i} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+fiber.sleep(0.1)
+box.info.replication[2].downstream.vclock[1] < box.info.vclock[1]
+
+--
+-- A heartbeat is answered right away. The relay picks up the
+-- new heartbeat interval once it is woken by a row.
+--
+box.error.injection.set('ERRINJ_RELAY_REPORT_INTERVAL', 0.1)
+_ = space:insert{1101}
+test_run:wait_cond(function() return box.info.replication[2].downstream.vclock[1] == box.info.vclock[1] end)
+box.info.replication[2].downstream.status
+box.error.injection.set('ERRINJ_RELAY_REPORT_INTERVAL', 0)
+
+test_run:cmd("switch replica")
+box.space.test:count()
+box.cfg{replication_ack_interval = 0, replication_timeout = 0.1}
+
+test_run:cmd("switch default")
+box.cfg{replication_timeout = 0.1}
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+space:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,51 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+space = box.schema.space.create('test', {engine = engine})
+index = space:create_index('primary')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+
+-- The stream is not compressed unless the replica asks for it.
+box.info.replication[1].upstream.compression == nil
+
+-- The option takes effect on the next SUBSCRIBE.
+replication = box.cfg.replication
+box.cfg{replication_compression = true, replication = {}}
+box.cfg{replication = replication}
+box.info.replication[1].upstream.status
+box.info.replication[1].upstream.compression ~= nil
+
+test_run:cmd("switch default")
+test_run:wait_cond(function() return box.info.replication[2].downstream.compression ~= nil end)
+for i = 1, 100 do space:insert{i, string.rep('x', 100)} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+stat = box.info.replication[2].downstream.compression
+stat.ratio > 1
+stat.time > 0
+
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get(100)[2] == string.rep('x', 100)
+stat = box.info.replication[1].upstream.compression
+stat.ratio > 1
+stat.time > 0
+
+box.cfg{replication_compression = false, replication = {}}
+box.cfg{replication = replication}
+box.info.replication[1].upstream.status
+box.info.replication[1].upstream.compression == nil
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+space:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,59 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+--
+-- On request, the master sends its memtx snapshot as is on
+-- initial join, along with the snapshots it is a delta of.
+--
+memtx_delta_checkpoint_count = box.cfg.memtx_delta_checkpoint_count
+box.cfg{memtx_delta_checkpoint_count = 2}
+space = box.schema.space.create('test', {engine = engine})
+index = space:create_index('primary')
+for i = 1, 100 do space:insert{i, string.rep('x', 100)} end
+loc = box.schema.space.create('loc', {engine = engine, is_local = true})
+index = loc:create_index('primary')
+for i = 1, 10 do loc:insert{i} end
+box.snapshot()
+for i = 101, 200 do space:insert{i, string.rep('y', 100)} end
+box.snapshot()
+-- Rows written after the checkpoint are sent by the final join.
+for i = 201, 210 do space:insert{i} end
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_join_files.lua'")
+test_run:cmd("start server replica")
+test_run:grep_log('default', 'joining replica .* with files') ~= nil
+
+test_run:cmd("switch replica")
+test_run:grep_log('replica', 'receiving checkpoint files') ~= nil
+box.space.test:count()
+box.space.test:get(1)[2] == string.rep('x', 100)
+box.space.test:get(200)[2] == string.rep('y', 100)
+box.space.test:get(210)
+-- Replica local rows aren't sent.
+box.space.loc:count()
+-- The received files are removed once loaded.
+fio = require('fio')
+#fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.join.inprogress'))
+
+-- The replica is functional after restart.
+test_run:cmd("switch default")
+for i = 211, 220 do space:insert{i} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+test_run:cmd("restart server replica")
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test.index.primary:max()
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.cfg{memtx_delta_checkpoint_count = memtx_delta_checkpoint_count}
+space:drop()
+loc:drop()
+box.schema.user.revoke('guest', 'replication')
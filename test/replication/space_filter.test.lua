@@ -0,0 +1,62 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+a = box.schema.space.create('a', {engine = engine})
+_ = a:create_index('primary')
+b = box.schema.space.create('b', {engine = engine})
+_ = b:create_index('primary')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+
+box.cfg{replication_space_filter = {'x'}}
+box.cfg{replication_space_filter = {-1}}
+box.cfg.replication_space_filter
+
+--
+-- The replica gets rows of the listed spaces only. The option
+-- takes effect on the next SUBSCRIBE.
+--
+replication = box.cfg.replication
+box.cfg{replication_space_filter = {box.space.a.id}, replication = {}}
+box.cfg{replication = replication}
+box.info.replication[1].upstream.status
+
+test_run:cmd("switch default")
+for i = 1, 10 do a:insert{i} b:insert{i} end
+-- Rows of system spaces are always sent.
+c = box.schema.space.create('c', {engine = engine})
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+
+test_run:cmd("switch replica")
+box.space.a:count()
+box.space.b:count()
+box.space.c ~= nil
+-- The filtered rows still advance the vclock.
+box.info.vclock[1] == test_run:get_vclock('default')[1]
+
+box.cfg{replication_space_filter = box.NULL, replication = {}}
+box.cfg{replication = replication}
+box.info.replication[1].upstream.status
+
+test_run:cmd("switch default")
+b:insert{11}
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+test_run:cmd("switch replica")
+box.space.b:count()
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+a:drop()
+b:drop()
+c:drop()
+box.schema.user.revoke('guest', 'replication')
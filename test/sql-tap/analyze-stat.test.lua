@@ -0,0 +1,230 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(17)
+
+--
+-- ANALYZE stores the cardinality of each index to _sql_stat1
+-- and samples of its keys to _sql_stat4. The planner uses them
+-- to estimate the number of rows a search returns, until the
+-- size of the space changes too much.
+--
+test:do_test(
+    "analyze-stat-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(id INT PRIMARY KEY, a INT, b INT);
+            CREATE INDEX i_a ON t1(a);
+            CREATE INDEX i_b ON t1(b);
+        ]])
+        for i = 1, 100 do
+            box.space.T1:insert({i, 1, i})
+        end
+        return test:execsql("ANALYZE t1")
+    end, {
+        -- <analyze-stat-1.0>
+        -- </analyze-stat-1.0>
+    })
+
+test:do_execsql_test(
+    "analyze-stat-1.1",
+    [[
+        SELECT "idx", "stat" FROM "_sql_stat1" WHERE "tbl" = 'T1';
+    ]], {
+        -- <analyze-stat-1.1>
+        "I_A", "100 100", "I_B", "100 1", "T1", "100 1"
+        -- </analyze-stat-1.1>
+    })
+
+test:do_execsql_test(
+    "analyze-stat-1.2",
+    [[
+        SELECT count(*) > 0 FROM "_sql_stat4" WHERE "tbl" = 'T1';
+    ]], {
+        -- <analyze-stat-1.2>
+        true
+        -- </analyze-stat-1.2>
+    })
+
+--
+-- Every row has the same value of "a", so the index on "b" is
+-- more selective.
+--
+test:do_execsql_test(
+    "analyze-stat-1.3",
+    [[
+        EXPLAIN QUERY PLAN SELECT id FROM t1 WHERE a = 1 AND b = 5;
+    ]], {
+        -- <analyze-stat-1.3>
+        "/I_B/"
+        -- </analyze-stat-1.3>
+    })
+
+--
+-- Skew the data the other way around. The statistics are stale
+-- now and not used, but the results are correct anyway.
+--
+test:do_test(
+    "analyze-stat-2.1",
+    function()
+        for i = 101, 400 do
+            box.space.T1:insert({i, i, 7})
+        end
+        return test:execsql("SELECT count(*) FROM t1 WHERE a = 150 AND b = 7")
+    end, {
+        -- <analyze-stat-2.1>
+        1
+        -- </analyze-stat-2.1>
+    })
+
+test:do_execsql_test(
+    "analyze-stat-2.2",
+    [[
+        ANALYZE;
+        SELECT "idx", "stat" FROM "_sql_stat1" WHERE "tbl" = 'T1';
+    ]], {
+        -- <analyze-stat-2.2>
+        "I_A", "400 2", "I_B", "400 4", "T1", "400 1"
+        -- </analyze-stat-2.2>
+    })
+
+test:do_execsql_test(
+    "analyze-stat-2.3",
+    [[
+        EXPLAIN QUERY PLAN SELECT id FROM t1 WHERE a = 150 AND b = 7;
+    ]], {
+        -- <analyze-stat-2.3>
+        "/I_A/"
+        -- </analyze-stat-2.3>
+    })
+
+test:do_catchsql_test(
+    "analyze-stat-3.1",
+    [[
+        ANALYZE no_such_table;
+    ]], {
+        -- <analyze-stat-3.1>
+        1, "Space 'NO_SUCH_TABLE' does not exist"
+        -- </analyze-stat-3.1>
+    })
+
+--
+-- Statistics are dropped along with the space.
+--
+test:do_execsql_test(
+    "analyze-stat-3.2",
+    [[
+        DROP TABLE t1;
+        SELECT count(*) FROM "_sql_stat1" WHERE "tbl" = 'T1';
+    ]], {
+        -- <analyze-stat-3.2>
+        0
+        -- </analyze-stat-3.2>
+    })
+
+--
+-- The planner estimates the number of rows a search returns by
+-- the _sql_stat4 samples. A full scan is cheaper than an index
+-- search followed by a lookup of every row in the primary key,
+-- unless the search is selective enough.
+--
+test:do_test(
+    "analyze-stat-4.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t2(id INT PRIMARY KEY, a INT, b INT);
+            CREATE INDEX i2a ON t2(a);
+        ]])
+        for i = 1, 1000 do
+            box.space.T2:insert({i, i <= 900 and 1 or i, i})
+        end
+        return test:execsql("ANALYZE t2")
+    end, {
+        -- <analyze-stat-4.0>
+        -- </analyze-stat-4.0>
+    })
+
+test:do_eqp_test(
+    "analyze-stat-4.1",
+    [[
+        SELECT b FROM t2 WHERE a = 1;
+    ]], {
+        -- <analyze-stat-4.1>
+        {0, 0, 0, "SCAN TABLE T2"}
+        -- </analyze-stat-4.1>
+    })
+
+test:do_eqp_test(
+    "analyze-stat-4.2",
+    [[
+        SELECT b FROM t2 WHERE a = 950;
+    ]], {
+        -- <analyze-stat-4.2>
+        {0, 0, 0, "SEARCH TABLE T2 USING INDEX I2A (A=?)"}
+        -- </analyze-stat-4.2>
+    })
+
+test:do_eqp_test(
+    "analyze-stat-4.3",
+    [[
+        SELECT b FROM t2 WHERE a > 990;
+    ]], {
+        -- <analyze-stat-4.3>
+        {0, 0, 0, "SEARCH TABLE T2 USING INDEX I2A (A>?)"}
+        -- </analyze-stat-4.3>
+    })
+
+test:do_eqp_test(
+    "analyze-stat-4.4",
+    [[
+        SELECT b FROM t2 WHERE a > 0;
+    ]], {
+        -- <analyze-stat-4.4>
+        {0, 0, 0, "SCAN TABLE T2"}
+        -- </analyze-stat-4.4>
+    })
+
+--
+-- Once the space has grown more than SQL_STAT_STALE_RATIO times
+-- since ANALYZE, the samples are ignored and the planner falls
+-- back to the default estimate of an equality search.
+--
+test:do_test(
+    "analyze-stat-4.5",
+    function()
+        for i = 1001, 2500 do
+            box.space.T2:insert({i, i, i})
+        end
+        return test:execsql("EXPLAIN QUERY PLAN SELECT b FROM t2 WHERE a = 1")
+    end, {
+        -- <analyze-stat-4.5>
+        0, 0, 0, "SEARCH TABLE T2 USING INDEX I2A (A=?)"
+        -- </analyze-stat-4.5>
+    })
+
+--
+-- A new ANALYZE brings the samples back.
+--
+test:do_execsql_test(
+    "analyze-stat-4.6",
+    [[
+        ANALYZE t2;
+        SELECT "stat" FROM "_sql_stat1" WHERE "idx" = 'I2A';
+    ]], {
+        -- <analyze-stat-4.6>
+        "2500 2"
+        -- </analyze-stat-4.6>
+    })
+
+test:do_eqp_test(
+    "analyze-stat-4.7",
+    [[
+        SELECT b FROM t2 WHERE a = 1;
+    ]], {
+        -- <analyze-stat-4.7>
+        {0, 0, 0, "SCAN TABLE T2"}
+        -- </analyze-stat-4.7>
+    })
+
+test:execsql("DROP TABLE t2;")
+
+test:finish_test()
@@ -26,18 +26,6 @@ local function eqp(sql)
     return test:execsql("EXPLAIN QUERY PLAN"..sql)
 end
 
-local function alpha(blob)
-    ret = ""
-    for _, c in ipairs(X(37, "X!cmd", [=[["split",["blob"],""]]=])) do
-        if X(39, "X!cmd", [=[["string","is","alpha",["c"]]]=])
- then
-            ret = ret .. c
-        end
-    end
-    return ret
-end
-
--- db("func", "alpha", "alpha")
 -- db("func", "lindex", "lindex")
 -- ["unset","-nocomplain","i","t","u","v","w","x","y","z"]
 
@@ -0,0 +1,228 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(19)
+
+--
+-- Simple aggregates over numeric columns of a single table are
+-- computed by OP_BatchAggregate a batch of tuples at a time.
+-- Make sure the results are the same the row-at-a-time program
+-- produces.
+--
+test:do_test(
+    "batch-aggregate-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(id INT PRIMARY KEY, a INT, b NUMBER, c INT);
+        ]])
+        for i = 1, 1000 do
+            local c = i % 2 == 1 and i or box.NULL
+            box.space.T1:insert({i, i, i, c})
+        end
+        return test:execsql("SELECT count(*) FROM t1")
+    end, {
+        -- <batch-aggregate-1.0>
+        1000
+        -- </batch-aggregate-1.0>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-1.1",
+    [[
+        SELECT count(*), count(c), sum(a), total(a), avg(a) FROM t1;
+    ]], {
+        -- <batch-aggregate-1.1>
+        1000, 500, 500500, 500500, 500.5
+        -- </batch-aggregate-1.1>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-1.2",
+    [[
+        SELECT typeof(sum(a)), typeof(sum(b)), typeof(avg(a)) FROM t1;
+    ]], {
+        -- <batch-aggregate-1.2>
+        "integer", "real", "real"
+        -- </batch-aggregate-1.2>
+    })
+
+test:do_test(
+    "batch-aggregate-1.3",
+    function()
+        local opcodes = {}
+        local res = box.execute("EXPLAIN SELECT sum(a) FROM t1 WHERE a > 1")
+        for _, row in ipairs(res.rows) do
+            table.insert(opcodes, row[2])
+        end
+        return {table.concat(opcodes, " "):match("BatchAggregate") ~= nil}
+    end, {
+        -- <batch-aggregate-1.3>
+        1
+        -- </batch-aggregate-1.3>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-1.4",
+    [[
+        EXPLAIN QUERY PLAN SELECT sum(a) FROM t1 WHERE a > 1;
+    ]], {
+        -- <batch-aggregate-1.4>
+        0, 0, 0, "SCAN TABLE T1"
+        -- </batch-aggregate-1.4>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-2.1",
+    [[
+        SELECT count(*), sum(a) FROM t1 WHERE a > 100 AND a <= 200;
+    ]], {
+        -- <batch-aggregate-2.1>
+        100, 15050
+        -- </batch-aggregate-2.1>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-2.2",
+    [[
+        SELECT count(*), sum(a) FROM t1 WHERE 990 < a;
+    ]], {
+        -- <batch-aggregate-2.2>
+        10, 9955
+        -- </batch-aggregate-2.2>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-2.3",
+    [[
+        SELECT count(*), sum(a) FROM t1 WHERE a < 10.5;
+    ]], {
+        -- <batch-aggregate-2.3>
+        10, 55
+        -- </batch-aggregate-2.3>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-2.4",
+    [[
+        SELECT count(*), sum(a) FROM t1 WHERE b >= 999.5 AND b <> 1000;
+    ]], {
+        -- <batch-aggregate-2.4>
+        0, ""
+        -- </batch-aggregate-2.4>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-2.5",
+    [[
+        SELECT count(*), sum(a) FROM t1 WHERE a = -1;
+    ]], {
+        -- <batch-aggregate-2.5>
+        0, ""
+        -- </batch-aggregate-2.5>
+    })
+
+--
+-- NULLs never satisfy a comparison and are skipped by the
+-- aggregates.
+--
+test:do_execsql_test(
+    "batch-aggregate-3.1",
+    [[
+        SELECT count(*), sum(c), avg(c) FROM t1 WHERE c < 10;
+    ]], {
+        -- <batch-aggregate-3.1>
+        5, 25, 5
+        -- </batch-aggregate-3.1>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-3.2",
+    [[
+        SELECT count(*), count(c), sum(c) FROM t1 WHERE c != 1;
+    ]], {
+        -- <batch-aggregate-3.2>
+        499, 499, 249999
+        -- </batch-aggregate-3.2>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-3.3",
+    [[
+        SELECT count(*), sum(a), total(a), avg(a) FROM t1 WHERE a > 1000;
+    ]], {
+        -- <batch-aggregate-3.3>
+        0, "", 0, ""
+        -- </batch-aggregate-3.3>
+    })
+
+--
+-- Integer overflow of SUM is an error, while TOTAL is always
+-- computed in floating point.
+--
+test:do_catchsql_test(
+    "batch-aggregate-4.1",
+    [[
+        CREATE TABLE t2(id INT PRIMARY KEY, a INT);
+        INSERT INTO t2 VALUES(1, 9223372036854775807), (2, 1);
+        SELECT sum(a) FROM t2;
+    ]], {
+        -- <batch-aggregate-4.1>
+        1, "Failed to execute SQL statement: integer overflow"
+        -- </batch-aggregate-4.1>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-4.2",
+    [[
+        SELECT total(a), sum(a) FROM t2 WHERE a < 2;
+    ]], {
+        -- <batch-aggregate-4.2>
+        1, 1
+        -- </batch-aggregate-4.2>
+    })
+
+--
+-- A condition on the first part of an index is searched in the
+-- index rather than scanned in batches.
+--
+test:do_execsql_test(
+    "batch-aggregate-5.1",
+    [[
+        EXPLAIN QUERY PLAN SELECT sum(a) FROM t1 WHERE id = 5;
+    ]], {
+        -- <batch-aggregate-5.1>
+        0, 0, 0, "SEARCH TABLE T1 USING PRIMARY KEY (ID=?)"
+        -- </batch-aggregate-5.1>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-5.2",
+    [[
+        EXPLAIN QUERY PLAN
+        SELECT sum(a) FROM t1 WHERE id > 100 AND id <= 200 AND a > 1;
+    ]], {
+        -- <batch-aggregate-5.2>
+        0, 0, 0, "SEARCH TABLE T1 USING PRIMARY KEY (ID>? AND ID<?)"
+        -- </batch-aggregate-5.2>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-5.3",
+    [[
+        SELECT count(*), sum(a) FROM t1 WHERE id > 100 AND id <= 200;
+    ]], {
+        -- <batch-aggregate-5.3>
+        100, 15050
+        -- </batch-aggregate-5.3>
+    })
+
+test:do_execsql_test(
+    "batch-aggregate-4.3",
+    [[
+        DROP TABLE t2;
+        DROP TABLE t1;
+    ]], {
+        -- <batch-aggregate-4.3>
+        -- </batch-aggregate-4.3>
+    })
+
+test:finish_test()
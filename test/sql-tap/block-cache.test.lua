@@ -0,0 +1,53 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(3)
+
+--
+-- Heap blocks freed by a statement are kept by the connection
+-- and reused by the next ones. Make sure the values built in the
+-- reused buffers, including the ones grown in place, are intact.
+--
+test:do_execsql_test(
+    "block-cache-1.0",
+    [[
+        CREATE TABLE t1(id INT PRIMARY KEY, s TEXT);
+    ]], {
+        -- <block-cache-1.0>
+        -- </block-cache-1.0>
+    })
+
+test:do_test(
+    "block-cache-1.1",
+    function()
+        for i = 1, 200 do
+            local s = string.rep(string.char(65 + i % 26), i * 37 % 5000)
+            box.execute("INSERT INTO t1 VALUES (?, ?)", {i, s})
+        end
+        for i = 1, 200 do
+            local n = i * 37 % 5000
+            local res = box.execute("SELECT s || s, length(s || s) "..
+                                    "FROM t1 WHERE id = ?", {i}).rows[1]
+            if res[2] ~= 2 * n or
+               res[1] ~= string.rep(string.char(65 + i % 26), 2 * n) then
+                return {i}
+            end
+        end
+        return {true}
+    end, {
+        -- <block-cache-1.1>
+        true
+        -- </block-cache-1.1>
+    })
+
+test:do_execsql_test(
+    "block-cache-1.2",
+    [[
+        SELECT count(*), length(group_concat(s, '')) FROM t1;
+        DROP TABLE t1;
+    ]], {
+        -- <block-cache-1.2>
+        200, 418700
+        -- </block-cache-1.2>
+    })
+
+test:finish_test()
@@ -0,0 +1,173 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(14)
+
+--
+-- WHERE terms comparing a column with a literal are checked by
+-- the cursor of a full scan before the tuple gets to the VDBE.
+-- Make sure the results are the same the VDBE would produce.
+--
+test:do_execsql_test(
+    "cursor-filter-1.0",
+    [[
+        CREATE TABLE t1(id INT PRIMARY KEY, a INT, b NUMBER, c TEXT,
+                        d TEXT COLLATE "unicode_ci");
+        INSERT INTO t1 VALUES (1, 1, 1.5, 'a', 'A');
+        INSERT INTO t1 VALUES (2, -2, 2, 'b', 'b');
+        INSERT INTO t1 VALUES (3, NULL, NULL, NULL, NULL);
+        INSERT INTO t1 VALUES (4, 4, 4.5, 'ab', 'AB');
+        INSERT INTO t1 VALUES (5, 5, -1, 'B', 'a');
+        SELECT count(*) FROM t1;
+    ]], {
+        -- <cursor-filter-1.0>
+        5
+        -- </cursor-filter-1.0>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-1.1",
+    [[
+        SELECT id FROM t1 WHERE a > 1;
+    ]], {
+        -- <cursor-filter-1.1>
+        4, 5
+        -- </cursor-filter-1.1>
+    })
+
+--
+-- NULL doesn't satisfy any comparison.
+--
+test:do_execsql_test(
+    "cursor-filter-1.2",
+    [[
+        SELECT id FROM t1 WHERE a <> 4;
+    ]], {
+        -- <cursor-filter-1.2>
+        1, 2, 5
+        -- </cursor-filter-1.2>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-1.3",
+    [[
+        SELECT id FROM t1 WHERE -1 > a;
+    ]], {
+        -- <cursor-filter-1.3>
+        2
+        -- </cursor-filter-1.3>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-1.4",
+    [[
+        SELECT id FROM t1 WHERE b >= 1.5;
+    ]], {
+        -- <cursor-filter-1.4>
+        1, 2, 4
+        -- </cursor-filter-1.4>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-1.5",
+    [[
+        SELECT id FROM t1 WHERE b <= 1.5 AND b > -1;
+    ]], {
+        -- <cursor-filter-1.5>
+        1
+        -- </cursor-filter-1.5>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-1.6",
+    [[
+        SELECT id FROM t1 WHERE b = 2 OR b < 0;
+    ]], {
+        -- <cursor-filter-1.6>
+        2, 5
+        -- </cursor-filter-1.6>
+    })
+
+--
+-- Strings are compared byte by byte.
+--
+test:do_execsql_test(
+    "cursor-filter-1.7",
+    [[
+        SELECT id FROM t1 WHERE c < 'b';
+    ]], {
+        -- <cursor-filter-1.7>
+        1, 4, 5
+        -- </cursor-filter-1.7>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-1.8",
+    [[
+        SELECT id FROM t1 WHERE c >= 'ab' AND a IS NOT NULL;
+    ]], {
+        -- <cursor-filter-1.8>
+        2, 4
+        -- </cursor-filter-1.8>
+    })
+
+--
+-- A column with a collation is checked by the VDBE only.
+--
+test:do_execsql_test(
+    "cursor-filter-1.9",
+    [[
+        SELECT id FROM t1 WHERE d = 'a';
+    ]], {
+        -- <cursor-filter-1.9>
+        1, 5
+        -- </cursor-filter-1.9>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-2.1",
+    [[
+        EXPLAIN SELECT id FROM t1 WHERE c = 'a';
+    ]], {
+        -- <cursor-filter-2.1>
+        "/CursorFilter/"
+        -- </cursor-filter-2.1>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-2.2",
+    [[
+        EXPLAIN SELECT id FROM t1 WHERE d = 'a';
+    ]], {
+        -- <cursor-filter-2.2>
+        "~/CursorFilter/"
+        -- </cursor-filter-2.2>
+    })
+
+--
+-- Each loop of a join has its own filter.
+--
+test:do_execsql_test(
+    "cursor-filter-3.1",
+    [[
+        SELECT x.id, y.id FROM t1 AS x, t1 AS y
+        WHERE x.a = 1 AND y.c = 'b';
+    ]], {
+        -- <cursor-filter-3.1>
+        1, 2
+        -- </cursor-filter-3.1>
+    })
+
+test:do_execsql_test(
+    "cursor-filter-3.2",
+    [[
+        UPDATE t1 SET a = a + 10 WHERE c = 'b';
+        DELETE FROM t1 WHERE a < 5;
+        SELECT id, a FROM t1;
+        DROP TABLE t1;
+    ]], {
+        -- <cursor-filter-3.2>
+        2, 8, 3, "", 5, 5
+        -- </cursor-filter-3.2>
+    })
+
+test:finish_test()
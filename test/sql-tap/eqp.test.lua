@@ -228,7 +228,7 @@ test:do_eqp_test("2.3.2", "SELECT min(x) FROM t2", {
     {0, 0, 0, "SEARCH TABLE T2 USING COVERING INDEX T2I1"},
 })
 test:do_eqp_test("2.3.3", "SELECT min(x), max(x) FROM t2", {
-    {0, 0, 0, "SCAN TABLE T2"},
+    {0, 0, 0, "SEARCH TABLE T2 USING COVERING INDEX T2I1 FOR MIN/MAX/COUNT"},
 })
 test:do_eqp_test("2.4.1", "SELECT * FROM t1 WHERE idt1=?", {
     {0, 0, 0, "SEARCH TABLE T1 USING PRIMARY KEY (IDT1=?)"},
@@ -0,0 +1,169 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(10)
+
+--
+-- EXPLAIN ANALYZE runs the statement and lists its program along
+-- with the number of times each instruction was executed, the
+-- number of rows it produced and the CPU cycles it took.
+--
+local function opcode_stat(sql, opcode)
+    local res = box.execute(sql)
+    local count, rows = 0, 0
+    for _, row in ipairs(res.rows) do
+        if row[2] == opcode then
+            count = count + row[9]
+            rows = rows + row[10]
+        end
+    end
+    return {count, rows}
+end
+
+test:do_test(
+    "explain-analyze-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(id INT PRIMARY KEY, a INT);
+        ]])
+        for i = 1, 10 do
+            box.space.T1:insert({i, i % 3})
+        end
+        return test:execsql("SELECT count(*) FROM t1")
+    end, {
+        -- <explain-analyze-1.0>
+        10
+        -- </explain-analyze-1.0>
+    })
+
+test:do_test(
+    "explain-analyze-1.1",
+    function()
+        local res = box.execute("EXPLAIN ANALYZE SELECT * FROM t1")
+        local names = {}
+        for _, column in ipairs(res.metadata) do
+            table.insert(names, column.name)
+        end
+        return {table.concat(names, " "), #res.rows[1]}
+    end, {
+        -- <explain-analyze-1.1>
+        "addr opcode p1 p2 p3 p4 p5 comment count rows cycles", 11
+        -- </explain-analyze-1.1>
+    })
+
+test:do_test(
+    "explain-analyze-1.2",
+    function()
+        return opcode_stat("EXPLAIN ANALYZE SELECT * FROM t1", "ResultRow")
+    end, {
+        -- <explain-analyze-1.2>
+        10, 10
+        -- </explain-analyze-1.2>
+    })
+
+--
+-- Rewind produces the first row of a scan and Next all the
+-- others. The rows which don't satisfy "a = 1" are skipped by
+-- the cursor filter.
+--
+test:do_test(
+    "explain-analyze-1.3",
+    function()
+        local sql = "EXPLAIN ANALYZE SELECT * FROM t1 WHERE a = 1"
+        local rewind = opcode_stat(sql, "Rewind")
+        local next = opcode_stat(sql, "Next")
+        local result = opcode_stat(sql, "ResultRow")
+        return {rewind[2] + next[2], next[1], result[2]}
+    end, {
+        -- <explain-analyze-1.3>
+        4, 4, 4
+        -- </explain-analyze-1.3>
+    })
+
+test:do_test(
+    "explain-analyze-1.4",
+    function()
+        local res = box.execute("EXPLAIN ANALYZE SELECT * FROM t1")
+        for _, row in ipairs(res.rows) do
+            if row[11] < 0 or (row[9] == 0 and row[11] ~= 0) then
+                return {row[1]}
+            end
+        end
+        return {true}
+    end, {
+        -- <explain-analyze-1.4>
+        true
+        -- </explain-analyze-1.4>
+    })
+
+--
+-- The statement is executed for real.
+--
+test:do_test(
+    "explain-analyze-2.1",
+    function()
+        box.execute("EXPLAIN ANALYZE INSERT INTO t1 VALUES (11, 1)")
+        return test:execsql("SELECT count(*), sum(a) FROM t1")
+    end, {
+        -- <explain-analyze-2.1>
+        11, 11
+        -- </explain-analyze-2.1>
+    })
+
+test:do_test(
+    "explain-analyze-2.2",
+    function()
+        return opcode_stat("EXPLAIN ANALYZE DELETE FROM t1 WHERE a = 1",
+                           "Delete")
+    end, {
+        -- <explain-analyze-2.2>
+        5, 0
+        -- </explain-analyze-2.2>
+    })
+
+test:do_execsql_test(
+    "explain-analyze-2.3",
+    [[
+        SELECT count(*) FROM t1;
+        DROP TABLE t1;
+    ]], {
+        -- <explain-analyze-2.3>
+        6
+        -- </explain-analyze-2.3>
+    })
+
+--
+-- Cycles and rows of a trigger are added to the Program
+-- instruction which calls it.
+--
+test:do_test(
+    "explain-analyze-3.1",
+    function()
+        test:execsql([[
+            CREATE TABLE t2(id INT PRIMARY KEY);
+            CREATE TABLE t3(id INT PRIMARY KEY, a INT);
+            INSERT INTO t3 VALUES (1, 0), (2, 0), (3, 0);
+            CREATE TRIGGER t2i AFTER INSERT ON t2 FOR EACH ROW
+            BEGIN UPDATE t3 SET a = a + 1; END;
+        ]])
+        local stat = opcode_stat("EXPLAIN ANALYZE INSERT INTO t2 VALUES (1)",
+                                 "Program")
+        return {stat[1], stat[2] >= 3}
+    end, {
+        -- <explain-analyze-3.1>
+        1, true
+        -- </explain-analyze-3.1>
+    })
+
+test:do_execsql_test(
+    "explain-analyze-3.2",
+    [[
+        SELECT sum(a) FROM t3;
+        DROP TABLE t2;
+        DROP TABLE t3;
+    ]], {
+        -- <explain-analyze-3.2>
+        3
+        -- </explain-analyze-3.2>
+    })
+
+test:finish_test()
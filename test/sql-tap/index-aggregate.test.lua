@@ -0,0 +1,175 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(14)
+
+--
+-- COUNT, MIN and MAX of an indexed column over a range of the
+-- index are computed by OP_IndexAggregate with index seeks
+-- instead of a scan. Make sure the results are the same the
+-- regular program produces. The unary plus hides the column
+-- from the optimization.
+--
+test:do_test(
+    "index-aggregate-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(id INT PRIMARY KEY, a INT, b NUMBER);
+            CREATE INDEX t1a ON t1(a);
+            CREATE INDEX t1b ON t1(b);
+        ]])
+        for i = 1, 100 do
+            local a = i % 10 ~= 0 and i % 20 or box.NULL
+            box.space.T1:insert({i, a, i})
+        end
+        return test:execsql("SELECT count(*), count(a) FROM t1")
+    end, {
+        -- <index-aggregate-1.0>
+        100, 90
+        -- </index-aggregate-1.0>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-1.1",
+    [[
+        SELECT count(*), count(a), min(a), max(a) FROM t1;
+    ]], {
+        -- <index-aggregate-1.1>
+        100, 90, 1, 19
+        -- </index-aggregate-1.1>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-1.2",
+    [[
+        SELECT count(*), min(a), max(a) FROM t1 WHERE a BETWEEN 5 AND 12;
+    ]], {
+        -- <index-aggregate-1.2>
+        35, 5, 12
+        -- </index-aggregate-1.2>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-1.3",
+    [[
+        SELECT count(*), min(a), max(a) FROM t1 WHERE +a BETWEEN 5 AND 12;
+    ]], {
+        -- <index-aggregate-1.3>
+        35, 5, 12
+        -- </index-aggregate-1.3>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-1.4",
+    [[
+        SELECT count(*), min(a), max(a) FROM t1 WHERE a > 15;
+    ]], {
+        -- <index-aggregate-1.4>
+        20, 16, 19
+        -- </index-aggregate-1.4>
+    })
+
+--
+-- NULLs never satisfy a bound.
+--
+test:do_execsql_test(
+    "index-aggregate-1.5",
+    [[
+        SELECT count(*), count(a), min(a), max(a) FROM t1 WHERE a < 3;
+    ]], {
+        -- <index-aggregate-1.5>
+        10, 10, 1, 2
+        -- </index-aggregate-1.5>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-1.6",
+    [[
+        SELECT count(*), min(a), max(a) FROM t1 WHERE 7 <= a AND a < 9;
+    ]], {
+        -- <index-aggregate-1.6>
+        10, 7, 8
+        -- </index-aggregate-1.6>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-1.7",
+    [[
+        SELECT count(*), min(a), max(a) FROM t1 WHERE a = 10;
+    ]], {
+        -- <index-aggregate-1.7>
+        0, "", ""
+        -- </index-aggregate-1.7>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-1.8",
+    [[
+        SELECT min(b), max(b), typeof(max(b)) FROM t1 WHERE b >= 50.5;
+    ]], {
+        -- <index-aggregate-1.8>
+        51, 100, "real"
+        -- </index-aggregate-1.8>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-2.1",
+    [[
+        EXPLAIN QUERY PLAN
+        SELECT count(*), min(a), max(a) FROM t1 WHERE a BETWEEN 5 AND 12;
+    ]], {
+        -- <index-aggregate-2.1>
+        0, 0, 0, "SEARCH TABLE T1 USING COVERING INDEX T1A "..
+                 "FOR MIN/MAX/COUNT (A>? AND A<?)"
+        -- </index-aggregate-2.1>
+    })
+
+--
+-- Bind parameters are checked at runtime. When they don't fit
+-- the index, the aggregates are computed by a scan.
+--
+local function range(...)
+    local sql = "SELECT count(*), min(a), max(a) FROM t1 "..
+                "WHERE a BETWEEN ? AND ?"
+    return box.execute(sql, {...}).rows[1]
+end
+
+test:do_test(
+    "index-aggregate-3.1",
+    function()
+        return range(5, 12)
+    end, {
+        -- <index-aggregate-3.1>
+        35, 5, 12
+        -- </index-aggregate-3.1>
+    })
+
+test:do_test(
+    "index-aggregate-3.2",
+    function()
+        return range(box.NULL, 12)
+    end, {
+        -- <index-aggregate-3.2>
+        0, "", ""
+        -- </index-aggregate-3.2>
+    })
+
+test:do_test(
+    "index-aggregate-3.3",
+    function()
+        return range(4.5, 12.5)
+    end, {
+        -- <index-aggregate-3.3>
+        35, 5, 12
+        -- </index-aggregate-3.3>
+    })
+
+test:do_execsql_test(
+    "index-aggregate-3.4",
+    [[
+        DROP TABLE t1;
+    ]], {
+        -- <index-aggregate-3.4>
+        -- </index-aggregate-3.4>
+    })
+
+test:finish_test()
@@ -0,0 +1,200 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(11)
+
+--
+-- When box.cfg.sql_scan_partitions is set, a full scan of a
+-- vinyl space is split into key ranges along the page index of
+-- its runs, and the ranges are read by separate fibers. The
+-- fibers only read the rows ahead, WHERE is evaluated by the
+-- statement as usual. Check that the rows and their order are
+-- the same as the ones of a sequential scan.
+--
+local N = 5000
+
+test:do_test(
+    "parallel-scan-1.0",
+    function()
+        local s = box.schema.space.create('T1', {
+            engine = 'vinyl',
+            format = {{'ID', 'integer'}, {'A', 'integer'},
+                      {'B', 'string'}}
+        })
+        s:create_index('pk', {page_size = 1024})
+        box.begin()
+        for i = 1, N do
+            s:replace({i, i % 13, string.rep('x', i % 50)})
+        end
+        box.commit()
+        box.snapshot()
+        -- Some rows are in memory only.
+        for i = N + 1, N + 100 do
+            s:replace({i, i % 13, ''})
+        end
+        return test:execsql("SELECT count(*) FROM t1")
+    end, {
+        -- <parallel-scan-1.0>
+        N + 100
+        -- </parallel-scan-1.0>
+    })
+
+local expected = nil
+
+-- Number of key ranges the scans done by @a sql were split into.
+local function scan_partitions(sql)
+    local before = box.stat.sql().sql_scan_partition_count
+    local rows = box.execute(sql).rows
+    return box.stat.sql().sql_scan_partition_count - before, rows
+end
+
+test:do_test(
+    "parallel-scan-1.1",
+    function()
+        box.cfg{sql_scan_partitions = 0}
+        local partitions
+        partitions, expected = scan_partitions("SELECT id FROM t1 WHERE a = 5")
+        return {#expected, partitions}
+    end, {
+        -- <parallel-scan-1.1>
+        392, 0
+        -- </parallel-scan-1.1>
+    })
+
+test:do_test(
+    "parallel-scan-1.2",
+    function()
+        box.cfg{sql_scan_partitions = 8}
+        local partitions, rows =
+            scan_partitions("SELECT id FROM t1 WHERE a = 5")
+        for i = 1, #expected do
+            if rows[i][1] ~= expected[i][1] then
+                return {i}
+            end
+        end
+        return {#rows, partitions}
+    end, {
+        -- <parallel-scan-1.2>
+        392, 8
+        -- </parallel-scan-1.2>
+    })
+
+test:do_execsql_test(
+    "parallel-scan-1.3",
+    [[
+        SELECT count(*), sum(id), min(id), max(id), sum(length(b))
+        FROM t1;
+    ]], {
+        -- <parallel-scan-1.3>
+        5100, 13007550, 1, 5100, 122500
+        -- </parallel-scan-1.3>
+    })
+
+--
+-- The scan may be stopped before the readers are done.
+--
+test:do_execsql_test(
+    "parallel-scan-1.4",
+    [[
+        SELECT id FROM t1 WHERE a = 0 LIMIT 3;
+    ]], {
+        -- <parallel-scan-1.4>
+        13, 26, 39
+        -- </parallel-scan-1.4>
+    })
+
+--
+-- In a transaction the space is read sequentially.
+--
+test:do_test(
+    "parallel-scan-1.5",
+    function()
+        box.begin()
+        box.space.T1:replace({N + 101, 5, ''})
+        local partitions, rows =
+            scan_partitions("SELECT count(*) FROM t1 WHERE a = 5")
+        box.rollback()
+        return {rows[1][1], partitions}
+    end, {
+        -- <parallel-scan-1.5>
+        393, 0
+        -- </parallel-scan-1.5>
+    })
+
+--
+-- Only the outermost scan of the top-level SELECT is read in
+-- parallel: a correlated subquery is re-run for every outer row
+-- and a scan with LIMIT is likely to stop early.
+--
+local function parallel_rewinds(sql)
+    local parallel, total = 0, 0
+    for _, row in ipairs(box.execute("EXPLAIN "..sql).rows) do
+        if row[2] == "Rewind" then
+            total = total + 1
+            if row[7] == "01" then
+                parallel = parallel + 1
+            end
+        end
+    end
+    return {parallel, total > parallel}
+end
+
+test:do_test(
+    "parallel-scan-1.6",
+    function()
+        return parallel_rewinds([[SELECT id FROM t1 WHERE a = 5 AND
+                                  EXISTS (SELECT 1 FROM t1 AS x
+                                          WHERE x.a = t1.a + 1 AND
+                                          x.b = t1.b)]])
+    end, {
+        -- <parallel-scan-1.6>
+        1, true
+        -- </parallel-scan-1.6>
+    })
+
+test:do_test(
+    "parallel-scan-1.7",
+    function()
+        return parallel_rewinds("SELECT id FROM t1 WHERE a = 0 LIMIT 3")
+    end, {
+        -- <parallel-scan-1.7>
+        0, true
+        -- </parallel-scan-1.7>
+    })
+
+test:do_execsql_test(
+    "parallel-scan-1.8",
+    [[
+        SELECT count(*) FROM t1 WHERE a = 5 AND
+        EXISTS (SELECT 1 FROM t1 AS x WHERE x.id = t1.id + 1 AND x.b = '');
+    ]], {
+        -- <parallel-scan-1.8>
+        14
+        -- </parallel-scan-1.8>
+    })
+
+test:do_test(
+    "parallel-scan-2.1",
+    function()
+        local ok, err = pcall(box.cfg, {sql_scan_partitions = 33})
+        return {ok, tostring(err)}
+    end, {
+        -- <parallel-scan-2.1>
+        false, "Incorrect value for option 'sql_scan_partitions': "..
+               "must be between 0 and 32"
+        -- </parallel-scan-2.1>
+    })
+
+test:do_test(
+    "parallel-scan-2.2",
+    function()
+        box.space.T1:drop()
+        return {box.space.T1 == nil}
+    end, {
+        -- <parallel-scan-2.2>
+        true
+        -- </parallel-scan-2.2>
+    })
+
+box.cfg{sql_scan_partitions = 0}
+
+test:finish_test()
@@ -0,0 +1,159 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(8)
+
+--
+-- When box.cfg.sql_sorter_threads is set, the external sorter
+-- builds and merges its runs in worker threads. Check that big
+-- sorts, which don't fit in memory and are spilled to temporary
+-- files, return the same rows in the same order.
+--
+local N = 30000
+local PAD = string.rep('x', 200)
+
+local function key(i)
+    return string.format("%08d", (i * 7919) % N) .. PAD
+end
+
+local function sorted(rows)
+    for i = 2, #rows do
+        if rows[i - 1][1] > rows[i][1] then
+            return false
+        end
+    end
+    return true
+end
+
+test:do_test(
+    "sort-threads-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(id INT PRIMARY KEY, b TEXT, c INT);
+        ]])
+        box.begin()
+        for i = 1, N do
+            box.space.T1:insert({i, key(i), i % 7})
+        end
+        box.commit()
+        return test:execsql("SELECT count(*) FROM t1")
+    end, {
+        -- <sort-threads-1.0>
+        N
+        -- </sort-threads-1.0>
+    })
+
+local expected = nil
+
+test:do_test(
+    "sort-threads-1.1",
+    function()
+        box.cfg{sql_sorter_threads = 0}
+        expected = box.execute("SELECT b, id FROM t1 ORDER BY b").rows
+        return {#expected, sorted(expected)}
+    end, {
+        -- <sort-threads-1.1>
+        N, true
+        -- </sort-threads-1.1>
+    })
+
+test:do_test(
+    "sort-threads-1.2",
+    function()
+        box.cfg{sql_sorter_threads = 4}
+        local rows = box.execute("SELECT b, id FROM t1 ORDER BY b").rows
+        for i = 1, N do
+            if rows[i][2] ~= expected[i][2] then
+                return {i}
+            end
+        end
+        return {#rows}
+    end, {
+        -- <sort-threads-1.2>
+        N
+        -- </sort-threads-1.2>
+    })
+
+test:do_test(
+    "sort-threads-1.3",
+    function()
+        local rows = box.execute([[
+            SELECT b, c FROM t1 ORDER BY b DESC LIMIT 3 OFFSET 100
+        ]]).rows
+        return {rows[1][2], rows[2][2], rows[3][2]}
+    end, {
+        -- <sort-threads-1.3>
+        expected[N - 100][2] % 7, expected[N - 101][2] % 7,
+        expected[N - 102][2] % 7
+        -- </sort-threads-1.3>
+    })
+
+--
+-- A sort inside a transaction can't yield, so it is done in
+-- the tx thread without workers.
+--
+test:do_test(
+    "sort-threads-1.4",
+    function()
+        box.begin()
+        local rows = box.execute("SELECT b, id FROM t1 ORDER BY b").rows
+        box.commit()
+        return {#rows, sorted(rows)}
+    end, {
+        -- <sort-threads-1.4>
+        N, true
+        -- </sort-threads-1.4>
+    })
+
+--
+-- Other fibers keep running while a sort of a memtx space waits
+-- for the workers, and may even change the space: the sorter
+-- already holds copies of all the rows it has read.
+--
+test:do_test(
+    "sort-threads-1.5",
+    function()
+        local fiber = require('fiber')
+        local count = 0
+        local f = fiber.create(function()
+            while true do
+                count = count + 1
+                box.space.T1:replace({N + count, key(count), 0})
+                fiber.sleep(0)
+            end
+        end)
+        fiber.sleep(0)
+        local before = count
+        local rows = box.execute("SELECT b, id FROM t1 ORDER BY b").rows
+        local yields = count - before
+        f:cancel()
+        return {#rows - before, sorted(rows), yields > 0}
+    end, {
+        -- <sort-threads-1.5>
+        N, true, true
+        -- </sort-threads-1.5>
+    })
+
+test:do_test(
+    "sort-threads-2.1",
+    function()
+        local ok, err = pcall(box.cfg, {sql_sorter_threads = 9})
+        return {ok, tostring(err)}
+    end, {
+        -- <sort-threads-2.1>
+        false, "Incorrect value for option 'sql_sorter_threads': "..
+               "must be between 0 and 8"
+        -- </sort-threads-2.1>
+    })
+
+test:do_execsql_test(
+    "sort-threads-2.2",
+    [[
+        DROP TABLE t1;
+    ]], {
+        -- <sort-threads-2.2>
+        -- </sort-threads-2.2>
+    })
+
+box.cfg{sql_sorter_threads = 0}
+
+test:finish_test()
@@ -0,0 +1,60 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.execute('pragma sql_default_engine=\''..engine..'\'')
+
+--
+-- Equality join on columns without an index is executed as
+-- a hash join: the smaller table is loaded into a hash table,
+-- which is then probed with the rows of the larger one.
+--
+box.execute("CREATE TABLE t1 (id INT PRIMARY KEY, a INT, s TEXT)")
+box.execute("CREATE TABLE t2 (id INT PRIMARY KEY, b INT, s TEXT)")
+box.begin() for i = 1, 1000 do box.space.T1:insert({i, i % 100, tostring(i % 10)}) end box.commit()
+box.begin() for i = 1, 20 do box.space.T2:insert({i, i, tostring(i % 10)}) end box.commit()
+-- NULL keys never match.
+box.space.T1:insert({1001, box.NULL, box.NULL})
+box.space.T2:insert({21, box.NULL, box.NULL})
+
+box.execute("EXPLAIN QUERY PLAN SELECT t1.id, t2.id FROM t1, t2 WHERE t1.a = t2.b")
+box.execute("SELECT COUNT(*) FROM t1, t2 WHERE t1.a = t2.b")
+box.execute("SELECT COUNT(*) FROM t1, t2 WHERE t1.a = t2.b AND t1.id + t2.id > 900")
+box.execute("SELECT COUNT(*) FROM t1, t2 WHERE t1.s = t2.s")
+box.execute("SELECT t1.id, t2.s FROM t1, t2 WHERE t1.a = t2.b AND t1.id < 5 ORDER BY t1.id")
+
+-- Rows which don't fit into box.cfg.sql_hash_join_memory are
+-- spilled to an ephemeral space and are found all the same,
+-- both when some of the rows are kept in memory and when all
+-- of them are spilled.
+box.cfg{sql_hash_join_memory = -1}
+box.cfg{sql_hash_join_memory = 200}
+box.execute("SELECT COUNT(*) FROM t1, t2 WHERE t1.a = t2.b")
+box.execute("SELECT COUNT(*) FROM t1, t2 WHERE t1.s = t2.s")
+box.execute("SELECT t1.id, t2.s FROM t1, t2 WHERE t1.a = t2.b AND t1.id < 5 ORDER BY t1.id")
+box.cfg{sql_hash_join_memory = 0}
+box.execute("SELECT COUNT(*) FROM t1, t2 WHERE t1.a = t2.b")
+box.execute("SELECT COUNT(*) FROM t1, t2 WHERE t1.s = t2.s")
+box.cfg{sql_hash_join_memory = 16 * 1024 * 1024}
+
+-- Integers and reals with an integral value compare equal, so
+-- they hash alike: 1 is joined with 1.0.
+box.execute("CREATE TABLE t3 (id INT PRIMARY KEY, n NUMBER)")
+box.execute("CREATE TABLE t4 (id INT PRIMARY KEY, n NUMBER)")
+box.begin() for i = 1, 1000 do box.space.T3:insert({i, i % 2 + 1}) end box.commit()
+box.execute("INSERT INTO t4 VALUES (1, 1.0), (2, 1e0)")
+for i = 3, 20 do box.execute("INSERT INTO t4 VALUES (?, ?)", {i, i + 0.5}) end
+box.execute("EXPLAIN QUERY PLAN SELECT t3.id, t4.id FROM t3, t4 WHERE t3.n = t4.n")
+box.execute("SELECT COUNT(*) FROM t3, t4 WHERE t3.n = t4.n")
+box.execute("SELECT t3.n, t4.n FROM t3, t4 WHERE t3.n = t4.n AND t3.id = 1")
+box.cfg{sql_hash_join_memory = 0}
+box.execute("SELECT COUNT(*) FROM t3, t4 WHERE t3.n = t4.n")
+box.cfg{sql_hash_join_memory = 16 * 1024 * 1024}
+box.execute("DROP TABLE t3")
+box.execute("DROP TABLE t4")
+
+-- An index on the join column is preferred to a hash join.
+box.execute("CREATE INDEX t1a ON t1 (a)")
+box.execute("EXPLAIN QUERY PLAN SELECT t1.id, t2.id FROM t1, t2 WHERE t1.a = t2.b")
+box.execute("SELECT COUNT(*) FROM t1, t2 WHERE t1.a = t2.b")
+
+box.execute("DROP TABLE t1")
+box.execute("DROP TABLE t2")
@@ -243,6 +243,69 @@ res.metadata
 cn:execute("SELECT min(1, 2, 3);")
 cn:execute("SELECT max(1, 2, 3);")
 
+--
+-- A result set can be sent by parts of chunk_size rows, each
+-- in a separate IPROTO_CHUNK response, which is passed to
+-- on_push.
+--
+box.execute('CREATE TABLE t2(id INT PRIMARY KEY, a INT)')
+for i = 1, 10 do box.space.T2:insert({i, i * 2}) end
+chunks = {}
+res = cn:execute('SELECT * FROM t2', nil, {chunk_size = 3}, {on_push = table.insert, on_push_ctx = chunks})
+#chunks, #res.rows
+chunks[1]
+res.metadata
+res.rows
+-- Without on_push the parts are collected into the result.
+res = cn:execute('SELECT a FROM t2 WHERE id > ?', {2}, {chunk_size = 4})
+#res.rows, res.rows[1], res.rows[8]
+cn:execute('SELECT 1', nil, {chunk_size = 0})
+--
+-- Unknown keys of IPROTO_OPTIONS are skipped along with their
+-- values wherever they are in the map.
+--
+socket = require('socket')
+msgpack = require('msgpack')
+test_run:cmd("setopt delimiter ';'")
+function execute_raw(sql, options)
+    local uri = require('uri').parse(box.cfg.listen)
+    local s = socket.tcp_connect(uri.host, uri.service)
+    s:read(128)
+    -- {IPROTO_REQUEST_TYPE: IPROTO_EXECUTE, IPROTO_SYNC: 1}
+    local header = msgpack.encode(setmetatable({[0] = 11, [1] = 1},
+                                               {__serialize = 'map'}))
+    local body = '\x83'..msgpack.encode(0x40)..msgpack.encode(sql)..
+                 msgpack.encode(0x41)..msgpack.encode({})..
+                 msgpack.encode(0x2b)..options
+    s:write(msgpack.encode(#header + #body)..header..body)
+    local chunks, rows = 0, 0
+    while true do
+        local size = msgpack.decode(s:read(5))
+        local data = s:read(size)
+        local resp, pos = msgpack.decode(data)
+        local res = msgpack.decode(data, pos)
+        if resp[0] ~= 128 and resp[0] ~= 0 then
+            s:close()
+            return res[0x31]
+        end
+        rows = rows + #res[0x30]
+        if resp[0] == 0 then
+            break
+        end
+        chunks = chunks + 1
+    end
+    s:close()
+    return chunks, rows
+end;
+test_run:cmd("setopt delimiter ''");
+-- {5: 1, 'k': 'v', chunk_size: 3, 7: [1, 2]}
+options = '\x84'..msgpack.encode(5)..msgpack.encode(1)..msgpack.encode('k')..msgpack.encode('v')..msgpack.encode(0)..msgpack.encode(3)..msgpack.encode(7)..msgpack.encode({1, 2})
+execute_raw('SELECT * FROM t2', options)
+-- {chunk_size: 4, 5: 1}
+options = '\x82'..msgpack.encode(0)..msgpack.encode(4)..msgpack.encode(5)..msgpack.encode(1)
+execute_raw('SELECT * FROM t2', options)
+box.execute('DROP TABLE t2')
+
 cn:close()
 box.execute('DROP TABLE t1')
 
@@ -0,0 +1,65 @@
+test_run = require('test_run').new()
+fio = require('fio')
+xlog = require('xlog')
+
+--
+-- Delta memtx checkpoints: spaces that haven't changed since
+-- the last checkpoint are not written, the snapshot refers to
+-- the previous one instead.
+--
+box.cfg{memtx_delta_checkpoint_count = -1}
+box.cfg.memtx_delta_checkpoint_count
+
+test_run:cmd("setopt delimiter ';'")
+function last_snap()
+    local snaps = fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snap'))
+    table.sort(snaps)
+    return snaps[#snaps]
+end;
+function base_spaces()
+    local ids = {}
+    for _, row in xlog.pairs(last_snap()) do
+        if row.HEADER.type == 'BASESPACE' then
+            table.insert(ids, row.BODY.space_id)
+        end
+    end
+    table.sort(ids)
+    return ids
+end;
+test_run:cmd("setopt delimiter ''");
+
+s1 = box.schema.space.create('s1')
+_ = s1:create_index('pk')
+s2 = box.schema.space.create('s2')
+_ = s2:create_index('pk')
+for i = 1, 10 do s1:insert{i} s2:insert{i} end
+box.snapshot()
+base_spaces()
+
+box.cfg{memtx_delta_checkpoint_count = 2}
+s2:insert{11}
+box.snapshot()
+base_spaces()[1] == s1.id
+#base_spaces()
+s2:insert{12}
+box.snapshot()
+base_spaces()[1] == s1.id
+#base_spaces()
+-- The chain is too long, a full checkpoint is made.
+s2:insert{13}
+box.snapshot()
+base_spaces()
+s1:insert{11}
+box.snapshot()
+base_spaces()[1] == s2.id
+#base_spaces()
+
+-- Recovery merges the chain.
+test_run:cmd('restart server default')
+box.space.s1:count()
+box.space.s2:count()
+box.space.s1:max()
+box.space.s2:max()
+
+box.space.s1:drop()
+box.space.s2:drop()
@@ -0,0 +1,55 @@
+test_run = require('test_run').new()
+fio = require('fio')
+xlog = require('xlog')
+
+--
+-- Several threads write a memtx snapshot in parallel.
+--
+box.cfg{memtx_checkpoint_threads = 0}
+box.cfg.memtx_checkpoint_threads
+
+test_run:cmd("setopt delimiter ';'")
+function last_snap()
+    local snaps = fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snap'))
+    table.sort(snaps)
+    return snaps[#snaps]
+end;
+-- Count user space rows, check that system spaces go first
+-- and rows are numbered in the file order.
+function check_snap()
+    local count = 0
+    local system_after_user = false
+    local lsn_in_order = true
+    local lsn = 0
+    for _, row in xlog.pairs(last_snap()) do
+        if (row.HEADER.lsn or 0) ~= lsn then
+            lsn_in_order = false
+        end
+        lsn = lsn + 1
+        if row.BODY.space_id > box.schema.SYSTEM_ID_MAX then
+            count = count + 1
+        elseif count > 0 then
+            system_after_user = true
+        end
+    end
+    return count, system_after_user, lsn_in_order
+end;
+test_run:cmd("setopt delimiter ''");
+
+box.cfg{memtx_checkpoint_threads = 4}
+box.cfg.memtx_checkpoint_threads
+
+pad = string.rep('x', 100)
+for i = 1, 6 do box.schema.space.create('s' .. i):create_index('pk') end
+for i = 1, 6 do for j = 1, 2000 do box.space['s' .. i]:insert{j, pad} end end
+box.snapshot()
+check_snap()
+
+-- The snapshot is loaded back by a reader thread, in several
+-- batches of rows.
+test_run:cmd('restart server default')
+for i = 1, 6 do assert(box.space['s' .. i]:count() == 2000) end
+box.space.s6:max()[1]
+box.space.s6:get{1000}[2] == string.rep('x', 100)
+
+for i = 1, 6 do box.space['s' .. i]:drop() end
@@ -0,0 +1,32 @@
+env = require('test_run').new()
+
+--
+-- WAL blocks are compressed with the configured level, level 0
+-- turns the compression off. With wal_compression_threads set
+-- the blocks are compressed in parallel. Check that the rows
+-- written with any of the settings are recovered.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.cfg{wal_compression_level = 0}
+for i = 1, 1000 do s:insert({i, string.rep('a', i % 100)}) end
+box.cfg{wal_compression_level = 19}
+for i = 1001, 2000 do s:insert({i, string.rep('b', i % 100)}) end
+box.cfg{wal_compression_level = 3, wal_compression_threads = 4}
+for i = 1, 20 do box.begin() for j = 1, 100 do local k = 2000 + (i - 1) * 100 + j s:insert({k, string.rep('c', k % 1000)}) end box.commit() end
+env:cmd('restart server default')
+
+s = box.space.test
+s:count()
+len = 0
+for _, t in s:pairs() do len = len + #t[2] end
+len
+s:drop()
+
+ok, err = pcall(box.cfg, {wal_compression_level = 23})
+ok, err:match('must be between 0 and 22') ~= nil
+ok, err = pcall(box.cfg, {memtx_compression_level = -1})
+ok, err:match('must be between 0 and 22') ~= nil
+ok, err = pcall(box.cfg, {wal_compression_threads = 33})
+ok, err:match('must be between 0 and 32') ~= nil
+box.cfg{wal_compression_threads = 0}
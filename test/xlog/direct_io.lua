@@ -0,0 +1,8 @@
+#!/usr/bin/env tarantool
+
+box.cfg {
+    listen = os.getenv("LISTEN"),
+    wal_direct_io = true
+}
+
+require('console').listen(os.getenv('ADMIN'))
@@ -0,0 +1,42 @@
+test_run = require('test_run').new()
+
+--
+-- With wal_direct_io the WAL is written bypassing the page
+-- cache in whole pages, the last one padded with zeros.
+--
+test_run:cmd('create server test with script = "xlog/direct_io.lua"')
+test_run:cmd("start server test")
+test_run:cmd("switch test")
+box.cfg.wal_direct_io
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 1000 do s:insert({i, string.rep('x', i % 100)}) end
+box.begin() for i = 1001, 3000 do s:insert({i, string.rep('y', i % 1000)}) end box.commit()
+
+--
+-- The file being written is read up to the padding.
+--
+fio = require('fio')
+xlog = require('xlog')
+files = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+table.sort(files)
+path = files[#files]
+n = 0
+for _, row in xlog.pairs(path) do if row.BODY.space_id == s.id then n = n + 1 end end
+n
+for i = 3001, 3010 do s:insert({i}) end
+n = 0
+for _, row in xlog.pairs(path) do if row.BODY.space_id == s.id then n = n + 1 end end
+n
+
+test_run:cmd("restart server test")
+s = box.space.test
+s:count()
+len = 0
+for _, t in s:pairs() do len = len + #(t[2] or '') end
+len
+box.cfg{wal_direct_io = false}
+
+test_run:cmd("switch default")
+test_run:cmd("stop server test")
+test_run:cmd("cleanup server test")
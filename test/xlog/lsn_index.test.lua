@@ -0,0 +1,47 @@
+test_run = require('test_run').new()
+fio = require('fio')
+
+--
+-- The WAL writer saves a sparse index of LSN to file offset
+-- next to a closed xlog. Recovery and relays use it to skip
+-- the rows which they have already seen.
+--
+box.cfg{wal_compression_level = 0}
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 30 do s:insert({i, string.rep('x', 150000)}) end
+indexes = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.index'))
+#indexes >= 2
+f = fio.open(indexes[1])
+text = f:read()
+f:close()
+text:match('^XLOG INDEX\nSize: %d+\n%d+ {.*}\n$') ~= nil
+
+test_run:cmd('restart server default')
+fio = require('fio')
+s = box.space.test
+s:count()
+len = 0
+for _, t in s:pairs() do len = len + #t[2] end
+len
+
+--
+-- A stale index is ignored.
+--
+indexes = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.index'))
+f = fio.open(indexes[#indexes], {'O_WRONLY', 'O_TRUNC'})
+f:write('XLOG INDEX\nSize: 1\n')
+f:close()
+test_run:cmd('restart server default')
+fio = require('fio')
+s = box.space.test
+s:count()
+
+--
+-- The index is removed along with the xlog.
+--
+box.cfg{checkpoint_count = 1}
+box.snapshot()
+test_run:wait_cond(function() return #fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.index')) == 0 end)
+s:drop()
+box.cfg{checkpoint_count = 2, wal_compression_level = 3}
@@ -0,0 +1,33 @@
+env = require('test_run').new()
+
+--
+-- Local recovery reads xlogs ahead in a separate thread and
+-- applies the rows in the tx thread. Check that the data is
+-- the same after a restart.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 200 do box.begin() for j = 1, 100 do local k = (i - 1) * 100 + j s:insert({k, k % 7, string.rep('x', k % 100)}) end box.commit() end
+for k = 1, 20000, 3 do s:delete(k) end
+for k = 2, 20000, 3 do s:update(k, {{'+', 2, 1}}) end
+env:cmd('restart server default')
+
+s = box.space.test
+s:count()
+s.index.sk:count(0)
+sum, len = 0, 0
+for _, t in s:pairs() do sum = sum + t[2] len = len + #t[3] end
+sum, len
+
+--
+-- The rest of a file which isn't finished is read by the
+-- recovery itself.
+--
+for k = 20001, 20100 do s:insert({k, k % 7, ''}) end
+env:cmd('restart server default')
+
+s = box.space.test
+s:count()
+s.index.pk:max()[1]
+s:drop()